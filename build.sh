@@ -10,6 +10,7 @@ WITH_ZK_INIT=false
 WITH_RDMA=false
 WITH_PROMETHEUS=false
 WITH_OBS_STORAGE=false
+WITH_IO_URING=false
 WITH_ASAN=false
 COVERAGE=false
 RUN_LOCAL_SERVICE_FOR_COVERAGE=false
@@ -182,6 +183,7 @@ build_falconfs() {
 		-DWITH_RDMA="$WITH_RDMA" \
 		-DWITH_PROMETHEUS="$WITH_PROMETHEUS" \
 		-DWITH_OBS_STORAGE="$WITH_OBS_STORAGE" \
+		-DWITH_IO_URING="$WITH_IO_URING" \
 		-DENABLE_COVERAGE="$cmake_coverage" \
 		-DENABLE_ASAN="$WITH_ASAN" \
 		-DBUILD_TEST=$BUILD_TEST \
@@ -549,6 +551,9 @@ build)
 			--with-obs-storage)
 				WITH_OBS_STORAGE=true
 				;;
+			--with-io-uring)
+				WITH_IO_URING=true
+				;;
 			--with-asan)
 				WITH_ASAN=true
 				;;
@@ -571,6 +576,7 @@ build)
 				echo "  --with-rdma          Enable RDMA support"
 				echo "  --with-prometheus    Enable Prometheus metrics"
 				echo "  --with-obs-storage   Enable OBS storage"
+				echo "  --with-io-uring      Enable io_uring local I/O engine (needs liburing)"
 				echo "  --with-asan          Enable AddressSanitizer with dynamic linking for memory debugging"
 				exit 0
 				;;
@@ -0,0 +1,399 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "buffer/mem_pool.h"
+
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "log/logging.h"
+
+/* mode of mbind(2), spelled out here since libnuma headers are not a build dependency */
+#define MEM_POOL_MPOL_PREFERRED 1
+
+static unsigned OnlineNumaNodes()
+{
+    /* e.g. "0" or "0-1" or "0,2-3", the highest id decides the number of depots */
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string online;
+    if (!std::getline(file, online) || online.empty()) {
+        return 1;
+    }
+    size_t pos = online.find_last_of(",-");
+    unsigned maxNode = std::strtoul(online.c_str() + (pos == std::string::npos ? 0 : pos + 1), nullptr, 10);
+    return std::min<unsigned>(maxNode + 1, MEM_POOL_MAX_NODES);
+}
+
+static void CurrentCpu(unsigned &cpu, unsigned &node)
+{
+    if (getcpu(&cpu, &node) != 0) {
+        cpu = 0;
+        node = 0;
+    }
+}
+
+/*---------------------- Depot ----------------------*/
+
+MemPool::Depot::Depot(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    cells = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+        cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    mask = size - 1;
+}
+
+bool MemPool::Depot::Push(void *block)
+{
+    size_t pos = pushPos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell &cell = cells[pos & mask];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.block = block;
+                cell.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = pushPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void *MemPool::Depot::Pop()
+{
+    size_t pos = popPos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell &cell = cells[pos & mask];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                void *block = cell.block;
+                cell.seq.store(pos + mask + 1, std::memory_order_release);
+                return block;
+            }
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            pos = popPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/*---------------------- MemPool ----------------------*/
+
+MemPool::MemPool(size_t blockSize, size_t capacity, size_t maxBlocks, bool hugePage)
+{
+    init(blockSize, capacity, maxBlocks, hugePage);
+}
+
+MemPool::~MemPool()
+{
+    if (!m_init.load()) {
+        return;
+    }
+    for (unsigned i = 0; i < m_cpuNum; ++i) {
+        CpuCache &cache = m_cpuCaches[i];
+        while (cache.count > 0) {
+            void *block = cache.blocks[--cache.count];
+            if (m_releaseHook) {
+                m_releaseHook(block);
+            }
+            if (!InSlab(block)) {
+                ::free(block);
+            }
+        }
+    }
+    for (auto &depot : m_depots) {
+        for (void *block = depot->Pop(); block != nullptr; block = depot->Pop()) {
+            if (m_releaseHook) {
+                m_releaseHook(block);
+            }
+            if (!InSlab(block)) {
+                ::free(block);
+            }
+        }
+    }
+    for (auto &slab : m_slabs) {
+        munmap(slab.base, slab.bytes);
+    }
+}
+
+void MemPool::init(size_t blockSize, size_t capacity, size_t maxBlocks, bool hugePage)
+{
+    if (!m_setup.exchange(true)) {
+        Setup(blockSize, capacity, maxBlocks, hugePage);
+        m_init.store(true);
+    }
+}
+
+void MemPool::Setup(size_t blockSize, size_t capacity, size_t maxBlocks, bool hugePage)
+{
+    m_blockSize = blockSize;
+    m_allocSize = (blockSize + MEM_POOL_ALIGN - 1) / MEM_POOL_ALIGN * MEM_POOL_ALIGN;
+    m_capacity = capacity;
+    m_maxBlocks = maxBlocks == 0 ? 0 : std::max(maxBlocks, capacity);
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    m_cpuNum = cpus > 0 ? cpus : 1;
+    m_nodeNum = OnlineNumaNodes();
+    m_cpuCaches = std::make_unique<CpuCache[]>(m_cpuNum);
+    /* any depot can hold all cached blocks, slab blocks never have to be dropped */
+    for (unsigned i = 0; i < m_nodeNum; ++i) {
+        m_depots.emplace_back(std::make_unique<Depot>(2 * capacity + m_nodeNum + 1));
+    }
+    if (hugePage && capacity > 0) {
+        CreateSlabs();
+    }
+}
+
+/*
+ * Carve the first capacity blocks from one hugepage backed slab per numa node. Without reserved hugepages a
+ * transparent hugepage mapping is used instead.
+ */
+void MemPool::CreateSlabs()
+{
+    size_t perNode = (m_capacity + m_nodeNum - 1) / m_nodeNum;
+    size_t bytes = perNode * m_allocSize;
+    bytes = (bytes + MEM_POOL_HUGEPAGE_SIZE - 1) / MEM_POOL_HUGEPAGE_SIZE * MEM_POOL_HUGEPAGE_SIZE;
+    for (unsigned node = 0; node < m_nodeNum; ++node) {
+        void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) {
+                FALCON_LOG(LOG_WARNING) << "MemPool::CreateSlabs(): mmap " << bytes << " bytes failed: "
+                                        << strerror(errno) << ", blocks come from the heap";
+                return;
+            }
+            madvise(base, bytes, MADV_HUGEPAGE);
+        }
+        /* pages are not touched yet, they are placed on the preferred node when first written */
+        if (m_nodeNum > 1) {
+            unsigned long nodeMask = 1UL << node;
+            if (syscall(SYS_mbind, base, bytes, MEM_POOL_MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0) != 0) {
+                FALCON_LOG(LOG_WARNING) << "MemPool::CreateSlabs(): mbind to node " << node
+                                        << " failed: " << strerror(errno);
+            }
+        }
+        m_slabs.push_back({(char *)base, bytes});
+        for (size_t i = 0; i < perNode; ++i) {
+            m_depots[node]->Push((char *)base + i * m_allocSize);
+        }
+        m_total += perNode;
+        m_cached += perNode;
+    }
+}
+
+bool MemPool::InSlab(void *block)
+{
+    for (const auto &slab : m_slabs) {
+        if ((char *)block >= slab.base && (char *)block < slab.base + slab.bytes) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Take a free block from the cpu cache, then from the local depot, then from the other nodes. A waiter at the
+ * memory limit also looks into the caches of the other cpus, the only block left may sit there.
+ */
+void *MemPool::PopCached(unsigned cpu, unsigned node, bool allCpus)
+{
+    for (unsigned i = 0; i < (allCpus ? m_cpuNum : 1); ++i) {
+        CpuCache &cache = m_cpuCaches[(cpu + i) % m_cpuNum];
+        if (cache.busy.test_and_set(std::memory_order_acquire)) {
+            continue;
+        }
+        void *block = cache.count > 0 ? cache.blocks[--cache.count] : nullptr;
+        cache.busy.clear(std::memory_order_release);
+        if (block != nullptr) {
+            return block;
+        }
+    }
+    for (unsigned i = 0; i < m_nodeNum; ++i) {
+        void *block = m_depots[(node + i) % m_nodeNum]->Pop();
+        if (block != nullptr) {
+            m_cached--;
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+void *MemPool::NewBlock()
+{
+    size_t total = m_total.load();
+    do {
+        if (m_maxBlocks != 0 && total >= m_maxBlocks) {
+            return nullptr;
+        }
+    } while (!m_total.compare_exchange_weak(total, total + 1));
+    void *block = aligned_alloc(MEM_POOL_ALIGN, m_allocSize);
+    if (block == nullptr) {
+        m_total--;
+    }
+    return block;
+}
+
+void MemPool::ReleaseBlock(void *block, unsigned cpu, unsigned node)
+{
+    CpuCache &cache = m_cpuCaches[cpu % m_cpuNum];
+    if (!cache.busy.test_and_set(std::memory_order_acquire)) {
+        bool kept = cache.count < MEM_POOL_CPU_CACHE_SIZE;
+        if (kept) {
+            cache.blocks[cache.count++] = block;
+        }
+        cache.busy.clear(std::memory_order_release);
+        if (kept) {
+            return;
+        }
+    }
+    bool slab = InSlab(block);
+    if (m_cached.fetch_add(1) < m_capacity || slab) {
+        for (unsigned i = 0; i < m_nodeNum; ++i) {
+            if (m_depots[(node + i) % m_nodeNum]->Push(block)) {
+                return;
+            }
+        }
+    }
+    m_cached--;
+    if (!slab) {
+        if (m_releaseHook) {
+            m_releaseHook(block);
+        }
+        ::free(block);
+        m_total--;
+    }
+}
+
+void *MemPool::alloc(bool wait)
+{
+    if (!m_init.load()) {
+        return nullptr;
+    }
+    unsigned cpu = 0;
+    unsigned node = 0;
+    CurrentCpu(cpu, node);
+    node = std::min(node, m_nodeNum - 1);
+    CpuCache &cache = m_cpuCaches[cpu % m_cpuNum];
+
+    void *block = PopCached(cpu, node, false);
+    if (block != nullptr) {
+        cache.hits.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+    block = NewBlock();
+    if (block != nullptr) {
+        cache.misses.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+    /* out of system memory, or at the limit and the caller can not wait */
+    if (m_maxBlocks == 0 || m_total.load() < m_maxBlocks || !wait) {
+        return nullptr;
+    }
+
+    m_waits++;
+    bool hit = false;
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    m_waiters++;
+    m_waitCv.wait_for(lock, std::chrono::milliseconds(MEM_POOL_WAIT_MS), [&]() {
+        block = PopCached(cpu, node, true);
+        hit = block != nullptr;
+        if (!hit) {
+            block = NewBlock();
+        }
+        return block != nullptr;
+    });
+    m_waiters--;
+    lock.unlock();
+    if (block == nullptr) {
+        FALCON_LOG(LOG_WARNING) << "MemPool::alloc(): no block freed within " << MEM_POOL_WAIT_MS << " ms, "
+                                << m_maxBlocks << " blocks of " << m_blockSize << " bytes in use";
+        return nullptr;
+    }
+    (hit ? cache.hits : cache.misses).fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+/*
+ * All num blocks or none, never waits since it would hold blocks while waiting for others
+ */
+std::vector<void *> MemPool::calloc(int num)
+{
+    std::vector<void *> bulkMem;
+    while (num-- > 0) {
+        void *mem = alloc(false);
+        if (mem == nullptr) {
+            for (auto &m : bulkMem) {
+                free(m);
+            }
+            return {};
+        }
+        bulkMem.emplace_back(mem);
+    }
+    return bulkMem;
+}
+
+void MemPool::free(void *buf)
+{
+    if (!m_init.load()) {
+        return;
+    }
+    if (buf == nullptr) {
+        return;
+    }
+    unsigned cpu = 0;
+    unsigned node = 0;
+    CurrentCpu(cpu, node);
+    ReleaseBlock(buf, cpu, std::min(node, m_nodeNum - 1));
+    /* pairs with the waiter announcing itself before it looks for blocks, one of both sees the other */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_waitMutex);
+        m_waitCv.notify_one();
+    }
+}
+
+MemPoolStats MemPool::GetStats()
+{
+    MemPoolStats stats;
+    if (!m_init.load()) {
+        return stats;
+    }
+    size_t cpuCached = 0;
+    for (unsigned i = 0; i < m_cpuNum; ++i) {
+        CpuCache &cache = m_cpuCaches[i];
+        while (cache.busy.test_and_set(std::memory_order_acquire)) {
+            sched_yield();
+        }
+        cpuCached += cache.count;
+        cache.busy.clear(std::memory_order_release);
+        stats.hits += cache.hits.load(std::memory_order_relaxed);
+        stats.misses += cache.misses.load(std::memory_order_relaxed);
+    }
+    stats.blockSize = m_blockSize;
+    stats.totalBlocks = m_total.load();
+    size_t idle = cpuCached + m_cached.load();
+    stats.usedBlocks = stats.totalBlocks > idle ? stats.totalBlocks - idle : 0;
+    stats.maxBlocks = m_maxBlocks;
+    stats.waits = m_waits.load();
+    return stats;
+}
@@ -29,7 +29,7 @@ struct DirOpenInstance
     uint64_t fd;
     std::unordered_map<std::string, std::shared_ptr<Connection>> workers;
     std::vector<std::string> partialEntryVec;
-    std::vector<unsigned int> fileModes;
+    std::vector<struct stat> fileStats;
     std::unordered_map<std::string, int> readFileCount;
     std::unordered_map<std::string, int> readFileCountIndex;
     std::unordered_map<std::string, std::string> lastFileNames;
@@ -61,7 +61,7 @@ struct DirOpenInstance
     {
         workers.clear();
         partialEntryVec.clear();
-        fileModes.clear();
+        fileStats.clear();
         readFileCount.clear();
         readFileCountIndex.clear();
         lastFileNames.clear();
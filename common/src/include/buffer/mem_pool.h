@@ -4,12 +4,49 @@
 
 #pragma once
 
-#include <pthread.h>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
-#include <queue>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#define MEM_POOL_ALIGN 512
+/* free blocks kept by every cpu in front of the shared depot */
+#define MEM_POOL_CPU_CACHE_SIZE 8
+/* numa nodes served by their own depot, higher node ids share the last one */
+#define MEM_POOL_MAX_NODES 8
+/* at the memory limit alloc waits this long for a block to come back before it fails */
+#define MEM_POOL_WAIT_MS 5000
+#define MEM_POOL_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+
+struct MemPoolStats
+{
+    size_t blockSize{0};
+    /* blocks taken from the system, handed out or cached */
+    size_t totalBlocks{0};
+    size_t usedBlocks{0};
+    /* 0 means no limit */
+    size_t maxBlocks{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    /* allocations that had to wait at the memory limit */
+    uint64_t waits{0};
+};
+
+/*
+ * Pool of fixed size blocks aligned to MEM_POOL_ALIGN. Every cpu keeps a few free blocks in its own cache line,
+ * alloc and free on it only take an uncontended flag. Behind the cpu caches every numa node has a lock-free bounded
+ * depot, a block freed on a node goes to the depot of that node and alloc prefers the local depot before stealing
+ * from the others. New blocks are first touched by the thread doing the io, so their pages are local to it.
+ *
+ * At most capacity free blocks are cached, the rest goes back to the system. With maxBlocks set no more blocks
+ * than that exist at once, alloc then waits up to MEM_POOL_WAIT_MS for a block to be freed. With hugePage set the
+ * first capacity blocks are carved from hugepage backed slabs, one per numa node and bound to it, which are only
+ * released with the pool.
+ */
 class MemPool {
   public:
     static MemPool &GetInstance()
@@ -19,120 +56,79 @@ class MemPool {
     }
 
     MemPool() = default;
+    MemPool(size_t blockSize, size_t capacity, size_t maxBlocks = 0, bool hugePage = false);
+    ~MemPool();
+    void init(size_t blockSize, size_t capacity, size_t maxBlocks = 0, bool hugePage = false);
+    /* without wait it fails at once at the memory limit, for callers that can go on without the block */
+    void *alloc(bool wait = true);
+    std::vector<void *> calloc(int num);
+    void free(void *buf);
+    MemPoolStats GetStats();
+    /* called with a block right before its memory goes back to the system, set before the pool is used */
+    void SetReleaseHook(std::function<void(void *)> hook) { m_releaseHook = std::move(hook); }
 
-    MemPool(size_t blockSize, size_t capacity)
-    {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
-
-    ~MemPool()
-    {
-        while (!m_freeBlocks.empty()) {
-            free(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        if (m_memLock) {
-            delete m_memLock;
-            m_memLock = nullptr;
-        }
-    }
+  private:
+    /* bounded multi producer multi consumer ring, every cell carries the sequence number of its next turn */
+    class Depot {
+      public:
+        explicit Depot(size_t capacity);
+        bool Push(void *block);
+        void *Pop();
 
-    void init(size_t blockSize, size_t capacity)
-    {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
+      private:
+        struct Cell
+        {
+            std::atomic<size_t> seq;
+            void *block;
+        };
+        std::unique_ptr<Cell[]> cells;
+        size_t mask{0};
+        alignas(64) std::atomic<size_t> pushPos{0};
+        alignas(64) std::atomic<size_t> popPos{0};
+    };
 
-    void *alloc()
+    struct alignas(64) CpuCache
     {
-        if (!m_init.load()) {
-            return nullptr;
-        }
-        void *block = nullptr;
-        pthread_spin_lock(m_memLock);
-        if (!m_freeBlocks.empty()) {
-            block = m_freeBlocks.front();
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        block = block ? block : aligned_alloc(512, m_blockSize);
-        m_size += block ? 1 : 0;
-        return block;
-    }
+        std::atomic_flag busy = ATOMIC_FLAG_INIT;
+        uint32_t count{0};
+        void *blocks[MEM_POOL_CPU_CACHE_SIZE];
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
 
-    std::vector<void *> calloc(int num)
+    struct Slab
     {
-        if (!m_init.load()) {
-            return {};
-        }
-        std::vector<void *> bulkMem;
-
-        pthread_spin_lock(m_memLock);
-        while (!m_freeBlocks.empty() && num--) {
-            bulkMem.emplace_back(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        while (num > 0) {
-            void *mem = aligned_alloc(512, m_blockSize);
-            if (mem == nullptr) {
-                break;
-            }
-            bulkMem.emplace_back(mem);
-            num--;
-        }
+        char *base{nullptr};
+        size_t bytes{0};
+    };
 
-        if (num > 0) {
-            /* error */
-            for (auto &m : bulkMem) {
-                /* how to free? */
-                ::free(m);
-            }
-            bulkMem.clear();
-        }
-        m_size += bulkMem.size();
-        return bulkMem;
-    }
+    void Setup(size_t blockSize, size_t capacity, size_t maxBlocks, bool hugePage);
+    void CreateSlabs();
+    bool InSlab(void *block);
+    void *PopCached(unsigned cpu, unsigned node, bool allCpus);
+    void *NewBlock();
+    void ReleaseBlock(void *block, unsigned cpu, unsigned node);
 
-    void free(void *buf)
-    {
-        if (!m_init.load()) {
-            return;
-        }
-        if (buf == nullptr) {
-            return;
-        }
-        if (m_size-- < m_capacity) {
-            pthread_spin_lock(m_memLock);
-            m_freeBlocks.push(buf);
-            pthread_spin_unlock(m_memLock);
-        } else {
-            ::free(buf);
-        }
-    }
-
-  private:
+    std::atomic<bool> m_setup = false;
     std::atomic<bool> m_init = false;
     size_t m_blockSize = 0;
+    size_t m_allocSize = 0;
     size_t m_capacity = 0;
-    std::atomic<size_t> m_size = 0;
-    std::queue<void *> m_freeBlocks;
-    pthread_spinlock_t *m_memLock = nullptr;
+    size_t m_maxBlocks = 0;
+
+    unsigned m_cpuNum = 1;
+    unsigned m_nodeNum = 1;
+    std::unique_ptr<CpuCache[]> m_cpuCaches;
+    std::vector<std::unique_ptr<Depot>> m_depots;
+    std::vector<Slab> m_slabs;
+    std::function<void(void *)> m_releaseHook;
+
+    std::atomic<size_t> m_total = 0;
+    /* blocks in the depots, admits freed blocks up to m_capacity */
+    std::atomic<size_t> m_cached = 0;
+    std::atomic<uint64_t> m_waits = 0;
+
+    std::mutex m_waitMutex;
+    std::condition_variable m_waitCv;
+    std::atomic<int> m_waiters = 0;
 };
@@ -52,6 +52,15 @@ class FalconPropertyKey : public PropertyKey {
     inline static const auto FALCON_MAX_OPEN_NUM =
         PropertyKey::Builder("main", "falcon_max_open_num", FALCON, FALCON_UINT).build();
 
+    inline static const auto FALCON_ATTR_CACHE_TTL_MS =
+        PropertyKey::Builder("main", "falcon_attr_cache_ttl_ms", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_ATTR_CACHE_NEGATIVE_TTL_MS =
+        PropertyKey::Builder("main", "falcon_attr_cache_negative_ttl_ms", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_ATTR_CACHE_MAX_MB =
+        PropertyKey::Builder("main", "falcon_attr_cache_max_mb", FALCON, FALCON_UINT).build();
+
     inline static const auto FALCON_PRE_BLOCKNUM =
         PropertyKey::Builder("main", "falcon_preblock_num", FALCON, FALCON_UINT).build();
 
@@ -67,6 +76,30 @@ class FalconPropertyKey : public PropertyKey {
     inline static const auto FALCON_TO_LOCAL =
         PropertyKey::Builder("main", "falcon_to_local", FALCON, FALCON_BOOL).build();
 
+    inline static const auto FALCON_PACKED_SMALL_FILE =
+        PropertyKey::Builder("main", "falcon_packed_small_file", FALCON, FALCON_BOOL).build();
+
+    inline static const auto FALCON_IO_ENGINE =
+        PropertyKey::Builder("main", "falcon_io_engine", FALCON, FALCON_STRING).build();
+
+    inline static const auto FALCON_READAHEAD_INIT_BLOCKS =
+        PropertyKey::Builder("main", "falcon_readahead_init_blocks", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_READAHEAD_MAX_BLOCKS =
+        PropertyKey::Builder("main", "falcon_readahead_max_blocks", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_READAHEAD_MEMORY =
+        PropertyKey::Builder("main", "falcon_readahead_memory", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_MIGRATE_BANDWIDTH =
+        PropertyKey::Builder("main", "falcon_migrate_bandwidth", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_MEM_POOL_LIMIT =
+        PropertyKey::Builder("main", "falcon_mem_pool_limit", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_MEM_POOL_HUGEPAGE =
+        PropertyKey::Builder("main", "falcon_mem_pool_hugepage", FALCON, FALCON_BOOL).build();
+
     inline static const auto FALCON_LOG_RESERVED_NUM =
         PropertyKey::Builder("main", "falcon_log_reserved_num", FALCON, FALCON_UINT).build();
 
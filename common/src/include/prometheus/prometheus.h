@@ -11,6 +11,7 @@
 #include <prometheus/exposer.h>
 
 #include "stats/falcon_stats.h"
+#include "buffer/mem_pool.h"
 #include "connection/node.h"
 #include "log/logging.h"
 #include "falcon_store/falcon_store.h"
@@ -54,6 +55,12 @@ int startPrometheusMonitor(const std::string &endpoint, std::stop_token stoken)
     auto &truncate_ops = ops.Add({{"category", "meta"}, {"name", "truncate-ops"}});
     auto &flush_ops = ops.Add({{"category", "meta"}, {"name", "flush-ops"}});
     auto &fsync_ops = ops.Add({{"category", "meta"}, {"name", "fsync-ops"}});
+    auto &readahead_hit_ops = ops.Add({{"category", "data"}, {"name", "readahead-hit-ops"}});
+    auto &readahead_miss_ops = ops.Add({{"category", "data"}, {"name", "readahead-miss-ops"}});
+    auto &migrate_ops = ops.Add({{"category", "blockcache"}, {"name", "migrate-ops"}});
+    auto &migrate_failed_ops = ops.Add({{"category", "blockcache"}, {"name", "migrate-failed-ops"}});
+    auto &attr_cache_hit_ops = ops.Add({{"category", "meta"}, {"name", "attr-cache-hit-ops"}});
+    auto &attr_cache_miss_ops = ops.Add({{"category", "meta"}, {"name", "attr-cache-miss-ops"}});
 
     // latency metrics
     auto &latency = prometheus::BuildGauge()
@@ -89,6 +96,7 @@ int startPrometheusMonitor(const std::string &endpoint, std::stop_token stoken)
     auto &blockcache_write_throughput = throughput.Add({{"category", "blockcache"}, {"name", "blockcache-write-throughput"}});
     auto &object_read_throughput = throughput.Add({{"category", "object"}, {"name", "object-read-throughput"}});
     auto &object_write_throughput = throughput.Add({{"category", "object"}, {"name", "object-write-throughput"}});
+    auto &migrate_throughput = throughput.Add({{"category", "blockcache"}, {"name", "migrate-throughput"}});
 
     // system status metrics
     auto &status = prometheus::BuildGauge()
@@ -96,6 +104,9 @@ int startPrometheusMonitor(const std::string &endpoint, std::stop_token stoken)
                            .Help("Current system status")
                            .Register(*registry);
     auto &current_fds = status.Add({{"category", "overall"}, {"name", "current-fds"}});
+    auto &mem_pool_used = status.Add({{"category", "overall"}, {"name", "mem-pool-used-blocks"}});
+    auto &mem_pool_total = status.Add({{"category", "overall"}, {"name", "mem-pool-total-blocks"}});
+    auto &mem_pool_hit_ratio = status.Add({{"category", "overall"}, {"name", "mem-pool-hit-ratio"}});
 
     // Register the gauge with the registry
     exposer.RegisterCollectable(registry);
@@ -128,6 +139,12 @@ int startPrometheusMonitor(const std::string &endpoint, std::stop_token stoken)
         truncate_ops.Set(currentStats[META_TRUNCATE]);
         flush_ops.Set(currentStats[META_FLUSH]);
         fsync_ops.Set(currentStats[META_FSYNC]);
+        readahead_hit_ops.Set(currentStats[READAHEAD_HIT]);
+        readahead_miss_ops.Set(currentStats[READAHEAD_MISS]);
+        migrate_ops.Set(currentStats[MIGRATE_FILES]);
+        migrate_failed_ops.Set(currentStats[MIGRATE_FAILED]);
+        attr_cache_hit_ops.Set(currentStats[ATTR_CACHE_HIT]);
+        attr_cache_miss_ops.Set(currentStats[ATTR_CACHE_MISS]);
 
         overall_latency.Set(averageMS(currentStats[FUSE_LAT], currentStats[FUSE_OPS]));
         read_latency.Set(averageMS(currentStats[FUSE_READ_LAT], currentStats[FUSE_READ_OPS]));
@@ -153,8 +170,14 @@ int startPrometheusMonitor(const std::string &endpoint, std::stop_token stoken)
         blockcache_write_throughput.Set(currentStats[BLOCKCACHE_WRITE]);
         object_read_throughput.Set(currentStats[OBJ_GET]);
         object_write_throughput.Set(currentStats[OBJ_PUT]);
+        migrate_throughput.Set(currentStats[MIGRATE_BYTES]);
 
         current_fds.Set(FalconFd::GetInstance()->GetCurrentOpenInstanceCount());
+        MemPoolStats poolStats = MemPool::GetInstance().GetStats();
+        mem_pool_used.Set(poolStats.usedBlocks);
+        mem_pool_total.Set(poolStats.totalBlocks);
+        uint64_t poolAllocs = poolStats.hits + poolStats.misses;
+        mem_pool_hit_ratio.Set(poolAllocs == 0 ? 0 : (double)poolStats.hits / poolAllocs);
     }
 
     return 0;
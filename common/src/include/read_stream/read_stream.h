@@ -7,12 +7,20 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
-#define QUEUE_SIZE 3
+/* defaults of the readahead tunables, see ReadStream::SetReadahead */
+#define READAHEAD_INIT_BLOCKS 2
+#define READAHEAD_MAX_BLOCKS 16
+#define READAHEAD_MEMORY_BUDGET (1024UL * 1024 * 1024)
+/* a jump of up to this many blocks from the read position keeps the window instead of restarting it */
+#define READAHEAD_JUMP_BLOCKS 2
+/* threads shared by all read streams that load readahead blocks, and the loads they queue at most */
+#define READAHEAD_LOADERS 16
+#define READAHEAD_LOADER_TASKS 4096
 
 struct OpenInstance;
 
@@ -22,6 +30,8 @@ class Pipe {
     void Init(size_t initSize, std::shared_ptr<char> initMem);
     ssize_t WaitPop(char *buf, size_t popSize, bool &end);
     ssize_t WaitPush(OpenInstance *openInstance, off_t offset);
+    void Assign(off_t blockOffset);
+    ssize_t WaitReadAt(char *buf, size_t readSize, off_t readOffset, off_t blockOffset);
     void Destroy();
 
     std::mutex mutex;
@@ -32,27 +42,75 @@ class Pipe {
     ssize_t size = 0;
     ssize_t index = 0;
     std::atomic<bool> stop = true;
+    /* file offset of the block assigned to the pipe, -1 if none */
+    off_t offset = -1;
+    /* data of the assigned block is in mem */
+    bool loaded = false;
+    /* a loader task owns the pipe, it loads whatever block is assigned until the pipe is loaded */
+    bool loading = false;
 };
 
+/*
+ * Readahead of a big file. The window is the range of blocks after the read position that are assigned round robin
+ * to pipes, assigned pipes are loaded by the READAHEAD_LOADERS threads shared by all streams, at most one load per
+ * pipe at a time. A reader waits for its block without holding the stream lock. Sequential reads grow the window
+ * up to READAHEAD_MAX_BLOCKS while the memory budget allows more pipes, the block before the read position stays
+ * loaded for small backward jumps. Jumps farther than READAHEAD_JUMP_BLOCKS restart the window at the new position
+ * and halve it.
+ */
 class ReadStream {
   public:
+    using FetchFunc = std::function<ssize_t(char *buf, off_t offset, size_t size)>;
+
+    static void SetReadahead(uint32_t initBlocks, uint32_t maxBlocks, uint64_t memoryBudget);
+
     bool Init(OpenInstance *instance, int blocks, size_t pipeSize);
+    bool Init(FetchFunc fetchFunc, int blocks, size_t pipeSize);
+    ssize_t Read(char *buf, size_t readSize, off_t offset);
     ssize_t WaitPop(char *buf, size_t popSize);
     void StartPushThreaded();
     void StopPushThreaded();
     void WaitPushEnded();
-
-    void addPipeIndex();
     ~ReadStream();
 
-    std::atomic<size_t> stopOffset = -1;
     size_t pipeCap = 0;
     int pipeIndex = 0;
     int fileBlocks = 0;
     OpenInstance *openInstance;
+    /* pipes holding a memory block, the window is at most pipeNum - 1 blocks */
     int pipeNum = 0;
-    Pipe pipes[QUEUE_SIZE];
+    int pipeMax = 0;
+    std::unique_ptr<Pipe[]> pipes;
     std::mutex pipeMutex;
     std::atomic<bool> stop = true;
-    std::vector<std::thread> threads;
+
+    /* consumer side, guarded by pipeMutex */
+    off_t readPos = 0;
+    int64_t headBlock = 0;
+    int64_t issuedEnd = 0;
+    int window = 0;
+    int seqBlocks = 0;
+
+  private:
+    void AllocPipes(int num);
+    void Load(int i);
+    void LoadPipe(int i);
+    int FindPipe(int64_t block);
+    void Issue();
+    void Advance(int64_t block);
+    void Reposition(int64_t block, bool shrink);
+
+    FetchFunc fetch;
+    bool pushing = false;
+    int lastIssuedPipe = -1;
+
+    /* loader tasks queued or running for the stream */
+    std::mutex loadMutex;
+    std::condition_variable loadCV;
+    int loads = 0;
+
+    static std::atomic<uint32_t> initBlocks;
+    static std::atomic<uint32_t> maxBlocks;
+    static std::atomic<uint64_t> memoryBudget;
+    static std::atomic<uint64_t> memoryUsed;
 };
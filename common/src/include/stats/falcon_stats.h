@@ -59,6 +59,13 @@ enum {
     BLOCKCACHE_WRITE,
     OBJ_GET,
     OBJ_PUT,
+    READAHEAD_HIT,
+    READAHEAD_MISS,
+    MIGRATE_FILES,
+    MIGRATE_BYTES,
+    MIGRATE_FAILED,
+    ATTR_CACHE_HIT,
+    ATTR_CACHE_MISS,
     STATS_END
 };
 
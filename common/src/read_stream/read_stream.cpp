@@ -6,6 +6,9 @@
 
 #include "buffer/open_instance.h"
 #include "falcon_store/falcon_store.h"
+#include "io_engine/io_engine.h"
+#include "stats/falcon_stats.h"
+#include "thread_pool/thread_pool.h"
 
 /*---------------------- Pipe ----------------------*/
 
@@ -22,6 +25,8 @@ bool Pipe::Init(size_t initSize)
         FALCON_LOG(LOG_ERROR) << "Pipe::Init(): malloc failed";
         return false;
     }
+    /* pipes are refilled block by block, the block stays registered with the io engine while the pool keeps it */
+    IoEngine::GetInstance().RegisterBuffer(mem.get(), initSize);
     capacity = initSize;
     size = initSize;
     index = initSize;
@@ -104,11 +109,52 @@ ssize_t Pipe::WaitPush(OpenInstance *openInstance, off_t offset)
 
     index = 0;
     size = readSize;
+    this->offset = offset;
+    loaded = true;
     readCV.notify_all();
 
     return readSize;
 }
 
+/*
+ * Called by the read stream to load the block at blockOffset into the pipe, drops what the pipe held.
+ */
+void Pipe::Assign(off_t blockOffset)
+{
+    std::unique_lock<std::mutex> xlock(mutex);
+    offset = blockOffset;
+    loaded = false;
+    size = 0;
+    index = 0;
+    writeCV.notify_all();
+}
+
+/*
+ * Wait for the block at blockOffset and copy data at readOffset of the file to buf, without consuming it.
+ * Returns -EAGAIN if the pipe was given another block meanwhile.
+ */
+ssize_t Pipe::WaitReadAt(char *buf, size_t readSize, off_t readOffset, off_t blockOffset)
+{
+    std::unique_lock<std::mutex> xlock(mutex);
+    readCV.wait(xlock, [this, blockOffset]() { return loaded || stop || offset != blockOffset; });
+    if (stop) {
+        return -ECANCELED;
+    }
+    if (offset != blockOffset) {
+        return -EAGAIN;
+    }
+    if (size < 0) {
+        return size;
+    }
+    off_t pos = readOffset - offset;
+    if (pos < 0 || pos >= size) {
+        return 0;
+    }
+    ssize_t copySize = std::min(readSize, (size_t)(size - pos));
+    (void)memcpy(buf, mem.get() + pos, copySize);
+    return copySize;
+}
+
 void Pipe::Destroy()
 {
     capacity = 0;
@@ -116,104 +162,339 @@ void Pipe::Destroy()
     index = 0;
     stop = true;
     mem = nullptr;
+    offset = -1;
+    loaded = false;
 }
 
 /*---------------------- ReadStream ----------------------*/
 
+std::atomic<uint32_t> ReadStream::initBlocks = READAHEAD_INIT_BLOCKS;
+std::atomic<uint32_t> ReadStream::maxBlocks = READAHEAD_MAX_BLOCKS;
+std::atomic<uint64_t> ReadStream::memoryBudget = READAHEAD_MEMORY_BUDGET;
+std::atomic<uint64_t> ReadStream::memoryUsed = 0;
+
+static ThreadPool &Loaders()
+{
+    static std::unique_ptr<ThreadPool> loaders = []() {
+        auto pool = ThreadPool::CreateThreadPool(READAHEAD_LOADERS, READAHEAD_LOADER_TASKS, "readahead");
+        if (pool->Start() != 0) {
+            FALCON_LOG(LOG_ERROR) << "ReadStream: start readahead loaders failed";
+        }
+        return pool;
+    }();
+    return *loaders;
+}
+
+/*
+ * Set the initial and max window in blocks, and the memory all read streams may hold for readahead.
+ */
+void ReadStream::SetReadahead(uint32_t initNum, uint32_t maxNum, uint64_t budget)
+{
+    maxBlocks = std::max(maxNum, 1U);
+    initBlocks = std::clamp(initNum, 1U, maxBlocks.load());
+    memoryBudget = budget;
+}
+
 /*
  * Init pipes under stream.
  */
 bool ReadStream::Init(OpenInstance *instance, int blocks, size_t pipeSize)
+{
+    openInstance = instance;
+    FetchFunc fetchFunc = [instance](char *buf, off_t offset, size_t size) {
+        return FalconStore::GetInstance()->ReadFileLR(buf, offset, instance, size);
+    };
+    return Init(fetchFunc, blocks, pipeSize);
+}
+
+bool ReadStream::Init(FetchFunc fetchFunc, int blocks, size_t pipeSize)
 {
     std::unique_lock<std::mutex> xlock(pipeMutex);
+    if (pipes != nullptr) {
+        return !stop;
+    }
 
-    openInstance = instance;
+    fetch = fetchFunc;
     fileBlocks = blocks;
-    pipeNum = std::min(blocks, QUEUE_SIZE);
     pipeCap = pipeSize;
+    pipeMax = std::min<int>(maxBlocks.load(), blocks) + 1;
+    pipes = std::make_unique<Pipe[]>(pipeMax);
+    pipeNum = 0;
+    pipeIndex = 0;
+    readPos = 0;
+    headBlock = 0;
+    issuedEnd = 0;
+    seqBlocks = 0;
+    lastIssuedPipe = -1;
     stop = false;
 
-    std::function<void(char *)> freeFunc = [](char *ptr) { MemPool::GetInstance().free(ptr); };
-    std::vector<void *> mem = MemPool::GetInstance().calloc(pipeNum);
-    if (mem.empty()) {
-        FALCON_LOG(LOG_ERROR) << "ReadStream::Init: calloc mem failed";
+    AllocPipes(initBlocks.load() + 1);
+    if (pipeNum < 2) {
+        FALCON_LOG(LOG_WARNING) << "ReadStream::Init: no memory for readahead pipes";
+        pipes = nullptr;
+        pipeNum = 0;
+        stop = true;
         return false;
     }
+    window = std::min<int>(initBlocks.load(), pipeNum - 1);
+    return true;
+}
+
+/*
+ * Give memory blocks to pipes until num pipes have one, as far as the memory budget allows.
+ */
+void ReadStream::AllocPipes(int num)
+{
+    num = std::min(num, pipeMax);
+    size_t cap = pipeCap;
+    std::function<void(char *)> freeFunc = [cap](char *ptr) {
+        MemPool::GetInstance().free(ptr);
+        memoryUsed -= cap;
+    };
+    while (pipeNum < num) {
+        if (memoryUsed.fetch_add(cap) + cap > memoryBudget.load()) {
+            memoryUsed -= cap;
+            break;
+        }
+        /* readahead is optional, it never waits for blocks held by other readers */
+        void *mem = MemPool::GetInstance().alloc(false);
+        if (mem == nullptr) {
+            memoryUsed -= cap;
+            break;
+        }
+        IoEngine::GetInstance().RegisterBuffer(mem, cap);
+        pipes[pipeNum].Init(cap, std::shared_ptr<char>((char *)mem, freeFunc));
+        ++pipeNum;
+    }
+}
+
+/*
+ * Queue a load of pipe i on the readahead loaders unless one is queued or running already.
+ */
+void ReadStream::Load(int i)
+{
+    {
+        std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
+        if (pipes[i].loading) {
+            return;
+        }
+        pipes[i].loading = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        ++loads;
+    }
+    Loaders().Submit({.taskName = "", .task = [this, i]() {
+        LoadPipe(i);
+        std::lock_guard<std::mutex> lock(loadMutex);
+        if (--loads == 0) {
+            loadCV.notify_all();
+        }
+    }});
+}
+
+/*
+ * Loader task of pipe i, loads the assigned block, and the next one if the pipe is reassigned while loading.
+ */
+void ReadStream::LoadPipe(int i)
+{
+    Pipe &pipe = pipes[i];
+    std::unique_lock<std::mutex> xlock(pipe.mutex);
+    while (!pipe.stop && pipe.offset >= 0 && !pipe.loaded) {
+        off_t blockOffset = pipe.offset;
+        std::shared_ptr<char> mem = pipe.mem;
+        size_t capacity = pipe.capacity;
+        xlock.unlock();
+        ssize_t readSize = fetch(mem.get(), blockOffset, capacity);
+        xlock.lock();
+        if (pipe.stop || pipe.offset != blockOffset || pipe.loaded) {
+            /* stopped, or assigned another block while loading */
+            continue;
+        }
+        if (readSize < 0) {
+            FALCON_LOG(LOG_ERROR) << "ReadStream loader: fetch block at " << blockOffset << " failed";
+        }
+        pipe.size = readSize;
+        pipe.index = 0;
+        pipe.loaded = true;
+    }
+    pipe.loading = false;
+    /* loaded, or no data will be loaded to the pipe later, wake up reader */
+    pipe.readCV.notify_all();
+}
+
+int ReadStream::FindPipe(int64_t block)
+{
+    off_t blockOffset = block * pipeCap;
     for (int i = 0; i < pipeNum; i++) {
-        pipes[i].Init(pipeCap, std::shared_ptr<char>((char *)mem[i], freeFunc));
+        std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
+        if (pipes[i].offset == blockOffset) {
+            return i;
+        }
     }
+    return -1;
+}
 
-    return true;
+/*
+ * Assign the blocks of the window that are not in a pipe yet, keeping the block before the read position.
+ */
+void ReadStream::Issue()
+{
+    while (issuedEnd < headBlock + window && issuedEnd < fileBlocks) {
+        if (FindPipe(issuedEnd) < 0) {
+            int target = -1;
+            for (int n = 1; n <= pipeNum && target < 0; n++) {
+                int i = (lastIssuedPipe + n) % pipeNum;
+                std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
+                int64_t block = pipes[i].offset / (off_t)pipeCap;
+                if (pipes[i].offset < 0 || block < headBlock - 1 || block >= issuedEnd) {
+                    target = i;
+                }
+            }
+            if (target < 0) {
+                break;
+            }
+            pipes[target].Assign(issuedEnd * pipeCap);
+            Load(target);
+            lastIssuedPipe = target;
+        }
+        ++issuedEnd;
+    }
+}
+
+/*
+ * Read position moved forward to block inside the window, grow the window on sustained sequential reads.
+ */
+void ReadStream::Advance(int64_t block)
+{
+    if (block <= headBlock) {
+        return;
+    }
+    seqBlocks += block - headBlock;
+    headBlock = block;
+    if (seqBlocks >= window && window < (int)maxBlocks.load()) {
+        seqBlocks = 0;
+        AllocPipes(std::min<int>(window * 2, maxBlocks.load()) + 1);
+        window = std::min<int>(window * 2, pipeNum - 1);
+    }
+    Issue();
+}
+
+/*
+ * Restart the window at block after a jump, dropping what was issued ahead of the old position.
+ */
+void ReadStream::Reposition(int64_t block, bool shrink)
+{
+    if (shrink) {
+        window = std::max(window / 2, 1);
+    }
+    seqBlocks = 0;
+    headBlock = block;
+    issuedEnd = block;
+    Issue();
 }
 
 /*
  * Called by user.
- * Wait for data to be popped to buf.
- * If current pipe gives out less data than wanted, loop to read next pipe.
+ * Read data at offset from the pipes, a read outside the window repositions it.
  */
-ssize_t ReadStream::WaitPop(char *buf, size_t popSize)
+ssize_t ReadStream::Read(char *buf, size_t readSize, off_t offset)
 {
     std::unique_lock<std::mutex> xlock(pipeMutex);
+    if (stop || !pushing) {
+        return -ECANCELED;
+    }
+
+    int64_t block = offset / pipeCap;
+    if (block >= fileBlocks) {
+        return 0;
+    }
+    if (block >= headBlock - 1 && block < issuedEnd) {
+        FalconStats::GetInstance().stats[READAHEAD_HIT]++;
+        Advance(block);
+    } else {
+        FalconStats::GetInstance().stats[READAHEAD_MISS]++;
+        bool nearby = block >= headBlock - READAHEAD_JUMP_BLOCKS && block < issuedEnd + READAHEAD_JUMP_BLOCKS;
+        Reposition(block, !nearby);
+    }
 
-    ssize_t readSize = 0;
-    ssize_t curSize = 0;
-    while (!stop && (size_t)readSize != popSize) {
-        bool isEnd = false;
-        curSize = pipes[pipeIndex].WaitPop(buf + readSize, popSize - readSize, isEnd);
-        if (isEnd) {
-            /* next pipe */
-            addPipeIndex();
+    ssize_t readDone = 0;
+    while ((size_t)readDone < readSize && !stop) {
+        off_t pos = offset + readDone;
+        block = pos / pipeCap;
+        if (block >= fileBlocks) {
+            break;
+        }
+        Advance(block);
+        int i = FindPipe(block);
+        if (i < 0) {
+            /* window starved of pipes, restart it here */
+            Reposition(block, true);
+            i = FindPipe(block);
+            if (i < 0) {
+                return readDone > 0 ? readDone : -ECANCELED;
+            }
+        }
+        /* wait for the block without the stream lock, so a stop is not held up by a slow load */
+        xlock.unlock();
+        ssize_t curSize = pipes[i].WaitReadAt(buf + readDone, readSize - readDone, pos, block * pipeCap);
+        xlock.lock();
+        if (curSize == -EAGAIN) {
+            continue;
         }
         if (curSize < 0) {
             /* error */
-            return curSize;
+            return readDone > 0 ? readDone : curSize;
         }
         if (curSize == 0) {
             /* read to end */
             break;
         }
-        readSize += curSize;
+        readDone += curSize;
     }
-
-    return readSize;
+    readPos = offset + readDone;
+    /* a fully read block is released right away */
+    if (readPos % pipeCap == 0) {
+        Advance(readPos / pipeCap);
+    }
+    int i = FindPipe(headBlock);
+    if (i >= 0) {
+        pipeIndex = i;
+    }
+    return readDone;
 }
 
 /*
- * Switch the pipe that gives out data to next one
+ * Called by user.
+ * Wait for data of popSize at the read position of the stream.
  */
-void ReadStream::addPipeIndex() { pipeIndex = (pipeIndex + 1) % pipeNum; }
+ssize_t ReadStream::WaitPop(char *buf, size_t popSize)
+{
+    off_t offset = 0;
+    {
+        std::unique_lock<std::mutex> xlock(pipeMutex);
+        offset = readPos;
+    }
+    return Read(buf, popSize, offset);
+}
 
 /*
  * Called by user.
- * Start max of threadNum and pipeNum number of threads to concurrently fills in the pipes.
+ * Issue the first window to the loaders.
  */
 void ReadStream::StartPushThreaded()
 {
     std::unique_lock<std::mutex> xlock(pipeMutex);
-    for (int i = 0; i < pipeNum; i++) {
-        threads.emplace_back([=, this]() {
-            size_t offset = i * pipeCap;
-            while (!stop.load() && offset < stopOffset) {
-                ssize_t retSize = pipes[i].WaitPush(openInstance, offset);
-                if (retSize != (ssize_t)pipes[i].capacity) {
-                    /* Read data not equals capacity, means error or read end. Mark end for other reading threads */
-                    /* stopOffset will be small than offset for other threads because pipes are popped in order */
-                    stopOffset = offset;
-                    break;
-                }
-                offset += pipeNum * pipeCap;
-            }
-            /* no data will be pushed to pipe later, wake up reader */
-            pipes[i].stop = true;
-            pipes[i].readCV.notify_all();
-        });
+    if (pushing || stop) {
+        return;
     }
+    pushing = true;
+    Issue();
 }
 
 /*
  * Called by user.
- * Stop all threads pushing the pipes started by StartPushThreaded.
- * Deallocate all memory of pipe.
+ * Stop loading the pipes, loads in flight end on their own. Deallocate all memory of pipe.
  */
 void ReadStream::StopPushThreaded()
 {
@@ -223,30 +504,25 @@ void ReadStream::StopPushThreaded()
         std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
         pipes[i].Destroy();
         pipes[i].writeCV.notify_all();
+        pipes[i].readCV.notify_all();
     }
 }
 
 void ReadStream::WaitPushEnded()
 {
-    for (auto &th : threads) {
-        if (th.joinable()) {
-            th.join();
-        }
-    }
+    std::unique_lock<std::mutex> xlock(loadMutex);
+    loadCV.wait(xlock, [this]() { return loads == 0; });
 }
 
 /*
- * Wait for all threads pushing to join
+ * Wait for the loads of the stream to end
  */
 ReadStream::~ReadStream()
 {
     for (int i = 0; i < pipeNum; i++) {
+        std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
         pipes[i].stop = true;
         pipes[i].writeCV.notify_all();
     }
-    for (auto &th : threads) {
-        if (th.joinable()) {
-            th.join();
-        }
-    }
+    WaitPushEnded();
 }
@@ -10,6 +10,7 @@
 #include <iomanip>
 #include <string>
 
+#include "buffer/mem_pool.h"
 #include "log/logging.h"
 
 void FalconStats::storeStatforGet(std::stop_token stoken)
@@ -156,6 +157,32 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
         outFile << "  Gets: " << currentStats[OBJ_GET] << "\n";
         outFile << "  Puts: " << currentStats[OBJ_PUT] << "\n";
 
+        outFile << "\nReadahead:\n";
+        outFile << "  Hits: " << currentStats[READAHEAD_HIT] << "\n";
+        outFile << "  Misses: " << currentStats[READAHEAD_MISS] << "\n";
+
+        outFile << "\nCache Migration:\n";
+        outFile << "  Files: " << currentStats[MIGRATE_FILES] << "\n";
+        outFile << "  Bytes: " << formatU64(currentStats[MIGRATE_BYTES]) << "\n";
+        outFile << "  Failed: " << currentStats[MIGRATE_FAILED] << "\n";
+
+        outFile << "\nAttribute Cache:\n";
+        outFile << "  Hits: " << currentStats[ATTR_CACHE_HIT] << "\n";
+        outFile << "  Misses: " << currentStats[ATTR_CACHE_MISS] << "\n";
+
+        /* pool counters are totals since start, occupancy is the current state */
+        MemPoolStats poolStats = MemPool::GetInstance().GetStats();
+        outFile << "\nMemory Pool:\n";
+        outFile << "  Used Blocks: " << poolStats.usedBlocks << "/" << poolStats.totalBlocks;
+        if (poolStats.maxBlocks != 0) {
+            outFile << " (limit " << poolStats.maxBlocks << ")";
+        }
+        outFile << "\n";
+        outFile << "  Block Size: " << formatU64(poolStats.blockSize) << "\n";
+        outFile << "  Hits: " << poolStats.hits << "\n";
+        outFile << "  Misses: " << poolStats.misses << "\n";
+        outFile << "  Waits: " << poolStats.waits << "\n";
+
         outFile.close();
         {
             std::unique_lock lock(mtx);
@@ -199,6 +226,13 @@ std::vector<std::string> convertStatstoString(const std::vector<size_t> &stats)
     stringStats[BLOCKCACHE_WRITE] = formatU64(stats[BLOCKCACHE_WRITE]);
     stringStats[OBJ_GET] = formatU64(stats[OBJ_GET]);
     stringStats[OBJ_PUT] = formatU64(stats[OBJ_PUT]);
+    stringStats[READAHEAD_HIT] = formatOp(stats[READAHEAD_HIT]);
+    stringStats[READAHEAD_MISS] = formatOp(stats[READAHEAD_MISS]);
+    stringStats[MIGRATE_FILES] = formatOp(stats[MIGRATE_FILES]);
+    stringStats[MIGRATE_BYTES] = formatU64(stats[MIGRATE_BYTES]);
+    stringStats[MIGRATE_FAILED] = formatOp(stats[MIGRATE_FAILED]);
+    stringStats[ATTR_CACHE_HIT] = formatOp(stats[ATTR_CACHE_HIT]);
+    stringStats[ATTR_CACHE_MISS] = formatOp(stats[ATTR_CACHE_MISS]);
 
     return stringStats;
 }
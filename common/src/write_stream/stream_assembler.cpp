@@ -5,6 +5,7 @@
 #include "write_stream/stream_assembler.h"
 
 #include "disk_cache/disk_cache.h"
+#include "io_engine/io_engine.h"
 #include "stats/falcon_stats.h"
 
 MemPool FixMemory::writeMemPool(FALCON_STORE_STREAM_MAX_SIZE, 500);
@@ -15,22 +16,9 @@ int WriteStream::Push(FalconWriteBuffer buf, off_t offset, uint64_t currentSize)
         return 0;
     }
 
-    /* align the buffer if write to loacl */
+    /* write to local directly, the io engine aligns the buffer for O_DIRECT */
     if (client == nullptr) {
-        if (!direct) {
-            return PersistToFile(buf.ptr, buf.size, offset, currentSize);
-        } else {
-            int alignedNum = buf.size / 512 + static_cast<int>(buf.size % 512 != 0);
-            char *alignedBuf = (char *)aligned_alloc(512, 512 * alignedNum);
-            if (alignedBuf == nullptr) {
-                FALCON_LOG(LOG_ERROR) << "aligned_alloc failed: " << strerror(errno);
-                return -ENOMEM;
-            }
-            (void)memcpy(alignedBuf, buf.ptr, buf.size);
-            int ret = PersistToFile(alignedBuf, buf.size, offset, currentSize);
-            free(alignedBuf);
-            return ret;
-        }
+        return PersistToFile(buf.ptr, buf.size, offset, currentSize);
     }
 
     std::unique_lock<std::shared_mutex> xlock(mutex);
@@ -98,10 +86,10 @@ int WriteStream::PersistToFile(const char *buf, size_t size, off_t offset, uint6
             return -ENOSPC;
         }
         FalconStats::GetInstance().stats[BLOCKCACHE_WRITE] += size;
-        retSize = pwrite(physicalFd, buf, size, offset);
+        retSize = IoEngine::GetInstance().Write(physicalFd, buf, size, offset, direct);
         if (retSize < 0) {
-            int err = errno;
-            FALCON_LOG(LOG_ERROR) << "In WriteStream::persistToFile(): pwrite failed" << strerror(err);
+            int err = -retSize;
+            FALCON_LOG(LOG_ERROR) << "In WriteStream::persistToFile(): write failed" << strerror(err);
             DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
             return -err;
         }
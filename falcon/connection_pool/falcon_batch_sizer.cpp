@@ -0,0 +1,181 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "connection_pool/falcon_batch_sizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "connection_pool/falcon_batch_service_def.h"
+
+void BatchSizer::Configure(int64_t sloNs, int64_t maxLingerNs, int maxBatch, int connNum)
+{
+    std::lock_guard<std::mutex> lock(m_modelMutex);
+    m_sloNs = std::max<int64_t>(sloNs, 0);
+    m_maxLingerNs = std::max<int64_t>(maxLingerNs, 0);
+    m_maxBatch = std::max(maxBatch, 1);
+    m_connNum = std::max(connNum, 1);
+    m_lingerStartNs = 0;
+    m_arrivalPerNs = 0;
+    m_rateSampleNs = 0;
+    m_rateSampleEnqueued = 0;
+    m_inflight = 0;
+    m_modelValid = false;
+}
+
+void BatchSizer::Complete(int jobNum, int64_t durationNs)
+{
+    m_inflight--;
+    if (jobNum <= 0 || durationNs <= 0) {
+        return;
+    }
+    double x = jobNum;
+    double y = durationNs;
+    std::lock_guard<std::mutex> lock(m_modelMutex);
+    if (!m_modelValid) {
+        m_meanJobs = x;
+        m_meanNs = y;
+        m_meanJobs2 = x * x;
+        m_meanJobsNs = x * y;
+        m_modelValid = true;
+        return;
+    }
+    double w = BATCH_SIZER_EWMA_WEIGHT;
+    m_meanJobs += w * (x - m_meanJobs);
+    m_meanNs += w * (y - m_meanNs);
+    m_meanJobs2 += w * (x * x - m_meanJobs2);
+    m_meanJobsNs += w * (x * y - m_meanJobsNs);
+}
+
+void BatchSizer::Estimate(double &fixedNs, double &perJobNs)
+{
+    std::lock_guard<std::mutex> lock(m_modelMutex);
+    fixedNs = 0;
+    perJobNs = 0;
+    if (!m_modelValid) {
+        return;
+    }
+    double variance = m_meanJobs2 - m_meanJobs * m_meanJobs;
+    // batch sizes barely varied, the split of fixed and per job cost is unknown, charge it all per job
+    if (variance < 0.25) {
+        perJobNs = m_meanNs / m_meanJobs;
+        return;
+    }
+    perJobNs = (m_meanJobsNs - m_meanJobs * m_meanNs) / variance;
+    fixedNs = m_meanNs - perJobNs * m_meanJobs;
+    if (perJobNs < 0) {
+        // bigger batches did not take longer
+        perJobNs = 0;
+        fixedNs = m_meanNs;
+    } else if (fixedNs < 0) {
+        perJobNs = m_meanNs / m_meanJobs;
+        fixedNs = 0;
+    }
+}
+
+int BatchSizer::TargetSize(int queueSize, double fixedNs, double perJobNs)
+{
+    int target = m_maxBatch;
+    if (perJobNs > 0) {
+        double fit = (m_sloNs - fixedNs) / perJobNs;
+        target = (int)std::clamp(fit, 1.0, (double)m_maxBatch);
+    }
+    // the backlog is over the SLO anyway, fewer bigger batches drain it sooner
+    int spread = (queueSize + m_connNum - 1) / m_connNum;
+    return std::max(target, std::min(spread, m_maxBatch));
+}
+
+BatchDecision BatchSizer::Decide(int queueSize, uint64_t enqueued, int idleConnNum, int64_t nowNs)
+{
+    BatchDecision decision;
+    if (m_sloNs == 0) {
+        decision.batchSize = std::min(queueSize, m_maxBatch);
+        decision.targetSize = m_maxBatch;
+        return decision;
+    }
+
+    if (m_rateSampleNs == 0) {
+        m_rateSampleNs = nowNs;
+        m_rateSampleEnqueued = enqueued;
+    } else if (nowNs - m_rateSampleNs >= BATCH_SIZER_RATE_WINDOW_NS) {
+        double sample = (double)(enqueued - m_rateSampleEnqueued) / (nowNs - m_rateSampleNs);
+        m_arrivalPerNs += BATCH_SIZER_EWMA_WEIGHT * (sample - m_arrivalPerNs);
+        m_rateSampleNs = nowNs;
+        m_rateSampleEnqueued = enqueued;
+    }
+
+    double fixedNs = 0;
+    double perJobNs = 0;
+    Estimate(fixedNs, perJobNs);
+    int target = TargetSize(queueSize, fixedNs, perJobNs);
+    decision.targetSize = target;
+
+    bool busy = idleConnNum > 0 && idleConnNum * 2 <= m_connNum;
+    bool linger = queueSize < target && busy && m_maxLingerNs > 0 && perJobNs > 0 && m_inflight > 0;
+    if (linger) {
+        if (m_lingerStartNs == 0) {
+            m_lingerStartNs = nowNs;
+        }
+        int64_t budget = std::min<int64_t>(m_maxLingerNs, m_sloNs - (int64_t)(fixedNs + perJobNs * target));
+        int64_t deadline = m_lingerStartNs + budget;
+        if (deadline - nowNs >= BATCH_SIZER_MIN_LINGER_NS && m_arrivalPerNs * (deadline - nowNs) >= 1.0) {
+            decision.lingerUntilNs = deadline;
+            return decision;
+        }
+    }
+
+    decision.batchSize = std::min(queueSize, target);
+    if (m_lingerStartNs != 0) {
+        decision.lingeredNs = nowNs - m_lingerStartNs;
+        m_lingerStartNs = 0;
+    }
+    return decision;
+}
+
+void ParseBatchLatencySloOverride(const char *spec, int64_t *sloUs, int typeNum)
+{
+    static const char *typeNames[] = {"mkdir", "create", "stat", "unlink", "open", "close",
+                                      "kv_put", "kv_get", "kv_del", "slice_put", "slice_get", "slice_del"};
+    static_assert(sizeof(typeNames) / sizeof(typeNames[0]) == (size_t)FalconBatchServiceType::NOT_SUPPORT);
+    if (spec == nullptr) {
+        return;
+    }
+    std::string rest(spec);
+    size_t pos = 0;
+    while (pos < rest.size()) {
+        size_t end = rest.find(',', pos);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+        std::string item = rest.substr(pos, end - pos);
+        pos = end + 1;
+        item.erase(std::remove_if(item.begin(), item.end(), ::isspace), item.end());
+        size_t eq = item.find('=');
+        if (item.empty()) {
+            continue;
+        }
+        if (eq == std::string::npos) {
+            std::cout << "batch_latency_slo_override: no value for " << item << std::endl;
+            continue;
+        }
+        std::string name = item.substr(0, eq);
+        char *valueEnd = nullptr;
+        long long value = strtoll(item.c_str() + eq + 1, &valueEnd, 10);
+        if (valueEnd == item.c_str() + eq + 1 || *valueEnd != '\0' || value < 0) {
+            std::cout << "batch_latency_slo_override: bad value for " << name << std::endl;
+            continue;
+        }
+        int type = 0;
+        while (type < typeNum && type < (int)FalconBatchServiceType::NOT_SUPPORT && name != typeNames[type]) {
+            ++type;
+        }
+        if (type == typeNum || type == (int)FalconBatchServiceType::NOT_SUPPORT) {
+            std::cout << "batch_latency_slo_override: unknown type " << name << std::endl;
+            continue;
+        }
+        sloUs[type] = value;
+    }
+}
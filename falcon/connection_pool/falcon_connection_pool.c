@@ -36,6 +36,12 @@ int FalconConnectionPoolBatchSize = FALCON_CONNECTION_POOL_BATCH_SIZE_DEFAULT;
 int FalconConnectionPoolWaitAdjust = FALCON_CONNECTION_POOL_WAIT_ADJUST_DEFAULT;
 int FalconConnectionPoolWaitMin = FALCON_CONNECTION_POOL_WAIT_MIN_DEFAULT;
 int FalconConnectionPoolWaitMax = FALCON_CONNECTION_POOL_WAIT_MAX_DEFAULT;
+int FalconConnectionPoolDispatcherNum = FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT;
+int FalconConnectionPoolBatchLatencySlo = FALCON_CONNECTION_POOL_BATCH_LATENCY_SLO_DEFAULT;
+char *FalconConnectionPoolBatchLatencySloOverride = NULL;
+int FalconConnectionPoolBatchLingerMax = FALCON_CONNECTION_POOL_BATCH_LINGER_MAX_DEFAULT;
+int FalconConnectionPoolPipelineDepth = FALCON_CONNECTION_POOL_PIPELINE_DEPTH_DEFAULT;
+int FalconConnectionPoolShedQueueDepth = FALCON_CONNECTION_POOL_SHED_QUEUE_DEPTH_DEFAULT;
 uint64_t FalconConnectionPoolShmemSize = FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT;
 
 // communication plugin path, using global variable for shared to worker process
@@ -261,9 +267,7 @@ void FalconConnectionPoolShmemInit(void)
     }
 
     if (!initialized) {
-        memset(allocator->signatureCounter,
-               0,
-               sizeof(PaddedAtomic64) * (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT + allocator->pageCount));
+        FalconShmemAllocatorReset(allocator);
     }
 }
 
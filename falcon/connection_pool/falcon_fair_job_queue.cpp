@@ -0,0 +1,71 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "connection_pool/falcon_fair_job_queue.h"
+
+static const int FairJobQueueWeights[FALCON_PRIORITY_NUM] = FAIR_JOB_QUEUE_WEIGHTS;
+
+void FairJobQueue::Push(BaseMetaServiceJob *job)
+{
+    PriorityClass &priorityClass = m_classes[job->priority];
+    std::deque<BaseMetaServiceJob *> &jobs = priorityClass.tenantJobs[job->tenantId];
+    if (jobs.empty()) {
+        priorityClass.tenantTurns.push_back(job->tenantId);
+    }
+    jobs.push_back(job);
+    priorityClass.size++;
+    m_size++;
+}
+
+BaseMetaServiceJob *FairJobQueue::PopFrom(PriorityClass &priorityClass)
+{
+    uint64_t tenantId = priorityClass.tenantTurns.front();
+    priorityClass.tenantTurns.pop_front();
+    auto it = priorityClass.tenantJobs.find(tenantId);
+    BaseMetaServiceJob *job = it->second.front();
+    it->second.pop_front();
+    if (it->second.empty()) {
+        // clients come and go, only the ones with waiting jobs are kept
+        priorityClass.tenantJobs.erase(it);
+    } else {
+        priorityClass.tenantTurns.push_back(tenantId);
+    }
+    priorityClass.size--;
+    priorityClass.credit--;
+    m_size--;
+    return job;
+}
+
+size_t FairJobQueue::Pop(size_t maxJobs, std::vector<BaseMetaServiceJob *> &jobs)
+{
+    size_t popped = 0;
+    while (popped < maxJobs && m_size > 0) {
+        PriorityClass *next = nullptr;
+        for (auto &priorityClass : m_classes) {
+            if (priorityClass.size > 0 && priorityClass.credit > 0) {
+                next = &priorityClass;
+                break;
+            }
+        }
+        if (next == nullptr) {
+            for (int i = 0; i < FALCON_PRIORITY_NUM; ++i) {
+                m_classes[i].credit = FairJobQueueWeights[i];
+            }
+            continue;
+        }
+        jobs.push_back(PopFrom(*next));
+        popped++;
+    }
+    return popped;
+}
+
+FalconRequestPriority FairJobQueue::TopPriority() const
+{
+    for (int i = 0; i < FALCON_PRIORITY_NUM; ++i) {
+        if (m_classes[i].size > 0) {
+            return (FalconRequestPriority)i;
+        }
+    }
+    return FALCON_PRIORITY_NUM;
+}
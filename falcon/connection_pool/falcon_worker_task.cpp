@@ -2,6 +2,9 @@
  * SPDX-License-Identifier: MulanPSL-2.0
  */
 #include "connection_pool/falcon_worker_task.h"
+#include <arpa/inet.h>
+#include <endian.h>
+#include <memory>
 #include <sstream>
 #include "falcon_meta_param_generated.h"
 #include "falcon_meta_response_generated.h"
@@ -14,6 +17,35 @@ extern "C" {
 #include "utils/utils_standalone.h"
 }
 
+// prepared by falcon_prepare_commands() on every pool connection
+#define META_CALL_SHMEM_STATEMENT "cs_meta_call_shmem"
+
+/*
+ * Call falcon_meta_call_by_serialized_shmem_internal through the statement prepared for it, the backend skips
+ * parse and plan of every call. Parameters go in binary, the reply shift comes back as text.
+ */
+static int SendMetaCallShmem(PGconn *conn,
+                             int32_t type,
+                             int32_t count,
+                             int64_t paramShift,
+                             int64_t signature,
+                             int64_t statIndicesShift)
+{
+    int32_t typeParam = htonl(type);
+    int32_t countParam = htonl(count);
+    int64_t paramShiftParam = htobe64(paramShift);
+    int64_t signatureParam = htobe64(signature);
+    int64_t statIndicesShiftParam = htobe64(statIndicesShift);
+    const char *const paramValues[5] = {(char *)&typeParam,
+                                        (char *)&countParam,
+                                        (char *)&paramShiftParam,
+                                        (char *)&signatureParam,
+                                        (char *)&statIndicesShiftParam};
+    const int paramLengths[5] = {sizeof(int32_t), sizeof(int32_t), sizeof(int64_t), sizeof(int64_t), sizeof(int64_t)};
+    const int paramFormats[5] = {1, 1, 1, 1, 1};
+    return PQsendQueryPrepared(conn, META_CALL_SHMEM_STATEMENT, 5, paramValues, paramLengths, paramFormats, 0);
+}
+
 /*
  * RAII guard: releases a per-request stat slot on abnormal exit.
  *
@@ -81,6 +113,13 @@ public:
             m_shift = 0;
         }
     }
+    // hand the block over to the caller without freeing it
+    uint64_t detach()
+    {
+        uint64_t shift = m_shift;
+        m_shift = 0;
+        return shift;
+    }
 
     ShmemAllocGuard(const ShmemAllocGuard &) = delete;
     ShmemAllocGuard &operator=(const ShmemAllocGuard &) = delete;
@@ -90,6 +129,21 @@ private:
     uint64_t m_shift;
 };
 
+/*
+ * Take the block over from the guard for replies sent straight out of shmem. Every response handed to a job keeps a
+ * copy of the reference in its deleter, the block is freed once the comm plugin released the last of them.
+ */
+static std::shared_ptr<char> ShareShmemBlock(FalconShmemAllocator *allocator, ShmemAllocGuard &guard, char *pointer)
+{
+    uint64_t shift = guard.detach();
+    return std::shared_ptr<char>(pointer, [allocator, shift](char *) { FalconShmemAllocatorFree(allocator, shift); });
+}
+
+static BaseMetaServiceJob::FalDataDeleter ShmemBlockDeleter(const std::shared_ptr<char> &block)
+{
+    return [block](void *) mutable { block.reset(); };
+}
+
 /*
  * RAII guard: PQclear()s a single PGresult on scope exit.
  */
@@ -154,8 +208,8 @@ void SingleWorkerTask::DoWork(PGconn *conn,
     ShmemAllocGuard paramGuard(m_allocator, sharedParamDataAddrShift);
     if (sharedParamDataAddrShift == 0) {
         printf("Shmem of connection pool is exhausted, requestParamSize: %zu. There may be "
-               "several reasons, 1) shmem size is too small, 2) allocate too much memory "
-               "once exceed FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE.",
+               "several reasons, 1) shmem size is too small, 2) the request is larger than "
+               "the whole shmem.",
                requestParamSize);
         fflush(stdout);
         throw std::runtime_error("memory exceed limit.");
@@ -185,6 +239,10 @@ void SingleWorkerTask::DoWork(PGconn *conn,
     std::stringstream toSendCommand;
     std::vector<bool> isPlainCommand;
     std::vector<int64_t> signatureList;
+    // the last meta call, sent through the prepared statement when it is the whole request
+    FalconMetaServiceType metaCallType = FalconMetaServiceType::PLAIN_COMMAND;
+    int metaCallCount = 0;
+    int64_t metaCallParamShift = 0;
     int i = 0;
     uint64_t currentParamSegment = 0;
     while (i < requestServiceCount) {
@@ -221,6 +279,9 @@ void SingleWorkerTask::DoWork(PGconn *conn,
             toSendCommand << "select falcon_meta_call_by_serialized_shmem_internal(" << serviceType << ", "
                           << currentParamSegmentCount << ", " << sharedParamDataAddrShift + currentParamSegment << ", "
                           << signatureList.back() << ", " << (int64_t)statIndicesShift << ");";
+            metaCallType = serviceType;
+            metaCallCount = currentParamSegmentCount;
+            metaCallParamShift = (int64_t)(sharedParamDataAddrShift + currentParamSegment);
 
             isPlainCommand.push_back(false);
         }
@@ -231,7 +292,18 @@ void SingleWorkerTask::DoWork(PGconn *conn,
 
     // 2.3 Send request to PG worker process
     STAT_CKPT(m_job->statArrayIndex, CKPT_PQ_SEND);
-    int sendQuerySucceed = PQsendQuery(conn, toSendCommand.str().c_str());
+    int sendQuerySucceed = 0;
+    if (isPlainCommand.size() == 1 && !isPlainCommand[0]) {
+        sendQuerySucceed = SendMetaCallShmem(conn,
+                                             metaCallType,
+                                             metaCallCount,
+                                             metaCallParamShift,
+                                             signatureList.back(),
+                                             (int64_t)statIndicesShift);
+    } else {
+        // several statements in one query string are only allowed by the simple query protocol
+        sendQuerySucceed = PQsendQuery(conn, toSendCommand.str().c_str());
+    }
     if (sendQuerySucceed != static_cast<int>(isPlainCommand.size())) {
         throw std::runtime_error(PQerrorMessage(conn));
     }
@@ -257,6 +329,9 @@ void SingleWorkerTask::DoWork(PGconn *conn,
     // 2.5 Process result
     SerializedData replyData;
     SerializedDataInit(&replyData, NULL, 0, 0, NULL);
+    // the reply of a lone meta call already is the whole response, it goes out of shmem without a copy
+    std::shared_ptr<char> zeroCopyReply;
+    uint64_t zeroCopyReplySize = 0;
     for (size_t i = 0; i < result.size(); ++i) {
         res = result[i];
         if (PQresultStatus(res) != PGRES_TUPLES_OK) {
@@ -265,6 +340,9 @@ void SingleWorkerTask::DoWork(PGconn *conn,
             FalconErrorCode errorCode = FalconErrorMsgAnalyse(totalErrorMsg, &validErrorMsg);
             if (errorCode == SUCCESS)
                 errorCode = PROGRAM_ERROR;
+            // a lone statement carries every param of the request, so the request failed as a whole
+            if (result.size() == 1)
+                m_job->MarkCallFailed(errorCode);
 
             flatBufferBuilder.Clear();
             auto metaResponse = falcon::meta_fbs::CreateMetaResponse(flatBufferBuilder, errorCode);
@@ -308,13 +386,21 @@ void SingleWorkerTask::DoWork(PGconn *conn,
             SerializedData oneReply;
             if (!SerializedDataInit(&oneReply, replyBuffer, replyBufferSize, replyBufferSize, NULL))
                 throw std::runtime_error("reply data is corrupt.");
+            if (result.size() == 1) {
+                zeroCopyReply = ShareShmemBlock(m_allocator, replyGuard, replyBuffer);
+                zeroCopyReplySize = replyBufferSize;
+                continue;
+            }
             SerializedDataAppend(&replyData, &oneReply);
             replyGuard.release();
         }
     }
 
     // 2.5.1 SendResponse & recycle resource
-    m_job->ProcessResponse(replyData.buffer, replyData.size, NULL);
+    if (zeroCopyReply != nullptr)
+        m_job->ProcessResponse(zeroCopyReply.get(), zeroCopyReplySize, ShmemBlockDeleter(zeroCopyReply));
+    else
+        m_job->ProcessResponse(replyData.buffer, replyData.size, NULL);
     {
         int32_t si = m_job->statArrayIndex;
         if (si >= 0 && g_FalconPerRequestStatShmem != nullptr)
@@ -336,8 +422,13 @@ void BatchWorkerTask::DoWork(PGconn *conn,
     PGresult *res{nullptr};
     while ((res = PQgetResult(conn)) != NULL)
         PQclear(res);
-    flatBufferBuilder.Clear();
 
+    SendRequest(conn);
+    ProcessResult(PQgetResult(conn), flatBufferBuilder, replyBuilder);
+}
+
+void BatchWorkerTask::SendRequest(PGconn *conn)
+{
     // this never should be happen, need make sure jobList not empty while create BatchWorkerTask
     if (m_jobList.empty()) {
         throw std::runtime_error("BatchWorkerTask: jobList is empty");
@@ -348,7 +439,7 @@ void BatchWorkerTask::DoWork(PGconn *conn,
     // 2. Start processing
     // 2.1 Copy data into shmem
     // all ServiceType in one batch worker are same.
-    FalconMetaServiceType serviceType = m_jobList[0]->GetFalconMetaServiceType(0);
+    m_serviceType = m_jobList[0]->GetFalconMetaServiceType(0);
 
     // calculate total totalRequestDataSize for allocate shared memory.
     uint32_t totalRequestServiceCount = 0;
@@ -367,8 +458,8 @@ void BatchWorkerTask::DoWork(PGconn *conn,
     ShmemAllocGuard paramGuard(m_allocator, sharedParamDataAddrShift);
     if (sharedParamDataAddrShift == 0) {
         printf("Shmem of connection pool is exhausted, totalParamSize: %u. There may be "
-               "several reasons, 1) shmem size is too small, 2) allocate too much memory "
-               "once exceed FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE.",
+               "several reasons, 1) shmem size is too small, 2) the request is larger than "
+               "the whole shmem.",
                totalRequestParamDataSize);
         fflush(stdout);
         throw std::runtime_error("memory exceed limit.");
@@ -405,29 +496,42 @@ void BatchWorkerTask::DoWork(PGconn *conn,
     }
     ShmemAllocGuard statIndicesGuard(m_allocator, statIndicesShift);
 
-    // 2.2 construct req msg
-    char command[256];
-    sprintf(command,
-            "select falcon_meta_call_by_serialized_shmem_internal(%d, %u, %ld, %ld, %ld);",
-            serviceType,
-            totalRequestServiceCount,
-            (int64_t)sharedParamDataAddrShift,
-            signature,
-            (int64_t)statIndicesShift);
-
-    // 2.3 Send request to PG worker process
+    // 2.2 Send request to PG worker process
     for (auto &job : m_jobList) {
         STAT_CKPT(job->statArrayIndex, CKPT_PQ_SEND);
     }
-    int sendQuerySucceed = PQsendQuery(conn, command);
+    // a single statement of the extended protocol, it may go through a pipelined connection
+    int sendQuerySucceed = SendMetaCallShmem(conn,
+                                             m_serviceType,
+                                             totalRequestServiceCount,
+                                             (int64_t)sharedParamDataAddrShift,
+                                             signature,
+                                             (int64_t)statIndicesShift);
     if (sendQuerySucceed != 1)
         throw std::runtime_error(PQerrorMessage(conn));
 
+    // the backend reads both blocks until the reply arrives, ProcessResult frees them
+    m_paramShift = paramGuard.detach();
+    m_statIndicesShift = statIndicesGuard.detach();
+    batchStatGuard.markCompleted(m_jobList.size());
+}
+
+void BatchWorkerTask::ProcessResult(PGresult *res,
+                                    flatbuffers::FlatBufferBuilder &flatBufferBuilder,
+                                    SerializedData &replyBuilder)
+{
+    PGresultGuard resGuard(res);
+    BatchStatSlotGuard batchStatGuard(m_jobList);
+    ShmemAllocGuard paramGuard(m_allocator, m_paramShift);
+    ShmemAllocGuard statIndicesGuard(m_allocator, m_statIndicesShift);
+    m_paramShift = 0;
+    m_statIndicesShift = 0;
+    FalconMetaServiceType serviceType = m_serviceType;
+    flatBufferBuilder.Clear();
+
     // 2.4 wait for process Result return
-    res = PQgetResult(conn);
     if (res == NULL)
-        throw std::runtime_error(PQerrorMessage(conn));
-    PGresultGuard resGuard(res);
+        throw std::runtime_error("BatchWorkerTask: no reply for the batch request");
     for (auto &job : m_jobList) {
         int32_t si = job->statArrayIndex;
         if (si >= 0 && g_FalconPerRequestStatShmem != nullptr)
@@ -457,6 +561,7 @@ void BatchWorkerTask::DoWork(PGconn *conn,
             char *data = (char *)malloc(replyBuilder.size);
             memcpy(data, replyBuilder.buffer, replyBuilder.size);
             // 2.5.1 SendResponse & clear resource
+            m_jobList[i]->MarkCallFailed(errorCode);
             m_jobList[i]->ProcessResponse(data, replyBuilder.size, NULL);
             {
                 int32_t si = m_jobList[i]->statArrayIndex;
@@ -490,14 +595,14 @@ void BatchWorkerTask::DoWork(PGconn *conn,
                 uint32_t size = SerializedDataNextSeveralItemSize(&replyData, p, count);
                 if (size == (sd_size_t)-1)
                     throw std::runtime_error("response is corrupt.");
-                char *data = (char *)malloc(size);
-                memcpy(data, replyBuffer + p, size);
-                replyParts[i] = {data, size};
+                replyParts[i] = {replyBuffer + p, size};
                 p += size;
             }
+            // every job answers with its own part of the reply block, the last one sent frees the block
+            std::shared_ptr<char> replyBlock = ShareShmemBlock(m_allocator, replyGuard, replyBuffer);
             // 2.5.1 SendResponse & clear resource
             for (size_t i = 0; i < m_jobList.size(); ++i) {
-                m_jobList[i]->ProcessResponse(replyParts[i].first, replyParts[i].second, NULL);
+                m_jobList[i]->ProcessResponse(replyParts[i].first, replyParts[i].second, ShmemBlockDeleter(replyBlock));
                 {
                     int32_t si = m_jobList[i]->statArrayIndex;
                     if (si >= 0 && g_FalconPerRequestStatShmem != nullptr)
@@ -509,7 +614,6 @@ void BatchWorkerTask::DoWork(PGconn *conn,
                 delete m_jobList[i];
                 m_jobList[i] = nullptr;
             }
-            replyGuard.release();
         } else {
             // 2.5.1 SendResponse & clear resource
             for (size_t i = 0; i < m_jobList.size(); ++i) {
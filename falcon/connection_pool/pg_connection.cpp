@@ -3,8 +3,10 @@
  */
 
 #include "connection_pool/pg_connection.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include "connection_pool/connection_pool_config.h"
 #include "falcon_meta_param_generated.h"
 #include "falcon_meta_response_generated.h"
 
@@ -23,23 +25,118 @@ PGConnection::PGConnection(PGConnectionWorkFinishNotifyFunc func, const char *ip
         throw std::runtime_error(std::string("pg connection error: ") + PQresultErrorMessage(res));
     }
 
+    m_pipelineDepth = std::clamp(FalconConnectionPoolPipelineDepth, 1, FALCON_CONNECTION_POOL_PIPELINE_DEPTH_MAX);
+    if (m_pipelineDepth > 1 && PQenterPipelineMode(conn) != 1) {
+        std::cout << "PGConnection: pipeline mode unavailable, " << PQerrorMessage(conn) << std::endl;
+        m_pipelineDepth = 1;
+    }
+
     SerializedDataInit(&replyBuilder, NULL, 0, 0, NULL);
     this->thread = std::thread(&PGConnection::BackgroundWorker, this);
 }
 
-void PGConnection::BackgroundWorker()
+void PGConnection::ClearResults()
+{
+    PGresult *res;
+    while ((res = PQgetResult(conn)) != NULL)
+        PQclear(res);
+}
+
+void PGConnection::RunExclusive(std::shared_ptr<BaseWorkerTask> &task)
+{
+    // only left with nothing in flight, multi statement queries are not allowed in pipeline mode
+    if (m_pipelineDepth > 1)
+        PQexitPipelineMode(conn);
+    try {
+        task->DoWork(conn, flatBufferBuilder, replyBuilder);
+    } catch (const std::exception &) {
+        ClearResults();
+    }
+    if (m_pipelineDepth > 1 && PQenterPipelineMode(conn) != 1)
+        m_pipelineDepth = 1;
+}
+
+bool PGConnection::SendPipelined(std::shared_ptr<BaseWorkerTask> &task)
+{
+    try {
+        task->SendRequest(conn);
+    } catch (const std::exception &) {
+        // the statement is not queued when sending fails
+        return false;
+    }
+    // the sync flushes the statement, it is consumed by ReceivePipelined even if the connection broke meanwhile
+    PQpipelineSync(conn);
+    return true;
+}
+
+void PGConnection::ReceivePipelined(std::shared_ptr<BaseWorkerTask> &task)
 {
-    while (working) {
-        if (!working)
+    PGresult *reply = NULL;
+    int nullCount = 0;
+    while (true) {
+        PGresult *res = PQgetResult(conn);
+        if (res == NULL) {
+            // one NULL ends the statement, a second one in a row means the connection is gone
+            if (++nullCount > 1)
+                break;
+            continue;
+        }
+        nullCount = 0;
+        if (PQresultStatus(res) == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
             break;
+        }
+        if (reply == NULL) {
+            reply = res;
+        } else {
+            PQclear(res);
+        }
+    }
+    try {
+        task->ProcessResult(reply, flatBufferBuilder, replyBuilder);
+    } catch (const std::exception &) {
+    }
+}
+
+void PGConnection::BackgroundWorker()
+{
+    // requests are copied into shmem by this thread, freed blocks are kept for it
+    FalconShmemAllocatorAttachThreadCache(GetFalconConnectionPoolShmemAllocator());
+    std::deque<std::shared_ptr<BaseWorkerTask>> inflight;
+    // a task that cannot join the pipeline, it runs once the pipeline is drained
+    std::shared_ptr<BaseWorkerTask> exclusive(nullptr);
+    while (working || !inflight.empty()) {
+        // fill the pipeline, block for a task only while nothing is in flight
+        while (working && exclusive == nullptr && (int)inflight.size() < m_pipelineDepth) {
+            std::shared_ptr<BaseWorkerTask> baseWorkerTaskPtr(nullptr);
+            boost::concurrent::queue_op_status status = inflight.empty()
+                                                            ? m_workerTaskQueue.wait_pull(baseWorkerTaskPtr)
+                                                            : m_workerTaskQueue.try_pull(baseWorkerTaskPtr);
+            if (status != boost::concurrent::queue_op_status::success)
+                break;
+            if (m_pipelineDepth == 1 || !baseWorkerTaskPtr->SupportPipeline()) {
+                exclusive = std::move(baseWorkerTaskPtr);
+                break;
+            }
+            if (!SendPipelined(baseWorkerTaskPtr)) {
+                // nothing in flight for it, the task destructor fails its jobs
+                baseWorkerTaskPtr = nullptr;
+                m_workerFinishNotifyFunc(this);
+                continue;
+            }
+            inflight.push_back(std::move(baseWorkerTaskPtr));
+        }
+
         std::shared_ptr<BaseWorkerTask> baseWorkerTaskPtr(nullptr);
-        m_workerTaskQueue.pull(baseWorkerTaskPtr);
-        try {
-            baseWorkerTaskPtr->DoWork(conn, flatBufferBuilder, replyBuilder);
-        } catch (const std::exception &) {
-            PGresult *res;
-            while ((res = PQgetResult(conn)) != NULL)
-                PQclear(res);
+        if (!inflight.empty()) {
+            baseWorkerTaskPtr = std::move(inflight.front());
+            inflight.pop_front();
+            ReceivePipelined(baseWorkerTaskPtr);
+        } else if (exclusive != nullptr) {
+            baseWorkerTaskPtr = std::move(exclusive);
+            RunExclusive(baseWorkerTaskPtr);
+        } else {
+            break;
         }
         // now no one handle the ptr, auto release WorkerTask
         baseWorkerTaskPtr = nullptr;
@@ -47,6 +144,7 @@ void PGConnection::BackgroundWorker()
         // notify worker finish and ready for an new work.
         m_workerFinishNotifyFunc(this);
     }
+    FalconShmemAllocatorDetachThreadCache();
 }
 
 void PGConnection::Exec(std::shared_ptr<BaseWorkerTask> workerTaskPtr)
@@ -54,7 +152,12 @@ void PGConnection::Exec(std::shared_ptr<BaseWorkerTask> workerTaskPtr)
     this->m_workerTaskQueue.push(workerTaskPtr);
 }
 
-void PGConnection::Stop() { working = false; }
+void PGConnection::Stop()
+{
+    working = false;
+    // wakes the worker blocked on an empty queue, tasks still queued are dropped and fail their jobs
+    m_workerTaskQueue.close();
+}
 
 PGConnection::~PGConnection()
 {
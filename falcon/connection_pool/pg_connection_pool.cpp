@@ -3,8 +3,12 @@
  */
 
 #include "connection_pool/pg_connection_pool.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <climits>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <queue>
@@ -16,20 +20,45 @@
 #include "base_comm_adapter/base_meta_service_job.h"
 #include "connection_pool/connection_pool_config.h"
 #include "connection_pool/falcon_batch_service_def.h"
+#include "connection_pool/falcon_batch_sizer.h"
+#include "connection_pool/falcon_fair_job_queue.h"
 #include "connection_pool/falcon_worker_task.h"
 #include "connection_pool/pg_connection.h"
-#include "connection_pool/falcon_concurrent_queue.h"
+#include "connection_pool/falcon_mpmc_ring_queue.h"
 #include "perf_counter/falcon_per_request_stat.h"
 
+// a dispatcher holding back a short batch looks at its queues again after this many microseconds
+#define BATCH_LINGER_SLICE_US 20
+// a producer finding the job queue full looks again after this many microseconds
+#define BACKPRESSURE_SLICE_US 100
+// a background job arriving at a queue deeper than shed_queue_depth is failed unless it drains within this time
+#define ADMISSION_WAIT_MS 20
+// jobs one batch type queues before producers have to wait for the dispatcher
+#define JOB_QUEUE_CAPACITY 32768
+
 class PGConnectionPool {
   private:
     std::unordered_set<PGConnection *> currentManagedConn;
 
-    bool working;
+    std::atomic<bool> working{false};
 
-    std::queue<PGConnection *> connPool;
+    // every connection with the tasks it was given and has not finished yet, at most pipelineDepth
+    struct ConnSlot
+    {
+        PGConnection *conn;
+        int inflight;
+    };
+    std::vector<ConnSlot> connPool;
+    std::unordered_map<PGConnection *, size_t> connSlotIndex;
+    int pipelineDepth{1};
+    // tasks the pool can still hand out before every pipeline is full
+    int freePipelineSlots{0};
+    size_t nextConnSlot{0};
+    std::atomic<int> idleConnNum{0};
     std::mutex connPoolMutex;
-    std::condition_variable cvPoolNotEmpty;
+    // waiters for a pipeline slot by priority class, a slot goes to the highest class waiting
+    std::condition_variable cvPoolNotEmpty[FALCON_PRIORITY_NUM];
+    int connWaiters[FALCON_PRIORITY_NUM]{};
 
     std::mutex pendingTaskMutex;
     std::condition_variable cvPendingTaskNotEmpty;
@@ -38,33 +67,91 @@ class PGConnectionPool {
 
     class TaskSupportBatch {
       public:
-        pg_connection_pool::ConcurrentQueue<BaseMetaServiceJob *> jobList;
+        pg_connection_pool::MpmcRingQueue<BaseMetaServiceJob *> jobList{JOB_QUEUE_CAPACITY};
         std::mutex taskMutex;
         std::condition_variable cvBatchNotFull;
+        // jobs ever enqueued, the sizer derives the arrival rate from it
+        std::atomic<uint64_t> enqueued{0};
+        // jobs ever taken into a task, enqueued - dispatched are the jobs waiting
+        std::atomic<uint64_t> dispatched{0};
+        // jobs the dispatcher took off jobList, waiting for a task by priority class and client
+        FairJobQueue staged;
+        // background jobs held back by admission control in arrival order, the dispatcher admits or sheds them
+        std::mutex deferredMutex;
+        std::deque<BaseMetaServiceJob *> deferred;
+        std::atomic<size_t> deferredNum{0};
+        BatchSizer sizer;
     };
     TaskSupportBatch supportBatchTaskList[int(FalconBatchServiceType::END)];
     uint16_t batchTaskBufferMaxSize;
 
+    // a dispatcher thread owns a fixed share of the job queues and sleeps while all of them are empty
+    class Dispatcher {
+      public:
+        std::vector<int> queueIndexes;
+        // bumped by every enqueue to an owned queue, the idle dispatcher waits on it like on a futex
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<bool> idle{false};
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Dispatcher>> dispatchers;
+    Dispatcher *queueDispatcher[int(FalconBatchServiceType::END)]{};
+
+    // only used when FalconConnectionPoolDispatcherNum is 0
     std::thread backgroundPoolManager;
 
     // define private construct function to avoid create single instance
     PGConnectionPool() = default;
 
-    // get one idle connection to do work
-    PGConnection *GetPGConnection();
+    // get the connection with the shortest pipeline, blocks while every pipeline is full or a higher class waits
+    PGConnection *GetPGConnection(FalconRequestPriority priority);
+
+    // wake a waiter of the highest class waiting, connPoolMutex held
+    void NotifyConnWaiter();
+
+    // a task of the connection is done or was never given to it, wake up one waiter
+    void ReturnPGConnection(PGConnection *conn);
 
     // background function for create work task and dispatch work task to idle connection.
     void BackgroundPoolManager();
 
+    // dispatcher thread, drains its queues and blocks until the next enqueue once they are empty
+    void DispatcherLoop(Dispatcher *dispatcher);
+
+    // dispatch the jobs of one queue, returns how many were waiting. with lingerUntilNs set a short batch may be held
+    // back, 0 is returned and lingerUntilNs lowered to the time the queue has to be looked at again
+    int DequeueExec(int queueIndex, int64_t *lingerUntilNs = nullptr);
+
     // create batch job work task and dispatch to connection
-    int BatchDequeueExec(int toDequeue, int queueIndex);
+    int BatchDequeueExec(const BatchDecision &decision, int queueIndex);
 
     // create single job work task and dispatch to connection
     int SingleDequeueExec(int toDequeue);
 
+    // move the jobs enqueued so far to the staged jobs of the queue
+    void StageJobs(TaskSupportBatch &taskList);
+
+    // take up to toDequeue staged jobs by priority and client
+    size_t TakeStagedJobs(TaskSupportBatch &taskList, size_t toDequeue, std::vector<BaseMetaServiceJob *> &jobList);
+
+    // stage the jobs of the queues, the queues holding the highest priority jobs come first
+    std::vector<int> StageByPriority(const std::vector<int> &queueIndexes);
+
+    // hold a background job back while its queue is over shed_queue_depth, returns false if it may be queued now
+    bool DeferJob(BaseMetaServiceJob *job, TaskSupportBatch &taskList);
+
+    // stage the held back jobs as far as the queue depth allows, shed those held back longer than ADMISSION_WAIT_MS
+    void AdmitDeferredJobs(TaskSupportBatch &taskList);
+
+    // wake the dispatcher of a queue that got new jobs, only a sleeping one needs the syscall
+    void WakeDispatcher(int queueIndex);
+
     // adjust sleep interval while no jobs waiting to work
     int AdjustWaitTime(int prevTime, size_t reqInLoop);
 
+    void StartDispatchers(int dispatcherNum);
+    void StopDispatchers();
+
   public:
     ~PGConnectionPool() = default;
 
@@ -86,9 +173,81 @@ class PGConnectionPool {
     void Destroy();
 };
 
+static int64_t SteadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void PGConnectionPool::StageJobs(TaskSupportBatch &taskList)
+{
+    if (taskList.deferredNum.load(std::memory_order_relaxed) != 0) {
+        AdmitDeferredJobs(taskList);
+    }
+    size_t queued = taskList.jobList.size_approx();
+    if (queued == 0) {
+        return;
+    }
+    FairJobQueue &staged = taskList.staged;
+    taskList.jobList.dequeue_bulk([&staged](BaseMetaServiceJob *job) { staged.Push(job); }, queued);
+}
+
+size_t PGConnectionPool::TakeStagedJobs(TaskSupportBatch &taskList,
+                                        size_t toDequeue,
+                                        std::vector<BaseMetaServiceJob *> &jobList)
+{
+    size_t count = taskList.staged.Pop(toDequeue, jobList);
+    taskList.dispatched.fetch_add(count, std::memory_order_relaxed);
+    int64_t now = SteadyNowNs();
+    for (size_t i = jobList.size() - count; i < jobList.size(); ++i) {
+        StatQueueWait(jobList[i]->priority, now - jobList[i]->enqueueNs);
+    }
+    return count;
+}
+
+std::vector<int> PGConnectionPool::StageByPriority(const std::vector<int> &queueIndexes)
+{
+    std::vector<int> order(queueIndexes);
+    for (int i : order) {
+        StageJobs(supportBatchTaskList[i]);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return supportBatchTaskList[a].staged.TopPriority() < supportBatchTaskList[b].staged.TopPriority();
+    });
+    return order;
+}
+
+int PGConnectionPool::DequeueExec(int queueIndex, int64_t *lingerUntilNs)
+{
+    TaskSupportBatch &taskList = supportBatchTaskList[queueIndex];
+    StageJobs(taskList);
+    int queueSizeApprox = taskList.staged.Size();
+    if (queueSizeApprox == 0) {
+        return 0;
+    }
+    if (queueIndex == (int)FalconBatchServiceType::NOT_SUPPORT) {
+        SingleDequeueExec(std::min(queueSizeApprox, FalconConnectionPoolBatchSize));
+        return queueSizeApprox;
+    }
+    // the polling manager has no deadline to come back at, it never lingers
+    int idle = lingerUntilNs != nullptr ? idleConnNum.load() : 0;
+    BatchDecision decision = taskList.sizer.Decide(queueSizeApprox, taskList.enqueued.load(), idle, SteadyNowNs());
+    if (decision.batchSize == 0) {
+        *lingerUntilNs = std::min(*lingerUntilNs, decision.lingerUntilNs);
+        return 0;
+    }
+    BatchDequeueExec(decision, queueIndex);
+    return queueSizeApprox;
+}
+
+// sleep-polling manager of all queues, kept for falcon_connection_pool.dispatcher_num = 0
 void PGConnectionPool::BackgroundPoolManager()
 {
     int waitTime = 100; // microseconds
+    std::vector<int> queueIndexes;
+    for (int i = 0; i <= (int)FalconBatchServiceType::NOT_SUPPORT; ++i) {
+        queueIndexes.push_back(i);
+    }
     while (working) {
         if (!working)
             break;
@@ -96,23 +255,11 @@ void PGConnectionPool::BackgroundPoolManager()
         int maxCount = 0;
         bool withTasks = true;
         while (withTasks) {
-            int emptyCount = 0;
-            for (int i = 0; i <= (int)FalconBatchServiceType::NOT_SUPPORT; ++i) {
-                int queueSizeApprox = supportBatchTaskList[i].jobList.size_approx();
-                if (queueSizeApprox == 0) {
-                    emptyCount++;
-                    continue;
-                }
+            withTasks = false;
+            for (int i : StageByPriority(queueIndexes)) {
+                int queueSizeApprox = DequeueExec(i);
                 maxCount = std::max(maxCount, queueSizeApprox);
-                int toDequeue = std::min(queueSizeApprox, FalconConnectionPoolBatchSize);
-                if (i < (int)FalconBatchServiceType::NOT_SUPPORT) {
-                    BatchDequeueExec(toDequeue, i);
-                } else {
-                    SingleDequeueExec(toDequeue);
-                }
-            }
-            if (emptyCount == (int)FalconBatchServiceType::NOT_SUPPORT + 1) {
-                withTasks = false;
+                withTasks = withTasks || queueSizeApprox != 0;
             }
         }
         // determine the amount to batch
@@ -121,6 +268,66 @@ void PGConnectionPool::BackgroundPoolManager()
     }
 }
 
+void PGConnectionPool::DispatcherLoop(Dispatcher *dispatcher)
+{
+    while (working) {
+        // read before the queues are checked, an enqueue after the check changes it and the wait returns at once
+        uint32_t epoch = dispatcher->epoch.load();
+        int64_t lingerUntilNs = INT64_MAX;
+        bool withTasks = true;
+        while (withTasks && working) {
+            withTasks = false;
+            lingerUntilNs = INT64_MAX;
+            for (int i : StageByPriority(dispatcher->queueIndexes)) {
+                withTasks = DequeueExec(i, &lingerUntilNs) != 0 || withTasks;
+            }
+        }
+        if (!working) {
+            break;
+        }
+        if (lingerUntilNs != INT64_MAX) {
+            // a short batch waits for more jobs, jobs of the other queues wait at most one slice meanwhile
+            int64_t waitNs = std::clamp<int64_t>(lingerUntilNs - SteadyNowNs(), 0, BATCH_LINGER_SLICE_US * 1000);
+            std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+            continue;
+        }
+        dispatcher->idle.store(true);
+        dispatcher->epoch.wait(epoch);
+        dispatcher->idle.store(false);
+    }
+}
+
+void PGConnectionPool::StartDispatchers(int dispatcherNum)
+{
+    int queueNum = (int)FalconBatchServiceType::NOT_SUPPORT + 1;
+    dispatcherNum = std::min(dispatcherNum, queueNum);
+    for (int i = 0; i < dispatcherNum; ++i) {
+        dispatchers.emplace_back(std::make_unique<Dispatcher>());
+    }
+    // queues of one batch type are never shared, a dispatcher is their only consumer
+    for (int i = 0; i < queueNum; ++i) {
+        Dispatcher *dispatcher = dispatchers[i % dispatcherNum].get();
+        dispatcher->queueIndexes.push_back(i);
+        queueDispatcher[i] = dispatcher;
+    }
+    for (auto &dispatcher : dispatchers) {
+        dispatcher->thread = std::thread(&PGConnectionPool::DispatcherLoop, this, dispatcher.get());
+    }
+}
+
+void PGConnectionPool::StopDispatchers()
+{
+    for (auto &dispatcher : dispatchers) {
+        dispatcher->epoch++;
+        dispatcher->epoch.notify_all();
+    }
+    for (auto &dispatcher : dispatchers) {
+        dispatcher->thread.join();
+    }
+    dispatchers.clear();
+    std::fill(std::begin(queueDispatcher), std::end(queueDispatcher), nullptr);
+}
+
 int PGConnectionPool::AdjustWaitTime(int prevTime, size_t reqInLoop)
 {
     if (FalconConnectionPoolWaitAdjust == 0) {
@@ -133,32 +340,38 @@ int PGConnectionPool::AdjustWaitTime(int prevTime, size_t reqInLoop)
     }
 }
 
-int PGConnectionPool::BatchDequeueExec(int toDequeue, int queueIndex)
+int PGConnectionPool::BatchDequeueExec(const BatchDecision &decision, int queueIndex)
 {
+    TaskSupportBatch &taskList = supportBatchTaskList[queueIndex];
+    // take the connection first, jobs arriving while all connections are busy still join this batch up to the target
+    PGConnection *conn = GetPGConnection(taskList.staged.TopPriority()); // get idle connection, may block
+    StageJobs(taskList);
+    int toDequeue = std::max<int>(decision.batchSize, taskList.staged.Size());
+    toDequeue = std::min(toDequeue, decision.targetSize);
+
     std::vector<BaseMetaServiceJob *> jobList;
     jobList.reserve(toDequeue);
-    std::function func = [&jobList](BaseMetaServiceJob *job) {
-        jobList.emplace_back(job);
-    };
-    size_t count = supportBatchTaskList[queueIndex].jobList.dequeue_bulk(
-        std::move(func),
-        toDequeue
-    );
+    size_t count = TakeStagedJobs(taskList, toDequeue, jobList);
     if (count == 0) {
+        ReturnPGConnection(conn);
         return 0;
     }
 
     for (auto &job : jobList) {
         STAT_CKPT(job->statArrayIndex, CKPT_DEQUEUE);
     }
-
-    auto workerTaskPtr = std::make_shared<BatchWorkerTask>(GetFalconConnectionPoolShmemAllocator(), jobList);
+    StatBatch(jobList[0]->opcodeForE2E, count, decision.targetSize, decision.lingeredNs);
+
+    BatchSizer *sizer = &taskList.sizer;
+    sizer->Dispatched();
+    auto workerTaskPtr = std::make_shared<BatchWorkerTask>(
+        GetFalconConnectionPoolShmemAllocator(),
+        jobList,
+        [sizer](int jobNum, int64_t durationNs) { sizer->Complete(jobNum, durationNs); });
     if (workerTaskPtr == nullptr) {
         throw std::runtime_error("BatchDequeueExec make_shared<BatchWorkerTask> failed, out of memory.");
     }
 
-    PGConnection *conn = GetPGConnection(); // get idle connection, may block
-
     for (auto &job : jobList) {
         STAT_CKPT(job->statArrayIndex, CKPT_CONN_ACQUIRED);
     }
@@ -171,13 +384,8 @@ int PGConnectionPool::SingleDequeueExec(int toDequeue)
 {
     std::vector<BaseMetaServiceJob *> singleJobList;
     singleJobList.reserve(toDequeue);
-    std::function func = [&singleJobList](BaseMetaServiceJob *job) {
-        singleJobList.emplace_back(job);
-    };
-    size_t count = supportBatchTaskList[(int)FalconBatchServiceType::NOT_SUPPORT].jobList.dequeue_bulk(
-        std::move(func),
-        toDequeue
-    );
+    size_t count =
+        TakeStagedJobs(supportBatchTaskList[(int)FalconBatchServiceType::NOT_SUPPORT], toDequeue, singleJobList);
     if (count == 0) {
         return 0;
     }
@@ -191,7 +399,7 @@ int PGConnectionPool::SingleDequeueExec(int toDequeue)
         if (workerTaskPtr == nullptr) {
             throw std::runtime_error("BatchDequeueExec make_shared<BatchWorkerTask> failed, out of memory.");
         }
-        PGConnection *conn = GetPGConnection(); // get idle connection, may block
+        PGConnection *conn = GetPGConnection(job->priority); // get idle connection, may block
 
         STAT_CKPT(job->statArrayIndex, CKPT_CONN_ACQUIRED);
 
@@ -200,19 +408,147 @@ int PGConnectionPool::SingleDequeueExec(int toDequeue)
     return count;
 }
 
-PGConnection *PGConnectionPool::GetPGConnection()
+void PGConnectionPool::NotifyConnWaiter()
+{
+    for (int i = 0; i < FALCON_PRIORITY_NUM; ++i) {
+        if (connWaiters[i] > 0) {
+            cvPoolNotEmpty[i].notify_one();
+            return;
+        }
+    }
+}
+
+PGConnection *PGConnectionPool::GetPGConnection(FalconRequestPriority priority)
 {
     PGConnection *result = NULL;
+    // an empty queue asks on behalf of no job, it gets the lowest class
+    int waitClass = std::min<int>(priority, FALCON_PRIORITY_BACKGROUND);
     {
         std::unique_lock<std::mutex> lk(connPoolMutex);
-        cvPoolNotEmpty.wait(lk, [this]() -> bool { return !this->connPool.empty(); });
-
-        result = connPool.front();
-        connPool.pop();
+        connWaiters[waitClass]++;
+        cvPoolNotEmpty[waitClass].wait(lk, [this, waitClass]() -> bool {
+            if (this->freePipelineSlots == 0) {
+                return false;
+            }
+            for (int i = 0; i < waitClass; ++i) {
+                if (this->connWaiters[i] > 0) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        connWaiters[waitClass]--;
+
+        // an idle connection always wins, pipelines only grow once every connection is busy. the scan starts
+        // after the last pick so equally loaded connections take turns
+        size_t best = nextConnSlot % connPool.size();
+        for (size_t i = 1; i < connPool.size() && connPool[best].inflight > 0; ++i) {
+            size_t slot = (nextConnSlot + i) % connPool.size();
+            if (connPool[slot].inflight < connPool[best].inflight) {
+                best = slot;
+            }
+        }
+        ConnSlot &slot = connPool[best];
+        if (slot.inflight == 0) {
+            idleConnNum--;
+        }
+        slot.inflight++;
+        freePipelineSlots--;
+        nextConnSlot = best + 1;
+        result = slot.conn;
+        // a slot left over goes on to the next waiter, which may be of a class not notified so far
+        if (freePipelineSlots > 0) {
+            NotifyConnWaiter();
+        }
     }
     return result;
 }
 
+void PGConnectionPool::ReturnPGConnection(PGConnection *conn)
+{
+    {
+        std::unique_lock<std::mutex> lk(connPoolMutex);
+        auto it = connSlotIndex.find(conn);
+        if (it == connSlotIndex.end()) {
+            return;
+        }
+        ConnSlot &slot = connPool[it->second];
+        slot.inflight--;
+        if (slot.inflight == 0) {
+            idleConnNum++;
+        }
+        freePipelineSlots++;
+        NotifyConnWaiter();
+    }
+}
+
+// more jobs of the queue wait for a task than shed_queue_depth
+static bool QueueOverloaded(uint64_t enqueued, uint64_t dispatched)
+{
+    int64_t waiting = (int64_t)(enqueued - dispatched);
+    return FalconConnectionPoolShedQueueDepth > 0 && waiting > FalconConnectionPoolShedQueueDepth;
+}
+
+bool PGConnectionPool::DeferJob(BaseMetaServiceJob *job, TaskSupportBatch &taskList)
+{
+    if (job->priority != FALCON_PRIORITY_BACKGROUND || FalconConnectionPoolShedQueueDepth <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(taskList.deferredMutex);
+    // jobs already held back go first, a later one may not overtake them
+    if (taskList.deferred.empty() && !QueueOverloaded(taskList.enqueued.load(std::memory_order_relaxed),
+                                                      taskList.dispatched.load(std::memory_order_relaxed))) {
+        return false;
+    }
+    taskList.deferred.push_back(job);
+    taskList.deferredNum.store(taskList.deferred.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void PGConnectionPool::AdmitDeferredJobs(TaskSupportBatch &taskList)
+{
+    std::vector<BaseMetaServiceJob *> shed;
+    {
+        std::lock_guard<std::mutex> lk(taskList.deferredMutex);
+        int64_t shedBeforeNs = SteadyNowNs() - (int64_t)ADMISSION_WAIT_MS * 1000000;
+        while (!taskList.deferred.empty()) {
+            BaseMetaServiceJob *job = taskList.deferred.front();
+            if (!QueueOverloaded(taskList.enqueued.load(std::memory_order_relaxed),
+                                 taskList.dispatched.load(std::memory_order_relaxed))) {
+                taskList.staged.Push(job);
+                taskList.enqueued.fetch_add(1, std::memory_order_relaxed);
+                StatAdmission(job->priority, false);
+                STAT_CKPT(job->statArrayIndex, CKPT_ENQUEUE);
+            } else if (job->enqueueNs < shedBeforeNs) {
+                shed.push_back(job);
+            } else {
+                break;
+            }
+            taskList.deferred.pop_front();
+        }
+        taskList.deferredNum.store(taskList.deferred.size(), std::memory_order_relaxed);
+    }
+    // answered outside the lock, Done sends the reply
+    for (BaseMetaServiceJob *job : shed) {
+        StatAdmission(job->priority, true);
+        job->MarkBusy();
+        job->Done();
+        delete job;
+    }
+}
+
+void PGConnectionPool::WakeDispatcher(int queueIndex)
+{
+    Dispatcher *dispatcher = queueDispatcher[queueIndex];
+    if (dispatcher != nullptr) {
+        dispatcher->epoch++;
+        // a busy dispatcher finds the job on its next pass, only a sleeping one needs the syscall
+        if (dispatcher->idle.load()) {
+            dispatcher->epoch.notify_one();
+        }
+    }
+}
+
 // lifetime of job must be longer than this function. it will be freed later
 void PGConnectionPool::DispatchMetaServiceJob(BaseMetaServiceJob *job)
 {
@@ -230,15 +566,39 @@ void PGConnectionPool::DispatchMetaServiceJob(BaseMetaServiceJob *job)
                                                         : FalconBatchServiceType::NOT_SUPPORT;
 
     job->opcodeForE2E = falconSupportType;
+    job->priority = job->GetRequestPriority();
+    if (job->priority < FALCON_PRIORITY_INTERACTIVE || job->priority >= FALCON_PRIORITY_NUM) {
+        job->priority = FalconMetaServiceTypeToPriority(falconSupportType);
+    }
+    job->tenantId = job->GetClientId();
 
     job->statArrayIndex = PerRequestStatAllocIndex();
     STAT_CKPT(job->statArrayIndex, CKPT_DISPATCH);
 
-    while (!supportBatchTaskList[(int)FalconBatchServiceType].jobList.enqueue(job)) {
-        std::cout << "DispatchMetaServiceJob: enqueue failed, type = " << (int)FalconBatchServiceType << std::endl;
-        std::this_thread::yield();
+    // the shmem ran out, turn new jobs away at once until the queued ones free some, the client retries them
+    if (FalconShmemAllocatorIsExhausted(GetFalconConnectionPoolShmemAllocator())) {
+        job->MarkBusy();
+        job->Done();
+        delete job;
+        return;
+    }
+
+    TaskSupportBatch &taskList = supportBatchTaskList[(int)FalconBatchServiceType];
+    job->enqueueNs = SteadyNowNs();
+    // a held back job is taken over by the dispatcher, the calling thread goes on at once
+    if (DeferJob(job, taskList)) {
+        WakeDispatcher((int)FalconBatchServiceType);
+        return;
     }
+    if (!taskList.jobList.enqueue(job)) {
+        std::cout << "DispatchMetaServiceJob: job queue full, type = " << (int)FalconBatchServiceType << std::endl;
+        while (!taskList.jobList.enqueue(job)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(BACKPRESSURE_SLICE_US));
+        }
+    }
+    taskList.enqueued.fetch_add(1, std::memory_order_relaxed);
     STAT_CKPT(job->statArrayIndex, CKPT_ENQUEUE);
+    WakeDispatcher((int)FalconBatchServiceType);
 }
 
 bool PGConnectionPool::Init(const uint16_t port,
@@ -247,24 +607,37 @@ bool PGConnectionPool::Init(const uint16_t port,
                             const uint16_t pendingTaskBufferMaxSize,
                             const uint16_t batchTaskBufferMaxSize)
 {
-    auto workerFinishNotifyFunc = [this](PGConnection *conn) {
-        {
-            std::unique_lock<std::mutex> lk(connPoolMutex);
-            connPool.push(conn);
-        }
-        cvPoolNotEmpty.notify_one();
-    };
+    auto workerFinishNotifyFunc = [this](PGConnection *conn) { ReturnPGConnection(conn); };
 
     for (int i = 0; i < connPoolSize; ++i) {
         PGConnection *conn = new PGConnection(workerFinishNotifyFunc, "127.0.0.1", port, userName);
         currentManagedConn.insert(conn);
-        connPool.push(conn);
+        connSlotIndex[conn] = connPool.size();
+        connPool.push_back({conn, 0});
     }
+    pipelineDepth = std::clamp(FalconConnectionPoolPipelineDepth, 1, FALCON_CONNECTION_POOL_PIPELINE_DEPTH_MAX);
+    freePipelineSlots = connPoolSize * pipelineDepth;
+    nextConnSlot = 0;
+    idleConnNum = connPoolSize;
     this->pendingTaskBufferMaxSize = pendingTaskBufferMaxSize;
     this->batchTaskBufferMaxSize = batchTaskBufferMaxSize;
 
+    int64_t sloUs[int(FalconBatchServiceType::NOT_SUPPORT)];
+    std::fill(std::begin(sloUs), std::end(sloUs), FalconConnectionPoolBatchLatencySlo);
+    ParseBatchLatencySloOverride(FalconConnectionPoolBatchLatencySloOverride, sloUs, std::size(sloUs));
+    for (int i = 0; i < (int)FalconBatchServiceType::NOT_SUPPORT; ++i) {
+        supportBatchTaskList[i].sizer.Configure(sloUs[i] * 1000,
+                                                FalconConnectionPoolBatchLingerMax * 1000LL,
+                                                FalconConnectionPoolBatchSize,
+                                                connPoolSize);
+    }
+
     working = true;
-    backgroundPoolManager = std::thread(&PGConnectionPool::BackgroundPoolManager, this);
+    if (FalconConnectionPoolDispatcherNum > 0) {
+        StartDispatchers(FalconConnectionPoolDispatcherNum);
+    } else {
+        backgroundPoolManager = std::thread(&PGConnectionPool::BackgroundPoolManager, this);
+    }
     return true;
 }
 
@@ -275,20 +648,33 @@ void PGConnectionPool::Destroy()
     int waitMaxCnt = 100;
     for (int i = 0; i <= (int)FalconBatchServiceType::NOT_SUPPORT; ++i) {
         int curWaitCnt = 0;
-        while (supportBatchTaskList[i].jobList.size_approx() > 0 && waitMaxCnt > curWaitCnt) {
+        TaskSupportBatch &taskList = supportBatchTaskList[i];
+        while ((taskList.enqueued.load() != taskList.dispatched.load() || taskList.deferredNum.load() != 0) &&
+               waitMaxCnt > curWaitCnt) {
             std::this_thread::sleep_for(std::chrono::microseconds(waitIntervalTime));
             curWaitCnt++;
         }
     }
 
     working = false;
+    // dispatch threads may still wait for a busy connection, join them while the connections are alive
+    StopDispatchers();
+    if (backgroundPoolManager.joinable()) {
+        backgroundPoolManager.join();
+    }
     for (auto it = currentManagedConn.begin(); it != currentManagedConn.end(); ++it) {
         (*it)->Stop();
     }
     for (auto it = currentManagedConn.begin(); it != currentManagedConn.end(); ++it) {
         delete (*it);
     }
-    backgroundPoolManager.join();
+    {
+        std::unique_lock<std::mutex> lk(connPoolMutex);
+        connPool.clear();
+        connSlotIndex.clear();
+        freePipelineSlots = 0;
+        idleConnNum = 0;
+    }
     currentManagedConn.clear();
 }
 
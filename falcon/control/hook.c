@@ -10,6 +10,7 @@
 #include "metadb/foreign_server.h"
 #include "metadb/shard_table.h"
 #include "transaction/transaction.h"
+#include "utils/falcon_shmem_allocator.h"
 #include "utils/rwlock.h"
 #include "utils/utils.h"
 
@@ -48,6 +49,8 @@ void FalconCleanupOnExit(int code, Datum arg)
 {
     RWLockReleaseAll(true);
     CleanupForeignServerConnections();
+    // blocks this backend keeps for its replies
+    FalconShmemAllocatorDetachThreadCache();
 };
 
 static void RegisterFalconPerBackendCallback(void)
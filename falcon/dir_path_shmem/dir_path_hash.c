@@ -3,6 +3,7 @@
  */
 
 #include "dir_path_shmem/dir_path_hash.h"
+#include "dir_path_shmem/dir_path_prefix_cache.h"
 
 #include "postgres.h"
 
@@ -35,64 +36,6 @@
 #include "utils/shmem_control.h"
 #include "utils/utils.h"
 
-#define NUM_FREELISTS 32
-
-typedef HASHELEMENT *HASHBUCKET;
-
-typedef HASHBUCKET *HASHSEGMENT;
-
-typedef struct
-{
-    slock_t mutex;         /* spinlock for this freelist */
-    long nentries;         /* number of entries in associated buckets */
-    HASHELEMENT *freeList; /* chain of free elements */
-} FreeListData;
-
-struct HASHHDR
-{
-    FreeListData freeList[NUM_FREELISTS];
-
-    long dsize;        /* directory size */
-    long nsegs;        /* number of allocated segments (<= dsize) */
-    uint32 max_bucket; /* ID of maximum bucket in use */
-    uint32 high_mask;  /* mask to modulo into entire table */
-    uint32 low_mask;   /* mask to modulo into lower half of table */
-
-    Size keysize;        /* hash key length in bytes */
-    Size entrysize;      /* total user element size in bytes */
-    long num_partitions; /* # partitions (must be power of 2), or 0 */
-    long max_dsize;      /* 'dsize' limit if directory is fixed size */
-    long ssize;          /* segment size --- must be power of 2 */
-    int sshift;          /* segment shift = log2(ssize) */
-    int nelem_alloc;     /* number of entries to allocate at once */
-
-#ifdef HASH_STATISTICS
-    long accesses;
-    long collisions;
-#endif
-};
-
-struct HTAB
-{
-    HASHHDR *hctl;         /* => shared control information */
-    HASHSEGMENT *dir;      /* directory of segment starts */
-    HashValueFunc hash;    /* hash function */
-    HashCompareFunc match; /* key comparison function */
-    HashCopyFunc keycopy;  /* key copying function */
-    HashAllocFunc alloc;   /* memory allocator */
-    MemoryContext hcxt;    /* memory context if default allocator used */
-    char *tabname;         /* table name (for error messages) */
-    bool isshared;         /* true if table is in shared memory */
-    bool isfixed;          /* if true, don't enlarge */
-
-    bool frozen; /* true = no more inserts allowed */
-
-    Size keysize; /* hash key length in bytes */
-    long ssize;   /* segment size --- must be power of 2 */
-    int sshift;   /* segment shift = log2(ssize) */
-};
-// end
-
 #define DIR_PATH_HASH_PARTITION_SIZE 128
 #define DIR_PATH_HASH_PARTITION_INDEX(hashcode) ((hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
 static int DirPathLWLockTrancheId;
@@ -101,55 +44,83 @@ static LWLockPadded *DirPathLWLockArray;
 #define DIR_PATH_HASH_PARTITION_LOCK(hashcode) (&(DirPathLWLockArray[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE].lock))
 static HTAB *PathDirHash[DIR_PATH_HASH_PARTITION_SIZE] = {0};
 #define DIR_PATH_HASH_PARTITION(hashcode) (PathDirHash[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE])
-static pg_atomic_uint32 *PathDirHashEntryCount = NULL;
-#define DIR_PATH_HASH_PARTITION_COUNT(hashcode) (PathDirHashEntryCount + (hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
 
-static char DirPathHashToCommitAction[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
-static DirPathHashItem DirPathHashToCommitActionInfo[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
+/* names are stored in chunks of 16, 32, ... MAX_DIRECTORY_PATH_HASH_SIZE bytes */
+#define DIR_PATH_NAME_CLASS_MIN_SHIFT 4
+#define DIR_PATH_NAME_CLASS_NUM 5
+#define DIR_PATH_NAME_CLASS_SIZE(nameClass) ((Size)1 << ((nameClass) + DIR_PATH_NAME_CLASS_MIN_SHIFT))
+/* name arena bytes reserved per entry, directory names are mostly far shorter than the longest allowed */
+#define DIR_PATH_NAME_AVG_BYTES 32
+/* an eviction gives up after the clock went round this many times without finding an unlocked entry */
+#define DIR_PATH_CLOCK_MAX_TURNS 2
+
+/*
+ * Per partition bookkeeping of the cache, changed under the exclusive partition lock. Every cached entry sits in a
+ * slot of the clock, the hand sweeps the slots and evicts the first unlocked entry not referenced since its last
+ * pass. Names are carved from the arena and recycled through one free list per chunk size.
+ */
+typedef struct DirPathPartition
+{
+    uint32 capacity;
+    uint32 entryCount;
+    uint32 clockHand;
+    uint32 freeSlotCount;
+    DirPathHashItem **slots;
+    uint32 *freeSlots;
+    char *arena;
+    Size arenaSize;
+    Size arenaUsed;
+    Size nameBytes;
+    char *freeNames[DIR_PATH_NAME_CLASS_NUM];
+    uint64 evictions;
+    pg_atomic_uint64 hits;
+    pg_atomic_uint64 misses;
+} DirPathPartition;
+static DirPathPartition *DirPathPartitions[DIR_PATH_HASH_PARTITION_SIZE] = {0};
+
+int FalconDirPathCacheCapacity = DIR_PATH_CACHE_CAPACITY_DEFAULT;
+
+typedef struct
+{
+    uint64_t parentId;
+    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
+    uint64_t inodeId;
+} DirPathHashToCommitItem;
+
+static DirPathHashToCommitItem DirPathHashToCommitActionInfo[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
 static int DirPathHashToCommitSize = 0;
-void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName);
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId);
 void DirPathHashToCommitClear(void);
 
-void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName)
-{
-    if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
-        FALCON_ELOG_ERROR(PROGRAM_ERROR,
-                          "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'A';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
-    DirPathHashToCommitSize++;
-}
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId)
 {
     if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
         FALCON_ELOG_ERROR(PROGRAM_ERROR,
                           "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'U';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
+    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].parentId = parentId;
+    strlcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].fileName, fileName, MAX_DIRECTORY_PATH_HASH_SIZE);
     DirPathHashToCommitActionInfo[DirPathHashToCommitSize].inodeId = inodeId;
     DirPathHashToCommitSize++;
 }
 void DirPathHashToCommitClear() { DirPathHashToCommitSize = 0; }
 
-DirPathHashKey ClockCountList[DIRECTORY_PATH_HASH_BUCKET_NUM];
-
 RWLock *DirectoryHashTableLastAcquiredLock = NULL;
 
 static uint32 dir_path_hash(const void *key, Size keysize);
 static int dir_path_compare(const void *key1, const void *key2);
-static int dir_path_compare(const void *key1, const void *key2);
 static int dir_path_match(const void *key1, const void *key2, Size keysize);
 static void *dir_path_keycopy(void *dest, const void *src, Size keysize);
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name);
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename);
-static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt);
-static bool EliminateDirPathHashByLRU(int partitionIndex);
+static DirPathHashItem *
+DirPathHashEnter(int partitionIndex, const DirPathHashKey *key, uint32 hashcode, uint64_t inodeId, bool *found);
+static void DirPathHashRemove(int partitionIndex, DirPathHashItem *item);
+static bool DirPathCacheEvict(int partitionIndex, int minNameClass);
 
 PG_FUNCTION_INFO_V1(falcon_print_dir_path_hash_elem);
 PG_FUNCTION_INFO_V1(falcon_acquire_hash_lock);
 PG_FUNCTION_INFO_V1(falcon_release_hash_lock);
+PG_FUNCTION_INFO_V1(falcon_dir_path_cache_stats);
 
 Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
 {
@@ -173,12 +144,16 @@ Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
 
         HASH_SEQ_STATUS status;
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
+            // the name of an entry goes back to the arena once it is evicted, copy it while the partition is locked
+            LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_SHARED);
             hash_seq_init(&status, PathDirHash[i]);
             while ((entry = hash_seq_search(&status)) != 0) {
                 DirPathHashItem *temp_entry = (DirPathHashItem *)palloc(sizeof(DirPathHashItem));
                 memcpy(temp_entry, entry, sizeof(DirPathHashItem));
+                temp_entry->key.fileName = pnstrdup(entry->key.fileName, entry->key.nameLen);
                 returnInfoList = lappend(returnInfoList, temp_entry);
             }
+            LWLockRelease(&(DirPathLWLockArray[i].lock));
         }
 
         functionContext->user_fctx = returnInfoList;
@@ -247,10 +222,63 @@ Datum falcon_release_hash_lock(PG_FUNCTION_ARGS)
     PG_RETURN_INT16(SUCCESS);
 }
 
+Datum falcon_dir_path_cache_stats(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *functionContext = NULL;
+    TupleDesc tupleDescriptor;
+    Datum values[7];
+    bool resNulls[7];
+
+    if (SRF_IS_FIRSTCALL()) {
+        functionContext = SRF_FIRSTCALL_INIT();
+        MemoryContext oldContext = MemoryContextSwitchTo(functionContext->multi_call_memory_ctx);
+        if (get_call_result_type(fcinfo, NULL, &tupleDescriptor) != TYPEFUNC_COMPOSITE) {
+            FALCON_ELOG_ERROR(PROGRAM_ERROR, "return type must be a row type.");
+        }
+        functionContext->tuple_desc = BlessTupleDesc(tupleDescriptor);
+        functionContext->max_calls = 1;
+        MemoryContextSwitchTo(oldContext);
+    }
+    functionContext = SRF_PERCALL_SETUP();
+    if (functionContext->call_cntr >= functionContext->max_calls) {
+        SRF_RETURN_DONE(functionContext);
+    }
+
+    int64 capacity = 0;
+    int64 entries = 0;
+    int64 nameBytes = 0;
+    int64 arenaBytes = 0;
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 evictions = 0;
+    for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
+        DirPathPartition *partition = DirPathPartitions[i];
+        LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_SHARED);
+        capacity += partition->capacity;
+        entries += partition->entryCount;
+        nameBytes += partition->nameBytes;
+        arenaBytes += partition->arenaSize;
+        evictions += partition->evictions;
+        LWLockRelease(&(DirPathLWLockArray[i].lock));
+        hits += pg_atomic_read_u64(&partition->hits);
+        misses += pg_atomic_read_u64(&partition->misses);
+    }
+    memset(resNulls, false, sizeof(resNulls));
+    values[0] = Int64GetDatum(capacity);
+    values[1] = Int64GetDatum(entries);
+    values[2] = Int64GetDatum(nameBytes);
+    values[3] = Int64GetDatum(arenaBytes);
+    values[4] = Int64GetDatum(hits);
+    values[5] = Int64GetDatum(misses);
+    values[6] = Int64GetDatum(evictions);
+    HeapTuple heapTupleRes = heap_form_tuple(functionContext->tuple_desc, values, resNulls);
+    SRF_RETURN_NEXT(functionContext, HeapTupleGetDatum(heapTupleRes));
+}
+
 static uint32 dir_path_hash(const void *key, Size keysize)
 {
     const DirPathHashKey *l = (const DirPathHashKey *)key;
-    return DatumGetUInt32(hash_any_extended((const unsigned char *)l->fileName, strlen(l->fileName), l->parentId));
+    return (uint32)DatumGetUInt64(hash_any_extended((const unsigned char *)l->fileName, l->nameLen, l->parentId));
 }
 
 static int dir_path_compare(const void *key1, const void *key2)
@@ -264,26 +292,177 @@ static int dir_path_compare(const void *key1, const void *key2)
     } else if (d1->parentId < d2->parentId) {
         return -1;
     }
-    /* parentId are equal, do a byte-by-byte comparison on fileName */
-    return strcmp(d1->fileName, d2->fileName);
+    /* parentId are equal, then by length, then byte-by-byte */
+    if (d1->nameLen != d2->nameLen) {
+        return d1->nameLen > d2->nameLen ? 1 : -1;
+    }
+    return memcmp(d1->fileName, d2->fileName, d1->nameLen);
 }
 
 static int dir_path_match(const void *key1, const void *key2, Size keysize) { return dir_path_compare(key1, key2); }
 
+/* the name was already copied to the arena by DirPathHashEnter, the entry only takes over the reference */
 static void *dir_path_keycopy(void *dest, const void *src, Size keysize)
 {
-    const DirPathHashKey *srcVal = (const DirPathHashKey *)src;
-    DirPathHashKey *destVal = (DirPathHashKey *)dest;
-    destVal->parentId = srcVal->parentId;
-    strcpy(destVal->fileName, srcVal->fileName);
+    memcpy(dest, src, sizeof(DirPathHashKey));
+    return dest;
+}
+
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name)
+{
+    size_t nameLen = strlen(name);
+    if (nameLen >= MAX_DIRECTORY_PATH_HASH_SIZE)
+        FALCON_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "file name too long: %zu bytes.", nameLen);
+    key->parentId = parentId;
+    key->fileName = name;
+    key->nameLen = (uint16_t)nameLen;
+    key->nameClass = 0;
+}
+
+static int DirPathNameClass(uint16_t nameLen)
+{
+    int nameClass = 0;
+    while (DIR_PATH_NAME_CLASS_SIZE(nameClass) < (Size)nameLen + 1)
+        nameClass++;
+    return nameClass;
+}
+
+/* a chunk of nameClass, or of a bigger class once the arena is used up, NULL when neither is left */
+static char *DirPathNameAlloc(DirPathPartition *partition, int nameClass, int *allocClass)
+{
+    char *name = partition->freeNames[nameClass];
+    if (name != NULL) {
+        partition->freeNames[nameClass] = *(char **)name;
+        *allocClass = nameClass;
+        return name;
+    }
+    if (partition->arenaUsed + DIR_PATH_NAME_CLASS_SIZE(nameClass) <= partition->arenaSize) {
+        name = partition->arena + partition->arenaUsed;
+        partition->arenaUsed += DIR_PATH_NAME_CLASS_SIZE(nameClass);
+        *allocClass = nameClass;
+        return name;
+    }
+    for (int bigger = nameClass + 1; bigger < DIR_PATH_NAME_CLASS_NUM; ++bigger) {
+        name = partition->freeNames[bigger];
+        if (name != NULL) {
+            partition->freeNames[bigger] = *(char **)name;
+            *allocClass = bigger;
+            return name;
+        }
+    }
     return NULL;
 }
 
+static void DirPathNameFree(DirPathPartition *partition, char *name, int nameClass)
+{
+    *(char **)name = partition->freeNames[nameClass];
+    partition->freeNames[nameClass] = name;
+}
+
+/*
+ * Find the entry of key or create it with inodeId, the partition lock is held exclusively. Running out of entries or
+ * of name space in the partition evicts by CLOCK, NULL when every entry is locked by some transaction.
+ */
+static DirPathHashItem *
+DirPathHashEnter(int partitionIndex, const DirPathHashKey *key, uint32 hashcode, uint64_t inodeId, bool *found)
+{
+    DirPathPartition *partition = DirPathPartitions[partitionIndex];
+    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(PathDirHash[partitionIndex],
+                                                                           (const void *)key,
+                                                                           hashcode,
+                                                                           HASH_FIND,
+                                                                           found);
+    if (*found)
+        return item;
+
+    int nameClass = DirPathNameClass(key->nameLen);
+    int allocClass = nameClass;
+    char *name = NULL;
+    bool prefixesDropped = false;
+    while (partition->freeSlotCount == 0 || (name = DirPathNameAlloc(partition, nameClass, &allocClass)) == NULL) {
+        if (DirPathCacheEvict(partitionIndex, partition->freeSlotCount == 0 ? 0 : nameClass))
+            continue;
+        // entries pinned by cached path prefixes can not go, unpin them once before giving up
+        if (prefixesDropped || !DirPathPrefixCacheFlush())
+            return NULL;
+        prefixesDropped = true;
+    }
+    memcpy(name, key->fileName, key->nameLen);
+    name[key->nameLen] = '\0';
+
+    DirPathHashKey storedKey = *key;
+    storedKey.fileName = name;
+    storedKey.nameClass = (uint8_t)allocClass;
+    item = (DirPathHashItem *)hash_search_with_hash_value(PathDirHash[partitionIndex],
+                                                          (const void *)&storedKey,
+                                                          hashcode,
+                                                          HASH_ENTER_NULL,
+                                                          found);
+    if (item == NULL) {
+        DirPathNameFree(partition, name, allocClass);
+        return NULL;
+    }
+    uint32 slot = partition->freeSlots[--partition->freeSlotCount];
+    partition->slots[slot] = item;
+    item->clockSlot = slot;
+    item->referenced = false;
+    item->inodeId = inodeId;
+    RWLockInitialize(&item->lock);
+    partition->entryCount++;
+    partition->nameBytes += DIR_PATH_NAME_CLASS_SIZE(allocClass);
+    return item;
+}
+
+/* partition lock held exclusively, the entry must not be locked */
+static void DirPathHashRemove(int partitionIndex, DirPathHashItem *item)
+{
+    DirPathPartition *partition = DirPathPartitions[partitionIndex];
+    DirPathHashKey key = item->key;
+    uint32 slot = item->clockSlot;
+    bool found;
+    hash_search_with_hash_value(PathDirHash[partitionIndex],
+                                (const void *)&key,
+                                dir_path_hash((const void *)&key, sizeof(DirPathHashKey)),
+                                HASH_REMOVE,
+                                &found);
+    partition->slots[slot] = NULL;
+    partition->freeSlots[partition->freeSlotCount++] = slot;
+    partition->entryCount--;
+    partition->nameBytes -= DIR_PATH_NAME_CLASS_SIZE(key.nameClass);
+    DirPathNameFree(partition, (char *)key.fileName, key.nameClass);
+}
+
+/*
+ * Evict one entry of the partition, lock held exclusively. The hand skips locked entries and gives a referenced
+ * entry a second chance by clearing its bit. With minNameClass set only an entry whose name chunk is at least that
+ * big helps, the others are passed over.
+ */
+static bool DirPathCacheEvict(int partitionIndex, int minNameClass)
+{
+    DirPathPartition *partition = DirPathPartitions[partitionIndex];
+    uint64 maxScan = (uint64)partition->capacity * DIR_PATH_CLOCK_MAX_TURNS;
+    for (uint64 scanned = 0; scanned < maxScan; ++scanned) {
+        DirPathHashItem *item = partition->slots[partition->clockHand];
+        partition->clockHand = (partition->clockHand + 1) % partition->capacity;
+        if (item == NULL || !RWLockCheckDestroyable(&item->lock))
+            continue;
+        if (item->referenced) {
+            item->referenced = false;
+            continue;
+        }
+        if (item->key.nameClass < minNameClass)
+            continue;
+        DirPathHashRemove(partitionIndex, item);
+        partition->evictions++;
+        return true;
+    }
+    return false;
+}
+
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename)
 {
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, filename);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, filename);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash(&dirPathHashKey, sizeof(DirPathHashKey));
@@ -312,11 +491,11 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
 {
 
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
     LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
     LWLockAcquire(lock, LW_SHARED);
     DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
@@ -333,28 +512,16 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space
+            item = DirPathHashEnter(partitionIndex, &dirPathHashKey, hashcode, tempId, &isfound);
+            if (!item) // every entry locked, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = tempId;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
-            } else if (item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
+            } else if (isfound && item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
                 item->inodeId = tempId;
-            } else if (item->inodeId != tempId)
+            } else if (isfound && item->inodeId != tempId)
                 FALCON_ELOG_ERROR(PROGRAM_ERROR, "dir path hash table is corrupt.");
             break;
         }
@@ -364,7 +531,7 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
         InsertIntoDirectoryTable(relation, indexState, parentId, name, inodeId);
         return;
     }
-    item->usageCount++;
+    item->referenced = true;
     if (lockMode != DIR_LOCK_NONE)
         RWLockDeclare(&item->lock);
     LWLockRelease(lock);
@@ -400,11 +567,11 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
     uint64_t inodeId;
 
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
     LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
     LWLockAcquire(lock, LW_SHARED);
     DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
@@ -414,41 +581,34 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
                                                                            &isfound);
     if (!isfound || item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
         LWLockRelease(lock);
+        pg_atomic_fetch_add_u64(&DirPathPartitions[partitionIndex]->misses, 1);
         SearchDirectoryTableInfo(relation, parentId, name, &inodeId);
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space, and must allocate space for rwlock
+            item = DirPathHashEnter(partitionIndex, &dirPathHashKey, hashcode, inodeId, &isfound);
+            if (!item) // every entry locked, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = inodeId;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
-            } else if (item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
+            } else if (isfound && item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
                 item->inodeId = inodeId;
-            } else if (item->inodeId != inodeId)
+            } else if (isfound && item->inodeId != inodeId)
                 FALCON_ELOG_ERROR(PROGRAM_ERROR, "dir path hash table is corrupt.");
             break;
         }
+    } else {
+        pg_atomic_fetch_add_u64(&DirPathPartitions[partitionIndex]->hits, 1);
     }
     if (!item) {
         LWLockRelease(lock);
         return inodeId;
     }
-    item->usageCount++;
+    item->referenced = true;
+    // without a declared lock the entry may be evicted as soon as the partition lock is gone
+    inodeId = item->inodeId;
     if (lockMode != DIR_LOCK_NONE)
         RWLockDeclare(&item->lock);
     LWLockRelease(lock);
@@ -470,9 +630,11 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
     if (lockMode != DIR_LOCK_NONE) {
         RWLockUndeclare(&item->lock);
         DirectoryHashTableLastAcquiredLock = &item->lock;
+        // the holder we waited for may have committed a new inode id
+        inodeId = item->inodeId;
     }
 
-    return item->inodeId;
+    return inodeId;
 }
 void DeleteDirectoryByDirectoryHashTable(Relation relation,
                                          uint64_t parentId,
@@ -483,11 +645,11 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
     if (lockMode == DIR_LOCK_SHARED)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "not supported lockmode while deleting.");
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
     LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
     LWLockAcquire(lock, LW_SHARED);
     DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
@@ -500,25 +662,13 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space, and must allocate space for rwlock
+            item = DirPathHashEnter(partitionIndex, &dirPathHashKey, hashcode, DIR_HASH_TABLE_PATH_UNKNOWN, &isfound);
+            if (!item) // every entry locked, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = DIR_HASH_TABLE_PATH_UNKNOWN;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
             }
             break;
         }
@@ -528,7 +678,7 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
         DeleteFromDirectoryTable(relation, parentId, name);
         return;
     }
-    item->usageCount++;
+    item->referenced = true;
     if (lockMode == DIR_LOCK_EXCLUSIVE)
         RWLockDeclare(&item->lock);
     LWLockRelease(lock);
@@ -541,163 +691,128 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
 
     DeleteFromDirectoryTable(relation, parentId, name);
 
-    DirPathHashToCommitUpdateEntry(dirPathHashKey.parentId, dirPathHashKey.fileName, DIR_HASH_TABLE_PATH_NOT_EXIST);
-}
-
-static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt)
-{
-    DirPathHashItem *entry;
-    while ((entry = hash_seq_search(status)) != NULL) {
-        if (!RWLockCheckDestroyable(&entry->lock)) {
-            continue;
-        }
-        if (destroyableCnt) {
-            (*destroyableCnt)++;
-        }
-        entry->usageCount--;
-        if (entry->usageCount <= 0) {
-            hash_seq_term(status);
-            break;
-        }
-    }
-    return entry;
+    DirPathHashToCommitUpdateEntry(parentId, name, DIR_HASH_TABLE_PATH_NOT_EXIST);
 }
 
-static bool EliminateDirPathHashByLRU(int partitionIndex)
+void CommitForDirPathHash()
 {
-    if (pg_atomic_read_u32(&(PathDirHashEntryCount[partitionIndex])) <=
-        MAX_BUCKET_SUM_LRU_CLAER_BEGIN / DIR_PATH_HASH_PARTITION_SIZE)
-        return false;
-
-    HASH_SEQ_STATUS status;
-    int32_t destroyableCnt = 0;
-    DirPathHashItem *entry = NULL;
-    DirPathHashKey target;
-
-    // eliminate one
-    for (;;) {
-        LWLockAcquire(&(DirPathLWLockArray[partitionIndex].lock), LW_SHARED);
-        hash_seq_init(&status, PathDirHash[partitionIndex]);
-        status.curBucket = rand() % PathDirHash[partitionIndex]->hctl->max_bucket;
-        entry = FindNextItem(&status, NULL);
-        while (entry == NULL) {
-            destroyableCnt = 0;
-            hash_seq_init(&status, PathDirHash[partitionIndex]);
-            entry = FindNextItem(&status, &destroyableCnt);
-            if (destroyableCnt == 0) {
-                break;
-            }
-        }
-        if (entry != NULL) {
-            strcpy(target.fileName, entry->key.fileName);
-            target.parentId = entry->key.parentId;
-        }
-        LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-
-        if (entry == NULL) // no candidate
-            return false;
-
+    for (int i = 0; i < DirPathHashToCommitSize; ++i) {
+        DirPathHashToCommitItem *info = &DirPathHashToCommitActionInfo[i];
+        DirPathHashKey key;
+        DirPathHashKeyInit(&key, info->parentId, info->fileName);
         bool found;
-        uint32 hashcode = dir_path_hash((const void *)&target, sizeof(DirPathHashKey));
-        LWLockAcquire(&(DirPathLWLockArray[partitionIndex].lock), LW_EXCLUSIVE);
-        entry = hash_search_with_hash_value(PathDirHash[partitionIndex],
-                                            (const void *)&target,
-                                            hashcode,
-                                            HASH_FIND,
-                                            &found);
-        if (!found || !RWLockCheckDestroyable(&entry->lock)) {
-            LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-            continue;
-        }
-        hash_search_with_hash_value(PathDirHash[partitionIndex], (const void *)&target, hashcode, HASH_REMOVE, &found);
-        LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-        if (found) // succeed in eliminating
-            break;
+        uint32 hashcode = dir_path_hash((const void *)&key, sizeof(DirPathHashKey));
+        LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
+        LWLockAcquire(lock, LW_EXCLUSIVE);
+        DirPathHashItem *item =
+            DirPathHashEnter(DIR_PATH_HASH_PARTITION_INDEX(hashcode), &key, hashcode, info->inodeId, &found);
+        if (item)
+            item->inodeId = info->inodeId;
+        LWLockRelease(lock);
     }
 
-    pg_atomic_fetch_sub_u32(&(PathDirHashEntryCount[partitionIndex]), 1);
-    return true;
+    DirPathHashToCommitClear();
 }
 
-void CommitForDirPathHash()
+void AbortForDirPathHash() { DirPathHashToCommitClear(); }
+
+uint64_t DirPathHashLockedInodeId(RWLock *lock)
 {
-    // switch()
-    for (int i = 0; i < DirPathHashToCommitSize; ++i) {
-        switch (DirPathHashToCommitAction[i]) {
-        case 'A': {
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
-            int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
-            EliminateDirPathHashByLRU(partitionIndex);
+    DirPathHashItem *item = (DirPathHashItem *)((char *)lock - offsetof(DirPathHashItem, lock));
+    return item->inodeId;
+}
 
-            break;
-        }
-        case 'U': {
-            bool found;
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
-            LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
-            LWLockAcquire(lock, LW_EXCLUSIVE);
-            DirPathHashItem *item = hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                (const void *)&(DirPathHashToCommitActionInfo[i].key),
-                                                                hashcode,
-                                                                HASH_ENTER_NULL,
-                                                                &found);
-            if (!found && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                item->key.parentId = DirPathHashToCommitActionInfo[i].key.parentId;
-                strcpy(item->key.fileName, DirPathHashToCommitActionInfo[i].key.fileName);
-            }
-            if (item)
-                item->inodeId = DirPathHashToCommitActionInfo[i].inodeId;
-            LWLockRelease(lock);
-            break;
-        }
-        default: {
-            FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong action !");
-        }
-        }
+static void DirPathPartitionReset(DirPathPartition *partition)
+{
+    partition->entryCount = 0;
+    partition->clockHand = 0;
+    partition->freeSlotCount = partition->capacity;
+    for (uint32 i = 0; i < partition->capacity; ++i) {
+        partition->slots[i] = NULL;
+        partition->freeSlots[i] = partition->capacity - 1 - i;
     }
-
-    DirPathHashToCommitClear();
+    partition->arenaUsed = 0;
+    partition->nameBytes = 0;
+    memset(partition->freeNames, 0, sizeof(partition->freeNames));
 }
 
-void AbortForDirPathHash() { DirPathHashToCommitClear(); }
-
 void ClearDirPathHash()
 {
+    // the prefix cache points into the entries, it takes no new ones until they are all gone
+    DirPathPrefixCacheBlock();
     for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
         LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_EXCLUSIVE);
         hash_clear(PathDirHash[i]);
+        DirPathPartitionReset(DirPathPartitions[i]);
         LWLockRelease(&(DirPathLWLockArray[i].lock));
     }
+    DirPathPrefixCacheUnblock();
+}
+
+static uint32 DirPathPartitionCapacity(void)
+{
+    return (FalconDirPathCacheCapacity + DIR_PATH_HASH_PARTITION_SIZE - 1) / DIR_PATH_HASH_PARTITION_SIZE;
+}
+
+/* the partition header followed by its clock slots, its free slot stack and its name arena */
+static Size DirPathPartitionSize(void)
+{
+    uint32 capacity = DirPathPartitionCapacity();
+    Size size = MAXALIGN(sizeof(DirPathPartition));
+    size = add_size(size, MAXALIGN(mul_size(capacity, sizeof(DirPathHashItem *))));
+    size = add_size(size, MAXALIGN(mul_size(capacity, sizeof(uint32))));
+    size = add_size(size, MAXALIGN(mul_size(capacity, DIR_PATH_NAME_AVG_BYTES)));
+    return size;
 }
 
 size_t DirPathShmemsize()
 {
-    return (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE +
-           (sizeof(DirPathHashItem)) * MAX_DIRECTORY_PATH_HASH_CAPACITY;
+    Size size = mul_size(sizeof(LWLockPadded), DIR_PATH_HASH_PARTITION_SIZE);
+    size = add_size(size, mul_size(DirPathPartitionSize(), DIR_PATH_HASH_PARTITION_SIZE));
+    Size hashSize = hash_estimate_size(DirPathPartitionCapacity(), sizeof(DirPathHashItem));
+    size = add_size(size, mul_size(hashSize, DIR_PATH_HASH_PARTITION_SIZE));
+    return size;
 }
 
 void DirPathShmemInit()
 {
-    srand((unsigned)time(NULL) + 0xD5F1);
-
     bool initialized;
-    DirPathLWLockArray =
-        ShmemInitStruct("Cucuoo path directory walk path resolution LWLock",
-                        (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE,
-                        &initialized);
-    PathDirHashEntryCount = (pg_atomic_uint32 *)(DirPathLWLockArray + DIR_PATH_HASH_PARTITION_SIZE);
+    DirPathLWLockArray = ShmemInitStruct("Cucuoo path directory walk path resolution LWLock",
+                                         sizeof(LWLockPadded) * DIR_PATH_HASH_PARTITION_SIZE,
+                                         &initialized);
     if (!initialized) {
         DirPathLWLockTrancheId = LWLockNewTrancheId();
         LWLockRegisterTranche(DirPathLWLockTrancheId, DirPathLWLockTrancheName);
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
             LWLockInitialize(&(DirPathLWLockArray[i].lock), DirPathLWLockTrancheId);
-            pg_atomic_init_u32(PathDirHashEntryCount + i, 0);
         }
     }
+
+    uint32 capacity = DirPathPartitionCapacity();
+    Size partitionSize = DirPathPartitionSize();
+    char *partitionBase =
+        ShmemInitStruct("Falcon path directory cache partitions", mul_size(partitionSize, DIR_PATH_HASH_PARTITION_SIZE),
+                        &initialized);
+    for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
+        char *base = partitionBase + partitionSize * i;
+        DirPathPartition *partition = (DirPathPartition *)base;
+        DirPathPartitions[i] = partition;
+        if (initialized)
+            continue;
+        base += MAXALIGN(sizeof(DirPathPartition));
+        partition->slots = (DirPathHashItem **)base;
+        base += MAXALIGN(sizeof(DirPathHashItem *) * capacity);
+        partition->freeSlots = (uint32 *)base;
+        base += MAXALIGN(sizeof(uint32) * capacity);
+        partition->arena = base;
+        partition->arenaSize = (Size)capacity * DIR_PATH_NAME_AVG_BYTES;
+        partition->capacity = capacity;
+        partition->evictions = 0;
+        pg_atomic_init_u64(&partition->hits, 0);
+        pg_atomic_init_u64(&partition->misses, 0);
+        DirPathPartitionReset(partition);
+    }
+
     HASHCTL info;
 
     info.keysize = sizeof(DirPathHashKey);
@@ -708,11 +823,8 @@ void DirPathShmemInit()
     char buf[64];
     for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
         sprintf(buf, "Falcon path directory hash %d", i);
-        PathDirHash[i] = ShmemInitHash(buf,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
-                                       &info,
-                                       HASH_ELEM | HASH_FUNCTION | HASH_KEYCOPY | HASH_COMPARE);
+        PathDirHash[i] =
+            ShmemInitHash(buf, capacity, capacity, &info, HASH_ELEM | HASH_FUNCTION | HASH_KEYCOPY | HASH_COMPARE);
         if (!PathDirHash[i]) {
             elog(FATAL, "invalid shmem status when creating path directory hash ");
         }
@@ -0,0 +1,225 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "dir_path_shmem/dir_path_prefix_cache.h"
+
+#include "postgres.h"
+
+#include "common/hashfn.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+
+/* entries of a set share one hash value modulo the set number, a full set replaces its least recently used entry */
+#define DIR_PATH_PREFIX_WAYS 4
+#define DIR_PATH_PREFIX_PARTITION_SIZE 128
+
+typedef struct DirPathPrefixEntry
+{
+    uint64 hash; /* 0 marks an empty way */
+    pg_atomic_uint64 lastUse;
+    uint16 pathLen;
+    uint16 depth;
+    uint64_t inodeIds[DIR_PATH_PREFIX_MAX_DEPTH];
+    RWLock *locks[DIR_PATH_PREFIX_MAX_DEPTH];
+    char path[DIR_PATH_PREFIX_MAX_PATH];
+} DirPathPrefixEntry;
+
+typedef struct DirPathPrefixCacheControl
+{
+    uint32 setNum;
+    pg_atomic_uint64 useClock;
+    /* held shared by inserts, exclusively while the cache is blocked */
+    LWLockPadded insertLock;
+    LWLockPadded locks[DIR_PATH_PREFIX_PARTITION_SIZE];
+} DirPathPrefixCacheControl;
+
+static DirPathPrefixCacheControl *PrefixCacheControl = NULL;
+static DirPathPrefixEntry *PrefixCacheEntries = NULL;
+static int DirPathPrefixLWLockTrancheId;
+static char *DirPathPrefixLWLockTrancheName = "Falcon dir path prefix cache";
+
+int FalconDirPathPrefixCacheCapacity = DIR_PATH_PREFIX_CACHE_CAPACITY_DEFAULT;
+
+#define DIR_PATH_PREFIX_SET_LOCK(set) (&(PrefixCacheControl->locks[(set) % DIR_PATH_PREFIX_PARTITION_SIZE].lock))
+
+static uint32 DirPathPrefixSetNum(void)
+{
+    if (FalconDirPathPrefixCacheCapacity <= 0)
+        return 0;
+    return Max(FalconDirPathPrefixCacheCapacity / DIR_PATH_PREFIX_WAYS, 1);
+}
+
+static uint64 DirPathPrefixHash(const char *path, int pathLen)
+{
+    uint64 hash = hash_bytes_extended((const unsigned char *)path, pathLen, 0);
+    return hash == 0 ? 1 : hash;
+}
+
+static DirPathPrefixEntry *DirPathPrefixFind(uint32 set, uint64 hash, const char *path, int pathLen)
+{
+    DirPathPrefixEntry *ways = PrefixCacheEntries + (Size)set * DIR_PATH_PREFIX_WAYS;
+    for (int i = 0; i < DIR_PATH_PREFIX_WAYS; ++i) {
+        if (ways[i].hash == hash && ways[i].pathLen == pathLen && memcmp(ways[i].path, path, pathLen) == 0)
+            return &ways[i];
+    }
+    return NULL;
+}
+
+/* set lock held exclusively */
+static void DirPathPrefixEntryClear(DirPathPrefixEntry *entry)
+{
+    for (int i = 0; i < entry->depth; ++i)
+        RWLockUnpin(entry->locks[i]);
+    entry->hash = 0;
+    entry->depth = 0;
+    entry->pathLen = 0;
+}
+
+size_t DirPathPrefixCacheShmemsize()
+{
+    Size size = MAXALIGN(sizeof(DirPathPrefixCacheControl));
+    size = add_size(size, mul_size(mul_size(DirPathPrefixSetNum(), DIR_PATH_PREFIX_WAYS), sizeof(DirPathPrefixEntry)));
+    return size;
+}
+
+void DirPathPrefixCacheShmemInit()
+{
+    bool initialized;
+    uint32 setNum = DirPathPrefixSetNum();
+    char *base = ShmemInitStruct("Falcon dir path prefix cache", DirPathPrefixCacheShmemsize(), &initialized);
+    PrefixCacheControl = (DirPathPrefixCacheControl *)base;
+    PrefixCacheEntries = (DirPathPrefixEntry *)(base + MAXALIGN(sizeof(DirPathPrefixCacheControl)));
+    if (!initialized) {
+        PrefixCacheControl->setNum = setNum;
+        pg_atomic_init_u64(&PrefixCacheControl->useClock, 0);
+        DirPathPrefixLWLockTrancheId = LWLockNewTrancheId();
+        LWLockRegisterTranche(DirPathPrefixLWLockTrancheId, DirPathPrefixLWLockTrancheName);
+        LWLockInitialize(&(PrefixCacheControl->insertLock.lock), DirPathPrefixLWLockTrancheId);
+        for (int i = 0; i < DIR_PATH_PREFIX_PARTITION_SIZE; ++i) {
+            LWLockInitialize(&(PrefixCacheControl->locks[i].lock), DirPathPrefixLWLockTrancheId);
+        }
+        for (Size i = 0; i < (Size)setNum * DIR_PATH_PREFIX_WAYS; ++i) {
+            PrefixCacheEntries[i].hash = 0;
+            PrefixCacheEntries[i].depth = 0;
+            PrefixCacheEntries[i].pathLen = 0;
+            pg_atomic_init_u64(&PrefixCacheEntries[i].lastUse, 0);
+        }
+    }
+}
+
+int DirPathPrefixCacheLookup(const char *path, int pathLen, uint64_t *inodeIds, RWLock **locks)
+{
+    if (PrefixCacheControl == NULL || PrefixCacheControl->setNum == 0 || pathLen >= DIR_PATH_PREFIX_MAX_PATH)
+        return 0;
+
+    uint64 hash = DirPathPrefixHash(path, pathLen);
+    uint32 set = hash % PrefixCacheControl->setNum;
+    LWLock *lock = DIR_PATH_PREFIX_SET_LOCK(set);
+    int depth = 0;
+    LWLockAcquire(lock, LW_SHARED);
+    DirPathPrefixEntry *entry = DirPathPrefixFind(set, hash, path, pathLen);
+    if (entry != NULL) {
+        depth = entry->depth;
+        for (int i = 0; i < depth; ++i) {
+            inodeIds[i] = entry->inodeIds[i];
+            locks[i] = entry->locks[i];
+            // the pin of the entry goes away with it, the declaration keeps the lock alive for the caller
+            RWLockDeclare(locks[i]);
+        }
+        pg_atomic_write_u64(&entry->lastUse, pg_atomic_fetch_add_u64(&PrefixCacheControl->useClock, 1));
+    }
+    LWLockRelease(lock);
+    return depth;
+}
+
+void DirPathPrefixCacheInsert(const char *path, int pathLen, const uint64_t *inodeIds, RWLock *const *locks, int depth)
+{
+    if (PrefixCacheControl == NULL || PrefixCacheControl->setNum == 0 || pathLen >= DIR_PATH_PREFIX_MAX_PATH ||
+        depth <= 0 || depth > DIR_PATH_PREFIX_MAX_DEPTH)
+        return;
+
+    uint64 hash = DirPathPrefixHash(path, pathLen);
+    uint32 set = hash % PrefixCacheControl->setNum;
+    LWLock *lock = DIR_PATH_PREFIX_SET_LOCK(set);
+    LWLockAcquire(&(PrefixCacheControl->insertLock.lock), LW_SHARED);
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    if (DirPathPrefixFind(set, hash, path, pathLen) != NULL) {
+        LWLockRelease(lock);
+        LWLockRelease(&(PrefixCacheControl->insertLock.lock));
+        return;
+    }
+    DirPathPrefixEntry *ways = PrefixCacheEntries + (Size)set * DIR_PATH_PREFIX_WAYS;
+    DirPathPrefixEntry *victim = &ways[0];
+    for (int i = 0; i < DIR_PATH_PREFIX_WAYS && victim->hash != 0; ++i) {
+        if (ways[i].hash == 0 || pg_atomic_read_u64(&ways[i].lastUse) < pg_atomic_read_u64(&victim->lastUse))
+            victim = &ways[i];
+    }
+    if (victim->hash != 0)
+        DirPathPrefixEntryClear(victim);
+
+    for (int i = 0; i < depth; ++i) {
+        victim->inodeIds[i] = inodeIds[i];
+        victim->locks[i] = locks[i];
+        RWLockPin(locks[i]);
+    }
+    memcpy(victim->path, path, pathLen);
+    victim->pathLen = pathLen;
+    victim->depth = depth;
+    victim->hash = hash;
+    pg_atomic_write_u64(&victim->lastUse, pg_atomic_fetch_add_u64(&PrefixCacheControl->useClock, 1));
+    LWLockRelease(lock);
+    LWLockRelease(&(PrefixCacheControl->insertLock.lock));
+}
+
+void DirPathPrefixCacheDrop(const char *path, int pathLen)
+{
+    if (PrefixCacheControl == NULL || PrefixCacheControl->setNum == 0 || pathLen >= DIR_PATH_PREFIX_MAX_PATH)
+        return;
+
+    uint64 hash = DirPathPrefixHash(path, pathLen);
+    uint32 set = hash % PrefixCacheControl->setNum;
+    LWLock *lock = DIR_PATH_PREFIX_SET_LOCK(set);
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    DirPathPrefixEntry *entry = DirPathPrefixFind(set, hash, path, pathLen);
+    if (entry != NULL)
+        DirPathPrefixEntryClear(entry);
+    LWLockRelease(lock);
+}
+
+bool DirPathPrefixCacheFlush()
+{
+    bool dropped = false;
+    if (PrefixCacheControl == NULL)
+        return false;
+    for (uint32 partition = 0; partition < DIR_PATH_PREFIX_PARTITION_SIZE; ++partition) {
+        LWLockAcquire(&(PrefixCacheControl->locks[partition].lock), LW_EXCLUSIVE);
+        for (uint32 set = partition; set < PrefixCacheControl->setNum; set += DIR_PATH_PREFIX_PARTITION_SIZE) {
+            DirPathPrefixEntry *ways = PrefixCacheEntries + (Size)set * DIR_PATH_PREFIX_WAYS;
+            for (int i = 0; i < DIR_PATH_PREFIX_WAYS; ++i) {
+                if (ways[i].hash != 0) {
+                    DirPathPrefixEntryClear(&ways[i]);
+                    dropped = true;
+                }
+            }
+        }
+        LWLockRelease(&(PrefixCacheControl->locks[partition].lock));
+    }
+    return dropped;
+}
+
+void DirPathPrefixCacheBlock()
+{
+    if (PrefixCacheControl == NULL)
+        return;
+    LWLockAcquire(&(PrefixCacheControl->insertLock.lock), LW_EXCLUSIVE);
+    DirPathPrefixCacheFlush();
+}
+
+void DirPathPrefixCacheUnblock()
+{
+    if (PrefixCacheControl == NULL)
+        return;
+    LWLockRelease(&(PrefixCacheControl->insertLock.lock));
+}
@@ -233,6 +233,8 @@ void FalconPrepareCommands()
 
     const char *commands[] = {
         "PREPARE cs_meta_call(int, int, bytea) AS SELECT falcon_meta_call_by_serialized_data($1, $2, $3);",
+        "PREPARE cs_meta_call_shmem(int, int, bigint, bigint, bigint) AS "
+        "SELECT falcon_meta_call_by_serialized_shmem_internal($1, $2, $3, $4, $5);",
     };
 
     for (int i = 0; i < sizeof(commands) / sizeof(char *); ++i) {
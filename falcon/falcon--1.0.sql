@@ -180,6 +180,14 @@ CREATE FUNCTION pg_catalog.falcon_release_hash_lock(IN path cstring, IN parentId
 COMMENT ON FUNCTION pg_catalog.falcon_release_hash_lock(IN path cstring, IN parentId bigint)
     IS 'falcon release hash lock';
 
+CREATE FUNCTION pg_catalog.falcon_dir_path_cache_stats()
+    RETURNS TABLE(capacity bigint, entries bigint, name_bytes_used bigint, name_bytes_total bigint,
+                  hits bigint, misses bigint, evictions bigint)
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_dir_path_cache_stats$$;
+COMMENT ON FUNCTION pg_catalog.falcon_dir_path_cache_stats()
+    IS 'falcon dir path cache capacity, usage and hit statistics';
+
 ----------------------------------------------------------------
 -- falcon_transaction_cleanup
 ----------------------------------------------------------------
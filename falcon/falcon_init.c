@@ -17,7 +17,10 @@
 #include "control/control_flag.h"
 #include "control/hook.h"
 #include "dir_path_shmem/dir_path_hash.h"
+#include "dir_path_shmem/dir_path_prefix_cache.h"
 #include "metadb/foreign_server.h"
+#include "metadb/meta_readdir.h"
+#include "metadb/meta_serialize_interface_helper.h"
 #include "metadb/metadata.h"
 #include "metadb/shard_table.h"
 #include "transaction/transaction.h"
@@ -161,6 +164,7 @@ static void FalconShmemRequest(void)
     RequestAddinShmemSpace(ForeignServerShmemsize());
     RequestAddinShmemSpace(ShardTableShmemsize());
     RequestAddinShmemSpace(DirPathShmemsize());
+    RequestAddinShmemSpace(DirPathPrefixCacheShmemsize());
     RequestAddinShmemSpace(FalconConnectionPoolShmemsize());
     RequestAddinShmemSpace(FalconPluginShmemSize());
     RequestAddinShmemSpace(FalconPerRequestStatShmemSize());
@@ -178,6 +182,7 @@ static void FalconShmemInit(void)
     ForeignServerShmemInit();
     ShardTableShmemInit();
     DirPathShmemInit();
+    DirPathPrefixCacheShmemInit();
     FalconConnectionPoolShmemInit();
     FalconPluginShmemInit();
     FalconPerRequestStatShmemInit();
@@ -276,6 +281,83 @@ static void RegisterFalconConfigVariables(void)
                             NULL,
                             NULL);
 
+    DefineCustomIntVariable("falcon_connection_pool.dispatcher_num",
+                            gettext_noop("dispatcher threads of the pool manager, 0 polls with wait_min/wait_max."),
+                            NULL,
+                            &FalconConnectionPoolDispatcherNum,
+                            FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT,
+                            0,
+                            16,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.batch_latency_slo",
+                            gettext_noop("target latency in mus of one batch, 0 always batches up to batch_size."),
+                            NULL,
+                            &FalconConnectionPoolBatchLatencySlo,
+                            FALCON_CONNECTION_POOL_BATCH_LATENCY_SLO_DEFAULT,
+                            0,
+                            10000000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomStringVariable("falcon_connection_pool.batch_latency_slo_override",
+                              gettext_noop("per batch type target latency in mus, e.g. stat=500,create=4000."),
+                              NULL,
+                              &FalconConnectionPoolBatchLatencySloOverride,
+                              NULL,
+                              PGC_POSTMASTER,
+                              0,
+                              NULL,
+                              NULL,
+                              NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.batch_linger_max",
+                            gettext_noop("max time in mus a short batch waits for more jobs, 0 never waits."),
+                            NULL,
+                            &FalconConnectionPoolBatchLingerMax,
+                            FALCON_CONNECTION_POOL_BATCH_LINGER_MAX_DEFAULT,
+                            0,
+                            1000000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.pipeline_depth",
+                            gettext_noop("batches in flight on one connection in libpq pipeline mode, 1 disables it."),
+                            NULL,
+                            &FalconConnectionPoolPipelineDepth,
+                            FALCON_CONNECTION_POOL_PIPELINE_DEPTH_DEFAULT,
+                            1,
+                            FALCON_CONNECTION_POOL_PIPELINE_DEPTH_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.shed_queue_depth",
+                            gettext_noop("queued jobs of one type beyond which background requests are held back and "
+                                         "then failed, 0 admits all."),
+                            NULL,
+                            &FalconConnectionPoolShedQueueDepth,
+                            FALCON_CONNECTION_POOL_SHED_QUEUE_DEPTH_DEFAULT,
+                            0,
+                            INT_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
     int FalconConnectionPoolShmemSizeInMB = FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT / 1024 / 1024;
     DefineCustomIntVariable(gettext_noop("falcon_connection_pool.shmem_size"),
                             "Shmem size of the pool manager, unit: MB.",
@@ -347,4 +429,73 @@ static void RegisterFalconConfigVariables(void)
                              NULL,
                              NULL);
 
+    DefineCustomIntVariable("falcon.dir_path_cache_capacity",
+                            gettext_noop("Number of directory entries the shared path cache holds."),
+                            NULL,
+                            &FalconDirPathCacheCapacity,
+                            DIR_PATH_CACHE_CAPACITY_DEFAULT,
+                            DIR_PATH_CACHE_CAPACITY_MIN,
+                            DIR_PATH_CACHE_CAPACITY_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.dir_path_prefix_cache_capacity",
+                            gettext_noop("Number of full directory paths the shared prefix cache holds, 0 disables "
+                                         "it."),
+                            NULL,
+                            &FalconDirPathPrefixCacheCapacity,
+                            DIR_PATH_PREFIX_CACHE_CAPACITY_DEFAULT,
+                            DIR_PATH_PREFIX_CACHE_CAPACITY_MIN,
+                            DIR_PATH_PREFIX_CACHE_CAPACITY_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.readdir_parallel_workers",
+                            gettext_noop("Parallel workers a readdir scans the local inode shards with, 0 scans them "
+                                         "one after another."),
+                            NULL,
+                            &FalconReadDirParallelWorkers,
+                            FALCON_READDIR_PARALLEL_WORKERS_DEFAULT,
+                            FALCON_READDIR_PARALLEL_WORKERS_MIN,
+                            FALCON_READDIR_PARALLEL_WORKERS_MAX,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.readdir_parallel_min_rows",
+                            gettext_noop("Rows a readdir reads serially before it scans the inode shards left with "
+                                         "parallel workers."),
+                            NULL,
+                            &FalconReadDirParallelMinRows,
+                            FALCON_READDIR_PARALLEL_MIN_ROWS_DEFAULT,
+                            FALCON_READDIR_PARALLEL_MIN_ROWS_MIN,
+                            FALCON_READDIR_PARALLEL_MIN_ROWS_MAX,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.attr_lease_ms",
+                            gettext_noop("Milliseconds a client may serve the attributes it got from its cache, 0 "
+                                         "grants no lease."),
+                            NULL,
+                            &FalconAttrLeaseMs,
+                            FALCON_ATTR_LEASE_MS_DEFAULT,
+                            FALCON_ATTR_LEASE_MS_MIN,
+                            FALCON_ATTR_LEASE_MS_MAX,
+                            PGC_SIGHUP,
+                            GUC_UNIT_MS,
+                            NULL,
+                            NULL,
+                            NULL);
+
 }
@@ -134,9 +134,9 @@ static bool ValidatePathComponentLengths(const std::string &path)
 }
 
 FalconErrorCode FalconMetaServiceSerializer::SerializeRequestToSerializedData(const FalconMetaServiceRequest &request,
-                                                                              std::vector<char> &buffer)
+                                                                              flatbuffers::DetachedBuffer &buffer)
 {
-    buffer.clear();
+    buffer = flatbuffers::DetachedBuffer();
     flatbuffers::FlatBufferBuilder builder(1024);
     flatbuffers::Offset<falcon::meta_fbs::MetaParam> meta_param;
 
@@ -542,22 +542,37 @@ FalconErrorCode FalconMetaServiceSerializer::SerializeRequestToSerializedData(co
     }
 
     builder.Finish(meta_param);
+    // keep the builder memory, the job frames it straight into the shmem of the connection pool
+    buffer = builder.Release();
 
-    SerializedData sd;
-    SerializedDataInit(&sd, NULL, 0, 0, NULL);
-    char *buf = SerializedDataApplyForSegment(&sd, builder.GetSize());
-    if (!buf) {
-        fprintf(stderr,
-                "[WARNING] [FalconMetaService] SerializeRequest: failed to allocate buffer, size=%u\n",
-                builder.GetSize());
-        return OUT_OF_MEMORY;
-    }
-    memcpy(buf, builder.GetBufferPointer(), builder.GetSize());
+    return SUCCESS;
+}
 
-    buffer.assign(sd.buffer, sd.buffer + sd.size);
-    SerializedDataDestroy(&sd);
+size_t FalconMetaServiceSerializer::SerializedRequestSize(const flatbuffers::DetachedBuffer &buffer)
+{
+    if (buffer.data() == nullptr) {
+        return 0;
+    }
+    size_t size = buffer.size();
+    size += (~(size & SERIALIZED_DATA_ALIGNMENT_MASK) + 1) & SERIALIZED_DATA_ALIGNMENT_MASK;
+    return SERIALIZED_DATA_ALIGNMENT + size;
+}
 
-    return SUCCESS;
+size_t FalconMetaServiceSerializer::WriteSerializedRequest(const flatbuffers::DetachedBuffer &buffer,
+                                                          void *dst,
+                                                          size_t dstSize)
+{
+    size_t total = SerializedRequestSize(buffer);
+    if (dst == nullptr || total == 0 || dstSize < total) {
+        return 0;
+    }
+    // same layout as SerializedDataApplyForSegment: aligned length, payload, zero padding
+    sd_size_t segmentSize = total - SERIALIZED_DATA_ALIGNMENT;
+    *(sd_size_t *)dst = SystemIsLittleEndian() ? segmentSize : ConvertBetweenBigAndLittleEndian(segmentSize);
+    char *payload = (char *)dst + SERIALIZED_DATA_ALIGNMENT;
+    memcpy(payload, buffer.data(), buffer.size());
+    memset(payload + buffer.size(), 0, segmentSize - buffer.size());
+    return total;
 }
 
 bool FalconMetaServiceSerializer::DeserializeResponseFromSerializedData(const void *data,
@@ -570,11 +585,11 @@ bool FalconMetaServiceSerializer::DeserializeResponseFromSerializedData(const vo
         return false;
     }
 
-    std::vector<char> buffer(size);
-    memcpy(&buffer[0], data, size);
+    // read in place, data may be a reply segment in the shmem of the connection pool
+    char *buffer = static_cast<char *>(const_cast<void *>(data));
 
     SerializedData sd;
-    if (!SerializedDataInit(&sd, &buffer[0], buffer.size(), buffer.size(), NULL)) {
+    if (!SerializedDataInit(&sd, buffer, size, size, NULL)) {
         fprintf(stderr, "[WARNING] [FalconMetaService] DeserializeResponse: SerializedDataInit failed\n");
         return false;
     }
@@ -585,8 +600,8 @@ bool FalconMetaServiceSerializer::DeserializeResponseFromSerializedData(const vo
         return false;
     }
 
-    char *fbs_data = &buffer[0] + SERIALIZED_DATA_ALIGNMENT;
-    sd_size_t fbs_size = *(sd_size_t *)&buffer[0];
+    char *fbs_data = buffer + SERIALIZED_DATA_ALIGNMENT;
+    sd_size_t fbs_size = *(sd_size_t *)buffer;
     if (!SystemIsLittleEndian()) {
         fbs_size = ConvertBetweenBigAndLittleEndian(fbs_size);
     }
@@ -184,16 +184,12 @@ int FalconMetaServiceJob::GetReqServiceCnt()
 
 size_t FalconMetaServiceJob::GetReqDatasize()
 {
-    return m_request_buffer.size();
+    return FalconMetaServiceSerializer::SerializedRequestSize(m_request_buffer);
 }
 
 size_t FalconMetaServiceJob::CopyOutData(void *dst, size_t dstSize)
 {
-    if (!dst || dstSize < m_request_buffer.size()) {
-        return 0;
-    }
-    memcpy(dst, m_request_buffer.data(), m_request_buffer.size());
-    return m_request_buffer.size();
+    return FalconMetaServiceSerializer::WriteSerializedRequest(m_request_buffer, dst, dstSize);
 }
 
 FalconMetaServiceType FalconMetaServiceJob::GetFalconMetaServiceType(int index)
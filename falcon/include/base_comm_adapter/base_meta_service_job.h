@@ -13,6 +13,9 @@ class BaseMetaServiceJob {
   public:
     FalconMetaServiceType opcodeForE2E;           // Opcode stored for e2e reporting in Done()
     int32_t statArrayIndex = -1;                  // Index into per-request stat array (-1 = disabled)
+    FalconRequestPriority priority = FALCON_PRIORITY_NORMAL; // Scheduling class, set on dispatch
+    uint64_t tenantId = 0;                        // Client the job is fairly queued under, set on dispatch
+    int64_t enqueueNs = 0;                        // Steady clock time the job was queued at
 
     BaseMetaServiceJob() : opcodeForE2E(NOT_SUPPORTED) {}
     virtual ~BaseMetaServiceJob() = default;
@@ -21,9 +24,15 @@ class BaseMetaServiceJob {
     virtual void Done() = 0;
 
     // Mark the job as failed before Done() on abnormal exit.
-    // HCOM overrides this to set m_response.status; BRPC relies on empty attachment.
+    // HCOM overrides this to set m_response.status; BRPC sets the error code of the response.
     virtual void MarkFailed() {}
 
+    // Mark the job as turned away by an overloaded server before Done(), the client may send it again later.
+    virtual void MarkBusy() { MarkFailed(); }
+
+    // Mark the whole request as failed with errorCode before Done(), none of its params is answered on its own.
+    virtual void MarkCallFailed(int32_t errorCode) {}
+
     // check where batch is allowed by send msg
     virtual bool IsAllowBatchProcess() = 0;
 
@@ -43,6 +52,12 @@ class BaseMetaServiceJob {
     // one Job may contains many Meta Service Request, so get service type by index
     virtual FalconMetaServiceType GetFalconMetaServiceType(int index) = 0;
 
+    // scheduling class asked for by the client, FALCON_PRIORITY_NUM leaves it to the connection pool
+    virtual FalconRequestPriority GetRequestPriority() { return FALCON_PRIORITY_NUM; }
+
+    // client the request is accounted to by fair queueing, 0 if unknown
+    virtual uint64_t GetClientId() { return 0; }
+
     // using shared flatBufferBuilder generate error response msg and reply to client
     // BrpcMetaServiceJob need recycle the data bye deleter
     using FalDataDeleter = std::function<void(void *)>;
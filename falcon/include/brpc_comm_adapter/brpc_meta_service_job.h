@@ -7,6 +7,7 @@
 #include <brpc/server.h>
 #include "base_comm_adapter/base_meta_service_job.h"
 #include "falcon_meta_rpc.pb.h"
+#include "remote_connection_utils/error_code_def.h"
 
 using namespace falcon::meta_proto;
 class BrpcMetaServiceJob : public BaseMetaServiceJob {
@@ -37,6 +38,14 @@ class BrpcMetaServiceJob : public BaseMetaServiceJob {
         m_done->Run();
     }
 
+    void MarkFailed() override { m_response->set_error_code(PROGRAM_ERROR); }
+
+    // the client sees EAGAIN as the error of the call
+    void MarkBusy() override { m_cntl->SetFailed(EAGAIN, "metadata server busy, retry later"); }
+
+    // the client reads the error from the response instead of the reply of each param
+    void MarkCallFailed(int32_t errorCode) override { m_response->set_error_code(errorCode); }
+
     // only while allow_batch_with_others set to true and all operations are same,
     // allows operations processed by batch.
     bool IsAllowBatchProcess() override
@@ -72,11 +81,36 @@ class BrpcMetaServiceJob : public BaseMetaServiceJob {
     // get falcon support meta service types
     FalconMetaServiceType GetFalconMetaServiceType(int index) override;
 
+    // scheduling class asked for by the client, the pool infers it from the request types by default
+    FalconRequestPriority GetRequestPriority() override
+    {
+        switch (m_request->priority()) {
+            case falcon::meta_proto::META_PRIORITY_INTERACTIVE:
+                return FALCON_PRIORITY_INTERACTIVE;
+            case falcon::meta_proto::META_PRIORITY_NORMAL:
+                return FALCON_PRIORITY_NORMAL;
+            case falcon::meta_proto::META_PRIORITY_BACKGROUND:
+                return FALCON_PRIORITY_BACKGROUND;
+            default:
+                return FALCON_PRIORITY_NUM;
+        }
+    }
+
+    // older clients send no id, their requests are told apart by address
+    uint64_t GetClientId() override
+    {
+        if (m_request->client_id() != 0) {
+            return m_request->client_id();
+        }
+        return butil::ip2int(m_cntl->remote_side().ip);
+    }
+
     // using shared flatBufferBuilder generate error response msg and reply to client
     void ProcessResponse(void *data, size_t size, FalDataDeleter deleter) override
     {
-        // now data transfer to response, and delete by response.
-        m_cntl->response_attachment().append_user_data(data, size, NULL);
+        // now data transfer to response, and delete by response. a reply sent straight from the shmem of the
+        // connection pool comes with the deleter releasing it, other data is freed by free()
+        m_cntl->response_attachment().append_user_data(data, size, deleter);
     }
 };
 
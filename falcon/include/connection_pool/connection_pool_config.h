@@ -34,6 +34,30 @@ extern int FalconConnectionPoolWaitMin;
 #define FALCON_CONNECTION_POOL_WAIT_MAX_DEFAULT 512
 extern int FalconConnectionPoolWaitMax;
 
+// 0 falls back to one manager thread polling all queues with the wait_* sleeps above
+#define FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT 2
+extern int FalconConnectionPoolDispatcherNum;
+
+// target latency of one batch in microseconds, batches are sized to meet it. 0 always takes batch_size jobs
+#define FALCON_CONNECTION_POOL_BATCH_LATENCY_SLO_DEFAULT 2000
+extern int FalconConnectionPoolBatchLatencySlo;
+
+// per batch type SLOs overriding the one above, e.g. "stat=500,kv_get=300"
+extern char *FalconConnectionPoolBatchLatencySloOverride;
+
+// longest time in microseconds a short batch is held back for more jobs, 0 never lingers
+#define FALCON_CONNECTION_POOL_BATCH_LINGER_MAX_DEFAULT 200
+extern int FalconConnectionPoolBatchLingerMax;
+
+// batches a connection may have sent before the reply of the first is consumed, 1 turns libpq pipeline mode off
+#define FALCON_CONNECTION_POOL_PIPELINE_DEPTH_DEFAULT 2
+#define FALCON_CONNECTION_POOL_PIPELINE_DEPTH_MAX 16
+extern int FalconConnectionPoolPipelineDepth;
+
+// jobs queued for one batch type beyond which background requests are held back and then shed, 0 admits all
+#define FALCON_CONNECTION_POOL_SHED_QUEUE_DEPTH_DEFAULT 4096
+extern int FalconConnectionPoolShedQueueDepth;
+
 #define FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT (256 * 1024 * 1024)
 extern uint64_t FalconConnectionPoolShmemSize;
 
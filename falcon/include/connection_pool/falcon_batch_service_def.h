@@ -56,4 +56,22 @@ inline FalconBatchServiceType FalconMetaServiceTypeToBatchServiceType(const Falc
     }
 }
 
+// namespace changes are what users wait for, reads often come in bulk from jobs. background is never inferred
+inline FalconRequestPriority FalconMetaServiceTypeToPriority(const FalconMetaServiceType type)
+{
+    switch (type) {
+    case FalconMetaServiceType::MKDIR:
+    case FalconMetaServiceType::CREATE:
+    case FalconMetaServiceType::UNLINK:
+    case FalconMetaServiceType::RMDIR:
+    case FalconMetaServiceType::RENAME:
+    case FalconMetaServiceType::UTIMENS:
+    case FalconMetaServiceType::CHOWN:
+    case FalconMetaServiceType::CHMOD:
+        return FALCON_PRIORITY_INTERACTIVE;
+    default:
+        return FALCON_PRIORITY_NORMAL;
+    }
+}
+
 #endif // FALCON_BATCH_SERVER_DEF_H
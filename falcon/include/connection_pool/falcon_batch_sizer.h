@@ -0,0 +1,88 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_BATCH_SIZER_H
+#define FALCON_BATCH_SIZER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// weight of the newest completed batch in the service time model
+#define BATCH_SIZER_EWMA_WEIGHT 0.125
+// a linger shorter than this costs more in wakeups than it collects
+#define BATCH_SIZER_MIN_LINGER_NS 5000
+// shortest window the arrival rate is sampled over
+#define BATCH_SIZER_RATE_WINDOW_NS 10000
+
+struct BatchDecision
+{
+    // 0 means keep lingering until lingerUntilNs
+    int batchSize{0};
+    int64_t lingerUntilNs{0};
+    // how long the dispatched jobs were held back, reported with the batch
+    int64_t lingeredNs{0};
+    int targetSize{0};
+};
+
+/*
+ * Chooses the size of the next batch of one FalconBatchServiceType. Completed batches feed a service time model
+ * cost(n) = fixed + perJob * n, fitted by exponentially weighted least squares over (batch size, duration). The target
+ * size is the largest batch that still finishes within the latency SLO. A backlog larger than all connections can take
+ * at that size is spread over them instead, the queue then drains in fewer round trips.
+ *
+ * A queue holding less than the target may linger for more jobs, but only while an idle connection would otherwise
+ * take it, at least half of the connections are busy so round trips are worth saving, and earlier batches of the type
+ * are still running, their completions and the observed arrival rate are what fills the batch. A lone synchronous
+ * client never waits for itself. The linger lasts at most maxLinger, only as long as the first waiting job still meets
+ * the SLO once the batch is done, and ends early once the arrival rate no longer promises another job before the
+ * deadline.
+ *
+ * Decide and Dispatched are called by the single dispatcher of the queue, Complete by the connection threads.
+ */
+class BatchSizer {
+  public:
+    // sloNs 0 turns the sizer off, batches then take min(queue size, maxBatch)
+    void Configure(int64_t sloNs, int64_t maxLingerNs, int maxBatch, int connNum);
+
+    // enqueued is the running count of jobs ever put into the queue
+    BatchDecision Decide(int queueSize, uint64_t enqueued, int idleConnNum, int64_t nowNs);
+
+    // a batch chosen by Decide went to a connection, Complete follows once it is done
+    void Dispatched() { m_inflight++; }
+    void Complete(int jobNum, int64_t durationNs);
+
+    // current model, for tests and logs
+    void Estimate(double &fixedNs, double &perJobNs);
+
+    int64_t GetSloNs() const { return m_sloNs; }
+
+  private:
+    int TargetSize(int queueSize, double fixedNs, double perJobNs);
+
+    int64_t m_sloNs{0};
+    int64_t m_maxLingerNs{0};
+    int m_maxBatch{1};
+    int m_connNum{1};
+
+    // time the dispatcher first saw the jobs it holds back, 0 while not lingering
+    int64_t m_lingerStartNs{0};
+    // EWMA of jobs enqueued per ns, tells whether waiting can fill a batch
+    double m_arrivalPerNs{0};
+    int64_t m_rateSampleNs{0};
+    uint64_t m_rateSampleEnqueued{0};
+    std::atomic<int> m_inflight{0};
+
+    std::mutex m_modelMutex;
+    bool m_modelValid{false};
+    double m_meanJobs{0};
+    double m_meanNs{0};
+    double m_meanJobs2{0};
+    double m_meanJobsNs{0};
+};
+
+// parse "stat=500,kv_get=300" into per type SLOs in microseconds, unknown names and bad values are skipped
+void ParseBatchLatencySloOverride(const char *spec, int64_t *sloUs, int typeNum);
+
+#endif // FALCON_BATCH_SIZER_H
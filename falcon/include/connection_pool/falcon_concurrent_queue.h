@@ -126,11 +126,13 @@ public:
     void GarbageCollectWorker() {
         while (!stop) {
             std::unique_lock lock(producers_mutex_);
-            for (auto it = active_producers_.begin(); it != active_producers_.end(); it++) {
-                if ((*it)->approx_size.load() == 0 && !((*it)->active)) {
-                    it = active_producers_.erase(it);
-                }
-            }
+            active_producers_.erase(std::remove_if(active_producers_.begin(),
+                                                   active_producers_.end(),
+                                                   [](const std::shared_ptr<ProducerInfo> &producer) {
+                                                       return producer->approx_size.load() == 0 &&
+                                                              !producer->active;
+                                                   }),
+                                    active_producers_.end());
             needGC = false;
             gcCv_.wait(lock, [this]() {
                 return needGC || stop;
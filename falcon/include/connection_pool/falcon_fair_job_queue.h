@@ -0,0 +1,56 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_FAIR_JOB_QUEUE_H
+#define FALCON_FAIR_JOB_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "base_comm_adapter/base_meta_service_job.h"
+
+// jobs a priority class may take in a row before the lower classes get their turn, by FalconRequestPriority
+#define FAIR_JOB_QUEUE_WEIGHTS {8, 4, 1}
+
+/*
+ * Jobs of one queue of the connection pool waiting for a batch, ordered by priority class and client. Classes are
+ * served by weighted round robin: a class with jobs and credit left goes before the lower ones, once every class
+ * with jobs has used its credit all of them start over with FAIR_JOB_QUEUE_WEIGHTS. A busy interactive class so
+ * gets most of the connections, while background jobs still move on. Within a class the clients take turns one
+ * job each, a client flooding the queue only delays its own jobs.
+ *
+ * Owned by the dispatcher of the queue, not thread safe.
+ */
+class FairJobQueue {
+  public:
+    // job->priority and job->tenantId have to be set
+    void Push(BaseMetaServiceJob *job);
+
+    // appends up to maxJobs jobs to jobs, returns how many
+    size_t Pop(size_t maxJobs, std::vector<BaseMetaServiceJob *> &jobs);
+
+    size_t Size() const { return m_size; }
+
+    // highest class with a waiting job, FALCON_PRIORITY_NUM while empty
+    FalconRequestPriority TopPriority() const;
+
+  private:
+    struct PriorityClass
+    {
+        std::unordered_map<uint64_t, std::deque<BaseMetaServiceJob *>> tenantJobs;
+        // tenants with waiting jobs, the front one is served next
+        std::deque<uint64_t> tenantTurns;
+        size_t size{0};
+        int credit{0};
+    };
+
+    BaseMetaServiceJob *PopFrom(PriorityClass &priorityClass);
+
+    PriorityClass m_classes[FALCON_PRIORITY_NUM];
+    size_t m_size{0};
+};
+
+#endif // FALCON_FAIR_JOB_QUEUE_H
@@ -0,0 +1,198 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace pg_connection_pool {
+
+#define MPMC_RING_QUEUE_CACHE_LINE 64
+#define MPMC_RING_QUEUE_DEFAULT_CAPACITY 16384
+
+/*
+ * Bounded multi producer multi consumer ring. Every cell carries the sequence number of its next turn: a producer
+ * may fill cell pos once its sequence is pos, a consumer may take it once it is pos + 1, after which the consumer
+ * hands it to the producer of the next lap with pos + capacity. Producers only meet on the enqueue position and
+ * consumers on the dequeue position, both on a cache line of their own, so the cost of an operation does not depend
+ * on how many threads produce. There is no per thread state to register or collect.
+ *
+ * The bulk operations claim their whole range of cells with a single CAS. A consumer takes only cells that are
+ * already filled, so jobs still leave in the order of their positions. A bulk producer may claim cells whose
+ * consumer of the previous lap has not yet finished reading them, it then waits for that read.
+ *
+ * The capacity is rounded up to a power of two. A full ring fails enqueue instead of growing.
+ */
+template <typename T>
+class MpmcRingQueue {
+  public:
+    explicit MpmcRingQueue(size_t capacity = MPMC_RING_QUEUE_DEFAULT_CAPACITY)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRingQueue(const MpmcRingQueue &) = delete;
+    MpmcRingQueue &operator=(const MpmcRingQueue &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool enqueue(const T &value) { return emplace(value); }
+
+    bool enqueue(T &&value) { return emplace(std::move(value)); }
+
+    // enqueues as many of the count values as fit, returns how many
+    template <typename InputIterator>
+    size_t enqueue_bulk(InputIterator first, size_t count)
+    {
+        if (count == 0) {
+            return 0;
+        }
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        size_t claimed = 0;
+        while (true) {
+            size_t taken = dequeuePos_.load(std::memory_order_acquire);
+            if ((ptrdiff_t)(pos - taken) < 0) {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            size_t freeCells = capacity() - std::min(pos - taken, capacity());
+            claimed = std::min(count, freeCells);
+            if (claimed == 0) {
+                return 0;
+            }
+            if (enqueuePos_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < claimed; ++i, ++first) {
+            Cell &cell = cells_[(pos + i) & mask_];
+            while (cell.seq.load(std::memory_order_acquire) != pos + i) {
+                std::this_thread::yield();
+            }
+            cell.value = *first;
+            cell.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+    bool dequeue(T &value)
+    {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)(seq - (pos + 1));
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.seq.store(pos + capacity(), std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // hands up to max_count values to func in queue order, returns how many
+    template <typename Func>
+    size_t dequeue_bulk(Func &&func, size_t max_count)
+    {
+        if (max_count == 0) {
+            return 0;
+        }
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        size_t ready = 0;
+        while (true) {
+            ready = 0;
+            while (ready < max_count &&
+                   cells_[(pos + ready) & mask_].seq.load(std::memory_order_acquire) == pos + ready + 1) {
+                ++ready;
+            }
+            if (ready == 0) {
+                // another consumer may have moved on while the cell at pos was taken
+                size_t current = dequeuePos_.load(std::memory_order_relaxed);
+                if (current == pos) {
+                    return 0;
+                }
+                pos = current;
+                continue;
+            }
+            if (dequeuePos_.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < ready; ++i) {
+            Cell &cell = cells_[(pos + i) & mask_];
+            T value = std::move(cell.value);
+            cell.seq.store(pos + i + capacity(), std::memory_order_release);
+            func(std::move(value));
+        }
+        return ready;
+    }
+
+    // values enqueued and not yet taken, exact while nobody else touches the queue
+    size_t size_approx() const
+    {
+        size_t taken = dequeuePos_.load(std::memory_order_relaxed);
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        return (ptrdiff_t)(pos - taken) > 0 ? pos - taken : 0;
+    }
+
+    bool empty() const { return size_approx() == 0; }
+
+  private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    template <typename V>
+    bool emplace(V &&value)
+    {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::forward<V>(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // the consumer of the previous lap has not taken the cell, the ring is full
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_{0};
+    alignas(MPMC_RING_QUEUE_CACHE_LINE) std::atomic<size_t> enqueuePos_{0};
+    alignas(MPMC_RING_QUEUE_CACHE_LINE) std::atomic<size_t> dequeuePos_{0};
+    char pad_[MPMC_RING_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+};
+
+} // namespace pg_connection_pool
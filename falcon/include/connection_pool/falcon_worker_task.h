@@ -6,6 +6,8 @@
 #define FALCON_WORKER_TASK_H
 
 #include <flatbuffers/flatbuffers.h>
+#include <chrono>
+#include <functional>
 #include <vector>
 #include "base_comm_adapter/base_meta_service_job.h"
 #include "connection_pool/falcon_concurrent_queue.h"
@@ -29,6 +31,18 @@ class BaseWorkerTask {
     // Here reuse FlatBufferBuilder & SerializedData for high performance
     virtual void
     DoWork(PGconn *conn, flatbuffers::FlatBufferBuilder &flatBufferBuilder, SerializedData &replyBuilder) = 0;
+
+    // a task sent as one statement may share a pipelined connection with other tasks, it is then split into
+    // SendRequest and ProcessResult with the results of earlier tasks consumed in between.
+    virtual bool SupportPipeline() { return false; }
+    virtual void SendRequest(PGconn *conn) {}
+    // takes the PGresult of the statement, NULL if none arrived
+    virtual void
+    ProcessResult(PGresult *res, flatbuffers::FlatBufferBuilder &flatBufferBuilder, SerializedData &replyBuilder)
+    {
+        if (res != NULL)
+            PQclear(res);
+    }
 };
 
 class SingleWorkerTask : public BaseWorkerTask {
@@ -54,17 +68,38 @@ class SingleWorkerTask : public BaseWorkerTask {
 };
 
 class BatchWorkerTask : public BaseWorkerTask {
+  public:
+    // told the batch size and how long the task lived once the connection is done with it
+    using FinishFunc = std::function<void(int jobNum, int64_t durationNs)>;
+
   private:
     std::vector<BaseMetaServiceJob *> m_jobList;
+    // DoWork empties m_jobList, the batch size is kept for m_finishFunc
+    int m_jobNum{0};
+    FinishFunc m_finishFunc;
+    std::chrono::steady_clock::time_point m_createTime;
+    // state between SendRequest and ProcessResult
+    FalconMetaServiceType m_serviceType{NOT_SUPPORTED};
+    uint64_t m_paramShift{0};
+    uint64_t m_statIndicesShift{0};
 
   public:
-    BatchWorkerTask(FalconShmemAllocator *allocator, std::vector<BaseMetaServiceJob *> jobList)
+    BatchWorkerTask(FalconShmemAllocator *allocator,
+                    std::vector<BaseMetaServiceJob *> jobList,
+                    FinishFunc finishFunc = nullptr)
         : BaseWorkerTask(allocator),
-          m_jobList(std::move(jobList))
+          m_jobList(std::move(jobList)),
+          m_jobNum((int)m_jobList.size()),
+          m_finishFunc(std::move(finishFunc)),
+          m_createTime(std::chrono::steady_clock::now())
     {
     }
     ~BatchWorkerTask() override
     {
+        if (m_finishFunc) {
+            auto duration = std::chrono::steady_clock::now() - m_createTime;
+            m_finishFunc(m_jobNum, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
         for (auto *job : m_jobList) {
             if (job != nullptr) {
                 job->MarkFailed();
@@ -75,6 +110,12 @@ class BatchWorkerTask : public BaseWorkerTask {
     }
     // implement logic of BatchWorker process
     void DoWork(PGconn *conn, flatbuffers::FlatBufferBuilder &flatBufferBuilder, SerializedData &replyBuilder) override;
+
+    bool SupportPipeline() override { return true; }
+    void SendRequest(PGconn *conn) override;
+    void ProcessResult(PGresult *res,
+                       flatbuffers::FlatBufferBuilder &flatBufferBuilder,
+                       SerializedData &replyBuilder) override;
 };
 
 #endif // FALCON_WORKER_TASK_H
@@ -5,7 +5,9 @@
 #ifndef FALCON_POOLER_PG_CONNECTION_H
 #define FALCON_POOLER_PG_CONNECTION_H
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -19,10 +21,20 @@
 #include "libpq-fe.h"
 #include "remote_connection_utils/serialized_data.h"
 
+/*
+ * One backend connection and the thread driving it. With a pipeline depth above 1 the connection runs in libpq
+ * pipeline mode: up to depth tasks that support it are sent, each followed by a sync point, before the reply of the
+ * oldest is consumed. The backend works on the next batch while replies of the previous one are built. A sync point
+ * per task keeps an error inside the task that caused it. Requests and replies are a few hundred bytes, the payload
+ * goes through shmem, so a bounded depth never fills the socket buffers in blocking mode. Other tasks wait until the
+ * pipeline is drained and run with pipeline mode left.
+ *
+ * m_workerFinishNotifyFunc is called once per task passed to Exec, in the order they were given.
+ */
 class PGConnection {
   private:
     typedef std::function<void(PGConnection *conn)> PGConnectionWorkFinishNotifyFunc;
-    bool working;
+    std::atomic<bool> working;
     PGConnectionWorkFinishNotifyFunc m_workerFinishNotifyFunc;
     flatbuffers::FlatBufferBuilder flatBufferBuilder;
     SerializedData replyBuilder;
@@ -30,6 +42,15 @@ class PGConnection {
     boost::concurrent::sync_queue<std::shared_ptr<BaseWorkerTask>> m_workerTaskQueue;
     std::thread thread;
     PGconn *conn;
+    int m_pipelineDepth{1};
+
+    // run a task alone, outside of pipeline mode
+    void RunExclusive(std::shared_ptr<BaseWorkerTask> &task);
+    // send a pipelined task with its sync point, false if nothing went out
+    bool SendPipelined(std::shared_ptr<BaseWorkerTask> &task);
+    // consume the results up to the sync point of the oldest pipelined task
+    void ReceivePipelined(std::shared_ptr<BaseWorkerTask> &task);
+    void ClearResults();
 
   public:
     PGConnection(PGConnectionWorkFinishNotifyFunc func, const char *ip, const int port, const char *userName);
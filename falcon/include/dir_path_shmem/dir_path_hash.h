@@ -17,17 +17,23 @@
 #include "storage/proclist_types.h"
 #include "utils/rwlock.h"
 
+/* longest cached name including the terminating zero */
 #define MAX_DIRECTORY_PATH_HASH_SIZE 256
 #define MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH 4096
 
 #define DIR_HASH_TABLE_PATH_NOT_EXIST -1
 #define DIR_HASH_TABLE_PATH_UNKNOWN -2
 
-/* A hash key for directory path */
+/*
+ * A hash key for directory path. The name of a cached entry lives in the name arena of its partition, in a chunk of
+ * nameClass, a lookup key points to the name of the caller.
+ */
 typedef struct
 {
-    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
     uint64_t parentId;
+    const char *fileName;
+    uint16_t nameLen;
+    uint8_t nameClass;
 } DirPathHashKey;
 
 /* A hash table entry */
@@ -36,7 +42,8 @@ typedef struct
     DirPathHashKey key;
     uint64_t inodeId;
     RWLock lock;
-    int32_t usageCount;
+    uint32_t clockSlot; /* position on the clock of the partition */
+    bool referenced;    /* CLOCK reference bit, set on every use */
 } DirPathHashItem;
 
 typedef enum { DIR_LOCK_EXCLUSIVE, DIR_LOCK_SHARED, DIR_LOCK_NONE } DirPathLockMode;
@@ -60,9 +67,13 @@ extern void InsertDirectoryByDirectoryHashTable(Relation relation,
                                                 DirPathLockMode lockMode);
 extern void
 DeleteDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const char *name, DirPathLockMode lockMode);
+// inode id cached with the lock of an entry, which the caller holds or keeps declared
+extern uint64_t DirPathHashLockedInodeId(RWLock *lock);
 
-#define DIRECTORY_PATH_HASH_BUCKET_NUM 2048
-#define MAX_DIRECTORY_PATH_HASH_CAPACITY 2048
-#define MAX_BUCKET_SUM_LRU_CLAER_BEGIN (MAX_DIRECTORY_PATH_HASH_CAPACITY / 4 * 3)
+/* entries the cache holds, falcon.dir_path_cache_capacity */
+#define DIR_PATH_CACHE_CAPACITY_DEFAULT (256 * 1024)
+#define DIR_PATH_CACHE_CAPACITY_MIN 2048
+#define DIR_PATH_CACHE_CAPACITY_MAX (64 * 1024 * 1024)
+extern int FalconDirPathCacheCapacity;
 
 #endif
@@ -0,0 +1,52 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_DIR_PATH_PREFIX_CACHE_H
+#define FALCON_DIR_PATH_PREFIX_CACHE_H
+
+#include "postgres.h"
+
+#include <stdint.h>
+
+#include "utils/rwlock.h"
+
+/* longest directory path and deepest directory the prefix cache takes, others resolve level by level */
+#define DIR_PATH_PREFIX_MAX_PATH 256
+#define DIR_PATH_PREFIX_MAX_DEPTH 16
+
+/* entries the prefix cache holds, falcon.dir_path_prefix_cache_capacity, 0 turns it off */
+#define DIR_PATH_PREFIX_CACHE_CAPACITY_DEFAULT (16 * 1024)
+#define DIR_PATH_PREFIX_CACHE_CAPACITY_MIN 0
+#define DIR_PATH_PREFIX_CACHE_CAPACITY_MAX (4 * 1024 * 1024)
+extern int FalconDirPathPrefixCacheCapacity;
+
+extern size_t DirPathPrefixCacheShmemsize(void);
+extern void DirPathPrefixCacheShmemInit(void);
+
+/*
+ * Cache of full directory paths, e.g. "/data/set/shard_0042", each mapped to the inode id of every directory on the
+ * way down, starting with "/", and to the dir path hash lock of each of them. An entry pins the locks of its levels
+ * so they stay valid while it is cached, it holds no lock though: whoever uses an entry takes the locks itself and
+ * checks the inode ids under them, a directory removed or renamed away since then shows up as a mismatch.
+ */
+
+/*
+ * Looks up the directory path, returns its depth, 0 on a miss. Every returned lock is declared on behalf of the
+ * caller, who must acquire and undeclare each of them or only undeclare it.
+ */
+extern int DirPathPrefixCacheLookup(const char *path, int pathLen, uint64_t *inodeIds, RWLock **locks);
+/* caches the levels of a resolved directory path, the caller holds the lock of every level */
+extern void
+DirPathPrefixCacheInsert(const char *path, int pathLen, const uint64_t *inodeIds, RWLock *const *locks, int depth);
+extern void DirPathPrefixCacheDrop(const char *path, int pathLen);
+/* drops every entry, returns whether there was any */
+extern bool DirPathPrefixCacheFlush(void);
+/*
+ * Drops every entry and keeps inserts out until DirPathPrefixCacheUnblock, so nothing caches the entries of the dir
+ * path hash again while they are cleared. Lookups go on and miss.
+ */
+extern void DirPathPrefixCacheBlock(void);
+extern void DirPathPrefixCacheUnblock(void);
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <vector>
 
+#include <flatbuffers/flatbuffers.h>
 #include "hcom_comm_adapter/falcon_meta_service.h"
 
 extern "C" {
@@ -30,20 +31,33 @@ public:
      * 将 Falcon 元数据请求序列化为 FlatBuffers 格式
      *
      * @param request: Falcon 元数据服务请求
-     * @param buffer: SerializedData 封装的 FlatBuffers 数据输出
+     * @param buffer: FlatBuffers MetaParam 输出, 由 FalconMetaServiceJob 直接封装进连接池共享内存
      * @return: SUCCESS 表示成功，其他错误码表示失败原因
      *
-     * 请求格式规范 (SerializedData):
+     * 请求格式规范 (SerializedData, 见 WriteSerializedRequest):
      * [size: 4字节] + [FlatBuffers数据: 对齐后的字节]
      */
     static FalconErrorCode SerializeRequestToSerializedData(
         const FalconMetaServiceRequest& request,
-        std::vector<char>& buffer);
+        flatbuffers::DetachedBuffer& buffer);
+
+    /**
+     * SerializedData 封装后的请求大小
+     */
+    static size_t SerializedRequestSize(const flatbuffers::DetachedBuffer& buffer);
+
+    /**
+     * 将 FlatBuffers 请求按 SerializedData 格式直接写入 dst, 不经过中间缓冲
+     *
+     * @return: 写入的字节数, dstSize 不足时返回 0
+     */
+    static size_t WriteSerializedRequest(const flatbuffers::DetachedBuffer& buffer, void* dst, size_t dstSize);
 
     /**
      * 从 FlatBuffers 格式反序列化 Falcon 元数据响应
      *
-     * @param data: SerializedData 封装的 FlatBuffers 响应数据
+     * @param data: SerializedData 封装的 FlatBuffers 响应数据,
+     *              可直接指向连接池共享内存, 不做拷贝
      * @param size: data size
      * @param response: Falcon 元数据服务响应（输出）
      * @param operation: 操作类型
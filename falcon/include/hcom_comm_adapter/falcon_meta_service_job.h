@@ -8,6 +8,7 @@
 #include <chrono>
 #include <vector>
 
+#include <flatbuffers/flatbuffers.h>
 #include "base_comm_adapter/base_meta_service_job.h"
 #include "hcom_comm_adapter/falcon_meta_service_interface.h"
 #include "remote_connection_utils/error_code_def.h"
@@ -24,6 +25,8 @@ class FalconMetaServiceJob : public BaseMetaServiceJob {
 
     void Done() override;
     void MarkFailed() override { m_response.status = PROGRAM_ERROR; }
+    void MarkBusy() override { m_response.status = POOLED_FAULT; }
+    void MarkCallFailed(int32_t errorCode) override { m_response.status = errorCode; }
     bool IsAllowBatchProcess() override;
     bool IsEmptyRequest() override;
     int GetReqServiceCnt() override;
@@ -41,7 +44,8 @@ class FalconMetaServiceJob : public BaseMetaServiceJob {
     FalconMetaServiceCallback m_callback;
     void *m_user_context;
     std::chrono::steady_clock::time_point m_start_time;
-    std::vector<char> m_request_buffer;
+    // finished MetaParam, CopyOutData frames it into the shmem of the connection pool without a staging copy
+    flatbuffers::DetachedBuffer m_request_buffer;
 };
 
 } // namespace meta_service
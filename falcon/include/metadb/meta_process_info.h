@@ -13,6 +13,19 @@ typedef struct OneReadDirResult
 {
     const char *fileName;
     uint32_t mode;
+    // the rest of the inode row, only filled for READDIRPLUS
+    uint64_t inodeId;
+    uint64_t st_dev;
+    uint64_t st_nlink;
+    uint32_t st_uid;
+    uint32_t st_gid;
+    uint64_t st_rdev;
+    int64_t st_size;
+    int64_t st_blksize;
+    int64_t st_blocks;
+    int64_t st_atim;
+    int64_t st_mtim;
+    int64_t st_ctim;
 } OneReadDirResult;
 typedef struct MetaProcessInfoData
 {
@@ -42,6 +55,7 @@ typedef struct MetaProcessInfoData
     int32_t node_id;
 
     // input(or output) for readdir
+    bool readDirPlus;
     int32_t readDirLastShardIndex;
     const char *readDirLastFileName;
     OneReadDirResult **readDirResultList;
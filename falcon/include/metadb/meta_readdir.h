@@ -0,0 +1,62 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_METADB_META_READDIR_H
+#define FALCON_METADB_META_READDIR_H
+
+#include "postgres.h"
+
+#include <stdint.h>
+
+#include "nodes/pg_list.h"
+
+#include "metadb/meta_process_info.h"
+
+/* parallel workers one readdir scans its local shards with, falcon.readdir_parallel_workers, 0 scans serially */
+#define FALCON_READDIR_PARALLEL_WORKERS_DEFAULT 4
+#define FALCON_READDIR_PARALLEL_WORKERS_MIN 0
+#define FALCON_READDIR_PARALLEL_WORKERS_MAX 64
+extern int FalconReadDirParallelWorkers;
+
+/*
+ * Rows a readdir reads serially before the shards left are handed to parallel workers,
+ * falcon.readdir_parallel_min_rows. A small directory is done before that and never pays for starting them.
+ */
+#define FALCON_READDIR_PARALLEL_MIN_ROWS_DEFAULT 1024
+#define FALCON_READDIR_PARALLEL_MIN_ROWS_MIN 0
+#define FALCON_READDIR_PARALLEL_MIN_ROWS_MAX PG_INT32_MAX
+extern int FalconReadDirParallelMinRows;
+
+/* row is only valid during the call, its palloc'd fileName goes to the callback */
+typedef void (*ReadDirRowCallback)(void *arg, const OneReadDirResult *row);
+
+/*
+ * Hands the entries of directoryId in one inode shard to callback in index order, at most maxReadCount of them.
+ * With lastFileName set the scan resumes after that entry. withAttributes fills the whole stat of each entry for
+ * READDIRPLUS, otherwise only name and mode are set. Returns the number of entries.
+ */
+int32_t ReadDirScanShard(uint64_t directoryId,
+                         int shardId,
+                         const char *lastFileName,
+                         int32_t maxReadCount,
+                         bool withAttributes,
+                         ReadDirRowCallback callback,
+                         void *arg);
+
+/*
+ * Reads the entries of directoryId in the given shards, at most maxReadCount of each, resuming the first after
+ * lastFileName if set. Fills shardResults[i] with the OneReadDirResult list of shardIds[i]. Later shards are left
+ * empty once the ones before them hold maxReadCount entries, so that concatenating the lists in order gives the same
+ * page as scanning the shards one after another. The shards are scanned serially until they produced
+ * FalconReadDirParallelMinRows rows, parallel workers scan the ones left when possible.
+ */
+void ReadDirScanShards(uint64_t directoryId,
+                       const int *shardIds,
+                       int shardNum,
+                       const char *lastFileName,
+                       int32_t maxReadCount,
+                       bool withAttributes,
+                       List **shardResults);
+
+#endif
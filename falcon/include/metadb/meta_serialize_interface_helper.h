@@ -14,6 +14,15 @@
 extern "C" {
 #endif
 
+/*
+ * How long a client may serve the attributes of a STAT, OPEN or READDIRPLUS answer from its cache before asking
+ * again, falcon.attr_lease_ms. 0 grants no lease, so clients always ask.
+ */
+#define FALCON_ATTR_LEASE_MS_DEFAULT 1000
+#define FALCON_ATTR_LEASE_MS_MIN 0
+#define FALCON_ATTR_LEASE_MS_MAX 60000
+extern int FalconAttrLeaseMs;
+
 bool SerializedDataMetaParamDecode(FalconMetaServiceType metaService,
                                    int count,
                                    SerializedData *param,
@@ -42,6 +42,28 @@ typedef struct OpcodeAccum
     GapAccum gaps[STAT_MAX_CHECKPOINTS - 1];
 } OpcodeAccum;
 
+/* Per-opcode batch sizing accumulator (in shmem, updated by the connection pool dispatchers) */
+typedef struct BatchAccum
+{
+    volatile int64_t batchCount;
+    volatile int64_t jobCount;     /* sum of chosen batch sizes */
+    volatile int64_t maxJobs;
+    volatile int64_t targetSum;    /* sum of the sizes the SLO allowed */
+    volatile int64_t lingerCount;  /* batches held back for more jobs */
+    volatile int64_t lingerSumNs;
+    volatile int64_t lingerMaxNs;
+} BatchAccum;
+
+/* Per-priority-class queueing accumulator (in shmem, updated by the connection pool) */
+typedef struct PriorityAccum
+{
+    volatile int64_t jobCount;
+    volatile int64_t queueSumNs;   /* from enqueue until taken into a task */
+    volatile int64_t queueMaxNs;
+    volatile int64_t delayCount;   /* jobs admission control held back, then admitted */
+    volatile int64_t shedCount;    /* jobs admission control failed */
+} PriorityAccum;
+
 /* Shared memory structure for per-request stats */
 typedef struct FalconPerRequestStatShmem
 {
@@ -50,6 +72,8 @@ typedef struct FalconPerRequestStatShmem
     volatile int64_t allocDropCount;   /* Requests dropped because no free slot */
     volatile int64_t statIndicesAllocDropCount; /* stat-indices shmem alloc failures (PG-side trace lost) */
     OpcodeAccum accum[NOT_SUPPORTED];
+    BatchAccum batchAccum[NOT_SUPPORTED];
+    PriorityAccum priorityAccum[FALCON_PRIORITY_NUM];
     RequestStat statArray[STAT_ARRAY_SIZE];
 } FalconPerRequestStatShmem;
 
@@ -65,7 +89,7 @@ typedef struct FalconPerRequestStatShmem
 #define CKPT_DEQUEUE        3 /* Job dequeued from queue */
 #define CKPT_CONN_ACQUIRED  4 /* PG connection obtained */
 #define CKPT_SHMEM_COPY     5 /* Data copied to shared memory */
-#define CKPT_PQ_SEND        6 /* PQsendQuery called */
+#define CKPT_PQ_SEND        6 /* request sent to PG */
 
 /*
  * Common PG envelope checkpoint indices.
@@ -199,6 +223,58 @@ static inline void StatCheckpointBroadcast(const int32_t *statIndices, int count
     }
 }
 
+/*
+ * Record one batch handed to a connection: its size, the size the latency SLO
+ * allowed and how long the dispatcher lingered for more jobs.
+ */
+static inline void StatBatch(int32_t opcode, int64_t jobs, int64_t target, int64_t lingerNs)
+{
+    if (g_FalconPerRequestStatShmem == NULL || !g_FalconPerRequestStatShmem->enabled)
+        return;
+    if (opcode < 0 || opcode >= NOT_SUPPORTED)
+        return;
+
+    BatchAccum *ba = &g_FalconPerRequestStatShmem->batchAccum[opcode];
+    __atomic_fetch_add(&ba->batchCount, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ba->jobCount, jobs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ba->targetSum, target, __ATOMIC_RELAXED);
+    atomic_max_i64(&ba->maxJobs, jobs);
+    if (lingerNs > 0) {
+        __atomic_fetch_add(&ba->lingerCount, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&ba->lingerSumNs, lingerNs, __ATOMIC_RELAXED);
+        atomic_max_i64(&ba->lingerMaxNs, lingerNs);
+    }
+}
+
+/*
+ * Record how long a job of the priority class waited in the connection pool
+ * queue before it was taken into a task.
+ */
+static inline void StatQueueWait(int32_t priority, int64_t waitNs)
+{
+    if (g_FalconPerRequestStatShmem == NULL || !g_FalconPerRequestStatShmem->enabled)
+        return;
+    if (priority < 0 || priority >= FALCON_PRIORITY_NUM)
+        return;
+
+    PriorityAccum *pa = &g_FalconPerRequestStatShmem->priorityAccum[priority];
+    __atomic_fetch_add(&pa->jobCount, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pa->queueSumNs, waitNs, __ATOMIC_RELAXED);
+    atomic_max_i64(&pa->queueMaxNs, waitNs);
+}
+
+/* Record a job admission control held back, shed if it was failed in the end. */
+static inline void StatAdmission(int32_t priority, bool shed)
+{
+    if (g_FalconPerRequestStatShmem == NULL || !g_FalconPerRequestStatShmem->enabled)
+        return;
+    if (priority < 0 || priority >= FALCON_PRIORITY_NUM)
+        return;
+
+    PriorityAccum *pa = &g_FalconPerRequestStatShmem->priorityAccum[priority];
+    __atomic_fetch_add(shed ? &pa->shedCount : &pa->delayCount, 1, __ATOMIC_RELAXED);
+}
+
 /* Convenience macro */
 #define STAT_CKPT(idx, ckpt) StatCheckpoint((idx), (ckpt))
 
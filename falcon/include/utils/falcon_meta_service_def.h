@@ -32,6 +32,15 @@ typedef enum FalconMetaServiceType {
     SLICE_GET,
     SLICE_DEL,
     FETCH_SLICE_ID,
+    READDIRPLUS,
     NOT_SUPPORTED
 } FalconMetaServiceType;
+
+// scheduling class of a request in the connection pool, lower classes are served first
+typedef enum FalconRequestPriority {
+    FALCON_PRIORITY_INTERACTIVE,
+    FALCON_PRIORITY_NORMAL,
+    FALCON_PRIORITY_BACKGROUND,
+    FALCON_PRIORITY_NUM
+} FalconRequestPriority;
 #endif // FALCON_META_SERVICE_DEF_H
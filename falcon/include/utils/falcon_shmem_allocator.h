@@ -23,6 +23,7 @@ extern "C" {
 // 2^6 = 64 -> 7 kind of size
 #define FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT 7
 
+// largest block carved out of a single page, bigger requests take a span of whole pages
 #define FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE (1024 * 1024)
 #define FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE \
     (FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE / FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT)
@@ -30,12 +31,31 @@ extern "C" {
 #define FALCON_SHMEM_ALLOCATOR_PAGE_SIZE FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE
 #define FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE
 #define FALCON_SHMEM_ALLOCATOR_PAD_SIZE 128
+
+// free blocks of one size a thread cache keeps, only sizes of which at least two fit are cached
+#define FALCON_SHMEM_ALLOCATOR_CACHE_BYTES (128 * 1024)
+#define FALCON_SHMEM_ALLOCATOR_CACHE_MAX_BLOCKS \
+    (FALCON_SHMEM_ALLOCATOR_CACHE_BYTES / FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE)
+// at the limit of the shmem an allocation waits this long for blocks to be freed before it fails
+#define FALCON_SHMEM_ALLOCATOR_WAIT_MS 5000
+
 typedef union PaddedAtomic64
 {
     atomic_uint_fast64_t data;
     char padding[FALCON_SHMEM_ALLOCATOR_PAD_SIZE];
 } PaddedAtomic64;
 
+// counters of rare events, kept in shmem next to the page control words
+typedef enum FalconShmemAllocatorCounter
+{
+    FALCON_SHMEM_ALLOCATOR_COUNTER_FAIL,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_WAIT,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_SPAN,
+    // set while a small block allocation failed and nothing was freed since, lets producers turn new requests away
+    FALCON_SHMEM_ALLOCATOR_COUNTER_EXHAUSTED,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_NUM
+} FalconShmemAllocatorCounter;
+
 typedef struct FalconShmemAllocator
 {
     char *shmem;
@@ -45,10 +65,28 @@ typedef struct FalconShmemAllocator
     // located in shmem
     PaddedAtomic64 *signatureCounter;
     PaddedAtomic64 *freeListHint;
+    PaddedAtomic64 *counters;
     PaddedAtomic64 *pageCntlArray;
     char *allocatableSpaceBase;
 } FalconShmemAllocator;
 
+typedef struct FalconShmemAllocatorStats
+{
+    uint64_t totalBytes;
+    // blocks handed out or held by thread caches
+    uint64_t usedBytes;
+    uint32_t pageCount;
+    uint32_t freePages;
+    // pages shared by used and free blocks, their free part only serves small requests
+    uint32_t partialPages;
+    // longest run of free pages, the largest span that can be allocated right now
+    uint32_t largestFreeSpan;
+    uint64_t failCount;
+    // allocations that had to wait for blocks to be freed
+    uint64_t waitCount;
+    uint64_t spanCount;
+} FalconShmemAllocatorStats;
+
 #define FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift) ((allocator)->allocatableSpaceBase + (shift))
 #define FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(pointer) (((MemoryHdr *)((char *)(pointer) - sizeof(MemoryHdr)))->size)
 #define FALCON_SHMEM_ALLOCATOR_SET_SIGNATURE(pointer, sign) \
@@ -58,6 +96,9 @@ typedef struct FalconShmemAllocator
 
 int FalconShmemAllocatorInit(FalconShmemAllocator *allocator, char *shmem, uint64_t size);
 
+// clear the control words in shmem, once by the process creating it
+void FalconShmemAllocatorReset(FalconShmemAllocator *allocator);
+
 int64_t FalconShmemAllocatorGetUniqueSignature(FalconShmemAllocator *allocator);
 
 typedef struct MemoryHdr
@@ -66,10 +107,34 @@ typedef struct MemoryHdr
     uint64_t size;
     uint64_t capacity;
 } MemoryHdr;
+
+// blocks up to FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE come from single pages, larger ones take a span of
+// contiguous pages. returns 0 while no space is left
 uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t size);
 
+// like FalconShmemAllocatorMalloc, but while the shmem is exhausted retries for up to waitMs
+uint64_t FalconShmemAllocatorMallocWait(FalconShmemAllocator *allocator, uint64_t size, int waitMs);
+
 void FalconShmemAllocatorFree(FalconShmemAllocator *allocator, uint64_t shift);
 
+// largest request that could ever succeed, bigger ones need not wait for space
+uint64_t FalconShmemAllocatorMaxAllocSize(FalconShmemAllocator *allocator);
+
+// a small block allocation failed and no block was freed since
+bool FalconShmemAllocatorIsExhausted(FalconShmemAllocator *allocator);
+
+/*
+ * A thread attached to an allocator keeps a few freed small blocks of every size and hands them out again without
+ * touching the shared page control words, a refill claims several blocks of a page at once. The thread has to
+ * detach before it exits or the allocator goes away, the cached blocks are given back then. Threads that never
+ * attach work on the shared pages directly.
+ */
+void FalconShmemAllocatorAttachThreadCache(FalconShmemAllocator *allocator);
+void FalconShmemAllocatorDetachThreadCache(void);
+
+// scans the page control words, the numbers are a snapshot while other threads go on allocating
+void FalconShmemAllocatorGetStats(FalconShmemAllocator *allocator, FalconShmemAllocatorStats *stats);
+
 // Get one FalconShmemAllocator, decouple the init and usage of FalconShmemAllocator
 // Using Register & Get to support manager multi FalconShmemAllocator is better, but not now.
 FalconShmemAllocator* GetFalconConnectionPoolShmemAllocator(void);
@@ -11,6 +11,7 @@
 #include "utils/relcache.h"
 
 #include "utils/error_log.h"
+#include "utils/rwlock.h"
 
 #define PATH_PARSE_FLAG_NOT_ROOT 1
 #define PATH_PARSE_FLAG_TARGET_IS_DIRECTORY 2
@@ -31,6 +32,7 @@ typedef struct PathParseRBTreeNode
     char *name;
     uint64_t inodeId;
     PPLockMode lockAcquired;
+    RWLock *lock; // dir path hash lock behind lockAcquired, NULL while none is held
     RBTree *children;
 } PathParseRBTreeNode;
 
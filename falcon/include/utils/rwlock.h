@@ -25,6 +25,12 @@ extern void RWLockInitialize(RWLock *lock);
 void RWLockDeclare(RWLock *lock);
 void RWLockUndeclare(RWLock *lock);
 bool RWLockCheckDestroyable(RWLock *lock);
+/*
+ * Pin and unpin only move the refcount, nothing is recorded for the backend. A pin keeps the lock from being
+ * destroyed until it is unpinned, by whichever backend, e.g. for a shared cache that outlives the transaction.
+ */
+void RWLockPin(RWLock *lock);
+void RWLockUnpin(RWLock *lock);
 void RWLockAcquire(RWLock *lock, RWLockMode mode);
 void RWLockRelease(RWLock *lock);
 void RWLockReleaseAll(bool keepInterruptHoldoffCount);
@@ -23,6 +23,7 @@
 #include "distributed_backend/remote_comm_falcon.h"
 #include "metadb/meta_handle_helper.h"
 #include "metadb/meta_process_info.h"
+#include "metadb/meta_readdir.h"
 #include "metadb/meta_serialize_interface_helper.h"
 #include "metadb/shard_table.h"
 #include "perf_counter/falcon_per_request_stat.h"
@@ -1313,105 +1314,45 @@ void FalconReadDirHandle(MetaProcessInfo info)
     List *shardTableData = GetShardTableData();
     int shardTableCount = list_length(shardTableData);
 
-    StreamSearchState state = firstCall ? NEW_SHARD : SAME_ID_GREATER_NAME;
+    // the local shards from the cursor on, only the one the cursor points at resumes after lastFileName
+    int startShardIndex = firstCall ? 0 : lastShardIndex;
+    int *localShardIndexes = palloc(sizeof(int) * Max(shardTableCount, 1));
+    int *localShardIds = palloc(sizeof(int) * Max(shardTableCount, 1));
+    int localShardCount = 0;
+    for (int shardIndex = startShardIndex; shardIndex < shardTableCount; ++shardIndex) {
+        FormData_falcon_shard_table *shard = (FormData_falcon_shard_table *)list_nth(shardTableData, shardIndex);
+        if (shard->server_id != GetLocalServerId())
+            continue;
+        localShardIndexes[localShardCount] = shardIndex;
+        localShardIds[localShardCount++] = shard->range_point;
+    }
+    const char *resumeFileName = NULL;
+    if (!firstCall && localShardCount > 0 && localShardIndexes[0] == lastShardIndex)
+        resumeFileName = lastFileName;
+
+    List **shardResults = palloc(sizeof(List *) * Max(localShardCount, 1));
+    ReadDirScanShards(directoryId,
+                      localShardIds,
+                      localShardCount,
+                      resumeFileName,
+                      maxReadCount,
+                      info->readDirPlus,
+                      shardResults);
+
+    // concatenating the shards in order keeps the cursor the same as for a serial scan
     List *resultList = NIL;
     int32_t readCount = 0;
-    int shardIndex = firstCall ? 0 : lastShardIndex;
-    while (shardIndex < shardTableCount) {
-        int workerId = ((FormData_falcon_shard_table *)list_nth(shardTableData, shardIndex))->server_id;
-        int shardId = ((FormData_falcon_shard_table *)list_nth(shardTableData, shardIndex))->range_point;
-        if (workerId != GetLocalServerId()) {
-            ++shardIndex;
-            continue;
-        }
-
-        uint64_t lowerId = CombineParentIdWithPartId(directoryId, 0);
-        uint64_t upperId = CombineParentIdWithPartId(directoryId, PART_ID_MASK);
-
-        StringInfo inodeShardName = GetInodeShardName(shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-
-        ScanKeyData scanKey[2];
-        int scanKeyCount = 2;
-        uint16_t partId;
-        uint64_t parentId_partId;
-
-        switch (state) {
-        case SAME_ID_GREATER_NAME:
-            partId = HashPartId(lastFileName);
-            parentId_partId = CombineParentIdWithPartId(directoryId, partId);
-
-            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
-            scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
-            scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_GT];
-            scanKey[1].sk_argument = CStringGetTextDatum(lastFileName);
-
-            state = GREATER_ID;
-            break;
-        case GREATER_ID:
-            partId = HashPartId(lastFileName);
-            parentId_partId = CombineParentIdWithPartId(directoryId, partId);
-
-            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GT];
-            scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
-            scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
-            scanKey[1].sk_argument = UInt64GetDatum(upperId);
-
-            state = NEW_SHARD;
-            break;
-        case NEW_SHARD:
-            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GE];
-            scanKey[0].sk_argument = UInt64GetDatum(lowerId);
-            scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
-            scanKey[1].sk_argument = UInt64GetDatum(upperId);
-            break;
-        default:
-            FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong state in FalconReadDirHandle.");
-        }
-
-        /* Time table open for inode shard */
-        Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), AccessShareLock);
-
-        /* Time the index scan for this shard */
-        SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
-                                                        GetRelationOidByName_FALCON(inodeIndexShardName->data),
-                                                        true,
-                                                        GetTransactionSnapshot(),
-                                                        scanKeyCount,
-                                                        scanKey);
-        TupleDesc tupleDescriptor = RelationGetDescr(workerInodeRel);
-
-        Datum datum;
-        bool isNull;
-        HeapTuple heapTuple;
-        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
-            OneReadDirResult *result = (OneReadDirResult *)palloc(sizeof(OneReadDirResult));
-
-            datum = heap_getattr(heapTuple, Anum_pg_dfs_file_name, tupleDescriptor, &isNull);
-            if (isNull)
-                FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name cannot be NULL.");
-            result->fileName = TextDatumGetCString(datum);
-
-            datum = heap_getattr(heapTuple, Anum_pg_dfs_file_st_mode, tupleDescriptor, &isNull);
-            if (isNull)
-                FALCON_ELOG_ERROR(PROGRAM_ERROR, "mode cannot be NULL.");
-            result->mode = DatumGetUInt32(datum);
-
-            resultList = lappend(resultList, result);
+    int shardIndex = shardTableCount;
+    for (int i = 0; i < localShardCount && readCount < maxReadCount; ++i) {
+        ListCell *cell;
+        foreach (cell, shardResults[i]) {
+            resultList = lappend(resultList, lfirst(cell));
             readCount++;
-            if (readCount >= maxReadCount)
+            if (readCount >= maxReadCount) {
+                shardIndex = localShardIndexes[i];
                 break;
+            }
         }
-
-        systable_endscan(scanDescriptor);
-        table_close(workerInodeRel, AccessShareLock);
-
-
-        if (readCount >= maxReadCount)
-            break;
-
-        if (state == NEW_SHARD)
-            ++shardIndex;
     }
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 3);
 
@@ -1700,6 +1641,86 @@ void FalconRmdirSubUnlinkHandle(MetaProcessInfo info)
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 3);
 }
 
+/*
+ * Moves the inode row of info->parentId_partId/info->name, which must be in a local shard. With
+ * info->dstParentIdPartId set it is inserted again as info->dstParentIdPartId/info->dstName, also in a local shard,
+ * otherwise its attributes are returned in info for RENAME_SUB_CREATE on the server owning the destination.
+ */
+static void RenameInodeLocally(MetaProcessInfo info)
+{
+    Datum fileInfo[Natts_pg_dfs_inode_table];
+    bool fileInfoNulls[Natts_pg_dfs_inode_table];
+
+    int srcShardId, srcWorkerId;
+    SearchShardInfoByShardValue(info->parentId_partId, &srcShardId, &srcWorkerId);
+    if (srcWorkerId != GetLocalServerId())
+        FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+
+    StringInfo srcInodeShardName = GetInodeShardName(srcShardId);
+    StringInfo srcInodeIndexShardName = GetInodeIndexShardName(srcShardId);
+
+    SetUpScanCaches();
+    ScanKeyData scanKey[2];
+    scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(info->parentId_partId);
+    scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(info->name);
+    Relation srcInodeRel = table_open(GetRelationOidByName_FALCON(srcInodeShardName->data), RowExclusiveLock);
+    SysScanDesc scanDescriptor = systable_beginscan(srcInodeRel,
+                                                    GetRelationOidByName_FALCON(srcInodeIndexShardName->data),
+                                                    true,
+                                                    GetTransactionSnapshot(),
+                                                    2,
+                                                    scanKey);
+    HeapTuple heapTuple = systable_getnext(scanDescriptor);
+    TupleDesc tupleDesc = RelationGetDescr(srcInodeRel);
+
+    if (!HeapTupleIsValid(heapTuple))
+        FALCON_ELOG_ERROR(FILE_NOT_EXISTS, "unexpected.");
+
+    heap_deform_tuple(heapTuple, tupleDesc, fileInfo, fileInfoNulls);
+    CatalogTupleDelete(srcInodeRel, &heapTuple->t_self);
+    CommandCounterIncrement();
+
+    systable_endscan(scanDescriptor);
+    table_close(srcInodeRel, RowExclusiveLock);
+
+    if (info->dstParentIdPartId != 0) {
+        int dstShardId, dstWorkerId;
+        SearchShardInfoByShardValue(info->dstParentIdPartId, &dstShardId, &dstWorkerId);
+        if (dstWorkerId != GetLocalServerId())
+            FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+
+        StringInfo dstInodeShardName = GetInodeShardName(dstShardId);
+        Relation dstInodeRel = table_open(GetRelationOidByName_FALCON(dstInodeShardName->data), RowExclusiveLock);
+
+        fileInfo[Anum_pg_dfs_file_parentid_partid - 1] = UInt64GetDatum(info->dstParentIdPartId);
+        fileInfo[Anum_pg_dfs_file_name - 1] = CStringGetTextDatum(info->dstName);
+
+        heapTuple = heap_form_tuple(tupleDesc, fileInfo, fileInfoNulls);
+        CatalogTupleInsert(dstInodeRel, heapTuple);
+        heap_freetuple(heapTuple);
+        CommandCounterIncrement();
+
+        table_close(dstInodeRel, RowExclusiveLock);
+    } else {
+        info->inodeId = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_ino - 1]);
+        info->st_dev = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_dev - 1]);
+        info->st_mode = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1]);
+        info->st_nlink = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_nlink - 1]);
+        info->st_uid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_uid - 1]);
+        info->st_gid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_gid - 1]);
+        info->st_rdev = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_rdev - 1]);
+        info->st_size = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_size - 1]);
+        info->st_blksize = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blksize - 1]);
+        info->st_blocks = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blocks - 1]);
+        info->st_atim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_atim - 1]);
+        info->st_mtim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_mtim - 1]);
+        info->st_ctim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_ctim - 1]);
+        info->node_id = DatumGetInt32(fileInfo[Anum_pg_dfs_file_primary_nodeid - 1]);
+    }
+}
+
 void FalconRenameHandle(MetaProcessInfo info)
 {
 
@@ -1713,14 +1734,13 @@ void FalconRenameHandle(MetaProcessInfo info)
     VerifyPathValidity(dstPath, 0, &dstProperty);
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 1);
 
-    if (GetLocalServerId() != 0)
-        FALCON_ELOG_ERROR(WRONG_WORKER, "rename can only be called on CN.");
-
     // 1.
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 2);
     Relation directoryRel = table_open(DirectoryRelationId(), RowExclusiveLock);
     uint64_t srcDirectoryId = CheckWhetherPathExistsInDirectoryTable(directoryRel, srcPath);
     bool renameDirectory = (srcDirectoryId != DIR_HASH_TABLE_PATH_NOT_EXIST);
+    if (renameDirectory && GetLocalServerId() != FALCON_CN_SERVER_ID)
+        FALCON_ELOG_ERROR(WRONG_WORKER, "rename of directory can only be called on CN.");
     if (renameDirectory && !(srcProperty & VERIFY_PATH_VALIDITY_PROPERTY_CAN_BE_DIRECTORY))
         FALCON_ELOG_ERROR(ARGUMENT_ERROR, "src is expected to be file, but it seems to be directory.");
     if (!renameDirectory && !(srcProperty & VERIFY_PATH_VALIDITY_PROPERTY_CAN_BE_FILE))
@@ -1799,6 +1819,21 @@ void FalconRenameHandle(MetaProcessInfo info)
     SearchShardInfoByShardValue(dstParentIdPartId, &dstShardId, &dstWorkerId);
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 6);
 
+    // a file staying on this server is moved by the local transaction, no other server takes part
+    if (!renameDirectory && srcWorkerId == GetLocalServerId() && dstWorkerId == srcWorkerId) {
+        info->parentId_partId = srcParentIdPartId;
+        info->dstParentIdPartId = dstParentIdPartId;
+        RenameInodeLocally(info);
+        STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 10);
+
+        info->errorCode = SUCCESS;
+
+        STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 11);
+        return;
+    }
+    if (GetLocalServerId() != FALCON_CN_SERVER_ID)
+        FALCON_ELOG_ERROR(WRONG_WORKER, "rename across servers can only be called on CN.");
+
     SerializedData subRenameLocallyParam;
     // 4.1
     info->parentId_partId = srcParentIdPartId;
@@ -1815,22 +1850,24 @@ void FalconRenameHandle(MetaProcessInfo info)
                                REMOTE_COMMAND_FLAG_WRITE,
                                list_make1_int(srcWorkerId));
 
-    // 4.2
-    info->parentId_partId = 0;
-    info->dstParentIdPartId = 0;
-    SerializedDataInit(&subRenameLocallyParam, NULL, 0, 0, &PgMemoryManager);
-    SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(RENAME_SUB_RENAME_LOCALLY,
-                                                                 &info,
-                                                                 NULL,
-                                                                 1,
-                                                                 &subRenameLocallyParam);
-    List *foreignServerIdList = GetAllForeignServerId(true, true);
-    foreignServerIdList = list_delete_int(foreignServerIdList, srcWorkerId);
-    FalconMetaCallOnWorkerList(RENAME_SUB_RENAME_LOCALLY,
-                               1,
-                               subRenameLocallyParam,
-                               REMOTE_COMMAND_FLAG_WRITE,
-                               foreignServerIdList);
+    // 4.2 the other servers only keep the directory table, which a file rename leaves as is
+    if (renameDirectory) {
+        info->parentId_partId = 0;
+        info->dstParentIdPartId = 0;
+        SerializedDataInit(&subRenameLocallyParam, NULL, 0, 0, &PgMemoryManager);
+        SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(RENAME_SUB_RENAME_LOCALLY,
+                                                                     &info,
+                                                                     NULL,
+                                                                     1,
+                                                                     &subRenameLocallyParam);
+        List *foreignServerIdList = GetAllForeignServerId(true, true);
+        foreignServerIdList = list_delete_int(foreignServerIdList, srcWorkerId);
+        FalconMetaCallOnWorkerList(RENAME_SUB_RENAME_LOCALLY,
+                                   1,
+                                   subRenameLocallyParam,
+                                   REMOTE_COMMAND_FLAG_WRITE,
+                                   foreignServerIdList);
+    }
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 7);
 
     MultipleServerRemoteCommandResult totalRemoteRes = FalconSendCommandAndWaitForResult();
@@ -1959,83 +1996,8 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
     }
 
     // 2.
-    Datum fileInfo[Natts_pg_dfs_inode_table];
-    bool fileInfoNulls[Natts_pg_dfs_inode_table];
-
-    int srcShardId, srcWorkerId;
-    SearchShardInfoByShardValue(info->parentId_partId, &srcShardId, &srcWorkerId);
-    if (srcWorkerId != GetLocalServerId())
-        FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
-
-    StringInfo srcInodeShardName = GetInodeShardName(srcShardId);
-    StringInfo srcInodeIndexShardName = GetInodeIndexShardName(srcShardId);
-
-    SetUpScanCaches();
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 5);
-    ScanKeyData scanKey[2];
-    scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
-    scanKey[0].sk_argument = UInt64GetDatum(info->parentId_partId);
-    scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
-    scanKey[1].sk_argument = CStringGetTextDatum(info->name);
-    Relation srcInodeRel = table_open(GetRelationOidByName_FALCON(srcInodeShardName->data), RowExclusiveLock);
-    SysScanDesc scanDescriptor = systable_beginscan(srcInodeRel,
-                                                    GetRelationOidByName_FALCON(srcInodeIndexShardName->data),
-                                                    true,
-                                                    GetTransactionSnapshot(),
-                                                    2,
-                                                    scanKey);
-    STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 6);
-    HeapTuple heapTuple = systable_getnext(scanDescriptor);
-    TupleDesc tupleDesc = RelationGetDescr(srcInodeRel);
-
-    if (!HeapTupleIsValid(heapTuple))
-        FALCON_ELOG_ERROR(FILE_NOT_EXISTS, "unexpected.");
-
-    heap_deform_tuple(heapTuple, tupleDesc, fileInfo, fileInfoNulls);
-    CatalogTupleDelete(srcInodeRel, &heapTuple->t_self);
-    STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 7);
-    CommandCounterIncrement();
-
-    systable_endscan(scanDescriptor);
-    table_close(srcInodeRel, RowExclusiveLock);
-
-    // 3.
-    if (info->dstParentIdPartId != 0) {
-        int dstShardId, dstWorkerId;
-        SearchShardInfoByShardValue(info->dstParentIdPartId, &dstShardId, &dstWorkerId);
-        if (dstWorkerId != GetLocalServerId())
-            FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
-
-        StringInfo dstInodeShardName = GetInodeShardName(dstShardId);
-        Relation dstInodeRel = table_open(GetRelationOidByName_FALCON(dstInodeShardName->data), RowExclusiveLock);
-
-        fileInfo[Anum_pg_dfs_file_parentid_partid - 1] = UInt64GetDatum(info->dstParentIdPartId);
-        fileInfo[Anum_pg_dfs_file_name - 1] = CStringGetTextDatum(info->dstName);
-
-        heapTuple = heap_form_tuple(tupleDesc, fileInfo, fileInfoNulls);
-        CatalogTupleInsert(dstInodeRel, heapTuple);
-        STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 8);
-        heap_freetuple(heapTuple);
-        CommandCounterIncrement();
-
-        table_close(dstInodeRel, RowExclusiveLock);
-    } else {
-        info->inodeId = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_ino - 1]);
-        info->st_dev = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_dev - 1]);
-        info->st_mode = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1]);
-        info->st_nlink = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_nlink - 1]);
-        info->st_uid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_uid - 1]);
-        info->st_gid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_gid - 1]);
-        info->st_rdev = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_rdev - 1]);
-        info->st_size = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_size - 1]);
-        info->st_blksize = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blksize - 1]);
-        info->st_blocks = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blocks - 1]);
-        info->st_atim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_atim - 1]);
-        info->st_mtim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_mtim - 1]);
-        info->st_ctim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_ctim - 1]);
-        info->node_id = DatumGetInt32(fileInfo[Anum_pg_dfs_file_primary_nodeid - 1]);
-    }
-
+    RenameInodeLocally(info);
     STAT_CKPT(info->statArrayIndex, CKPT_HANDLER_START + 9);
 
     info->errorCode = SUCCESS;
@@ -88,6 +88,7 @@ Datum falcon_plain_readdir(PG_FUNCTION_ARGS)
     MetaProcessInfo info = &infoData;
     info->path = path;
     info->readDirMaxReadCount = -1;
+    info->readDirPlus = false;
     info->readDirLastShardIndex = -1;
     info->readDirLastFileName = "";
 
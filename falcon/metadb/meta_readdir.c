@@ -0,0 +1,414 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "metadb/meta_readdir.h"
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/parallel.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "postmaster/bgworker.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "utils/builtins.h"
+#include "utils/snapmgr.h"
+
+#include "metadb/inode_table.h"
+#include "metadb/meta_handle_helper.h"
+#include "metadb/meta_process_info.h"
+#include "metadb/metadata.h"
+#include "utils/error_log.h"
+#include "utils/utils.h"
+
+#define READDIR_PARALLEL_KEY_SHARED UINT64CONST(0xFA1C0D1200000001)
+#define READDIR_PARALLEL_KEY_QUEUES UINT64CONST(0xFA1C0D1200000002)
+#define READDIR_PARALLEL_QUEUE_SIZE (64 * 1024)
+
+int FalconReadDirParallelWorkers = FALCON_READDIR_PARALLEL_WORKERS_DEFAULT;
+int FalconReadDirParallelMinRows = FALCON_READDIR_PARALLEL_MIN_ROWS_DEFAULT;
+
+/*
+ * State of one parallel readdir in the DSM segment. Workers claim shards in order, so the claimed shards are always
+ * a prefix of the list. No shard is claimed once the rows produced so far reach maxReadCount: the prefix then already
+ * holds a full page and the shards after it would not show up in it.
+ */
+typedef struct ReadDirParallelShared
+{
+    uint64_t directoryId;
+    int32_t maxReadCount;
+    int shardNum;
+    bool resume;
+    bool withAttributes;
+    char lastFileName[FILENAMELENGTH + 1];
+    pg_atomic_uint32 nextShard;
+    pg_atomic_uint64 rowCount;
+    int shardIds[FLEXIBLE_ARRAY_MEMBER];
+} ReadDirParallelShared;
+
+/* one entry as a worker sends it to the leader, the file name of row is not set */
+typedef struct ReadDirRowMessage
+{
+    int32_t shard;
+    OneReadDirResult row;
+    char fileName[FLEXIBLE_ARRAY_MEMBER];
+} ReadDirRowMessage;
+
+typedef struct ReadDirWorkerState
+{
+    shm_mq_handle *queue;
+    ReadDirRowMessage *message;
+    int32_t shard;
+    pg_atomic_uint64 *rowCount;
+} ReadDirWorkerState;
+
+PGDLLEXPORT void FalconReadDirParallelMain(dsm_segment *seg, shm_toc *toc);
+
+static void ReadDirFillRow(HeapTuple heapTuple, TupleDesc tupleDescriptor, OneReadDirResult *row)
+{
+    bool isNull;
+    Datum datum = heap_getattr(heapTuple, Anum_pg_dfs_file_name, tupleDescriptor, &isNull);
+    if (isNull)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name cannot be NULL.");
+    row->fileName = TextDatumGetCString(datum);
+
+    datum = heap_getattr(heapTuple, Anum_pg_dfs_file_st_mode, tupleDescriptor, &isNull);
+    if (isNull)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "mode cannot be NULL.");
+    row->mode = DatumGetUInt32(datum);
+}
+
+/* the tuple is already at hand, deforming it whole spares the client a STAT per entry */
+static void ReadDirFillRowWithAttributes(HeapTuple heapTuple, TupleDesc tupleDescriptor, OneReadDirResult *row)
+{
+    Datum datumArray[Natts_pg_dfs_inode_table];
+    bool isNullArray[Natts_pg_dfs_inode_table];
+    heap_deform_tuple(heapTuple, tupleDescriptor, datumArray, isNullArray);
+    if (isNullArray[Anum_pg_dfs_file_name - 1])
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name cannot be NULL.");
+    if (isNullArray[Anum_pg_dfs_file_st_mode - 1])
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "mode cannot be NULL.");
+    row->fileName = TextDatumGetCString(datumArray[Anum_pg_dfs_file_name - 1]);
+    row->mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
+    row->inodeId = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
+    row->st_dev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_dev - 1]);
+    row->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
+    row->st_uid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_uid - 1]);
+    row->st_gid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_gid - 1]);
+    row->st_rdev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_rdev - 1]);
+    row->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
+    row->st_blksize = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blksize - 1]);
+    row->st_blocks = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blocks - 1]);
+    row->st_atim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_atim - 1]);
+    row->st_mtim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_mtim - 1]);
+    row->st_ctim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_ctim - 1]);
+}
+
+int32_t ReadDirScanShard(uint64_t directoryId,
+                         int shardId,
+                         const char *lastFileName,
+                         int32_t maxReadCount,
+                         bool withAttributes,
+                         ReadDirRowCallback callback,
+                         void *arg)
+{
+    uint64_t upperId = CombineParentIdWithPartId(directoryId, PART_ID_MASK);
+    StreamSearchState state = lastFileName != NULL ? SAME_ID_GREATER_NAME : NEW_SHARD;
+    StringInfo inodeShardName = GetInodeShardName(shardId);
+    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
+    Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), AccessShareLock);
+    Oid workerInodeIndexOid = GetRelationOidByName_FALCON(inodeIndexShardName->data);
+    TupleDesc tupleDescriptor = RelationGetDescr(workerInodeRel);
+
+    int32_t readCount = 0;
+    bool shardDone = false;
+    while (!shardDone && readCount < maxReadCount) {
+        ScanKeyData scanKey[2];
+        uint64_t parentId_partId;
+
+        switch (state) {
+        case SAME_ID_GREATER_NAME:
+            parentId_partId = CombineParentIdWithPartId(directoryId, HashPartId(lastFileName));
+            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
+            scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+            scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_GT];
+            scanKey[1].sk_argument = CStringGetTextDatum(lastFileName);
+            state = GREATER_ID;
+            break;
+        case GREATER_ID:
+            parentId_partId = CombineParentIdWithPartId(directoryId, HashPartId(lastFileName));
+            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GT];
+            scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+            scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
+            scanKey[1].sk_argument = UInt64GetDatum(upperId);
+            shardDone = true;
+            break;
+        case NEW_SHARD:
+            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GE];
+            scanKey[0].sk_argument = UInt64GetDatum(CombineParentIdWithPartId(directoryId, 0));
+            scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
+            scanKey[1].sk_argument = UInt64GetDatum(upperId);
+            shardDone = true;
+            break;
+        default:
+            FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong state in ReadDirScanShard.");
+        }
+
+        SysScanDesc scanDescriptor =
+            systable_beginscan(workerInodeRel, workerInodeIndexOid, true, GetTransactionSnapshot(), 2, scanKey);
+        HeapTuple heapTuple;
+        while (readCount < maxReadCount && HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+            OneReadDirResult row = {0};
+            if (withAttributes)
+                ReadDirFillRowWithAttributes(heapTuple, tupleDescriptor, &row);
+            else
+                ReadDirFillRow(heapTuple, tupleDescriptor, &row);
+            callback(arg, &row);
+            readCount++;
+        }
+        systable_endscan(scanDescriptor);
+    }
+    table_close(workerInodeRel, AccessShareLock);
+    return readCount;
+}
+
+static void ReadDirAppendResult(void *arg, const OneReadDirResult *row)
+{
+    List **resultList = (List **)arg;
+    OneReadDirResult *result = (OneReadDirResult *)palloc(sizeof(OneReadDirResult));
+    *result = *row;
+    *resultList = lappend(*resultList, result);
+}
+
+static void ReadDirSendResult(void *arg, const OneReadDirResult *row)
+{
+    ReadDirWorkerState *state = (ReadDirWorkerState *)arg;
+    size_t nameLength = strlen(row->fileName);
+    if (nameLength > FILENAMELENGTH)
+        FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR, "file name %s too long.", row->fileName);
+    state->message->shard = state->shard;
+    state->message->row = *row;
+    state->message->row.fileName = NULL;
+    memcpy(state->message->fileName, row->fileName, nameLength + 1);
+    pfree((char *)row->fileName);
+    shm_mq_result res = shm_mq_send(state->queue,
+                                    offsetof(ReadDirRowMessage, fileName) + nameLength + 1,
+                                    state->message,
+                                    false,
+                                    true);
+    if (res != SHM_MQ_SUCCESS)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "readdir leader detached.");
+    pg_atomic_fetch_add_u64(state->rowCount, 1);
+}
+
+/* claims shards until there are none left or the claimed ones hold a full page, returns the shards claimed */
+static int ReadDirClaimShards(ReadDirParallelShared *shared, ReadDirRowCallback callback, void *arg, int32_t *shard)
+{
+    int claimed = 0;
+    while (pg_atomic_read_u64(&shared->rowCount) < (uint64)shared->maxReadCount) {
+        uint32 next = pg_atomic_fetch_add_u32(&shared->nextShard, 1);
+        if (next >= (uint32)shared->shardNum)
+            break;
+        *shard = next;
+        const char *lastFileName = (next == 0 && shared->resume) ? shared->lastFileName : NULL;
+        ReadDirScanShard(shared->directoryId,
+                         shared->shardIds[next],
+                         lastFileName,
+                         shared->maxReadCount,
+                         shared->withAttributes,
+                         callback,
+                         arg);
+        claimed++;
+    }
+    return claimed;
+}
+
+void FalconReadDirParallelMain(dsm_segment *seg, shm_toc *toc)
+{
+    ReadDirParallelShared *shared = shm_toc_lookup(toc, READDIR_PARALLEL_KEY_SHARED, false);
+    char *queueSpace = shm_toc_lookup(toc, READDIR_PARALLEL_KEY_QUEUES, false);
+    shm_mq *queue = (shm_mq *)(queueSpace + (Size)ParallelWorkerNumber * READDIR_PARALLEL_QUEUE_SIZE);
+    shm_mq_set_sender(queue, MyProc);
+
+    ReadDirWorkerState state;
+    state.queue = shm_mq_attach(queue, seg, NULL);
+    state.message = palloc(offsetof(ReadDirRowMessage, fileName) + FILENAMELENGTH + 1);
+    state.rowCount = &shared->rowCount;
+    SetUpScanCaches();
+    ReadDirClaimShards(shared, ReadDirSendResult, &state, &state.shard);
+    shm_mq_detach(state.queue);
+}
+
+/* counts the rows of the leader like a worker does, so that workers stop claiming as soon as they should */
+typedef struct ReadDirLeaderState
+{
+    List **shardResults;
+    int32_t shard;
+    pg_atomic_uint64 *rowCount;
+} ReadDirLeaderState;
+
+static void ReadDirLeaderAppendResult(void *arg, const OneReadDirResult *row)
+{
+    ReadDirLeaderState *state = (ReadDirLeaderState *)arg;
+    ReadDirAppendResult(&state->shardResults[state->shard], row);
+    pg_atomic_fetch_add_u64(state->rowCount, 1);
+}
+
+/*
+ * The dir path locks taken by the path walk hold interrupts until the transaction ends, so ProcessInterrupts never
+ * reads what the workers report and WaitForParallelWorkersToFinish alone would wait for them forever. Read their
+ * messages here, rethrowing a worker error, until every worker said goodbye or is gone.
+ */
+static void ReadDirHandleWorkerMessages(void)
+{
+    if (ParallelMessagePending)
+        HandleParallelMessages();
+}
+
+static void ReadDirWaitForWorkers(ParallelContext *pcxt)
+{
+    for (;;) {
+        ReadDirHandleWorkerMessages();
+        bool finished = true;
+        for (int i = 0; i < pcxt->nworkers_launched; ++i) {
+            pid_t pid;
+            if (pcxt->worker[i].error_mqh != NULL &&
+                GetBackgroundWorkerPid(pcxt->worker[i].bgwhandle, &pid) != BGWH_STOPPED)
+                finished = false;
+        }
+        if (finished)
+            break;
+        (void)WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH, 10, PG_WAIT_EXTENSION);
+        ResetLatch(MyLatch);
+    }
+    ReadDirHandleWorkerMessages();
+    WaitForParallelWorkersToFinish(pcxt);
+}
+
+static void ReadDirScanShardsInParallel(uint64_t directoryId,
+                                        const int *shardIds,
+                                        int shardNum,
+                                        const char *lastFileName,
+                                        int32_t maxReadCount,
+                                        bool withAttributes,
+                                        List **shardResults)
+{
+    int workerNum = Min(FalconReadDirParallelWorkers, shardNum);
+    Size sharedSize = add_size(offsetof(ReadDirParallelShared, shardIds), mul_size(sizeof(int), shardNum));
+
+    EnterParallelMode();
+    ParallelContext *pcxt = CreateParallelContext("falcon", "FalconReadDirParallelMain", workerNum);
+    shm_toc_estimate_chunk(&pcxt->estimator, sharedSize);
+    shm_toc_estimate_chunk(&pcxt->estimator, mul_size(READDIR_PARALLEL_QUEUE_SIZE, workerNum));
+    shm_toc_estimate_keys(&pcxt->estimator, 2);
+    InitializeParallelDSM(pcxt);
+
+    ReadDirParallelShared *shared = shm_toc_allocate(pcxt->toc, sharedSize);
+    shared->directoryId = directoryId;
+    shared->maxReadCount = maxReadCount;
+    shared->shardNum = shardNum;
+    shared->resume = lastFileName != NULL;
+    shared->withAttributes = withAttributes;
+    if (lastFileName != NULL)
+        strlcpy(shared->lastFileName, lastFileName, sizeof(shared->lastFileName));
+    pg_atomic_init_u32(&shared->nextShard, 0);
+    pg_atomic_init_u64(&shared->rowCount, 0);
+    memcpy(shared->shardIds, shardIds, sizeof(int) * shardNum);
+    shm_toc_insert(pcxt->toc, READDIR_PARALLEL_KEY_SHARED, shared);
+
+    char *queueSpace = shm_toc_allocate(pcxt->toc, mul_size(READDIR_PARALLEL_QUEUE_SIZE, workerNum));
+    for (int i = 0; i < workerNum; ++i) {
+        shm_mq *queue = shm_mq_create(queueSpace + (Size)i * READDIR_PARALLEL_QUEUE_SIZE, READDIR_PARALLEL_QUEUE_SIZE);
+        shm_mq_set_receiver(queue, MyProc);
+    }
+    shm_toc_insert(pcxt->toc, READDIR_PARALLEL_KEY_QUEUES, queueSpace);
+
+    LaunchParallelWorkers(pcxt);
+
+    int launched = pcxt->nworkers_launched;
+    shm_mq_handle **queues = palloc0(sizeof(shm_mq_handle *) * Max(launched, 1));
+    for (int i = 0; i < launched; ++i) {
+        shm_mq *queue = (shm_mq *)(queueSpace + (Size)i * READDIR_PARALLEL_QUEUE_SIZE);
+        queues[i] = shm_mq_attach(queue, pcxt->seg, pcxt->worker[i].bgwhandle);
+    }
+
+    // gather the rows of every worker into the list of their shard, until all of them detached
+    int active = launched;
+    while (active > 0) {
+        bool received = false;
+        for (int i = 0; i < launched; ++i) {
+            if (queues[i] == NULL)
+                continue;
+            Size nbytes;
+            void *data;
+            shm_mq_result res = shm_mq_receive(queues[i], &nbytes, &data, true);
+            if (res == SHM_MQ_SUCCESS) {
+                ReadDirRowMessage *message = (ReadDirRowMessage *)data;
+                OneReadDirResult row = message->row;
+                row.fileName = pstrdup(message->fileName);
+                ReadDirAppendResult(&shardResults[message->shard], &row);
+                received = true;
+            } else if (res == SHM_MQ_DETACHED) {
+                shm_mq_detach(queues[i]);
+                queues[i] = NULL;
+                active--;
+            }
+        }
+        if (!received && active > 0) {
+            (void)WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0, PG_WAIT_EXTENSION);
+            ResetLatch(MyLatch);
+            ReadDirHandleWorkerMessages();
+        }
+    }
+    ReadDirWaitForWorkers(pcxt);
+
+    // shards left over by workers that never started
+    ReadDirLeaderState leader = {.shardResults = shardResults, .shard = 0, .rowCount = &shared->rowCount};
+    ReadDirClaimShards(shared, ReadDirLeaderAppendResult, &leader, &leader.shard);
+
+    DestroyParallelContext(pcxt);
+    ExitParallelMode();
+}
+
+void ReadDirScanShards(uint64_t directoryId,
+                       const int *shardIds,
+                       int shardNum,
+                       const char *lastFileName,
+                       int32_t maxReadCount,
+                       bool withAttributes,
+                       List **shardResults)
+{
+    for (int i = 0; i < shardNum; ++i)
+        shardResults[i] = NIL;
+
+    int32_t readCount = 0;
+    for (int i = 0; i < shardNum && readCount < maxReadCount; ++i) {
+        // the directory proved big enough, the workers read the rest of the page from the shards left
+        if (FalconReadDirParallelWorkers > 0 && readCount >= FalconReadDirParallelMinRows && shardNum - i > 1 &&
+            !IsInParallelMode()) {
+            ReadDirScanShardsInParallel(directoryId,
+                                        shardIds + i,
+                                        shardNum - i,
+                                        i == 0 ? lastFileName : NULL,
+                                        maxReadCount - readCount,
+                                        withAttributes,
+                                        shardResults + i);
+            return;
+        }
+        readCount += ReadDirScanShard(directoryId,
+                                      shardIds[i],
+                                      i == 0 ? lastFileName : NULL,
+                                      maxReadCount - readCount,
+                                      withAttributes,
+                                      ReadDirAppendResult,
+                                      &shardResults[i]);
+    }
+}
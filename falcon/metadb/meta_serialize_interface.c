@@ -74,6 +74,7 @@ static SerializedData FileMetaProcess(FalconSupportMetaService metaService, int
         FalconUnlinkHandle(infoArray, count);
         break;
     case READDIR:
+    case READDIRPLUS:
         FalconReadDirHandle(infoArray[0]);
         break;
     case OPENDIR:
@@ -251,7 +252,7 @@ static SerializedData SliceIdProcess(char *paramBuffer)
 
 static SerializedData MetaProcess(FalconSupportMetaService metaService, int count, char *paramBuffer)
 {
-    if (metaService >= PLAIN_COMMAND && metaService <= CHMOD) {
+    if ((metaService >= PLAIN_COMMAND && metaService <= CHMOD) || metaService == READDIRPLUS) {
         return FileMetaProcess(metaService, count, paramBuffer);
     }
 
@@ -283,6 +284,8 @@ Datum falcon_meta_call_by_serialized_shmem_internal(PG_FUNCTION_ARGS)
     // set type to FalconMetaServiceType from the send end.
     FalconMetaServiceType metaService = (FalconMetaServiceType)type;
     FalconShmemAllocator *allocator = GetFalconConnectionPoolShmemAllocator();
+    // the backend keeps a few reply blocks of its own, given back by FalconCleanupOnExit
+    FalconShmemAllocatorAttachThreadCache(allocator);
     if (paramShmemShift > allocator->pageCount * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE)
         FALCON_ELOG_ERROR(ARGUMENT_ERROR, "paramShmemShift is invalid.");
     char *paramBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, paramShmemShift);
@@ -310,7 +313,9 @@ Datum falcon_meta_call_by_serialized_shmem_internal(PG_FUNCTION_ARGS)
     g_currentStatIndices = NULL;
     g_currentStatIndicesCount = 0;
     
-    uint64_t responseShmemShift = FalconShmemAllocatorMalloc(allocator, response.size);
+    // the pool frees replies once they are sent, wait for that rather than failing the request
+    uint64_t responseShmemShift =
+        FalconShmemAllocatorMallocWait(allocator, response.size, FALCON_SHMEM_ALLOCATOR_WAIT_MS);
     if (responseShmemShift == 0)
         FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR, "FalconShmemAllocMalloc failed. Size: %u.", response.size);
     for (int32_t si = 0; si < savedStatIndicesCount; si++) {
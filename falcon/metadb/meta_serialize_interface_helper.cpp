@@ -11,6 +11,8 @@ extern "C" {
 
 static flatbuffers::FlatBufferBuilder FlatBufferBuilderPerProcess;
 
+int FalconAttrLeaseMs = FALCON_ATTR_LEASE_MS_DEFAULT;
+
 FalconSupportMetaService MetaServiceTypeDecode(int32_t type){
     return static_cast<FalconSupportMetaService>(type);
 }
@@ -96,13 +98,15 @@ bool SerializedDataMetaParamDecode(FalconSupportMetaService metaService,
             info->node_id = closeParam->node_id();
             break;
         }
-        case FalconMetaServiceType::READDIR: {
+        case FalconMetaServiceType::READDIR:
+        case FalconMetaServiceType::READDIRPLUS: {
             if (metaParam->param_type() != falcon::meta_fbs::AnyMetaParam::AnyMetaParam_ReadDirParam) {
                 printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
                 return false;
             }
             auto readDirParam = metaParam->param_as_ReadDirParam();
             info->path = readDirParam->path()->c_str();
+            info->readDirPlus = metaService == FalconMetaServiceType::READDIRPLUS;
             info->readDirMaxReadCount = readDirParam->max_read_count();
             info->readDirLastShardIndex = readDirParam->last_shard_index();
             info->readDirLastFileName = readDirParam->last_file_name()->c_str();
@@ -464,7 +468,8 @@ static bool SerializedDataMetaResponseEncode(FalconMetaServiceType metaService,
                                                                          info->st_blocks,
                                                                          info->st_atim,
                                                                          info->st_mtim,
-                                                                         info->st_ctim);
+                                                                         info->st_ctim,
+                                                                         FalconAttrLeaseMs);
                 metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
                                                                     info->errorCode,
                                                                     falcon::meta_fbs::AnyMetaResponse_StatResponse,
@@ -486,7 +491,8 @@ static bool SerializedDataMetaResponseEncode(FalconMetaServiceType metaService,
                                                                          info->st_blocks,
                                                                          info->st_atim,
                                                                          info->st_mtim,
-                                                                         info->st_ctim);
+                                                                         info->st_ctim,
+                                                                         FalconAttrLeaseMs);
                 metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
                                                                     info->errorCode,
                                                                     falcon::meta_fbs::AnyMetaResponse_OpenResponse,
@@ -519,6 +525,39 @@ static bool SerializedDataMetaResponseEncode(FalconMetaServiceType metaService,
                                                                     readDirResponse.Union());
                 break;
             }
+            case FalconMetaServiceType::READDIRPLUS: {
+                std::vector<flatbuffers::Offset<falcon::meta_fbs::OneReadDirPlusResponse>> readDirResultList;
+                for (int j = 0; j < info->readDirResultCount; ++j) {
+                    OneReadDirResult *result = info->readDirResultList[j];
+                    readDirResultList.push_back(falcon::meta_fbs::CreateOneReadDirPlusResponseDirect(builder,
+                                                                                                    result->fileName,
+                                                                                                    result->inodeId,
+                                                                                                    result->st_dev,
+                                                                                                    result->mode,
+                                                                                                    result->st_nlink,
+                                                                                                    result->st_uid,
+                                                                                                    result->st_gid,
+                                                                                                    result->st_rdev,
+                                                                                                    result->st_size,
+                                                                                                    result->st_blksize,
+                                                                                                    result->st_blocks,
+                                                                                                    result->st_atim,
+                                                                                                    result->st_mtim,
+                                                                                                    result->st_ctim));
+                }
+                auto readDirPlusResponse =
+                    falcon::meta_fbs::CreateReadDirPlusResponseDirect(builder,
+                                                                      info->readDirLastShardIndex,
+                                                                      info->readDirLastFileName,
+                                                                      &readDirResultList,
+                                                                      FalconAttrLeaseMs);
+                metaResponse =
+                    falcon::meta_fbs::CreateMetaResponse(builder,
+                                                         info->errorCode,
+                                                         falcon::meta_fbs::AnyMetaResponse_ReadDirPlusResponse,
+                                                         readDirPlusResponse.Union());
+                break;
+            }
             case FalconMetaServiceType::OPENDIR: {
                 auto openDirResponse = falcon::meta_fbs::CreateOpenDirResponse(builder, info->inodeId);
                 metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
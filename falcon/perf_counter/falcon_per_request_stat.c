@@ -35,7 +35,7 @@ bool FalconPerfEnabled = true;
     "dequeue",       /* 3: job dequeued */ \
     "connAcquired",  /* 4: PG connection obtained */ \
     "shmemCopy",     /* 5: data copied to shmem */ \
-    "pqSend",        /* 6: PQsendQuery called */ \
+    "pqSend",        /* 6: request sent to PG */ \
     "pgEntry",       /* 7: PG function entry */ \
     "paramDecode"    /* 8: param deserialization done */
 
@@ -210,6 +210,11 @@ const char *g_checkpointNames[NOT_SUPPORTED][STAT_MAX_CHECKPOINTS] = {
     {COMMON_PREFIX,
      "handlerEntry", "scanReady", "done",
      COMMON_TAIL, NULL},
+
+    /* READDIRPLUS (27) */
+    {COMMON_PREFIX,
+     "handlerEntry", "pathVerify", "pathResolve", "shardScan", "resultBuild",
+     COMMON_TAIL, NULL},
 };
 
 /*
@@ -327,6 +332,7 @@ void PerRequestStatAggregateAndOutput(void)
     bool hasData = false;
 
     OpcodeAccum snapshot[NOT_SUPPORTED];
+    BatchAccum batchSnapshot[NOT_SUPPORTED];
     for (int op = 0; op < NOT_SUPPORTED; op++) {
         OpcodeAccum *src = &g_FalconPerRequestStatShmem->accum[op];
         snapshot[op].requestCount = __atomic_exchange_n(&src->requestCount, 0, __ATOMIC_RELAXED);
@@ -341,7 +347,29 @@ void PerRequestStatAggregateAndOutput(void)
             snapshot[op].gaps[g].max_ns = __atomic_exchange_n(&ga->max_ns, 0, __ATOMIC_RELAXED);
         }
 
-        if (snapshot[op].requestCount > 0)
+        BatchAccum *ba = &g_FalconPerRequestStatShmem->batchAccum[op];
+        batchSnapshot[op].batchCount = __atomic_exchange_n(&ba->batchCount, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].jobCount = __atomic_exchange_n(&ba->jobCount, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].maxJobs = __atomic_exchange_n(&ba->maxJobs, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].targetSum = __atomic_exchange_n(&ba->targetSum, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].lingerCount = __atomic_exchange_n(&ba->lingerCount, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].lingerSumNs = __atomic_exchange_n(&ba->lingerSumNs, 0, __ATOMIC_RELAXED);
+        batchSnapshot[op].lingerMaxNs = __atomic_exchange_n(&ba->lingerMaxNs, 0, __ATOMIC_RELAXED);
+
+        if (snapshot[op].requestCount > 0 || batchSnapshot[op].batchCount > 0)
+            hasData = true;
+    }
+
+    PriorityAccum prioritySnapshot[FALCON_PRIORITY_NUM];
+    for (int pr = 0; pr < FALCON_PRIORITY_NUM; pr++) {
+        PriorityAccum *pa = &g_FalconPerRequestStatShmem->priorityAccum[pr];
+        prioritySnapshot[pr].jobCount = __atomic_exchange_n(&pa->jobCount, 0, __ATOMIC_RELAXED);
+        prioritySnapshot[pr].queueSumNs = __atomic_exchange_n(&pa->queueSumNs, 0, __ATOMIC_RELAXED);
+        prioritySnapshot[pr].queueMaxNs = __atomic_exchange_n(&pa->queueMaxNs, 0, __ATOMIC_RELAXED);
+        prioritySnapshot[pr].delayCount = __atomic_exchange_n(&pa->delayCount, 0, __ATOMIC_RELAXED);
+        prioritySnapshot[pr].shedCount = __atomic_exchange_n(&pa->shedCount, 0, __ATOMIC_RELAXED);
+        if (prioritySnapshot[pr].jobCount > 0 || prioritySnapshot[pr].delayCount > 0 ||
+            prioritySnapshot[pr].shedCount > 0)
             hasData = true;
     }
 
@@ -360,9 +388,22 @@ void PerRequestStatAggregateAndOutput(void)
                                  (long long)statIdxDropped)));
     }
 
+    static const char *priorityNames[FALCON_PRIORITY_NUM] = {"INTERACTIVE", "NORMAL", "BACKGROUND"};
+    for (int pr = 0; pr < FALCON_PRIORITY_NUM; pr++) {
+        PriorityAccum *ps = &prioritySnapshot[pr];
+        if (ps->jobCount == 0 && ps->delayCount == 0 && ps->shedCount == 0)
+            continue;
+        double queueAvgUs = ps->jobCount > 0 ? (double)ps->queueSumNs / ps->jobCount / 1000.0 : 0.0;
+        ereport(LOG, (errmsg("[priority %s] queue avg/max=%.1f/%.1fus cnt=%lld delayed=%lld shed=%lld",
+                             priorityNames[pr], queueAvgUs, ps->queueMaxNs / 1000.0,
+                             (long long)ps->jobCount, (long long)ps->delayCount,
+                             (long long)ps->shedCount)));
+    }
+
     for (int op = 1; op < NOT_SUPPORTED; op++) {
         OpcodeAccum *os = &snapshot[op];
-        if (os->requestCount == 0)
+        BatchAccum *bs = &batchSnapshot[op];
+        if (os->requestCount == 0 && bs->batchCount == 0)
             continue;
 
         const char *opName = "UNKNOWN";
@@ -393,6 +434,7 @@ void PerRequestStatAggregateAndOutput(void)
             case SLICE_GET:                opName = "SLICE_GET"; break;
             case SLICE_DEL:                opName = "SLICE_DEL"; break;
             case FETCH_SLICE_ID:           opName = "FETCH_SLICE_ID"; break;
+            case READDIRPLUS:              opName = "READDIRPLUS"; break;
             default:                       break;
         }
 
@@ -404,6 +446,16 @@ void PerRequestStatAggregateAndOutput(void)
                              opName, e2eAvgUs, e2eSumUs,
                              (unsigned long long)os->requestCount)));
 
+        if (bs->batchCount > 0) {
+            double lingerAvgUs = bs->lingerCount > 0 ? (double)bs->lingerSumNs / bs->lingerCount / 1000.0 : 0.0;
+            ereport(LOG, (errmsg("    %-20s size avg/max=%.1f/%lld target avg=%.1f cnt=%lld "
+                                 "linger avg/max=%.1f/%.1fus cnt=%lld",
+                                 "batch",
+                                 (double)bs->jobCount / bs->batchCount, (long long)bs->maxJobs,
+                                 (double)bs->targetSum / bs->batchCount, (long long)bs->batchCount,
+                                 lingerAvgUs, bs->lingerMaxNs / 1000.0, (long long)bs->lingerCount)));
+        }
+
         const char **names = g_checkpointNames[op];
         int maxCkpt = (int)os->maxCheckpointCount;
         for (int g = 0; g < maxCkpt - 1; g++) {
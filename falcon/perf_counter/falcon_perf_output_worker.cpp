@@ -13,6 +13,7 @@ extern "C" {
 #include "storage/proc.h"
 #include "utils/elog.h"
 #include "perf_counter/falcon_per_request_stat.h"
+#include "utils/falcon_shmem_allocator.h"
 }
 
 /* Signal handling */
@@ -26,6 +27,30 @@ static void falcon_perf_output_sigterm(SIGNAL_ARGS)
     errno = save_errno;
 }
 
+/* Usage and fragmentation of the connection pool shmem */
+static void ShmemAllocatorStatOutput(void)
+{
+    FalconShmemAllocator *allocator = GetFalconConnectionPoolShmemAllocator();
+    if (allocator->shmem == NULL)
+        return;
+
+    FalconShmemAllocatorStats stats;
+    FalconShmemAllocatorGetStats(allocator, &stats);
+    uint64_t freeBytes = stats.totalBytes - stats.usedBytes;
+    /* share of the free space a single span cannot use */
+    double fragmentation =
+        freeBytes > 0
+            ? 100.0 - (double)stats.largestFreeSpan * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * 100.0 / freeBytes
+            : 0.0;
+    ereport(LOG,
+            (errmsg("Falcon shmem: used/total=%llu/%llu bytes pages free/partial/total=%u/%u/%u "
+                    "largest free span=%u pages fragmentation=%.1f%% spans=%llu waits=%llu failures=%llu",
+                    (unsigned long long)stats.usedBytes, (unsigned long long)stats.totalBytes,
+                    stats.freePages, stats.partialPages, stats.pageCount, stats.largestFreeSpan, fragmentation,
+                    (unsigned long long)stats.spanCount, (unsigned long long)stats.waitCount,
+                    (unsigned long long)stats.failCount)));
+}
+
 extern "C" __attribute__((visibility("default"))) void FalconPerfOutputWorkerMain(Datum main_arg)
 {
     /* Signal handling setup */
@@ -58,6 +83,7 @@ extern "C" __attribute__((visibility("default"))) void FalconPerfOutputWorkerMai
         }
 
         PerRequestStatAggregateAndOutput();
+        ShmemAllocatorStatOutput();
     }
 
     ereport(LOG, (errmsg("Falcon performance output worker stopped")));
@@ -7,11 +7,34 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// signature counter, free list hints and counters in front of the page control words
+#define FALCON_SHMEM_ALLOCATOR_HEAD_WORDS \
+    (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT + FALCON_SHMEM_ALLOCATOR_COUNTER_NUM)
+// spans of pages share the free list hint of whole page blocks
+#define FALCON_SHMEM_ALLOCATOR_SPAN_LEVEL 0
+// first and longest sleep of an allocation waiting for blocks to be freed
+#define FALCON_SHMEM_ALLOCATOR_WAIT_MIN_US 50
+#define FALCON_SHMEM_ALLOCATOR_WAIT_MAX_US 5000
+
+typedef struct ThreadCacheLevel
+{
+    uint32_t count;
+    uint64_t shifts[FALCON_SHMEM_ALLOCATOR_CACHE_MAX_BLOCKS];
+} ThreadCacheLevel;
+
+// free blocks held by this thread, shifts of the block heads
+static __thread FalconShmemAllocator *threadCacheAllocator = NULL;
+static __thread ThreadCacheLevel threadCache[FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT];
 
 int FalconShmemAllocatorInit(FalconShmemAllocator *allocator, char *shmem, uint64_t size)
 {
-    uint32_t pageCount = (size - sizeof(PaddedAtomic64) * (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT)) /
-                         (sizeof(PaddedAtomic64) + FALCON_SHMEM_ALLOCATOR_PAGE_SIZE);
+    uint64_t headSize = sizeof(PaddedAtomic64) * FALCON_SHMEM_ALLOCATOR_HEAD_WORDS;
+    if (size <= headSize)
+        return -1;
+    uint32_t pageCount = (size - headSize) / (sizeof(PaddedAtomic64) + FALCON_SHMEM_ALLOCATOR_PAGE_SIZE);
     if (pageCount == 0)
         return -1;
 
@@ -21,11 +44,19 @@ int FalconShmemAllocatorInit(FalconShmemAllocator *allocator, char *shmem, uint6
 
     allocator->signatureCounter = (PaddedAtomic64 *)shmem;
     allocator->freeListHint = allocator->signatureCounter + 1;
-    allocator->pageCntlArray = allocator->freeListHint + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->counters = allocator->freeListHint + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->pageCntlArray = allocator->counters + FALCON_SHMEM_ALLOCATOR_COUNTER_NUM;
     allocator->allocatableSpaceBase = (char *)(allocator->pageCntlArray + pageCount);
     return 0;
 }
 
+void FalconShmemAllocatorReset(FalconShmemAllocator *allocator)
+{
+    memset(allocator->signatureCounter,
+           0,
+           sizeof(PaddedAtomic64) * (FALCON_SHMEM_ALLOCATOR_HEAD_WORDS + allocator->pageCount));
+}
+
 int64_t FalconShmemAllocatorGetUniqueSignature(FalconShmemAllocator *allocator)
 {
     return (int64_t)atomic_fetch_add_explicit(&allocator->signatureCounter->data, 1, memory_order_relaxed) + 1;
@@ -57,22 +88,43 @@ static uint64_t LevelBlockOccupyBitMap[FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT] =
                                                                                   0x0000000000000003,
                                                                                   0x0000000000000001};
 
-uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t size)
+// blocks of the level a thread cache keeps, 0 for sizes not cached
+static inline uint32_t ThreadCacheCapacity(int level)
 {
-    if (size > FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE - sizeof(MemoryHdr)) {
-        printf("asked size exceed limit, size: %" PRIu64 ".", size);
-        fflush(stdout);
-        return 0; // valid shift of allocated buffer cannot be zero, since there must be a memory head before it
-    }
+    uint32_t capacity = FALCON_SHMEM_ALLOCATOR_CACHE_BYTES / (FALCON_SHMEM_ALLOCATOR_PAGE_SIZE >> level);
+    return capacity >= 2 ? capacity : 0;
+}
 
-    uint64_t requiredSize = size + sizeof(MemoryHdr);
-    if (requiredSize < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE)
-        requiredSize = FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE;
-    else
-        requiredSize = GetNextPowerOfTwo(requiredSize);
+static void LowerFreeListHint(FalconShmemAllocator *allocator, int level, uint64_t pageNo)
+{
+    // Maybe the freed block is fetched by others immediately before we change freeListHint, but that doesn't matter
+    uint64_t freeHint = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
+    while (true) {
+        if (freeHint <= pageNo) // do nothing as unnecessary
+            break;
+        if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
+                                                  &freeHint,
+                                                  pageNo,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+            break;
+    }
+}
 
-    int level = __builtin_ctzll(FALCON_SHMEM_ALLOCATOR_PAGE_SIZE) - __builtin_ctzll(requiredSize);
+static inline void ClearExhausted(FalconShmemAllocator *allocator)
+{
+    PaddedAtomic64 *exhausted = &allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_EXHAUSTED];
+    // only written while set, frees do not bounce the cache line otherwise
+    if (atomic_load_explicit(&exhausted->data, memory_order_relaxed) != 0)
+        atomic_store_explicit(&exhausted->data, 0, memory_order_relaxed);
+}
 
+/*
+ * Claim up to maxBlocks free blocks of the level from the first page having one, with a single update of its control
+ * word. Returns the number of blocks claimed, their shifts are written to shifts.
+ */
+static uint32_t ClaimBlocks(FalconShmemAllocator *allocator, int level, uint32_t maxBlocks, uint64_t *shifts)
+{
     for (int scan = 0; scan < 2; scan++) {
         uint64_t start;
         if (scan == 0) {
@@ -86,18 +138,19 @@ uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t si
         for (uint32_t pageNo = start; pageNo < allocator->pageCount; ++pageNo) {
             uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
 
-            uint64_t allocatedShift = -1;
-            bool succeed = false;
+            uint32_t claimed = 0;
             bool pageIsFull = false;
             while (true) {
                 uint64_t expected;
                 uint64_t desired;
+                claimed = 0;
                 if (level == 0) {
                     if (bitmap != 0) // some blocks of this page is used
                         break;
                     expected = 0;
                     desired = ~(uint64_t)0;
-                    allocatedShift = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo;
+                    shifts[claimed++] = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo;
+                    pageIsFull = true;
                 } else {
                     expected = bitmap;
 
@@ -108,24 +161,27 @@ uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t si
                         shift <<= 1;
                     }
 
-                    if (bitmap == LevelBlockMask[level]) // all of the blocks in this level is used
+                    uint64_t freeBlocks = ~bitmap & LevelBlockMask[level];
+                    if (freeBlocks == 0) // all of the blocks in this level is used
                         break;
 
-                    int firstEmptyBlockInLevel = __builtin_ctzll(~bitmap & LevelBlockMask[level]);
-                    allocatedShift = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo +
-                                     FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE * firstEmptyBlockInLevel;
-                    if (allocatedShift + requiredSize == FALCON_SHMEM_ALLOCATOR_PAGE_SIZE)
-                        pageIsFull = true;
-                    desired = expected | (LevelBlockOccupyBitMap[level] << firstEmptyBlockInLevel);
+                    desired = expected;
+                    while (freeBlocks != 0 && claimed < maxBlocks) {
+                        int emptyBlockInLevel = __builtin_ctzll(freeBlocks);
+                        freeBlocks &= freeBlocks - 1;
+                        desired |= LevelBlockOccupyBitMap[level] << emptyBlockInLevel;
+                        shifts[claimed++] = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo +
+                                            FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE * emptyBlockInLevel;
+                    }
+                    pageIsFull = freeBlocks == 0;
                 }
 
+                // acquire pairs with the release of the freeing thread, its last writes to the blocks are done
                 if (atomic_compare_exchange_strong_explicit(&allocator->pageCntlArray[pageNo].data,
                                                             &expected,
                                                             desired,
-                                                            memory_order_relaxed,
+                                                            memory_order_acquire,
                                                             memory_order_relaxed)) {
-                    succeed = true;
-
                     if (scan == 0) {
                         if (pageIsFull || pageNo != start) {
                             // Renew freelistHint if it is not changed, If freellstuint is changed by others,
@@ -137,42 +193,195 @@ uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t si
                                                                     memory_order_relaxed,
                                                                     memory_order_relaxed);
                         }
-                    } else {
-                        if (!pageIsFull) {
-                            uint64_t freeHint =
-                                atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
-                            while (true) {
-                                if (freeHint <= pageNo) // do nothing as unnecessary
-                                    break;
-                                if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
-                                                                          &freeHint,
-                                                                          pageNo,
-                                                                          memory_order_relaxed,
-                                                                          memory_order_relaxed))
-                                    break;
-                            }
-                        }
+                    } else if (!pageIsFull) {
+                        LowerFreeListHint(allocator, level, pageNo);
                     }
-
-                    break;
+                    return claimed;
                 }
                 bitmap = expected;
+                claimed = 0;
             }
+        }
+    }
+    return 0;
+}
 
-            if (succeed) {
-                if (allocatedShift == -1) {
-                    printf("unexpected situation in FalconShmemAllocatorMalloc.");
-                    fflush(stdout);
-                    return 0;
+// claim pageNum contiguous free pages, page by page, a page taken by others meanwhile gives the ones before back
+static bool ClaimSpan(FalconShmemAllocator *allocator, uint32_t pageNum, uint64_t *shift)
+{
+    PaddedAtomic64 *pages = allocator->pageCntlArray;
+    for (int scan = 0; scan < 2; scan++) {
+        uint32_t pageNo = 0;
+        if (scan == 0)
+            pageNo = atomic_load_explicit(&allocator->freeListHint[FALCON_SHMEM_ALLOCATOR_SPAN_LEVEL].data,
+                                          memory_order_relaxed);
+
+        while ((uint64_t)pageNo + pageNum <= allocator->pageCount) {
+            uint32_t run = 0;
+            while (run < pageNum && atomic_load_explicit(&pages[pageNo + run].data, memory_order_relaxed) == 0)
+                run++;
+            if (run == pageNum) {
+                run = 0;
+                while (run < pageNum) {
+                    uint64_t expected = 0;
+                    if (!atomic_compare_exchange_strong_explicit(&pages[pageNo + run].data,
+                                                                 &expected,
+                                                                 ~(uint64_t)0,
+                                                                 memory_order_acquire,
+                                                                 memory_order_relaxed))
+                        break;
+                    run++;
                 }
-                MemoryHdr *hdr = (MemoryHdr *)FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, allocatedShift);
-                hdr->size = size;
-                hdr->capacity = requiredSize;
-                hdr->signature = 0;
-                return allocatedShift + sizeof(MemoryHdr);
+                if (run == pageNum) {
+                    *shift = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * (uint64_t)pageNo;
+                    atomic_fetch_add_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_SPAN].data,
+                                              1,
+                                              memory_order_relaxed);
+                    return true;
+                }
+                for (uint32_t i = 0; i < run; i++)
+                    atomic_store_explicit(&pages[pageNo + i].data, 0, memory_order_release);
             }
+            // go on behind the page in use
+            pageNo += run + 1;
         }
     }
+    return false;
+}
+
+static bool TakeBlock(FalconShmemAllocator *allocator, int level, uint64_t *shift)
+{
+    uint32_t cacheCapacity = ThreadCacheCapacity(level);
+    if (threadCacheAllocator != allocator || cacheCapacity == 0)
+        return ClaimBlocks(allocator, level, 1, shift) == 1;
+
+    ThreadCacheLevel *cache = &threadCache[level];
+    if (cache->count == 0) {
+        // refill half of the cache, the other half takes the blocks this thread frees
+        cache->count = ClaimBlocks(allocator, level, cacheCapacity / 2, cache->shifts);
+        if (cache->count == 0)
+            return false;
+    }
+    *shift = cache->shifts[--cache->count];
+    return true;
+}
+
+static void ReleaseBlock(FalconShmemAllocator *allocator, int level, uint64_t shift)
+{
+    uint64_t pageNo = shift / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+    uint32_t blockNo = shift / FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE - pageNo * FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT;
+    uint64_t occupyBitmap = LevelBlockOccupyBitMap[level] << blockNo;
+    atomic_fetch_and_explicit(&allocator->pageCntlArray[pageNo].data, ~occupyBitmap, memory_order_release);
+    LowerFreeListHint(allocator, level, pageNo);
+}
+
+static bool FlushThreadCache(void)
+{
+    bool released = false;
+    if (threadCacheAllocator == NULL)
+        return false;
+    for (int level = 0; level < FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT; level++) {
+        ThreadCacheLevel *cache = &threadCache[level];
+        while (cache->count > 0) {
+            ReleaseBlock(threadCacheAllocator, level, cache->shifts[--cache->count]);
+            released = true;
+        }
+    }
+    if (released)
+        ClearExhausted(threadCacheAllocator);
+    return released;
+}
+
+static uint64_t AllocateBlock(FalconShmemAllocator *allocator, uint64_t size)
+{
+    uint64_t requiredSize = size + sizeof(MemoryHdr);
+    uint64_t shift = 0;
+    if (requiredSize > FALCON_SHMEM_ALLOCATOR_PAGE_SIZE) {
+        uint32_t pageNum = (requiredSize + FALCON_SHMEM_ALLOCATOR_PAGE_SIZE - 1) / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        if (!ClaimSpan(allocator, pageNum, &shift))
+            return 0;
+        requiredSize = (uint64_t)pageNum * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+    } else {
+        if (requiredSize < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE)
+            requiredSize = FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE;
+        else
+            requiredSize = GetNextPowerOfTwo(requiredSize);
+        int level = __builtin_ctzll(FALCON_SHMEM_ALLOCATOR_PAGE_SIZE) - __builtin_ctzll(requiredSize);
+        if (!TakeBlock(allocator, level, &shift))
+            return 0;
+    }
+
+    MemoryHdr *hdr = (MemoryHdr *)FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift);
+    hdr->size = size;
+    hdr->capacity = requiredSize;
+    hdr->signature = 0;
+    return shift + sizeof(MemoryHdr);
+}
+
+static uint64_t TryMalloc(FalconShmemAllocator *allocator, uint64_t size)
+{
+    uint64_t shift = AllocateBlock(allocator, size);
+    // the blocks this thread keeps for other sizes may be what the asked size lacks
+    if (shift == 0 && threadCacheAllocator == allocator && FlushThreadCache())
+        shift = AllocateBlock(allocator, size);
+    // a span may fail on fragmentation alone, only a small block failing means the shmem is out of space
+    if (shift == 0 && size + sizeof(MemoryHdr) <= FALCON_SHMEM_ALLOCATOR_PAGE_SIZE)
+        atomic_store_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_EXHAUSTED].data,
+                              1,
+                              memory_order_relaxed);
+    return shift;
+}
+
+static int64_t ElapsedMs(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+uint64_t FalconShmemAllocatorMaxAllocSize(FalconShmemAllocator *allocator)
+{
+    return (uint64_t)allocator->pageCount * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE - sizeof(MemoryHdr);
+}
+
+uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t size)
+{
+    return FalconShmemAllocatorMallocWait(allocator, size, 0);
+}
+
+uint64_t FalconShmemAllocatorMallocWait(FalconShmemAllocator *allocator, uint64_t size, int waitMs)
+{
+    if (size > FalconShmemAllocatorMaxAllocSize(allocator)) {
+        printf("asked size exceed limit, size: %" PRIu64 ".", size);
+        fflush(stdout);
+        return 0; // valid shift of allocated buffer cannot be zero, since there must be a memory head before it
+    }
+
+    uint64_t shift = TryMalloc(allocator, size);
+    if (shift != 0)
+        return shift;
+
+    if (waitMs > 0) {
+        atomic_fetch_add_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_WAIT].data,
+                                  1,
+                                  memory_order_relaxed);
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t sleepUs = FALCON_SHMEM_ALLOCATOR_WAIT_MIN_US;
+        while (ElapsedMs(&start) < waitMs) {
+            struct timespec sleepTime = {(time_t)(sleepUs / 1000000), (long)(sleepUs % 1000000) * 1000};
+            nanosleep(&sleepTime, NULL);
+            shift = TryMalloc(allocator, size);
+            if (shift != 0)
+                return shift;
+            sleepUs = sleepUs * 2 < FALCON_SHMEM_ALLOCATOR_WAIT_MAX_US ? sleepUs * 2
+                                                                       : FALCON_SHMEM_ALLOCATOR_WAIT_MAX_US;
+        }
+    }
+
+    atomic_fetch_add_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_FAIL].data,
+                              1,
+                              memory_order_relaxed);
     printf("FalconShmemAllocatorMalloc: Cannot find a segment.");
     fflush(stdout);
     return 0;
@@ -183,31 +392,86 @@ void FalconShmemAllocatorFree(FalconShmemAllocator *allocator, uint64_t shift)
     shift -= sizeof(MemoryHdr);
     MemoryHdr *hdr = (MemoryHdr *)FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift);
     uint64_t capacity = hdr->capacity;
-    if (capacity < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE ||
-        capacity > FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE)
+    if (capacity > FALCON_SHMEM_ALLOCATOR_PAGE_SIZE) {
+        uint64_t pageNo = shift / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        uint64_t pageNum = capacity / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        if (shift % FALCON_SHMEM_ALLOCATOR_PAGE_SIZE != 0 || capacity % FALCON_SHMEM_ALLOCATOR_PAGE_SIZE != 0 ||
+            pageNo + pageNum > allocator->pageCount)
+            return;
+        for (uint64_t i = 0; i < pageNum; i++)
+            atomic_store_explicit(&allocator->pageCntlArray[pageNo + i].data, 0, memory_order_release);
+        LowerFreeListHint(allocator, FALCON_SHMEM_ALLOCATOR_SPAN_LEVEL, pageNo);
+        ClearExhausted(allocator);
+        return;
+    }
+
+    if (capacity < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE)
         return;
     int level = __builtin_ctzll(FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE) - __builtin_ctzll(capacity);
     if (capacity != (FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE >> level))
         return;
 
-    uint64_t pageNo = shift / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
-    uint32_t blockNo = shift / FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE - pageNo * FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT;
-    uint64_t occupyBitmap = LevelBlockOccupyBitMap[level] << blockNo;
-    atomic_fetch_and_explicit(&allocator->pageCntlArray[pageNo].data, ~occupyBitmap, memory_order_relaxed);
+    // while others wait for space the block goes back to the shared pages
+    if (threadCacheAllocator == allocator && !FalconShmemAllocatorIsExhausted(allocator)) {
+        ThreadCacheLevel *cache = &threadCache[level];
+        if (cache->count < ThreadCacheCapacity(level)) {
+            cache->shifts[cache->count++] = shift;
+            return;
+        }
+    }
+    ReleaseBlock(allocator, level, shift);
+    ClearExhausted(allocator);
+}
 
-    // Renew freeListHint, Maybe this block will be fetch by others immediately before we change
-    // freelistHine, but that doesn't matter
-    uint64_t freeHint = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
-    while (true) {
-        if (freeHint <= pageNo) // do nothing as unnecessary
-            break;
-        if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
-                                                  &freeHint,
-                                                  pageNo,
-                                                  memory_order_relaxed,
-                                                  memory_order_relaxed))
-            break;
+bool FalconShmemAllocatorIsExhausted(FalconShmemAllocator *allocator)
+{
+    // an allocator never initialized has no blocks to wait for
+    if (allocator->counters == NULL)
+        return false;
+    return atomic_load_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_EXHAUSTED].data,
+                                memory_order_relaxed) != 0;
+}
+
+void FalconShmemAllocatorAttachThreadCache(FalconShmemAllocator *allocator)
+{
+    if (threadCacheAllocator == allocator)
+        return;
+    FalconShmemAllocatorDetachThreadCache();
+    threadCacheAllocator = allocator;
+}
+
+void FalconShmemAllocatorDetachThreadCache(void)
+{
+    FlushThreadCache();
+    threadCacheAllocator = NULL;
+}
+
+void FalconShmemAllocatorGetStats(FalconShmemAllocator *allocator, FalconShmemAllocatorStats *stats)
+{
+    memset(stats, 0, sizeof(FalconShmemAllocatorStats));
+    stats->totalBytes = (uint64_t)allocator->pageCount * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+    stats->pageCount = allocator->pageCount;
+    uint32_t freeRun = 0;
+    for (uint32_t pageNo = 0; pageNo < allocator->pageCount; ++pageNo) {
+        uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
+        stats->usedBytes += (uint64_t)__builtin_popcountll(bitmap) * FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE;
+        if (bitmap == 0) {
+            stats->freePages++;
+            freeRun++;
+            if (freeRun > stats->largestFreeSpan)
+                stats->largestFreeSpan = freeRun;
+        } else {
+            freeRun = 0;
+            if (bitmap != ~(uint64_t)0)
+                stats->partialPages++;
+        }
     }
+    stats->failCount = atomic_load_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_FAIL].data,
+                                            memory_order_relaxed);
+    stats->waitCount = atomic_load_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_WAIT].data,
+                                            memory_order_relaxed);
+    stats->spanCount = atomic_load_explicit(&allocator->counters[FALCON_SHMEM_ALLOCATOR_COUNTER_SPAN].data,
+                                            memory_order_relaxed);
 }
 
 FalconShmemAllocator g_falconConnectionPoolShmemAllocator;
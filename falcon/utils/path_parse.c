@@ -14,6 +14,7 @@
 #include "utils/varlena.h"
 
 #include "dir_path_shmem/dir_path_hash.h"
+#include "dir_path_shmem/dir_path_prefix_cache.h"
 #include "distributed_backend/remote_comm.h"
 #include "utils/error_log.h"
 #include "utils/utils.h"
@@ -54,6 +55,7 @@ void PathParseTreeInit(PathParseRBTreeNode *root)
 {
     root->inodeId = 0;
     root->name = NULL;
+    root->lock = NULL;
     root->children = NULL;
 }
 
@@ -105,6 +107,82 @@ void TransactionLevelPathParseReset()
     MemoryContextReset(PathParseContext);
 }
 
+/*
+ * Takes the levels of the parent directory of path from the prefix cache: shared locks on every directory on the way
+ * down, checked against the cached inode ids, without a lookup per level. Each level goes into the tree as if it had
+ * been walked, the walk that follows then only finds them there. Returns whether every level was taken, a stale
+ * entry is dropped and whatever levels are left to the walk.
+ */
+static bool PathParseTreeInsertFromPrefixCache(PathParseTree root, const char *path, int parentPathLength)
+{
+    uint64_t inodeIds[DIR_PATH_PREFIX_MAX_DEPTH];
+    RWLock *locks[DIR_PATH_PREFIX_MAX_DEPTH];
+    int depth = DirPathPrefixCacheLookup(path, parentPathLength, inodeIds, locks);
+    if (depth == 0)
+        return false;
+
+    bool valid = true;
+    int currentFileNameStartPos = 0;
+    int currentFileNameLength = 1;
+    PathParseRBTreeNode *currentNode = root;
+    for (int level = 0; level < depth; ++level) {
+        if (valid) {
+            PathParseRBTreeNode target;
+            target.name = palloc(currentFileNameLength + 1);
+            memcpy(target.name, path + currentFileNameStartPos, currentFileNameLength);
+            target.name[currentFileNameLength] = '\0';
+
+            PathParseRBTreeNode *node = NULL;
+            if (currentNode->children)
+                node = (PathParseRBTreeNode *)rbt_find(currentNode->children, (RBTNode *)&target);
+            if (node != NULL && (node->inodeId != inodeIds[level] || node->lockAcquired == PP_EXCLUSIVE)) {
+                // this transaction changed the directory or locks it already, leave the rest to the walk
+                valid = false;
+            } else if (node == NULL || node->lockAcquired == PP_NONE) {
+                RWLockAcquire(locks[level], RW_SHARED);
+                if (DirPathHashLockedInodeId(locks[level]) != inodeIds[level]) {
+                    RWLockRelease(locks[level]);
+                    valid = false;
+                } else if (node != NULL) {
+                    node->lockAcquired = PP_SHARED;
+                    node->lock = locks[level];
+                } else {
+                    if (!currentNode->children) {
+                        MemoryContext oldContext = MemoryContextSwitchTo(PathParseContext);
+                        currentNode->children = rbt_create(sizeof(PathParseRBTreeNode),
+                                                           PathParseRBT_cmp,
+                                                           PathParseRBT_combine,
+                                                           PathParseRBT_alloc,
+                                                           PathParseRBT_free,
+                                                           NULL);
+                        MemoryContextSwitchTo(oldContext);
+                    }
+                    target.inodeId = inodeIds[level];
+                    target.children = NULL;
+                    target.lockAcquired = PP_SHARED;
+                    target.lock = locks[level];
+                    bool isNew;
+                    node = (PathParseRBTreeNode *)rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
+                }
+            }
+            currentNode = node;
+        }
+        RWLockUndeclare(locks[level]);
+
+        if (currentFileNameStartPos == 0)
+            currentFileNameStartPos = 1;
+        else
+            currentFileNameStartPos += currentFileNameLength + 1;
+        currentFileNameLength = 0;
+        while (path[currentFileNameStartPos + currentFileNameLength] != '\0' &&
+               path[currentFileNameStartPos + currentFileNameLength] != '/')
+            ++currentFileNameLength;
+    }
+    if (!valid)
+        DirPathPrefixCacheDrop(path, parentPathLength);
+    return valid;
+}
+
 FalconErrorCode PathParseTreeInsert(PathParseTree root,
                                     Relation directoryRel,
                                     const char *path,
@@ -126,6 +204,16 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
         root = TransactionLevelPathParseRoot;
     }
 
+    // the parent directory is path up to its last '/', "/a/b" for "/a/b/c" and for "/a/b/"
+    const char *lastSlash = strrchr(path, '/');
+    int parentPathLength = lastSlash != NULL ? lastSlash - path : 0;
+    bool prefixCacheable = path[0] == '/' && parentPathLength > 1 && parentPathLength < DIR_PATH_PREFIX_MAX_PATH;
+    if (prefixCacheable && PathParseTreeInsertFromPrefixCache(root, path, parentPathLength))
+        prefixCacheable = false;
+    uint64_t levelInodeIds[DIR_PATH_PREFIX_MAX_DEPTH];
+    RWLock *levelLocks[DIR_PATH_PREFIX_MAX_DEPTH];
+    int levelNum = 0;
+
     int currentFileNameStartPos = 0;
     int currentFileNameLength = 1;
     PathParseRBTreeNode *currentNode = root;
@@ -162,11 +250,13 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             target.inodeId = currentDirectoryId;
             target.children = NULL;
             target.lockAcquired = PP_SHARED;
+            target.lock = DirectoryHashTableLastAcquiredLock;
             bool isNew;
             node = (PathParseRBTreeNode *)rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
         } else if (node->lockAcquired == PP_NONE) {
             SearchDirectoryByDirectoryHashTable(directoryRel, node->inodeId, node->name, DIR_LOCK_SHARED);
             node->lockAcquired = PP_SHARED;
+            node->lock = DirectoryHashTableLastAcquiredLock;
         }
 
         if (currentFileNameStartPos == 0)
@@ -178,7 +268,20 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
                path[currentFileNameStartPos + currentFileNameLength] != '/')
             ++currentFileNameLength;
         currentNode = node;
+
+        // only directories this transaction merely looked up, held shared, go to the prefix cache
+        if (prefixCacheable) {
+            if (levelNum < DIR_PATH_PREFIX_MAX_DEPTH && node->lockAcquired == PP_SHARED && node->lock != NULL &&
+                node->inodeId != DIR_HASH_TABLE_PATH_NOT_EXIST && node->inodeId != DIR_HASH_TABLE_PATH_UNKNOWN) {
+                levelInodeIds[levelNum] = node->inodeId;
+                levelLocks[levelNum++] = node->lock;
+            } else {
+                prefixCacheable = false;
+            }
+        }
     }
+    if (prefixCacheable && levelNum > 1)
+        DirPathPrefixCacheInsert(path, parentPathLength, levelInodeIds, levelLocks, levelNum);
     if (parentId != NULL)
         *parentId = currentNode->inodeId;
     if (fileName != NULL) {
@@ -224,6 +327,7 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             }
             target.inodeId = *inodeId;
             target.children = NULL;
+            target.lock = DirectoryHashTableLastAcquiredLock;
             if (flag & PATH_PARSE_FLAG_ALLOW_OPERATION_UNDER_CREATED_DIRECTORY)
                 target.lockAcquired = PP_EXCLUSIVE_FOR_CREATE;
             else
@@ -278,10 +382,12 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             if (node->lockAcquired != PP_NONE)
                 return PATH_LOCK_CONFLICT;
             node->lockAcquired = PP_EXCLUSIVE;
+            node->lock = DirectoryHashTableLastAcquiredLock;
         } else {
             target.inodeId = *inodeId;
             target.children = NULL;
             target.lockAcquired = PP_EXCLUSIVE;
+            target.lock = DirectoryHashTableLastAcquiredLock;
             bool isNew;
             rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
         }
@@ -320,14 +426,17 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             if (currentDirectoryId == DIR_HASH_TABLE_PATH_NOT_EXIST) {
                 RWLockRelease(DirectoryHashTableLastAcquiredLock);
                 target.lockAcquired = PP_NONE;
+                target.lock = NULL;
             } else {
                 target.lockAcquired = PP_SHARED;
+                target.lock = DirectoryHashTableLastAcquiredLock;
             }
             bool isNew;
             node = (PathParseRBTreeNode *)rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
         } else if (node->inodeId != DIR_HASH_TABLE_PATH_NOT_EXIST && node->lockAcquired == PP_NONE) {
             SearchDirectoryByDirectoryHashTable(directoryRel, node->inodeId, node->name, DIR_LOCK_SHARED);
             node->lockAcquired = PP_SHARED;
+            node->lock = DirectoryHashTableLastAcquiredLock;
         }
 
         if (inodeId)
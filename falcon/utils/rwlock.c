@@ -125,6 +125,10 @@ bool RWLockCheckDestroyable(RWLock *lock)
     return (state & RW_REF_COUNT_MASK) == 0;
 }
 
+void RWLockPin(RWLock *lock) { pg_atomic_fetch_add_u64(&lock->state, RW_VAL_REF_COUNT); }
+
+void RWLockUnpin(RWLock *lock) { pg_atomic_fetch_sub_u64(&lock->state, RW_VAL_REF_COUNT); }
+
 void RWLockAcquire(RWLock *lock, RWLockMode mode)
 {
     if (mode == RW_DECLARE)
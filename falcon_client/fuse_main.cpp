@@ -23,6 +23,7 @@
 #include "error_code.h"
 #include "falcon_code.h"
 #include "falcon_meta.h"
+#include "attr_cache.h"
 #include "init/falcon_init.h"
 #include "stats/falcon_stats.h"
 #include "connection/falcon_io_client.h"
@@ -564,6 +565,16 @@ int main(int argc, char *argv[])
     g_persist = config->GetBool(FalconPropertyKey::FALCON_PERSIST);
     uint32_t maxOpenNum = config->GetUint32(FalconPropertyKey::FALCON_MAX_OPEN_NUM);
     SetMaxOpenInstanceNum(maxOpenNum);
+    uint32_t attrTtlMs = config->GetUint32(FalconPropertyKey::FALCON_ATTR_CACHE_TTL_MS);
+    uint32_t negativeTtlMs = config->GetUint32(FalconPropertyKey::FALCON_ATTR_CACHE_NEGATIVE_TTL_MS);
+    AttrCache::GetInstance().SetTtl(attrTtlMs);
+    AttrCache::GetInstance().SetNegativeTtl(negativeTtlMs);
+    AttrCache::GetInstance().SetMemoryLimit(uint64_t(config->GetUint32(FalconPropertyKey::FALCON_ATTR_CACHE_MAX_MB)) *
+                                            1024 * 1024);
+    /*
+     * the kernel keeps attributes and dentries for the timeouts of libfuse, one for all entries. the lease the server
+     * grants differs per entry, it is honoured by the client cache the kernel asks once its timeout passed
+     */
 #ifdef ZK_INIT
     std::cout << "Initialize with ZK" << std::endl;
     const char *zkEndPoint = std::getenv("zk_endpoint");
@@ -0,0 +1,145 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "attr_cache.h"
+
+#include <algorithm>
+
+#include "stats/falcon_stats.h"
+
+AttrCache &AttrCache::GetInstance()
+{
+    static AttrCache instance;
+    return instance;
+}
+
+void AttrCache::Put(const std::string &path, const struct stat &st, uint32_t leaseMs)
+{
+    uint32_t ttl = std::min<uint32_t>(leaseMs, ttlMs);
+    if (ttl == 0) {
+        return;
+    }
+    Insert(path, Entry{st, 0, std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl)});
+}
+
+void AttrCache::PutNegative(const std::string &path, int errorCode)
+{
+    uint32_t ttl = negativeTtlMs;
+    if (ttl == 0 || ttlMs == 0) {
+        return;
+    }
+    struct stat st {};
+    Insert(path, Entry{st, errorCode, std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl)});
+}
+
+void AttrCache::Erase(Shard &shard, std::unordered_map<std::string, Entry>::iterator it)
+{
+    size_t size = EntrySize(it->first);
+    shard.memoryUsage -= size;
+    memoryUsage -= size;
+    shard.entries.erase(it);
+}
+
+void AttrCache::Insert(const std::string &path, const Entry &entry)
+{
+    uint64_t limit = shardMemoryLimit;
+    size_t size = EntrySize(path);
+    if (size > limit) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        it->second = entry;
+        return;
+    }
+    if (shard.memoryUsage + size > limit) {
+        // drop what expired first, then arbitrary entries until an eighth of the shard is free, so that the scan
+        // is not repeated for every insert into a shard full of live entries
+        auto now = std::chrono::steady_clock::now();
+        for (it = shard.entries.begin(); it != shard.entries.end();) {
+            auto next = std::next(it);
+            if (it->second.expireTime <= now) {
+                Erase(shard, it);
+            }
+            it = next;
+        }
+        while (!shard.entries.empty() && shard.memoryUsage + size > limit - limit / 8) {
+            Erase(shard, shard.entries.begin());
+        }
+    }
+    shard.entries.emplace(path, entry);
+    shard.memoryUsage += size;
+    memoryUsage += size;
+}
+
+bool AttrCache::Lookup(const std::string &path, struct stat *st, int &errorCode)
+{
+    if (ttlMs == 0) {
+        return false;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    if (it->second.expireTime <= std::chrono::steady_clock::now()) {
+        Erase(shard, it);
+        return false;
+    }
+    errorCode = it->second.errorCode;
+    if (errorCode == 0) {
+        *st = it->second.st;
+    }
+    return true;
+}
+
+bool AttrCache::Get(const std::string &path, struct stat *st, int &errorCode)
+{
+    if (ttlMs == 0) {
+        return false;
+    }
+    bool hit = Lookup(path, st, errorCode);
+    FalconStats::GetInstance().stats[hit ? ATTR_CACHE_HIT : ATTR_CACHE_MISS]++;
+    return hit;
+}
+
+bool AttrCache::Peek(const std::string &path, struct stat *st, int &errorCode) { return Lookup(path, st, errorCode); }
+
+void AttrCache::Invalidate(const std::string &path)
+{
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        Erase(shard, it);
+    }
+}
+
+void AttrCache::InvalidatePrefix(const std::string &dir)
+{
+    std::string prefix = dir + "/";
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            auto next = std::next(it);
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                Erase(shard, it);
+            }
+            it = next;
+        }
+    }
+}
+
+void AttrCache::Clear()
+{
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        memoryUsage -= shard.memoryUsage;
+        shard.memoryUsage = 0;
+        shard.entries.clear();
+    }
+}
@@ -4,6 +4,9 @@
 
 #include "connection.h"
 
+#include <unistd.h>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -24,6 +27,38 @@
 
 static void BrpcDummyDeleter(void *) {}
 
+static thread_local falcon::meta_proto::MetaRequestPriority ThreadRequestPriority =
+    falcon::meta_proto::META_PRIORITY_DEFAULT;
+
+// the server lets the requests of different clients take turns, all threads of the process count as one client
+static uint64_t ClientId()
+{
+    static const uint64_t clientId = []() {
+        char hostname[256] = {0};
+        gethostname(hostname, sizeof(hostname) - 1);
+        uint64_t id = std::hash<std::string>{}(std::string(hostname) + ":" + std::to_string(getpid()));
+        return id != 0 ? id : 1;
+    }();
+    return clientId;
+}
+
+// a server turning the call away for overload answers EAGAIN, the call may be sent again later
+static FalconErrorCode CallErrorCode(const brpc::Controller &cntl)
+{
+    if (cntl.ErrorCode() == brpc::ELOGOFF || cntl.ErrorCode() == EHOSTDOWN) {
+        return SERVER_FAULT;
+    }
+    if (cntl.ErrorCode() == EAGAIN) {
+        return POOLED_FAULT;
+    }
+    return REMOTE_QUERY_FAILED;
+}
+
+void Connection::SetThreadRequestPriority(falcon::meta_proto::MetaRequestPriority priority)
+{
+    ThreadRequestPriority = priority;
+}
+
 inline falcon::meta_fbs::AnyMetaParam ToFlatBuffersType(falcon::meta_proto::MetaServiceType type)
 {
     switch (type) {
@@ -40,6 +75,7 @@ inline falcon::meta_fbs::AnyMetaParam ToFlatBuffersType(falcon::meta_proto::Meta
     case falcon::meta_proto::CLOSE:
         return falcon::meta_fbs::AnyMetaParam_CloseParam;
     case falcon::meta_proto::READDIR:
+    case falcon::meta_proto::READDIRPLUS:
         return falcon::meta_fbs::AnyMetaParam_ReadDirParam;
     case falcon::meta_proto::RENAME:
         return falcon::meta_fbs::AnyMetaParam_RenameParam;
@@ -99,6 +135,8 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
         proto_type == falcon::meta_proto::SLICE_GET || proto_type == falcon::meta_proto::SLICE_DEL) {
         request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
     }
+    request.set_priority(ThreadRequestPriority);
+    request.set_client_id(ClientId());
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
     cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
@@ -112,12 +150,7 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
         FALCON_LOG(LOG_ERROR) << __func__ << ": Send request failed, error code = "
                               << cntl.ErrorCode() << ", error text = " 
                               << cntl.ErrorText();
-
-        if (cntl.ErrorCode() == brpc::ELOGOFF || cntl.ErrorCode() == EHOSTDOWN) {
-            return SERVER_FAULT;
-        } else {
-            return REMOTE_QUERY_FAILED;
-        }
+        return CallErrorCode(cntl);
     }
 
     // 4. Parse response
@@ -127,7 +160,7 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
 
     // Store buffer in result if provided
     SerializedData response;
-    if constexpr (std::is_same_v<ResultType, ReadDirResponse>) {
+    if constexpr (std::is_same_v<ResultType, ReadDirResponse> || std::is_same_v<ResultType, ReadDirPlusResponse>) {
         result->buffer = std::move(tempBuffer);
         SerializedDataInit(&response, result->buffer.get(), responseBufferSize, responseBufferSize, nullptr);
     } else if constexpr (!std::is_same_v<ResultType, void>) {
@@ -163,6 +196,129 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
     return responseHandler(metaResponse, result);
 }
 
+// what an asynchronous batch call needs until it is answered, brpc runs it once and it deletes itself
+class BatchCallDone : public google::protobuf::Closure {
+  public:
+    brpc::Controller cntl;
+    falcon::meta_proto::Empty response;
+    std::function<void(BatchCallDone *)> onAnswered;
+
+    void Run() override
+    {
+        std::unique_ptr<BatchCallDone> self(this);
+        onAnswered(this);
+    }
+};
+
+// parses the answer of a batch call of count params, exactly one reply per param
+template <typename ResponseHandler>
+static FalconErrorCode ParseBatchReplies(BatchCallDone *call,
+                                         size_t count,
+                                         const ResponseHandler &responseHandler,
+                                         std::vector<FalconErrorCode> &errorCodes)
+{
+    brpc::Controller &cntl = call->cntl;
+    if (cntl.Failed()) {
+        FALCON_LOG(LOG_ERROR) << __func__ << ": Send request failed, error code = " << cntl.ErrorCode()
+                              << ", error text = " << cntl.ErrorText();
+        FalconErrorCode errorCode = CallErrorCode(cntl);
+        errorCodes.assign(count, errorCode);
+        return errorCode;
+    }
+    // the server failed the call as a whole, the attachment carries no reply of the params
+    int32_t callErrorCode = call->response.error_code();
+    if (callErrorCode != SUCCESS) {
+        FalconErrorCode errorCode =
+            callErrorCode > 0 && callErrorCode < LAST_FALCON_ERROR_CODE ? (FalconErrorCode)callErrorCode : PROGRAM_ERROR;
+        errorCodes.assign(count, errorCode);
+        return errorCode;
+    }
+
+    size_t responseBufferSize = cntl.response_attachment().size();
+    std::unique_ptr<char[]> responseBuffer = std::make_unique<char[]>(responseBufferSize);
+    cntl.response_attachment().cutn(responseBuffer.get(), responseBufferSize);
+    SerializedData response;
+    SerializedDataInit(&response, responseBuffer.get(), responseBufferSize, responseBufferSize, nullptr);
+
+    sd_size_t p = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sd_size_t responseSize = SerializedDataNextSeveralItemSize(&response, p, 1);
+        if (responseSize == (sd_size_t)-1) {
+            FALCON_LOG(LOG_ERROR) << "returned data is corrupt, " << i << " of " << count << " replies.";
+            errorCodes.assign(count, REMOTE_QUERY_FAILED);
+            return REMOTE_QUERY_FAILED;
+        }
+        uint8_t *itemBuffer = (uint8_t *)response.buffer + p + SERIALIZED_DATA_ALIGNMENT;
+        flatbuffers::Verifier verifier(itemBuffer, responseSize - SERIALIZED_DATA_ALIGNMENT);
+        if (!verifier.VerifyBuffer<falcon::meta_fbs::MetaResponse>()) {
+            FALCON_LOG(LOG_ERROR) << "Meta response is corrupt.";
+            errorCodes.assign(count, REMOTE_QUERY_FAILED);
+            return REMOTE_QUERY_FAILED;
+        }
+        auto metaResponse = falcon::meta_fbs::GetMetaResponse(itemBuffer);
+        if (metaResponse->error_code() != SUCCESS) {
+            errorCodes[i] = metaResponse->error_code() < LAST_FALCON_ERROR_CODE
+                                ? (FalconErrorCode)metaResponse->error_code()
+                                : PROGRAM_ERROR;
+        } else {
+            errorCodes[i] = responseHandler(i, metaResponse);
+        }
+        p += responseSize;
+    }
+    if (p != responseBufferSize) {
+        FALCON_LOG(LOG_ERROR) << "returned data is corrupt, more than " << count << " replies.";
+        errorCodes.assign(count, REMOTE_QUERY_FAILED);
+        return REMOTE_QUERY_FAILED;
+    }
+    return SUCCESS;
+}
+
+template <typename ParamBuilder, typename ResponseHandler>
+void Connection::ProcessBatchRequest(falcon::meta_proto::MetaServiceType proto_type,
+                                     size_t count,
+                                     const ParamBuilder &paramBuilder,
+                                     ResponseHandler responseHandler,
+                                     std::vector<FalconErrorCode> &errorCodes,
+                                     BatchDone done,
+                                     ConnectionCache *cache)
+{
+    if (!cache)
+        cache = &ThreadLocalConnectionCache;
+    errorCodes.assign(count, REMOTE_QUERY_FAILED);
+    if (count == 0) {
+        done(SUCCESS);
+        return;
+    }
+
+    // 1. Prepare params, one segment each
+    SerializedDataClear(&cache->serializedDataBuffer);
+    auto type = ToFlatBuffersType(proto_type);
+    falcon::meta_proto::MetaRequest request;
+    for (size_t i = 0; i < count; ++i) {
+        cache->flatBufferBuilder.Clear();
+        auto param = paramBuilder(i, cache->flatBufferBuilder);
+        auto metaParam = falcon::meta_fbs::CreateMetaParam(cache->flatBufferBuilder, type, param.Union());
+        cache->flatBufferBuilder.Finish(metaParam);
+
+        char *p = SerializedDataApplyForSegment(&cache->serializedDataBuffer, cache->flatBufferBuilder.GetSize());
+        memcpy(p, cache->flatBufferBuilder.GetBufferPointer(), cache->flatBufferBuilder.GetSize());
+        request.add_type(proto_type);
+    }
+
+    // 2. Construct and send request, the replies are parsed by the done closure
+    request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
+    request.set_priority(ThreadRequestPriority);
+    request.set_client_id(ClientId());
+    auto *call = new BatchCallDone();
+    call->cntl.set_timeout_ms(10000);
+    // copied, the cache is reused by the next request of this thread while this one may not be written out yet
+    call->cntl.request_attachment().append(cache->serializedDataBuffer.buffer, cache->serializedDataBuffer.size);
+    call->onAnswered = [count, responseHandler, &errorCodes, done = std::move(done)](BatchCallDone *answered) {
+        done(ParseBatchReplies(answered, count, responseHandler, errorCodes));
+    };
+    stub.MetaCall(&call->cntl, &request, &call->response, call);
+}
+
 static timespec ConvertTimestampFromPGToUnix(uint64_t t)
 {
     // seconds from 1970-01-01 to 2000-01-01
@@ -241,18 +397,21 @@ Connection::Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct
     return ProcessRequest(falcon::meta_proto::CREATE, paramBuilder, responseHandler, cache);
 }
 
-FalconErrorCode Connection::Stat(const char *path, struct stat *stbuf, ConnectionCache *cache)
+FalconErrorCode Connection::Stat(const char *path, struct stat *stbuf, uint32_t *leaseMs, ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
         return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, path);
     };
 
-    auto responseHandler = [stbuf](const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
+    auto responseHandler = [stbuf, leaseMs](const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
         if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_StatResponse) {
             return PROGRAM_ERROR;
         }
 
         auto statResponse = metaResponse->response_as_StatResponse();
+        if (leaseMs) {
+            *leaseMs = statResponse->lease_ms();
+        }
         if (stbuf) {
             stbuf->st_ino = statResponse->st_ino();
             stbuf->st_dev = statResponse->st_dev();
@@ -279,14 +438,15 @@ FalconErrorCode Connection::Open(const char *path,
                                  int64_t &size,
                                  int32_t &nodeId,
                                  struct stat *stbuf,
+                                 uint32_t *leaseMs,
                                  ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
         return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, path);
     };
 
-    auto responseHandler = [&inodeId, &size, &nodeId, stbuf](const falcon::meta_fbs::MetaResponse *metaResponse,
-                                                             void *) {
+    auto responseHandler = [&inodeId, &size, &nodeId, stbuf, leaseMs](
+                               const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
         if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_OpenResponse) {
             return PROGRAM_ERROR;
         }
@@ -295,6 +455,9 @@ FalconErrorCode Connection::Open(const char *path,
         inodeId = openResponse->st_ino();
         size = openResponse->st_size();
         nodeId = openResponse->node_id();
+        if (leaseMs) {
+            *leaseMs = openResponse->lease_ms();
+        }
 
         if (stbuf) {
             stbuf->st_ino = openResponse->st_ino();
@@ -357,6 +520,114 @@ Connection::Unlink(const char *path, uint64_t &inodeId, int64_t &size, int32_t &
     return ProcessRequest(falcon::meta_proto::UNLINK, paramBuilder, responseHandler, cache);
 }
 
+void Connection::BatchStat(const std::vector<const char *> &paths,
+                           std::vector<FalconErrorCode> &errorCodes,
+                           std::vector<struct stat> &stbufs,
+                           std::vector<uint32_t> &leaseMs,
+                           BatchDone done,
+                           ConnectionCache *cache)
+{
+    stbufs.assign(paths.size(), {});
+    leaseMs.assign(paths.size(), 0);
+    auto paramBuilder = [&paths](size_t i, flatbuffers::FlatBufferBuilder &builder) {
+        return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i]);
+    };
+
+    auto responseHandler = [&stbufs, &leaseMs](size_t i, const falcon::meta_fbs::MetaResponse *metaResponse) {
+        if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_StatResponse) {
+            return PROGRAM_ERROR;
+        }
+
+        auto statResponse = metaResponse->response_as_StatResponse();
+        struct stat *stbuf = &stbufs[i];
+        stbuf->st_ino = statResponse->st_ino();
+        stbuf->st_dev = statResponse->st_dev();
+        stbuf->st_mode = statResponse->st_mode();
+        stbuf->st_nlink = statResponse->st_nlink();
+        stbuf->st_uid = statResponse->st_uid();
+        stbuf->st_gid = statResponse->st_gid();
+        stbuf->st_rdev = statResponse->st_rdev();
+        stbuf->st_size = statResponse->st_size();
+        stbuf->st_blksize = ST_BLKSIZE;
+        stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+        stbuf->st_atim = ConvertTimestampFromPGToUnix(statResponse->st_atim());
+        stbuf->st_mtim = ConvertTimestampFromPGToUnix(statResponse->st_mtim());
+        stbuf->st_ctim = ConvertTimestampFromPGToUnix(statResponse->st_ctim());
+        leaseMs[i] = statResponse->lease_ms();
+        return SUCCESS;
+    };
+
+    ProcessBatchRequest(falcon::meta_proto::STAT,
+                        paths.size(),
+                        paramBuilder,
+                        responseHandler,
+                        errorCodes,
+                        std::move(done),
+                        cache);
+}
+
+void Connection::BatchCreate(const std::vector<const char *> &paths,
+                             std::vector<FalconErrorCode> &errorCodes,
+                             BatchDone done,
+                             ConnectionCache *cache)
+{
+    auto paramBuilder = [&paths](size_t i, flatbuffers::FlatBufferBuilder &builder) {
+        return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i]);
+    };
+
+    auto responseHandler = [](size_t, const falcon::meta_fbs::MetaResponse *metaResponse) {
+        if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_CreateResponse) {
+            return PROGRAM_ERROR;
+        }
+        return SUCCESS;
+    };
+
+    ProcessBatchRequest(falcon::meta_proto::CREATE,
+                        paths.size(),
+                        paramBuilder,
+                        responseHandler,
+                        errorCodes,
+                        std::move(done),
+                        cache);
+}
+
+void Connection::BatchUnlink(const std::vector<const char *> &paths,
+                             std::vector<FalconErrorCode> &errorCodes,
+                             std::vector<uint64_t> &inodeIds,
+                             std::vector<int64_t> &sizes,
+                             std::vector<int32_t> &nodeIds,
+                             BatchDone done,
+                             ConnectionCache *cache)
+{
+    inodeIds.assign(paths.size(), 0);
+    sizes.assign(paths.size(), 0);
+    nodeIds.assign(paths.size(), 0);
+    auto paramBuilder = [&paths](size_t i, flatbuffers::FlatBufferBuilder &builder) {
+        return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i]);
+    };
+
+    auto responseHandler = [&inodeIds, &sizes, &nodeIds](size_t i,
+                                                         const falcon::meta_fbs::MetaResponse *metaResponse) {
+        if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_UnlinkResponse) {
+            return PROGRAM_ERROR;
+        }
+
+        auto unlinkResponse = metaResponse->response_as_UnlinkResponse();
+        inodeIds[i] = unlinkResponse->st_ino();
+        sizes[i] = unlinkResponse->st_size();
+        nodeIds[i] = unlinkResponse->node_id();
+        return SUCCESS;
+    };
+
+    ProcessBatchRequest(falcon::meta_proto::UNLINK,
+                        paths.size(),
+                        paramBuilder,
+                        responseHandler,
+                        errorCodes,
+                        std::move(done),
+                        cache);
+}
+
 FalconErrorCode Connection::ReadDir(const char *path,
                                     ReadDirResponse &readDirResponse,
                                     int32_t maxReadCount,
@@ -379,6 +650,47 @@ FalconErrorCode Connection::ReadDir(const char *path,
     return ProcessRequest(falcon::meta_proto::READDIR, paramBuilder, responseHandler, cache, &readDirResponse);
 }
 
+void Connection::ReadDirPlusResponse::EntryStat(uint32_t index, struct stat *stbuf) const
+{
+    auto entry = response->result_list()->Get(index);
+    (void)memset(stbuf, 0, sizeof(*stbuf));
+    stbuf->st_ino = entry->st_ino();
+    stbuf->st_dev = entry->st_dev();
+    stbuf->st_mode = entry->st_mode();
+    stbuf->st_nlink = entry->st_nlink();
+    stbuf->st_uid = entry->st_uid();
+    stbuf->st_gid = entry->st_gid();
+    stbuf->st_rdev = entry->st_rdev();
+    stbuf->st_size = entry->st_size();
+    stbuf->st_blksize = ST_BLKSIZE;
+    stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+    stbuf->st_atim = ConvertTimestampFromPGToUnix(entry->st_atim());
+    stbuf->st_mtim = ConvertTimestampFromPGToUnix(entry->st_mtim());
+    stbuf->st_ctim = ConvertTimestampFromPGToUnix(entry->st_ctim());
+}
+
+FalconErrorCode Connection::ReadDirPlus(const char *path,
+                                        ReadDirPlusResponse &readDirPlusResponse,
+                                        int32_t maxReadCount,
+                                        int32_t lastShardIndex,
+                                        const char *lastFileName,
+                                        ConnectionCache *cache)
+{
+    auto paramBuilder = [=](flatbuffers::FlatBufferBuilder &builder) {
+        return falcon::meta_fbs::CreateReadDirParamDirect(builder, path, maxReadCount, lastShardIndex, lastFileName);
+    };
+
+    auto responseHandler = [](const falcon::meta_fbs::MetaResponse *metaResponse, ReadDirPlusResponse *result) {
+        if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_ReadDirPlusResponse) {
+            return PROGRAM_ERROR;
+        }
+        result->response = metaResponse->response_as_ReadDirPlusResponse();
+        return SUCCESS;
+    };
+
+    return ProcessRequest(falcon::meta_proto::READDIRPLUS, paramBuilder, responseHandler, cache, &readDirPlusResponse);
+}
+
 FalconErrorCode Connection::OpenDir(const char *path, uint64_t &inodeId, ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
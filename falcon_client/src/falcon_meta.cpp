@@ -10,11 +10,15 @@
 #include <cstdlib>
 #include <cstring>
 #include <mutex>
+#include <numeric>
 #include <unordered_map>
 
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#include <bthread/countdown_event.h>
+
+#include "attr_cache.h"
 #include "buffer/dir_open_instance.h"
 #include "cm/falcon_cm.h"
 #include "falcon_store/falcon_store.h"
@@ -24,6 +28,8 @@
 
 constexpr int FILE_NUMBER_PER_EPOCH = 1048576;
 constexpr int FILE_NUMBER_PER_WORKER = 4096;
+// paths one batched request carries at most, keeps params and replies within the server's shared memory blocks
+constexpr size_t BATCH_META_MAX_COUNT = 1024;
 
 std::shared_ptr<Router> router;
 
@@ -71,6 +77,7 @@ int FalconInitWithZK(std::string zkEndPoint, const std::string &zkPath)
 
 int FalconMkdir(const std::string &path)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -87,6 +94,7 @@ int FalconMkdir(const std::string &path)
         errorCode = conn->Mkdir(path.c_str());
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconMkdir failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -95,6 +103,7 @@ int FalconMkdir(const std::string &path)
 
 int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat *stbuf)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -112,6 +121,7 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
         errorCode = conn->Create(path.c_str(), inodeId, nodeId, stbuf);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     /* Handle the case of not exclusively created file */
     if (errorCode == FILE_EXISTS && !(oflags & O_EXCL)) {
         errorCode = SUCCESS;
@@ -131,27 +141,62 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
 
 int FalconGetStat(const std::string &path, struct stat *stbuf)
 {
+    int errorCode = SUCCESS;
+    if (AttrCache::GetInstance().Get(path, stbuf, errorCode)) {
+        return errorCode;
+    }
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
         return PROGRAM_ERROR;
     }
-    int errorCode = conn->Stat(path.c_str(), stbuf);
+    uint32_t leaseMs = 0;
+    errorCode = conn->Stat(path.c_str(), stbuf, &leaseMs);
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
         ++cnt;
         sleep(SLEEPTIME);
         conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Stat(path.c_str(), stbuf);
+        errorCode = conn->Stat(path.c_str(), stbuf, &leaseMs);
     }
 #endif
+    if (errorCode == SUCCESS) {
+        AttrCache::GetInstance().Put(path, *stbuf, leaseMs);
+    } else if (errorCode == FILE_NOT_EXISTS || errorCode == PATH_NOT_EXISTS) {
+        AttrCache::GetInstance().PutNegative(path, errorCode);
+    }
     if (errorCode != SUCCESS && errorCode != FILE_NOT_EXISTS) {
         FALCON_LOG(LOG_ERROR) << "FalconGetStat failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
     return errorCode;
 }
 
+/* small files are read whole on open into the read buffer */
+static bool IsSmallFileRead(OpenInstance *openInstance)
+{
+    return openInstance->originalSize > 0 && openInstance->originalSize < READ_BIGFILE_SIZE &&
+           (openInstance->oflags & O_ACCMODE) == O_RDONLY;
+}
+
+static int AllocSmallFileBuffer(OpenInstance *openInstance)
+{
+    std::shared_ptr<char> buffer;
+    if (openInstance->oflags & __O_DIRECT) {
+        int alignedNum = openInstance->originalSize / 512 + int(openInstance->originalSize % 512 != 0);
+        buffer = std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
+    } else {
+        buffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
+    }
+    if (buffer == nullptr) {
+        FALCON_LOG(LOG_ERROR) << "In FalconOpen() malloc failed";
+        return -ENOMEM;
+    }
+    openInstance->readBuffer = buffer;
+    openInstance->readBufferSize = openInstance->originalSize;
+    return 0;
+}
+
 int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf)
 {
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
@@ -168,17 +213,20 @@ int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
-    int errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
+    uint32_t leaseMs = 0;
+    int errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf, &leaseMs);
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
         ++cnt;
         sleep(SLEEPTIME);
         conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
+        errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf, &leaseMs);
     }
 #endif
+    // an open always revalidates with the server, what it answered is what the next getattr gets
     if (errorCode != SUCCESS) {
+        AttrCache::GetInstance().Invalidate(path);
         FalconFd::GetInstance()->ReleaseOpenInstance();
         FALCON_LOG(LOG_ERROR) << "FalconOpen failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -193,23 +241,13 @@ int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
 
     /* allocate fd and handle the small file read */
     if (errorCode == SUCCESS) {
-        if (openInstance->originalSize > 0 && openInstance->originalSize < READ_BIGFILE_SIZE &&
-            (openInstance->oflags & O_ACCMODE) == O_RDONLY) {
+        AttrCache::GetInstance().Put(path, *stbuf, leaseMs);
+        if (IsSmallFileRead(openInstance.get())) {
             // For small files: read all when open
-            std::shared_ptr<char> buffer;
-            if (openInstance->oflags & __O_DIRECT) {
-                int alignedNum = openInstance->originalSize / 512 + int(openInstance->originalSize % 512 != 0);
-                buffer = std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
-            } else {
-                buffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
-            }
-            if (buffer == nullptr) {
-                FALCON_LOG(LOG_ERROR) << "In FalconOpen() malloc failed";
+            if (AllocSmallFileBuffer(openInstance.get()) != 0) {
                 FalconFd::GetInstance()->ReleaseOpenInstance();
                 return -ENOMEM;
             }
-            openInstance->readBuffer = buffer;
-            openInstance->readBufferSize = openInstance->originalSize;
             int ret = InnerFalconReadSmallFiles(openInstance.get());
             if (ret < 0) {
                 FalconFd::GetInstance()->ReleaseOpenInstance();
@@ -221,6 +259,91 @@ int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
     return errorCode;
 }
 
+/*
+ * Open a batch of files, e.g. the samples of a dataloader step. The small files are read together, grouped by the
+ * store node holding them, instead of one rpc per open. rets get what FalconOpen returns for each path.
+ */
+int FalconBatchOpen(const std::vector<std::string> &paths, int oflags, std::vector<uint64_t> &fds, std::vector<int> &rets)
+{
+    size_t num = paths.size();
+    fds.assign(num, UINT64_MAX);
+    rets.assign(num, SUCCESS);
+    std::vector<std::shared_ptr<OpenInstance>> openInstances(num);
+    std::vector<OpenInstance *> smallFiles;
+    std::vector<size_t> smallIndexes;
+
+    for (size_t i = 0; i < num; ++i) {
+        std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(paths[i]);
+        if (!conn) {
+            FALCON_LOG(LOG_ERROR) << "route error";
+            rets[i] = PROGRAM_ERROR;
+            continue;
+        }
+        std::shared_ptr<OpenInstance> openInstance = FalconFd::GetInstance()->WaitGetNewOpenInstance();
+        if (openInstance == nullptr) {
+            FALCON_LOG(LOG_ERROR) << "new openInstance failed";
+            rets[i] = -EMFILE;
+            continue;
+        }
+        uint64_t inodeId = 0;
+        int64_t size = 0;
+        int32_t nodeId = 0;
+        struct stat stbuf;
+        int errorCode = conn->Open(paths[i].c_str(), inodeId, size, nodeId, &stbuf);
+#ifdef ZK_INIT
+        int cnt = 0;
+        while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateWorkerConn(conn);
+            errorCode = conn->Open(paths[i].c_str(), inodeId, size, nodeId, &stbuf);
+        }
+#endif
+        if (errorCode != SUCCESS) {
+            FalconFd::GetInstance()->ReleaseOpenInstance();
+            FALCON_LOG(LOG_ERROR) << "FalconBatchOpen failed for path: " << paths[i] << ", DN: " << conn->server.id
+                                  << ", ip: " << conn->server.ip << ", error code: " << errorCode;
+            rets[i] = errorCode;
+            continue;
+        }
+        openInstance->inodeId = inodeId;
+        openInstance->originalSize = size;
+        openInstance->currentSize = size;
+        openInstance->nodeId = nodeId;
+        openInstance->path = paths[i];
+        openInstance->oflags = oflags;
+        if (IsSmallFileRead(openInstance.get())) {
+            if (AllocSmallFileBuffer(openInstance.get()) != 0) {
+                FalconFd::GetInstance()->ReleaseOpenInstance();
+                rets[i] = -ENOMEM;
+                continue;
+            }
+            smallFiles.push_back(openInstance.get());
+            smallIndexes.push_back(i);
+        }
+        openInstances[i] = openInstance;
+    }
+
+    if (!smallFiles.empty()) {
+        std::vector<int> readRets;
+        InnerFalconBatchReadSmallFiles(smallFiles, readRets);
+        for (size_t i = 0; i < smallIndexes.size(); ++i) {
+            if (readRets[i] < 0) {
+                FalconFd::GetInstance()->ReleaseOpenInstance();
+                openInstances[smallIndexes[i]] = nullptr;
+                rets[smallIndexes[i]] = readRets[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num; ++i) {
+        if (openInstances[i] != nullptr) {
+            fds[i] = FalconFd::GetInstance()->AttachFd(paths[i], openInstances[i]);
+        }
+    }
+    return SUCCESS;
+}
+
 int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync)
 {
     OpenInstance *openInstance = FalconFd::GetInstance()->GetOpenInstanceByFd(fd).get();
@@ -253,6 +376,7 @@ int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         return SUCCESS;
     }
 
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -269,6 +393,7 @@ int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconClose failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -281,6 +406,7 @@ int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
 
 int FalconUnlink(const std::string &path)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -300,6 +426,7 @@ int FalconUnlink(const std::string &path)
         errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconUnlink failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -315,6 +442,194 @@ int FalconUnlink(const std::string &path)
     return errorCode;
 }
 
+struct BatchMetaGroup
+{
+    std::shared_ptr<Connection> conn;
+    std::vector<size_t> indexes;
+    std::vector<const char *> paths;
+    // result of each path once the request of the group is answered
+    std::vector<FalconErrorCode> errorCodes;
+};
+
+// splits the paths by the server owning them, at most BATCH_META_MAX_COUNT per group, unroutable ones fail in rets
+static std::vector<BatchMetaGroup> GroupPathsByServer(const std::vector<std::string> &paths,
+                                                      const std::vector<size_t> &indexes,
+                                                      std::vector<int> &rets)
+{
+    std::vector<BatchMetaGroup> groups;
+    std::unordered_map<Connection *, size_t> openGroups;
+    for (size_t i : indexes) {
+        std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(paths[i]);
+        if (!conn) {
+            FALCON_LOG(LOG_ERROR) << "route error";
+            rets[i] = PROGRAM_ERROR;
+            continue;
+        }
+        auto it = openGroups.find(conn.get());
+        if (it == openGroups.end() || groups[it->second].indexes.size() >= BATCH_META_MAX_COUNT) {
+            groups.push_back(BatchMetaGroup{conn, {}, {}, {}});
+            it = openGroups.insert_or_assign(conn.get(), groups.size() - 1).first;
+        }
+        groups[it->second].indexes.push_back(i);
+        groups[it->second].paths.push_back(paths[i].c_str());
+    }
+    return groups;
+}
+
+/*
+ * Sends the request of every group without waiting for the answers, so those to different servers are in flight at
+ * the same time, and returns once all of them are answered. send(g, done) starts the request of groups[g] on its
+ * connection, done gets the error of the request itself. Requests to a server gone away are sent again to the one
+ * the router finds instead.
+ */
+template <typename BatchSend>
+static void RunBatchPerServer(std::vector<BatchMetaGroup> &groups, const BatchSend &send)
+{
+    std::vector<FalconErrorCode> errorCodes(groups.size(), SUCCESS);
+    auto sendAndWait = [&](const std::vector<size_t> &toSend) {
+        bthread::CountdownEvent answered((int)toSend.size());
+        for (size_t g : toSend) {
+            send(g, [&errorCodes, &answered, g](FalconErrorCode errorCode) {
+                errorCodes[g] = errorCode;
+                answered.signal();
+            });
+        }
+        answered.wait();
+    };
+
+    std::vector<size_t> toSend(groups.size());
+    std::iota(toSend.begin(), toSend.end(), 0);
+    sendAndWait(toSend);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT) {
+        toSend.clear();
+        for (size_t g = 0; g < groups.size(); ++g) {
+            if (errorCodes[g] == SERVER_FAULT) {
+                toSend.push_back(g);
+            }
+        }
+        if (toSend.empty()) {
+            break;
+        }
+        ++cnt;
+        sleep(SLEEPTIME);
+        for (size_t g : toSend) {
+            groups[g].conn = router->TryToUpdateWorkerConn(groups[g].conn);
+        }
+        sendAndWait(toSend);
+    }
+#endif
+    for (size_t g = 0; g < groups.size(); ++g) {
+        if (errorCodes[g] != SUCCESS) {
+            FALCON_LOG(LOG_ERROR) << "batch request of " << groups[g].indexes.size() << " paths failed, DN: "
+                                  << groups[g].conn->server.id << ", ip: " << groups[g].conn->server.ip
+                                  << ", error code: " << errorCodes[g];
+        }
+    }
+}
+
+int FalconBatchStat(const std::vector<std::string> &paths, std::vector<struct stat> &stbufs, std::vector<int> &rets)
+{
+    size_t num = paths.size();
+    stbufs.assign(num, {});
+    rets.assign(num, SUCCESS);
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < num; ++i) {
+        int errorCode = SUCCESS;
+        if (AttrCache::GetInstance().Get(paths[i], &stbufs[i], errorCode)) {
+            rets[i] = errorCode;
+        } else {
+            misses.push_back(i);
+        }
+    }
+
+    std::vector<BatchMetaGroup> groups = GroupPathsByServer(paths, misses, rets);
+    std::vector<std::vector<struct stat>> groupStbufs(groups.size());
+    std::vector<std::vector<uint32_t>> leaseMs(groups.size());
+    RunBatchPerServer(groups, [&](size_t g, Connection::BatchDone done) {
+        groups[g].conn->BatchStat(groups[g].paths, groups[g].errorCodes, groupStbufs[g], leaseMs[g], std::move(done));
+    });
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const BatchMetaGroup &group = groups[g];
+        for (size_t j = 0; j < group.indexes.size(); ++j) {
+            size_t i = group.indexes[j];
+            rets[i] = group.errorCodes[j];
+            if (group.errorCodes[j] == SUCCESS) {
+                stbufs[i] = groupStbufs[g][j];
+                AttrCache::GetInstance().Put(paths[i], stbufs[i], leaseMs[g][j]);
+            } else if (group.errorCodes[j] == FILE_NOT_EXISTS || group.errorCodes[j] == PATH_NOT_EXISTS) {
+                AttrCache::GetInstance().PutNegative(paths[i], group.errorCodes[j]);
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+int FalconBatchCreate(const std::vector<std::string> &paths, std::vector<int> &rets)
+{
+    size_t num = paths.size();
+    rets.assign(num, SUCCESS);
+    std::vector<size_t> indexes(num);
+    for (size_t i = 0; i < num; ++i) {
+        indexes[i] = i;
+        AttrCache::GetInstance().Invalidate(paths[i]);
+    }
+
+    std::vector<BatchMetaGroup> groups = GroupPathsByServer(paths, indexes, rets);
+    RunBatchPerServer(groups, [&](size_t g, Connection::BatchDone done) {
+        groups[g].conn->BatchCreate(groups[g].paths, groups[g].errorCodes, std::move(done));
+    });
+    for (size_t i = 0; i < num; ++i) {
+        AttrCache::GetInstance().Invalidate(paths[i]);
+    }
+    for (const BatchMetaGroup &group : groups) {
+        for (size_t j = 0; j < group.indexes.size(); ++j) {
+            rets[group.indexes[j]] = group.errorCodes[j];
+        }
+    }
+    return SUCCESS;
+}
+
+int FalconBatchUnlink(const std::vector<std::string> &paths, std::vector<int> &rets)
+{
+    size_t num = paths.size();
+    rets.assign(num, SUCCESS);
+    std::vector<size_t> indexes(num);
+    for (size_t i = 0; i < num; ++i) {
+        indexes[i] = i;
+        AttrCache::GetInstance().Invalidate(paths[i]);
+    }
+
+    std::vector<BatchMetaGroup> groups = GroupPathsByServer(paths, indexes, rets);
+    std::vector<std::vector<uint64_t>> inodeIds(groups.size());
+    std::vector<std::vector<int64_t>> sizes(groups.size());
+    std::vector<std::vector<int32_t>> nodeIds(groups.size());
+    RunBatchPerServer(groups, [&](size_t g, Connection::BatchDone done) {
+        groups[g].conn->BatchUnlink(groups[g].paths,
+                                    groups[g].errorCodes,
+                                    inodeIds[g],
+                                    sizes[g],
+                                    nodeIds[g],
+                                    std::move(done));
+    });
+    for (size_t i = 0; i < num; ++i) {
+        AttrCache::GetInstance().Invalidate(paths[i]);
+    }
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const BatchMetaGroup &group = groups[g];
+        for (size_t j = 0; j < group.indexes.size(); ++j) {
+            size_t i = group.indexes[j];
+            rets[i] = group.errorCodes[j];
+            // delete data
+            if (group.errorCodes[j] == SUCCESS && InnerFalconUnlink(inodeIds[g][j], nodeIds[g][j], paths[i]) != 0) {
+                FALCON_LOG(LOG_WARNING) << "In FalconBatchUnlink(): delete cache " << paths[i] << " failed";
+            }
+        }
+    }
+    return SUCCESS;
+}
+
 int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, off_t offset, struct FalconFuseInfo *fi)
 {
     uint64_t fd = fi->fh;
@@ -349,48 +664,55 @@ int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, o
         dirOpenInstance->workers = dirOpenInstance->workingWorkers;
         dirOpenInstance->workingWorkers.clear();
         dirOpenInstance->partialEntryVec.clear();
+        dirOpenInstance->fileStats.clear();
         dirOpenInstance->offset = 0;
         for (auto it = dirOpenInstance->workers.begin(); it != dirOpenInstance->workers.end(); ++it) {
             std::string ipPort = it->first;
             std::shared_ptr<Connection> conn = it->second;
-            Connection::ReadDirResponse readDirResponse;
-            ret = conn->ReadDir(path.c_str(),
-                                readDirResponse,
-                                fileNumberPerWorker,
-                                dirOpenInstance->lastShardIndexes[ipPort],
-                                dirOpenInstance->lastFileNames[ipPort].empty()
-                                    ? nullptr
-                                    : dirOpenInstance->lastFileNames[ipPort].c_str());
+            Connection::ReadDirPlusResponse readDirPlusResponse;
+            ret = conn->ReadDirPlus(path.c_str(),
+                                    readDirPlusResponse,
+                                    fileNumberPerWorker,
+                                    dirOpenInstance->lastShardIndexes[ipPort],
+                                    dirOpenInstance->lastFileNames[ipPort].empty()
+                                        ? nullptr
+                                        : dirOpenInstance->lastFileNames[ipPort].c_str());
 #ifdef ZK_INIT
             int cnt = 0;
             while (cnt < RETRY_CNT && ret == SERVER_FAULT) {
                 ++cnt;
                 sleep(SLEEPTIME);
                 conn = router->TryToUpdateWorkerConn(conn);
-                ret = conn->ReadDir(path.c_str(),
-                                    readDirResponse,
-                                    fileNumberPerWorker,
-                                    dirOpenInstance->lastShardIndexes[ipPort],
-                                    dirOpenInstance->lastFileNames[ipPort].empty()
-                                        ? nullptr
-                                        : dirOpenInstance->lastFileNames[ipPort].c_str());
+                ret = conn->ReadDirPlus(path.c_str(),
+                                        readDirPlusResponse,
+                                        fileNumberPerWorker,
+                                        dirOpenInstance->lastShardIndexes[ipPort],
+                                        dirOpenInstance->lastFileNames[ipPort].empty()
+                                            ? nullptr
+                                            : dirOpenInstance->lastFileNames[ipPort].c_str());
             }
 #endif
             if (ret != SUCCESS) {
                 FALCON_LOG(LOG_ERROR) << "FalconReadDir failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << ret;
                 return ret;
             }
-            dirOpenInstance->lastShardIndexes[ipPort] = readDirResponse.response->last_shard_index();
-            if (readDirResponse.response->last_file_name() == nullptr)
+            dirOpenInstance->lastShardIndexes[ipPort] = readDirPlusResponse.response->last_shard_index();
+            if (readDirPlusResponse.response->last_file_name() == nullptr)
                 dirOpenInstance->lastFileNames[ipPort] = "";
             else
-                dirOpenInstance->lastFileNames[ipPort] = readDirResponse.response->last_file_name()->str();
-            auto result_list = readDirResponse.response->result_list();
+                dirOpenInstance->lastFileNames[ipPort] = readDirPlusResponse.response->last_file_name()->str();
+            auto result_list = readDirPlusResponse.response->result_list();
 
-            // fill the fuse readdir buffer using metadata
+            // fill the fuse readdir buffer using metadata, the getattr calls that follow a listing hit the cache
+            std::string parent = path.back() == '/' ? path : path + "/";
             for (unsigned i = 0; i < result_list->size(); i++) {
+                struct stat st;
+                readDirPlusResponse.EntryStat(i, &st);
                 dirOpenInstance->partialEntryVec.push_back(result_list->Get(i)->file_name()->c_str());
-                dirOpenInstance->fileModes.push_back(result_list->Get(i)->st_mode());
+                dirOpenInstance->fileStats.push_back(st);
+                AttrCache::GetInstance().Put(parent + result_list->Get(i)->file_name()->str(),
+                                             st,
+                                             readDirPlusResponse.response->lease_ms());
             }
             if (result_list->size() < fileNumberPerWorker && ret == SUCCESS) {
                 dirOpenInstance->lastFileNames.erase(ipPort);
@@ -400,11 +722,7 @@ int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, o
         }
     }
     for (size_t i = dirOpenInstance->offset; i < dirOpenInstance->partialEntryVec.size(); i++) {
-        struct stat st;
-        (void)memset(&st, 0, sizeof(st));
-
-        st.st_mode = static_cast<mode_t>(dirOpenInstance->fileModes[i]);
-        if (filler(buf, dirOpenInstance->partialEntryVec[i].c_str(), &st, idx++)) {
+        if (filler(buf, dirOpenInstance->partialEntryVec[i].c_str(), &dirOpenInstance->fileStats[i], idx++)) {
             dirOpenInstance->offset = i;
             return 0;
         }
@@ -463,6 +781,7 @@ int FalconDestroy()
 
 int FalconRmDir(const std::string &path)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -478,6 +797,7 @@ int FalconRmDir(const std::string &path)
         errorCode = conn->Rmdir(path.c_str());
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconRmDir failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -512,9 +832,61 @@ int FalconRead(const std::string & /*path*/, uint64_t fd, char *buffer, size_t s
     return ret;
 }
 
-int FalconRename(const std::string &srcName, const std::string &dstName)
+/*
+ * Only a source the cache knows as a regular file has no cached paths below it. Any other source may be a directory
+ * whose children were cached without it, e.g. by READDIRPLUS.
+ */
+static bool CachedAsRegularFile(const std::string &path)
 {
-    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
+    struct stat st;
+    int errorCode = 0;
+    return AttrCache::GetInstance().Peek(path, &st, errorCode) && errorCode == SUCCESS && S_ISREG(st.st_mode);
+}
+
+/*
+ * A rename changes the two paths themselves, a renamed directory also moves every cached path below it. Done before
+ * the rename and again once it is answered, a lookup racing with it may have cached the old attributes meanwhile.
+ */
+static void InvalidateRenamedAttrs(const std::string &srcName, const std::string &dstName, bool srcIsFile)
+{
+    AttrCache &cache = AttrCache::GetInstance();
+    cache.Invalidate(srcName);
+    cache.Invalidate(dstName);
+    if (!srcIsFile) {
+        cache.InvalidatePrefix(srcName);
+        cache.InvalidatePrefix(dstName);
+    }
+}
+
+/*
+ * A file whose old and new name belong to the same server is renamed by that server alone, in its local transaction.
+ * Everything else goes through the coordinator, including the directories such a server turns down with
+ * WRONG_WORKER, since every server keeps a copy of the directory table.
+ */
+static int RenameOnServer(const std::string &srcName, const std::string &dstName)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(srcName);
+    if (conn && conn == router->GetWorkerConnByPath(dstName)) {
+        int errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
+#ifdef ZK_INIT
+        int cnt = 0;
+        while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateWorkerConn(conn);
+            errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
+        }
+#endif
+        if (errorCode != WRONG_WORKER) {
+            if (errorCode != SUCCESS) {
+                FALCON_LOG(LOG_ERROR) << "rename " << srcName << " failed, DN: " << conn->server.id
+                                      << ", ip: " << conn->server.ip << ", error code: " << errorCode;
+            }
+            return errorCode;
+        }
+    }
+
+    conn = router->GetCoordinatorConn();
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
         return PROGRAM_ERROR;
@@ -530,11 +902,21 @@ int FalconRename(const std::string &srcName, const std::string &dstName)
     }
 #endif
     if (errorCode != SUCCESS) {
-        FALCON_LOG(LOG_ERROR) << "FalconRename failed for srcName: " << srcName << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
+        FALCON_LOG(LOG_ERROR) << "rename " << srcName << " failed, DN: " << conn->server.id
+                              << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
     return errorCode;
 }
 
+int FalconRename(const std::string &srcName, const std::string &dstName)
+{
+    bool srcIsFile = CachedAsRegularFile(srcName);
+    InvalidateRenamedAttrs(srcName, dstName, srcIsFile);
+    int errorCode = RenameOnServer(srcName, dstName);
+    InvalidateRenamedAttrs(srcName, dstName, srcIsFile);
+    return errorCode;
+}
+
 int FalconRenamePersist(const std::string &srcName, const std::string &dstName)
 {
     struct stat stbuf;
@@ -555,24 +937,9 @@ int FalconRenamePersist(const std::string &srcName, const std::string &dstName)
         return ret;
     }
     // update the metadata for rename
-    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
-    if (!conn) {
-        FALCON_LOG(LOG_ERROR) << "route error";
-        return PROGRAM_ERROR;
-    }
-    int errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
-#ifdef ZK_INIT
-    int cnt = 0;
-    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
-        ++cnt;
-        sleep(SLEEPTIME);
-        conn = router->TryToUpdateCNConn(conn);
-        errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
-    }
-#endif
-    if (errorCode != SUCCESS) {
-        FALCON_LOG(LOG_ERROR) << "FalconRenamePersist failed for srcName: " << srcName << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
-    }
+    InvalidateRenamedAttrs(srcName, dstName, true);
+    int errorCode = RenameOnServer(srcName, dstName);
+    InvalidateRenamedAttrs(srcName, dstName, true);
     if (errorCode == SUCCESS) {
         // delete src object
         InnerFalconDeleteDataAfterRename(srcName);
@@ -596,6 +963,7 @@ int FalconStatFS(struct statvfs *vfsbuf)
 
 int FalconUtimens(const std::string &path, int64_t accessTime, int64_t modifyTime)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -612,6 +980,7 @@ int FalconUtimens(const std::string &path, int64_t accessTime, int64_t modifyTim
         errorCode = conn->UtimeNs(path.c_str(), accessTime, modifyTime);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconUtimens failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -620,6 +989,7 @@ int FalconUtimens(const std::string &path, int64_t accessTime, int64_t modifyTim
 
 int FalconChown(const std::string &path, uid_t uid, gid_t gid)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -636,6 +1006,7 @@ int FalconChown(const std::string &path, uid_t uid, gid_t gid)
         errorCode = conn->Chown(path.c_str(), uid, gid);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconChown failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -644,6 +1015,7 @@ int FalconChown(const std::string &path, uid_t uid, gid_t gid)
 
 int FalconChmod(const std::string &path, mode_t mode)
 {
+    AttrCache::GetInstance().Invalidate(path);
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
@@ -660,6 +1032,7 @@ int FalconChmod(const std::string &path, mode_t mode)
         errorCode = conn->Chmod(path.c_str(), mode);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconChmod failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
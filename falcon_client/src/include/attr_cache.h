@@ -0,0 +1,83 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+constexpr int ATTR_CACHE_SHARD_NUM = 64;
+constexpr uint64_t ATTR_CACHE_DEFAULT_MEMORY_LIMIT = 64ULL * 1024 * 1024;
+// hash node, key string and bucket slot of one entry, on top of sizeof(Entry) and the path bytes
+constexpr size_t ATTR_CACHE_ENTRY_OVERHEAD = 64;
+
+/*
+ * Attributes and dentries the client got from the metadata server, path -> stat, and the paths it was told do not
+ * exist. A positive entry is served for the lease the server granted with it, capped by the local ttl, a negative
+ * one for the negative ttl. The server does not call clients back, so changes made through other clients show up
+ * once the lease runs out, changes made through this client drop what they touch right away. They drop it before
+ * their rpc and again once it is answered, so a lookup racing with the rpc cannot keep the old attributes. Opens
+ * always ask the server, which gives close-to-open consistency.
+ */
+class AttrCache {
+  public:
+    static AttrCache &GetInstance();
+
+    // upper bound of the lease a positive entry is served for, 0 turns the cache off
+    void SetTtl(uint32_t ttl) { ttlMs = ttl; }
+    uint32_t GetTtl() const { return ttlMs; }
+    // how long a path that does not exist is remembered, 0 keeps no negative entries
+    void SetNegativeTtl(uint32_t ttl) { negativeTtlMs = ttl; }
+    uint32_t GetNegativeTtl() const { return negativeTtlMs; }
+    // bytes all entries may take, split evenly over the shards
+    void SetMemoryLimit(uint64_t bytes) { shardMemoryLimit = bytes / ATTR_CACHE_SHARD_NUM; }
+    uint64_t GetMemoryUsage() const { return memoryUsage; }
+
+    void Put(const std::string &path, const struct stat &st, uint32_t leaseMs);
+    // errorCode is what the server answered for the missing path
+    void PutNegative(const std::string &path, int errorCode);
+    /*
+     * Returns true on a hit, with errorCode 0 and st filled for a positive entry or the remembered error code for a
+     * negative one. Counted as ATTR_CACHE_HIT or ATTR_CACHE_MISS.
+     */
+    bool Get(const std::string &path, struct stat *st, int &errorCode);
+    // Get for the client itself, not counted in the hit and miss stats
+    bool Peek(const std::string &path, struct stat *st, int &errorCode);
+    void Invalidate(const std::string &path);
+    // drops every entry below the directory, a walk over the whole cache
+    void InvalidatePrefix(const std::string &dir);
+    void Clear();
+
+  private:
+    struct Entry
+    {
+        struct stat st;
+        int errorCode;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        uint64_t memoryUsage = 0;
+    };
+
+    Shard &GetShard(const std::string &path) { return shards[std::hash<std::string>{}(path) % ATTR_CACHE_SHARD_NUM]; }
+    static size_t EntrySize(const std::string &path) { return sizeof(Entry) + path.size() + ATTR_CACHE_ENTRY_OVERHEAD; }
+    bool Lookup(const std::string &path, struct stat *st, int &errorCode);
+    void Insert(const std::string &path, const Entry &entry);
+    void Erase(Shard &shard, std::unordered_map<std::string, Entry>::iterator it);
+
+    Shard shards[ATTR_CACHE_SHARD_NUM];
+    std::atomic<uint32_t> ttlMs{0};
+    std::atomic<uint32_t> negativeTtlMs{0};
+    std::atomic<uint64_t> shardMemoryLimit{ATTR_CACHE_DEFAULT_MEMORY_LIMIT / ATTR_CACHE_SHARD_NUM};
+    std::atomic<uint64_t> memoryUsage{0};
+};
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -70,6 +71,21 @@ class Connection {
                                    ResponseHandler responseHandler,
                                    ConnectionCache *cache = nullptr,
                                    ResultType *result = nullptr);
+  public:
+    // told the error of a batched request once it is answered, on a brpc thread
+    using BatchDone = std::function<void(FalconErrorCode)>;
+
+  private:
+    // one request carrying count params of the same type, sent without waiting for the answer. responseHandler
+    // fills errorCodes[i] for the i-th reply before done is run
+    template <typename ParamBuilder, typename ResponseHandler>
+    void ProcessBatchRequest(falcon::meta_proto::MetaServiceType type,
+                             size_t count,
+                             const ParamBuilder &paramBuilder,
+                             ResponseHandler responseHandler,
+                             std::vector<FalconErrorCode> &errorCodes,
+                             BatchDone done,
+                             ConnectionCache *cache = nullptr);
 
   public:
     ServerIdentifier server;
@@ -84,6 +100,9 @@ class Connection {
     }
     ~Connection() = default;
 
+    // scheduling class of the requests this thread sends from now on, e.g. BACKGROUND for bulk scans and copies
+    static void SetThreadRequestPriority(falcon::meta_proto::MetaRequestPriority priority);
+
     class PlainCommandResult {
         friend Connection;
 
@@ -103,18 +122,45 @@ class Connection {
     FalconErrorCode Mkdir(const char *path, ConnectionCache *cache = nullptr);
     FalconErrorCode
     Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct stat *stbuf, ConnectionCache *cache = nullptr);
-    FalconErrorCode Stat(const char *path, struct stat *stbuf, ConnectionCache *cache = nullptr);
+    // leaseMs gets how long the server allows stbuf to be cached
+    FalconErrorCode
+    Stat(const char *path, struct stat *stbuf, uint32_t *leaseMs = nullptr, ConnectionCache *cache = nullptr);
     FalconErrorCode Open(const char *path,
                          uint64_t &inodeId,
                          int64_t &size,
                          int32_t &nodeId,
                          struct stat *stbuf,
+                         uint32_t *leaseMs = nullptr,
                          ConnectionCache *cache = nullptr);
     FalconErrorCode
     Close(const char *path, int64_t size, uint64_t mtime, int32_t nodeId, ConnectionCache *cache = nullptr);
     FalconErrorCode
     Unlink(const char *path, uint64_t &inodeId, int64_t &size, int32_t &nodeId, ConnectionCache *cache = nullptr);
 
+    /*
+     * Batched STAT, CREATE and UNLINK of paths that all live on this server, sent as one request. They return once
+     * the request is sent and run done with the error of the request itself when it is answered, by then errorCodes
+     * has the result of each path and the other vectors are filled for the paths that succeeded. The vectors must
+     * outlive the call of done.
+     */
+    void BatchStat(const std::vector<const char *> &paths,
+                   std::vector<FalconErrorCode> &errorCodes,
+                   std::vector<struct stat> &stbufs,
+                   std::vector<uint32_t> &leaseMs,
+                   BatchDone done,
+                   ConnectionCache *cache = nullptr);
+    void BatchCreate(const std::vector<const char *> &paths,
+                     std::vector<FalconErrorCode> &errorCodes,
+                     BatchDone done,
+                     ConnectionCache *cache = nullptr);
+    void BatchUnlink(const std::vector<const char *> &paths,
+                     std::vector<FalconErrorCode> &errorCodes,
+                     std::vector<uint64_t> &inodeIds,
+                     std::vector<int64_t> &sizes,
+                     std::vector<int32_t> &nodeIds,
+                     BatchDone done,
+                     ConnectionCache *cache = nullptr);
+
     struct ReadDirResponse
     {
       protected:
@@ -131,6 +177,24 @@ class Connection {
                             const char *lastFileName = nullptr,
                             ConnectionCache *cache = nullptr);
 
+    // READDIR whose entries carry the whole stat, so that listing a directory needs no STAT per entry
+    struct ReadDirPlusResponse
+    {
+      protected:
+        std::unique_ptr<char[]> buffer;
+
+      public:
+        const falcon::meta_fbs::ReadDirPlusResponse *response;
+        void EntryStat(uint32_t index, struct stat *stbuf) const;
+        friend class Connection;
+    };
+    FalconErrorCode ReadDirPlus(const char *path,
+                                ReadDirPlusResponse &readDirPlusResponse,
+                                int32_t maxReadCount = -1,
+                                int32_t lastShardIndex = -1,
+                                const char *lastFileName = nullptr,
+                                ConnectionCache *cache = nullptr);
+
     FalconErrorCode OpenDir(const char *path, uint64_t &inodeId, ConnectionCache *cache = nullptr);
     FalconErrorCode Rmdir(const char *path, ConnectionCache *cache = nullptr);
     FalconErrorCode Rename(const char *src, const char *dst, ConnectionCache *cache = nullptr);
@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "router.h"
 
@@ -44,8 +46,24 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
 
 int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf);
 
+int FalconBatchOpen(const std::vector<std::string> &paths,
+                    int oflags,
+                    std::vector<uint64_t> &fds,
+                    std::vector<int> &rets);
+
 int FalconUnlink(const std::string &path);
 
+/*
+ * Stat, create or unlink many paths with one request per metadata server instead of one per path, e.g. the files of
+ * a dataset being prepared or of a checkpoint being cleaned up. rets get what the single-path call returns for each
+ * path. Created files are empty and not opened.
+ */
+int FalconBatchStat(const std::vector<std::string> &paths, std::vector<struct stat> &stbufs, std::vector<int> &rets);
+
+int FalconBatchCreate(const std::vector<std::string> &paths, std::vector<int> &rets);
+
+int FalconBatchUnlink(const std::vector<std::string> &paths, std::vector<int> &rets);
+
 int FalconOpenDir(const std::string &path, struct FalconFuseInfo *fi);
 
 int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, off_t offset, struct FalconFuseInfo *fi);
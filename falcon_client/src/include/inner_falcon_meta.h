@@ -27,6 +27,7 @@ int InnerFalconRead(OpenInstance *openInstance, char *buffer, size_t size, off_t
 int InnerFalconAsyncCopy(uint64_t inodeId, int &backupNodeId);
 
 int InnerFalconReadSmallFiles(OpenInstance *openInstance);
+void InnerFalconBatchReadSmallFiles(std::vector<OpenInstance *> &openInstances, std::vector<int> &rets);
 int InnerFalconStatFS(struct statvfs *vfsbuf);
 int InnerFalconCopydata(const std::string &srcName, const std::string &dstName);
 int InnerFalconDeleteDataAfterRename(const std::string &objectName);
@@ -26,6 +26,11 @@ int InnerFalconReadSmallFiles(OpenInstance *openInstance)
     return FalconStore::GetInstance()->ReadSmallFiles(openInstance);
 }
 
+void InnerFalconBatchReadSmallFiles(std::vector<OpenInstance *> &openInstances, std::vector<int> &rets)
+{
+    FalconStore::GetInstance()->BatchReadSmallFiles(openInstances, rets);
+}
+
 int InnerFalconStatFS(struct statvfs *vfsbuf) { return FalconStore::GetInstance()->StatFS(vfsbuf); }
 
 int InnerFalconCopydata(const std::string &srcName, const std::string &dstName)
@@ -16,6 +16,7 @@
 #include "buffer/dir_open_instance.h"
 #include "buffer/open_instance.h"
 #include "connection/node.h"
+#include "falcon_store/cache_migrator.h"
 #include "falcon_store/falcon_store.h"
 #include "log/logging.h"
 #include "util/utils.h"
@@ -155,35 +156,16 @@ void RemoteIOServiceImpl::ReadFile(google::protobuf::RpcController *cntl_base,
         return;
     }
 
-    char *buffer;
-    size_t allocSize = readSize;
-    if (openInstance->oflags & __O_DIRECT) {
-        allocSize = (readSize / ALIGNMENT + (readSize % ALIGNMENT != 0)) * ALIGNMENT;
-        buffer = static_cast<char *>(aligned_alloc(ALIGNMENT, allocSize));
-    } else {
-        buffer = static_cast<char *>(malloc(allocSize));
-    }
-    if (buffer == nullptr) {
-        FALCON_LOG(LOG_ERROR) << "Allocation failed for size " << allocSize;
-        response->set_error_code(-ENOMEM);
-        return;
-    }
-
-    int retSize = FalconStore::GetInstance()->ReadFileLR(buffer, offset, openInstance.get(), allocSize);
+    ssize_t retSize =
+        FalconStore::GetInstance()->ReadFileForBrpc(openInstance.get(), cntl->response_attachment(), readSize, offset);
     if (retSize < 0) {
-        free(buffer);
+        cntl->response_attachment().clear();
         FALCON_LOG(LOG_ERROR) << "ReadFile rpc failed, fd = " << fd << ", error = " << retSize;
         response->set_error_code(retSize);
         return;
     }
 
     response->set_error_code(0);
-#ifdef USE_RDMA
-    cntl->response_attachment().append(buffer, retSize);
-    free(buffer);
-#else
-    cntl->response_attachment().append_user_data(buffer, retSize, [](void *buf) { free(buf); });
-#endif
 }
 
 void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_base,
@@ -250,6 +232,83 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
 #endif
 }
 
+void RemoteIOServiceImpl::BatchReadSmallFiles(google::protobuf::RpcController *cntl_base,
+                                              const BatchReadSmallFilesRequest *request,
+                                              BatchReadSmallFilesReply *response,
+                                              google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+
+    int num = request->files_size();
+    FALCON_LOG(LOG_INFO) << "Receive BatchReadSmallFiles rpc request, files = " << num;
+    if (num > BATCH_READ_SMALL_FILES_MAX) {
+        response->set_error_code(-EINVAL);
+        return;
+    }
+
+    auto items = std::make_shared<std::vector<SmallFileReadItem>>(num);
+    size_t totalSize = 0;
+    for (int i = 0; i < num; ++i) {
+        const ReadSmallFileRequest &file = request->files(i);
+        SmallFileReadItem &item = (*items)[i];
+        item.inodeId = file.inode_id();
+        item.path = file.path();
+        item.oflags = file.oflags();
+        item.nodeFail = file.node_fail();
+        if (file.read_size() > READ_BIGFILE_SIZE) {
+            item.ret = -EAGAIN;
+            continue;
+        }
+        item.size = file.read_size();
+        totalSize += item.size;
+    }
+
+    /* one buffer for all items, each item reads into its own slice */
+    char *buffer = nullptr;
+    if (totalSize > 0) {
+        buffer = static_cast<char *>(malloc(totalSize));
+        if (buffer == nullptr) {
+            FALCON_LOG(LOG_ERROR) << "Allocation failed for size " << totalSize;
+            response->set_error_code(-ENOMEM);
+            return;
+        }
+    }
+    size_t bufOffset = 0;
+    for (SmallFileReadItem &item : *items) {
+        item.buf = buffer + bufOffset;
+        bufOffset += item.size;
+    }
+
+    /* the reply is sent by whichever store thread reads the last item, the bthread returns right away */
+    google::protobuf::Closure *batchDone = doneGuard.release();
+    auto finish = [items, buffer, totalSize, cntl, response, batchDone]() {
+        brpc::ClosureGuard finishGuard(batchDone);
+        response->set_error_code(0);
+        butil::IOBuf data;
+        if (totalSize > 0) {
+#ifdef USE_RDMA
+            data.append(buffer, totalSize);
+            free(buffer);
+#else
+            data.append_user_data(buffer, totalSize, [](void *buf) { free(buf); });
+#endif
+        }
+        /* slices of failed items are dropped, the others are moved without copy */
+        for (SmallFileReadItem &item : *items) {
+            response->add_error_codes(item.ret);
+            if (item.ret == 0) {
+                data.cutn(&cntl->response_attachment(), item.size);
+            } else {
+                data.pop_front(item.size);
+                FALCON_LOG(LOG_ERROR) << "BatchReadSmallFiles rpc failed, inodeId = " << item.inodeId
+                                      << ", error = " << item.ret;
+            }
+        }
+    };
+    FalconStore::GetInstance()->BatchReadSmallFilesForBrpc(items, finish);
+}
+
 void RemoteIOServiceImpl::WriteFile(google::protobuf::RpcController *cntl_base,
                                     const WriteRequest *request,
                                     WriteReply *response,
@@ -416,6 +475,24 @@ void RemoteIOServiceImpl::StatCluster(google::protobuf::RpcController *cntl_base
     response->set_error_code(ret);
 }
 
+void RemoteIOServiceImpl::MigrateFile(google::protobuf::RpcController *cntl_base,
+                                      const MigrateFileRequest *request,
+                                      ErrorCodeOnlyReply *response,
+                                      google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+
+    uint64_t inodeId = request->inode_id();
+    uint64_t size = request->size();
+    off_t offset = request->offset();
+    FALCON_LOG(LOG_INFO) << "Receive MigrateFile rpc request, inode = " << inodeId << " offset = " << offset
+                         << " size = " << size;
+
+    int ret = CacheMigrator::GetInstance().Receive(inodeId, size, offset, cntl->request_attachment());
+    response->set_error_code(ret);
+}
+
 int RemoteIOServer::Run()
 {
     falcon::brpc_io::RemoteIOServiceImpl remoteIOServiceImpl;
@@ -4,6 +4,8 @@
 
 #include "connection/falcon_io_client.h"
 
+#include <bthread/countdown_event.h>
+
 #include "log/logging.h"
 
 static int BrpcErrorCodeToFuseErrno(int brpcErrorCode)
@@ -185,6 +187,84 @@ ssize_t FalconIOClient::ReadSmallFile(uint64_t inodeId,
     return 0;
 }
 
+/* one BatchReadSmallFiles rpc in flight, brpc runs it once the rpc is answered and it deletes itself */
+class BatchReadSmallFilesDone : public google::protobuf::Closure {
+  public:
+    brpc::Controller cntl;
+    falcon::brpc_io::BatchReadSmallFilesReply response;
+    std::vector<SmallFileReadItem *> items;
+    std::function<void(int)> done;
+
+    void Run() override
+    {
+        std::unique_ptr<BatchReadSmallFilesDone> self(this);
+        done(Finish());
+    }
+
+  private:
+    int Finish()
+    {
+        if (cntl.Failed()) {
+            FALCON_LOG(LOG_ERROR) << "Batch read small files by brpc failed " << cntl.ErrorText()
+                                  << "error code: " << cntl.ErrorCode();
+            return BrpcErrorCodeToFuseErrno(cntl.ErrorCode()); // positive reply
+        }
+
+        if (response.error_code() != 0) {
+            FALCON_LOG(LOG_ERROR) << "FalconIOClient::BatchReadSmallFiles failed: "
+                                  << strerror(-response.error_code());
+            return response.error_code();
+        }
+        if (response.error_codes_size() != (int)items.size()) {
+            FALCON_LOG(LOG_ERROR) << "Return item count doesn't equal to requested.";
+            return -EIO;
+        }
+
+        butil::IOBuf &attachment = cntl.response_attachment();
+        for (size_t i = 0; i < items.size(); ++i) {
+            int ret = response.error_codes(i);
+            if (ret == 0 && attachment.cutn(items[i]->buf, items[i]->size) != items[i]->size) {
+                FALCON_LOG(LOG_ERROR) << "Return bytes of " << items[i]->path << " doesn't equal to requested.";
+                ret = -EIO;
+            }
+            items[i]->ret = ret;
+        }
+        FALCON_LOG(LOG_INFO) << "In FalconIOClient::BatchReadSmallFiles(): read " << items.size() << " files";
+        return 0;
+    }
+};
+
+void FalconIOClient::BatchReadSmallFiles(const std::vector<SmallFileReadItem *> &items, std::function<void(int)> done)
+{
+    falcon::brpc_io::BatchReadSmallFilesRequest request;
+    for (SmallFileReadItem *item : items) {
+        falcon::brpc_io::ReadSmallFileRequest *file = request.add_files();
+        file->set_inode_id(item->inodeId);
+        file->set_read_size(item->size);
+        file->set_path(item->path);
+        file->set_oflags(item->oflags);
+        file->set_node_fail(item->nodeFail);
+    }
+    auto *call = new BatchReadSmallFilesDone();
+    call->cntl.set_timeout_ms(10000);
+    call->items = items;
+    call->done = std::move(done);
+    stub->BatchReadSmallFiles(&call->cntl, &request, &call->response, call);
+}
+
+// return 0: OK, result of each item in its ret; return negative: remote IO error, return positive: network error
+int FalconIOClient::BatchReadSmallFiles(std::vector<SmallFileReadItem *> &items)
+{
+    int ret = 0;
+    bthread::CountdownEvent answered(1);
+    BatchReadSmallFiles(items, [&ret, &answered](int batchRet) {
+        ret = batchRet;
+        answered.signal();
+    });
+    answered.wait();
+    return ret;
+}
+
 // return 0: OK, return negative: error of both network and IO
 int FalconIOClient::WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset)
 {
@@ -378,4 +458,30 @@ int FalconIOClient::StatCluster(int nodeId, std::vector<size_t> &stats, bool sca
     stats.assign(response.stats().begin(), response.stats().end());
 
     return 0;
-}
\ No newline at end of file
+}
+
+/* data is moved into the request attachment. return 0: OK, return negative: error of both network and IO */
+int FalconIOClient::MigrateFile(uint64_t inodeId, uint64_t size, off_t offset, butil::IOBuf &data)
+{
+    falcon::brpc_io::MigrateFileRequest request;
+    request.set_inode_id(inodeId);
+    request.set_size(size);
+    request.set_offset(offset);
+    falcon::brpc_io::ErrorCodeOnlyReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+    cntl.request_attachment().swap(data);
+
+    stub->MigrateFile(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        FALCON_LOG(LOG_ERROR) << "MigrateFile by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
+    }
+
+    /* EEXIST means the receiver caches the file already, left to the caller */
+    if (response.error_code() != 0 && response.error_code() != -EEXIST) {
+        FALCON_LOG(LOG_ERROR) << "FalconIOClient::MigrateFile failed: " << strerror(-response.error_code());
+    }
+    return response.error_code();
+}
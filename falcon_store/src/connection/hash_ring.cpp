@@ -0,0 +1,51 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "connection/hash_ring.h"
+
+#include <algorithm>
+
+uint64_t hash64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    x = x ^ (x >> 31);
+    return x;
+}
+
+HashRing::HashRing(const std::vector<int> &nodeIds, uint32_t virtualNodes)
+{
+    points.reserve(nodeIds.size() * virtualNodes);
+    for (int nodeId : nodeIds) {
+        for (uint32_t i = 0; i < virtualNodes; ++i) {
+            points.emplace_back(hash64(((uint64_t)(uint32_t)nodeId << 32) | i), nodeId);
+        }
+    }
+    std::sort(points.begin(), points.end());
+}
+
+int HashRing::Locate(uint64_t key) const
+{
+    if (points.empty()) {
+        return -1;
+    }
+    auto it = std::lower_bound(points.begin(), points.end(), std::make_pair(hash64(key), INT32_MIN));
+    return it == points.end() ? points.front().second : it->second;
+}
+
+int HashRing::Successor(uint64_t key, int nodeId) const
+{
+    if (points.empty()) {
+        return nodeId;
+    }
+    size_t start = std::lower_bound(points.begin(), points.end(), std::make_pair(hash64(key), INT32_MIN)) -
+                   points.begin();
+    for (size_t i = 0; i < points.size(); ++i) {
+        const auto &point = points[(start + i) % points.size()];
+        if (point.second != nodeId) {
+            return point.second;
+        }
+    }
+    return nodeId;
+}
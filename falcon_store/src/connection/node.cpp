@@ -58,6 +58,7 @@ int StoreNode::SetNodeConfig(int initNodeId, std::string &clusterView)
         }
         i++;
     }
+    RebuildRing();
 
     return initStatus;
 }
@@ -96,6 +97,7 @@ void StoreNode::UpdateNodeConfigByValue(std::unordered_map<int, std::string> &zk
     for (auto &delNode : toDel) {
         nodeMap.erase(delNode);
     }
+    bool changed = !toDel.empty();
     for (auto &newNodeKv : zkStoreNodes) {
         auto conn = CreateIOConnection(newNodeKv.second);
         if (conn == nullptr) {
@@ -104,6 +106,11 @@ void StoreNode::UpdateNodeConfigByValue(std::unordered_map<int, std::string> &zk
         }
         std::shared_ptr<FalconIOClient> connection(conn);
         nodeMap.emplace(newNodeKv.first, std::make_pair(newNodeKv.second, connection));
+        changed = true;
+    }
+    /* the view is fetched every few seconds, only rebuild when it really changed */
+    if (changed) {
+        RebuildRing();
     }
 }
 
@@ -154,6 +161,7 @@ void StoreNode::Delete()
 {
     std::unique_lock<std::shared_mutex> lock(nodeMutex);
     nodeMap.clear();
+    RebuildRing();
 }
 
 FalconIOClient *StoreNode::CreateIOConnection(const std::string &rpcEndPoint)
@@ -253,41 +261,39 @@ int StoreNode::GetNumberofAllNodes()
     return nodeMap.size();
 }
 
-uint64_t hash64(uint64_t x)
+/*
+ * Called with nodeMutex held after nodeMap changed
+ */
+void StoreNode::RebuildRing()
 {
-    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
-    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
-    x = x ^ (x >> 31);
-    return x;
+    std::vector<int> nodeIds;
+    nodeIds.reserve(nodeMap.size());
+    for (const auto &it : nodeMap) {
+        nodeIds.emplace_back(it.first);
+    }
+    ring.store(std::make_shared<const HashRing>(nodeIds));
+    ringVersion++;
 }
 
+uint64_t StoreNode::GetRingVersion() { return ringVersion.load(); }
+
 int StoreNode::AllocNode(uint64_t inodeId)
 {
-    std::shared_lock<std::shared_mutex> lock(nodeMutex);
-    if (!nodeMap.empty()) {
-        int index = (hash64(inodeId)) % nodeMap.size();
-        auto it = nodeMap.begin();
-        std::advance(it, index);
-        return it->first;
+    std::shared_ptr<const HashRing> current = ring.load();
+    if (current != nullptr && !current->Empty()) {
+        return current->Locate(inodeId);
     }
     return nodeId;
 }
 
+/*
+ * Failover target of a file placed on nodeId, the next node on the ring
+ */
 int StoreNode::GetNextNode(int nodeId, uint64_t inodeId)
 {
-    std::shared_lock<std::shared_mutex> lock(nodeMutex);
-    if (!nodeMap.empty()) {
-        auto it = nodeMap.find(nodeId);
-        if (it == nodeMap.end()) {
-            FALCON_LOG(LOG_WARNING) << "nodeId is not in nodeMap, rehash";
-            lock.unlock();
-            return AllocNode(inodeId);
-        }
-        it = std::next(it);
-        if (it == nodeMap.end()) {
-            it = nodeMap.begin();
-        }
-        return it->first;
+    std::shared_ptr<const HashRing> current = ring.load();
+    if (current != nullptr && !current->Empty()) {
+        return current->Successor(inodeId, nodeId);
     }
     return nodeId;
 }
@@ -296,6 +302,7 @@ void StoreNode::DeleteNode(int nodeId)
 {
     std::unique_lock<std::shared_mutex> lock(nodeMutex);
     nodeMap.erase(nodeId);
+    RebuildRing();
 }
 
 std::vector<int> StoreNode::GetAllNodeId()
@@ -5,20 +5,92 @@
 #include "disk_cache/disk_cache.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <algorithm>
 
+#include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/time.h>
 
+#include "disk_cache/packed_cache.h"
 #include "log/logging.h"
 #include "util/utils.h"
 
 std::vector<CacheItem> DiskCache::initCacheVector;
 std::mutex DiskCache::initCacheMutex;
 
+#define DISK_CACHE_INDEX_MAGIC 0x46434958U /* "FCIX" */
+#define DISK_CACHE_INDEX_VERSION 1U
+#define DISK_CACHE_INDEX_FLAG_HOT 0x1U
+#define DISK_CACHE_INDEX_IO_RECORDS 65536
+
+struct DiskCacheIndexHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dirNum;
+    uint32_t recordSize;
+    uint64_t itemNum;
+    uint64_t snapshotTime;
+};
+
+struct DiskCacheIndexRecord
+{
+    uint64_t inode;
+    uint64_t size;
+    uint32_t atime;
+    uint32_t flags;
+};
+
+static int WriteFull(int fd, const void *buf, size_t len)
+{
+    const char *pos = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, pos, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        pos += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* remove the cache file or packed record of key, return 0 or -errno */
+static int RemoveCacheFile(uint64_t key, bool packed)
+{
+    if (packed) {
+        return PackedCache::GetInstance().Remove(key);
+    }
+    return remove(GetFilePath(key).c_str()) == 0 ? 0 : -errno;
+}
+
+static ssize_t ReadFull(int fd, void *buf, size_t len)
+{
+    char *pos = static_cast<char *>(buf);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, pos + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
 DiskCache::DiskCache(float ratio) { freeRatio = ratio; }
 
 DiskCache::~DiskCache()
@@ -26,9 +98,14 @@ DiskCache::~DiskCache()
     stop = true;
     if (cleanupThread.joinable()) {
         cleanupThread.join();
+        SaveSnapshot();
+    }
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.slots.clear();
+        shard.freeSlots.clear();
     }
-    inodeToCacheIter.clear();
-    cacheItems.clear();
 }
 
 int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRatio)
@@ -64,8 +141,13 @@ int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRat
 int DiskCache::ScanCache()
 {
     std::vector<std::thread> initCacheThreads;
+    std::vector<bool> walkDirs(totalDirNum, true);
+    LoadSnapshot(walkDirs);
 
     for (int i = 0; i < totalDirNum; ++i) {
+        if (!walkDirs[i]) {
+            continue;
+        }
         std::string dirPath = std::string(rootDir) + "/" + std::to_string(i);
 
         initCacheThreads.emplace_back(Walk, dirPath);
@@ -73,17 +155,189 @@ int DiskCache::ScanCache()
     for (auto &thread : initCacheThreads) {
         thread.join();
     }
-    if (initCacheVector.empty()) {
-        return RETURN_OK;
-    }
-
     std::sort(initCacheVector.begin(), initCacheVector.end(), [](const CacheItem &first, const CacheItem &second) {
         return first.atime < second.atime;
     });
     for (CacheItem cache : initCacheVector) {
-        InsertAndUpdate(cache.inode, cache.size, false);
+        InsertFromScan(cache);
     }
     initCacheVector.clear();
+
+    /* packed records rebuilt by PackedCache, a regular file of the same inode is newer and wins */
+    if (PackedCache::GetInstance().IsStarted()) {
+        std::vector<CacheItem> packedItems;
+        PackedCache::GetInstance().ForEach([&packedItems](uint64_t inode, uint64_t size) {
+            CacheItem cache;
+            cache.inode = inode;
+            cache.size = size;
+            cache.packed = true;
+            packedItems.push_back(cache);
+        });
+        for (const CacheItem &cache : packedItems) {
+            if (Find(cache.inode, false)) {
+                PackedCache::GetInstance().Remove(cache.inode);
+                continue;
+            }
+            InsertFromScan(cache);
+        }
+    }
+    return RETURN_OK;
+}
+
+void DiskCache::InsertFromScan(const CacheItem &cache)
+{
+    CacheShard &shard = GetShard(cache.inode);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    if (Lookup(shard, lock, cache.inode) != nullptr) {
+        return;
+    }
+    CacheItem &item = InsertLocked(shard, cache.inode, cache.size);
+    item.atime = cache.atime;
+    item.referenced = cache.referenced;
+    item.packed = cache.packed;
+    item.unverified = cache.unverified;
+}
+
+/*
+ * Load the index snapshot in one sequential pass. A directory whose mtime is not older than the snapshot (minus
+ * DISK_CACHE_SNAPSHOT_SLACK) has been changed since, its records are dropped and it stays in walkDirs for a full
+ * walk. Records are inserted in file order, which rebuilds every shard's CLOCK ring in its saved order. Appending to
+ * a file leaves its directory mtime alone, so loaded sizes are only trusted until ReconcileLocked checks them.
+ */
+void DiskCache::LoadSnapshot(std::vector<bool> &walkDirs)
+{
+    std::string indexPath = rootDir + "/" + DISK_CACHE_INDEX_FILE;
+    int fd = open(indexPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        FALCON_LOG(LOG_INFO) << "DiskCache::LoadSnapshot(): no index snapshot in " << rootDir << ", walk all";
+        return;
+    }
+
+    DiskCacheIndexHeader header;
+    struct stat st;
+    if (ReadFull(fd, &header, sizeof(header)) != sizeof(header) || fstat(fd, &st) != 0 ||
+        header.magic != DISK_CACHE_INDEX_MAGIC || header.version != DISK_CACHE_INDEX_VERSION ||
+        header.dirNum != static_cast<uint32_t>(totalDirNum) || header.recordSize != sizeof(DiskCacheIndexRecord) ||
+        static_cast<uint64_t>(st.st_size) != sizeof(header) + header.itemNum * sizeof(DiskCacheIndexRecord)) {
+        FALCON_LOG(LOG_WARNING) << "DiskCache::LoadSnapshot(): index snapshot " << indexPath << " is invalid, walk all";
+        close(fd);
+        return;
+    }
+
+    int staleDirs = 0;
+    for (int i = 0; i < totalDirNum; ++i) {
+        struct stat dirSt;
+        std::string dirPath = rootDir + "/" + std::to_string(i);
+        if (stat(dirPath.c_str(), &dirSt) == 0 &&
+            static_cast<uint64_t>(dirSt.st_mtime) + DISK_CACHE_SNAPSHOT_SLACK < header.snapshotTime) {
+            walkDirs[i] = false;
+        } else {
+            staleDirs++;
+        }
+    }
+
+    uint64_t loaded = 0;
+    std::vector<DiskCacheIndexRecord> records(DISK_CACHE_INDEX_IO_RECORDS);
+    for (uint64_t left = header.itemNum; left > 0;) {
+        size_t batch = std::min<uint64_t>(left, records.size());
+        ssize_t n = ReadFull(fd, records.data(), batch * sizeof(DiskCacheIndexRecord));
+        if (n != static_cast<ssize_t>(batch * sizeof(DiskCacheIndexRecord))) {
+            FALCON_LOG(LOG_ERROR) << "DiskCache::LoadSnapshot(): read " << indexPath << " failed, walk all";
+            std::fill(walkDirs.begin(), walkDirs.end(), true);
+            close(fd);
+            return;
+        }
+        for (size_t i = 0; i < batch; ++i) {
+            const DiskCacheIndexRecord &record = records[i];
+            if (walkDirs[record.inode % totalDirNum]) {
+                continue;
+            }
+            CacheItem cache;
+            cache.inode = record.inode;
+            cache.size = record.size;
+            cache.atime = record.atime;
+            cache.referenced = (record.flags & DISK_CACHE_INDEX_FLAG_HOT) != 0;
+            cache.unverified = true;
+            InsertFromScan(cache);
+            loaded++;
+        }
+        left -= batch;
+    }
+    close(fd);
+    FALCON_LOG(LOG_INFO) << "DiskCache::LoadSnapshot(): loaded " << loaded << " items from " << indexPath << ", "
+                         << staleDirs << " directories changed since the snapshot";
+}
+
+/*
+ * Write the index to a temporary file and rename it over the previous snapshot. Shards are copied one at a time, so
+ * a snapshot never blocks more than one shard.
+ */
+int DiskCache::SaveSnapshot()
+{
+    if (rootDir.empty()) {
+        return RETURN_ERROR;
+    }
+    std::string indexPath = rootDir + "/" + DISK_CACHE_INDEX_FILE;
+    std::string tmpPath = indexPath + ".tmp";
+    uint64_t version = indexVersion.load();
+
+    DiskCacheIndexHeader header;
+    (void)memset(&header, 0, sizeof(header));
+    header.magic = DISK_CACHE_INDEX_MAGIC;
+    header.version = DISK_CACHE_INDEX_VERSION;
+    header.dirNum = static_cast<uint32_t>(totalDirNum);
+    header.recordSize = sizeof(DiskCacheIndexRecord);
+    header.snapshotTime = static_cast<uint64_t>(time(nullptr));
+
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "DiskCache::SaveSnapshot(): create " << tmpPath << " failed: " << strerror(err);
+        return -err;
+    }
+    int ret = WriteFull(fd, &header, sizeof(header));
+    std::vector<DiskCacheIndexRecord> records;
+    for (auto &shard : shards) {
+        if (ret != 0) {
+            break;
+        }
+        records.clear();
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            records.reserve(shard.index.size());
+            for (const CacheItem &item : shard.slots) {
+                /* packed records are rebuilt from their segments */
+                if (!item.valid || item.packed) {
+                    continue;
+                }
+                DiskCacheIndexRecord record;
+                record.inode = item.inode;
+                record.size = item.size;
+                record.atime = static_cast<uint32_t>(item.atime);
+                record.flags = (item.refs > 0 || item.referenced) ? DISK_CACHE_INDEX_FLAG_HOT : 0;
+                records.push_back(record);
+            }
+        }
+        header.itemNum += records.size();
+        ret = WriteFull(fd, records.data(), records.size() * sizeof(DiskCacheIndexRecord));
+    }
+    if (ret == 0 && pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        ret = -errno;
+    }
+    if (ret == 0 && fsync(fd) != 0) {
+        ret = -errno;
+    }
+    close(fd);
+    if (ret == 0 && rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+        ret = -errno;
+    }
+    if (ret != 0) {
+        FALCON_LOG(LOG_ERROR) << "DiskCache::SaveSnapshot(): write " << indexPath << " failed: " << strerror(-ret);
+        unlink(tmpPath.c_str());
+        return ret;
+    }
+    snapshotVersion = version;
+    FALCON_LOG(LOG_INFO) << "DiskCache::SaveSnapshot(): saved " << header.itemNum << " items to " << indexPath;
     return RETURN_OK;
 }
 
@@ -140,9 +394,13 @@ int DiskCache::GetCurFreeRatio()
 
 void DiskCache::CheckFreeSpace()
 {
+    int rounds = 0;
     while (!stop) {
+        if (++rounds % DISK_CACHE_SNAPSHOT_ROUNDS == 0 && indexVersion.load() != snapshotVersion) {
+            SaveSnapshot();
+        }
         {
-            std::lock_guard<std::mutex> lock(mutex);
+            std::lock_guard<std::mutex> lock(evictMutex);
             int ret = GetCurFreeRatio();
             if (ret != RETURN_OK) {
                 break;
@@ -157,9 +415,194 @@ void DiskCache::CheckFreeSpace()
     }
 }
 
+DiskCache::CacheShard &DiskCache::GetShard(uint64_t key)
+{
+    /* inode ids are mostly sequential, scramble them before taking the high bits */
+    return shards[(key * 0x9E3779B97F4A7C15ULL) >> (64 - DISK_CACHE_SHARD_BITS)];
+}
+
+/*
+ * Look up key in a locked shard. An entry that is being evicted is waited out, so callers never see a file that is
+ * about to disappear, and never recreate one that is about to be unlinked.
+ */
+CacheItem *DiskCache::Lookup(CacheShard &shard, std::unique_lock<std::mutex> &lock, uint64_t key)
+{
+    while (true) {
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return nullptr;
+        }
+        CacheItem &item = shard.slots[it->second];
+        if (!item.evicting) {
+            return &item;
+        }
+        shard.evictDone.wait(lock);
+    }
+}
+
+CacheItem &DiskCache::InsertLocked(CacheShard &shard, uint64_t key, uint64_t size)
+{
+    uint32_t slot = 0;
+    if (!shard.freeSlots.empty()) {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(shard.slots.size());
+        shard.slots.emplace_back();
+    }
+    CacheItem &item = shard.slots[slot];
+    item = CacheItem{};
+    item.inode = key;
+    item.size = size;
+    item.atime = static_cast<uint64_t>(time(nullptr));
+    item.valid = true;
+    item.referenced = true;
+    shard.index[key] = slot;
+    ++indexVersion;
+    usedCap += size;
+    freeCap -= size;
+    ++cachedInodes;
+    return item;
+}
+
+void DiskCache::EraseLocked(CacheShard &shard, uint64_t key)
+{
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return;
+    }
+    CacheItem &item = shard.slots[it->second];
+    usedCap -= item.size;
+    freeCap += item.size;
+    --cachedInodes;
+    item.valid = false;
+    item.evicting = false;
+    shard.freeSlots.push_back(it->second);
+    shard.index.erase(it);
+    ++indexVersion;
+    if (eraseHook) {
+        eraseHook(key);
+    }
+}
+
+/*
+ * Stat the file of an item loaded from the snapshot the first time it is used and correct its size and the space
+ * accounting. Returns false if the file is gone, the item is erased then.
+ */
+bool DiskCache::ReconcileLocked(CacheShard &shard, CacheItem &item)
+{
+    item.unverified = false;
+    struct stat st;
+    if (stat(GetFilePath(item.inode).c_str(), &st) != 0) {
+        if (errno == ENOENT) {
+            EraseLocked(shard, item.inode);
+            return false;
+        }
+        return true;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    if (size != item.size) {
+        usedCap += size - item.size;
+        freeCap -= size - item.size;
+        item.size = size;
+        ++indexVersion;
+    }
+    return true;
+}
+
+/*
+ * Advance the CLOCK hand of a locked shard and collect up to DISK_CACHE_EVICT_BATCH unpinned victims. Referenced
+ * entries get a second chance, so the hand sweeps at most two rounds.
+ */
+void DiskCache::PickVictims(CacheShard &shard, std::vector<CacheItem> &victims)
+{
+    size_t slotNum = shard.slots.size();
+    if (slotNum == 0) {
+        return;
+    }
+    for (size_t step = 0; step < slotNum * 2 && victims.size() < DISK_CACHE_EVICT_BATCH; ++step) {
+        if (shard.hand >= slotNum) {
+            shard.hand = 0;
+        }
+        CacheItem &item = shard.slots[shard.hand++];
+        if (!item.valid || item.evicting || item.refs > 0) {
+            continue;
+        }
+        if (item.referenced) {
+            item.referenced = false;
+            continue;
+        }
+        item.evicting = true;
+        victims.push_back(item);
+    }
+}
+
+/*
+ * Evict unpinned files shard by shard until enough space and inodes are freed. Victims are chosen under the shard
+ * lock, but the files are unlinked after releasing it.
+ */
+void DiskCache::EvictItems(uint64_t toFreeCap, uint64_t toFreeInode, const char *caller)
+{
+    uint64_t freedCap = 0;
+    uint64_t freedInode = 0;
+    std::vector<CacheItem> victims;
+    std::vector<int> errs;
+    victims.reserve(DISK_CACHE_EVICT_BATCH);
+    errs.reserve(DISK_CACHE_EVICT_BATCH);
+
+    bool progress = true;
+    while ((freedCap < toFreeCap || freedInode < toFreeInode) && progress) {
+        progress = false;
+        for (int n = 0; n < DISK_CACHE_SHARD_NUM && (freedCap < toFreeCap || freedInode < toFreeInode); ++n) {
+            CacheShard &shard = shards[evictShardCursor++ % DISK_CACHE_SHARD_NUM];
+            victims.clear();
+            errs.clear();
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                PickVictims(shard, victims);
+            }
+            if (victims.empty()) {
+                continue;
+            }
+
+            for (const CacheItem &victim : victims) {
+                std::string fileName = GetFilePath(victim.inode);
+                int ret = RemoveCacheFile(victim.inode, victim.packed);
+                errs.push_back(-ret);
+                if (ret == 0) {
+                    FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName << (victim.packed ? " (packed)" : "");
+                } else {
+                    FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName << " failed: " << strerror(-ret);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (size_t i = 0; i < victims.size(); ++i) {
+                    uint64_t key = victims[i].inode;
+                    /* a missing file only leaves a stale entry behind, drop it as well */
+                    if (errs[i] == 0 || errs[i] == ENOENT) {
+                        freedCap += shard.slots[shard.index[key]].size;
+                        freedInode++;
+                        EraseLocked(shard, key);
+                        progress = true;
+                    } else {
+                        shard.slots[shard.index[key]].evicting = false;
+                    }
+                }
+            }
+            shard.evictDone.notify_all();
+        }
+    }
+    if (freedInode > 0) {
+        FALCON_LOG(LOG_WARNING) << "DiskCache::" << caller << "(): Evicted " << freedInode << " files, all size is "
+                                << freedCap;
+    }
+}
+
 void DiskCache::CleanupForEvict(uint64_t preAllocSize)
 {
-    // lock
+    // evictMutex held
     uint64_t toFreeCap = 0;
     uint64_t toFreeInode = 0;
     float freeBlockRatio = blockRatio - (preAllocSize + reservedCap) * 1.0 / totalCap;
@@ -176,46 +619,17 @@ void DiskCache::CleanupForEvict(uint64_t preAllocSize)
         toFreeInode = (uint64_t)(totalInodes * (freeRatio - inodeRatio));
         FALCON_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evict file due to inode limit, inodes toFreeInode = "
                                 << toFreeInode;
-        if (toFreeInode > inodeToCacheIter.size()) {
-            toFreeInode = inodeToCacheIter.size();
+        if (toFreeInode > cachedInodes) {
+            toFreeInode = cachedInodes;
         }
     }
 
-    uint64_t freedCap = 0;
-    uint64_t freedInode = 0;
-
-    for (auto it = cacheItems.begin(); it != cacheItems.end();) {
-        if (it->refs > 0) {
-            ++it;
-            continue;
-        }
-        uint64_t key = it->inode;
-        uint64_t size = it->size;
-        std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
-        if (ret == 0) {
-            freedCap += size;
-            freedInode++;
-            it = cacheItems.erase(it);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
-            FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName;
-        } else {
-            ++it;
-            FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName << " failed: " << strerror(errno);
-        }
-        if (freedCap >= toFreeCap && freedInode >= toFreeInode) {
-            FALCON_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evicted " << freedInode << " files, all size is "
-                                    << freedCap;
-            break;
-        }
-    }
+    EvictItems(toFreeCap, toFreeInode, "CleanupForEvict");
 }
 
 void DiskCache::Cleanup()
 {
-    // lock
+    // evictMutex held
     uint64_t toFreeCap = 0;
     uint64_t toFreeInode = 0;
     float freeRatio = bgFreeRatio;
@@ -232,41 +646,12 @@ void DiskCache::Cleanup()
         toFreeInode = (uint64_t)(totalInodes * (freeRatio - inodeRatio));
         FALCON_LOG(LOG_WARNING) << "DiskCache::Cleanup(): Evict file due to inode limit, inodes toFreeInode = "
                                 << toFreeInode;
-        if (toFreeInode > inodeToCacheIter.size()) {
-            toFreeInode = inodeToCacheIter.size();
+        if (toFreeInode > cachedInodes) {
+            toFreeInode = cachedInodes;
         }
     }
 
-    uint64_t freedCap = 0;
-    uint64_t freedInode = 0;
-
-    for (auto it = cacheItems.begin(); it != cacheItems.end();) {
-        if (it->refs > 0) {
-            ++it;
-            continue;
-        }
-        uint64_t key = it->inode;
-        uint64_t size = it->size;
-        std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
-        if (ret == 0) {
-            freedCap += size;
-            freedInode++;
-            it = cacheItems.erase(it);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
-            FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName;
-        } else {
-            ++it;
-            FALCON_LOG(LOG_WARNING) << "Evict file: " << fileName << " failed: " << strerror(errno);
-        }
-        if (freedCap >= toFreeCap && freedInode >= toFreeInode) {
-            FALCON_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evicted " << freedInode << " files, all size is "
-                                    << freedCap;
-            break;
-        }
-    }
+    EvictItems(toFreeCap, toFreeInode, "Cleanup");
 }
 
 int DiskCache::Delete(uint64_t key)
@@ -276,34 +661,60 @@ int DiskCache::Delete(uint64_t key)
         int ret = remove(fileName.c_str());
         return ret;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        int ret = 0;
-        auto elem = inodeToCacheIter[key];
-        uint64_t size = elem->size;
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr) {
         std::string fileName = GetFilePath(key);
-        ret = remove(fileName.c_str());
+        int ret = RemoveCacheFile(key, item->packed);
         if (ret != 0) {
-            int err = errno;
-            FALCON_LOG(LOG_ERROR) << "Delete file: " << fileName << " failed: " << strerror(err);
-            return -err;
+            FALCON_LOG(LOG_ERROR) << "Delete file: " << fileName << " failed: " << strerror(-ret);
+            return ret;
         }
-        cacheItems.erase(elem);
-        inodeToCacheIter.erase(key);
-        usedCap -= size;
-        freeCap += size;
+        EraseLocked(shard, key);
         FALCON_LOG(LOG_INFO) << "Delete file: " << fileName;
     }
     return 0;
 }
 
+/*
+ * Items are copied out one shard at a time and func runs without any shard lock, so it may call back into the cache
+ */
+void DiskCache::ForEach(const std::function<void(uint64_t inode, uint64_t size)> &func)
+{
+    std::vector<std::pair<uint64_t, uint64_t>> items;
+    for (CacheShard &shard : shards) {
+        items.clear();
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            items.reserve(shard.index.size());
+            for (const auto &[key, slot] : shard.index) {
+                const CacheItem &item = shard.slots[slot];
+                if (!item.packed && !item.evicting) {
+                    items.emplace_back(key, item.size);
+                }
+            }
+        }
+        for (const auto &[inode, size] : items) {
+            func(inode, size);
+        }
+    }
+}
+
 void DiskCache::Pin(uint64_t key)
 {
     if (stop) {
         return;
     }
-    inodeToCacheIter[key]->refs += 1;
-    inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr && (!item->unverified || ReconcileLocked(shard, *item))) {
+        item->refs += 1;
+        item->referenced = true;
+        item->atime = static_cast<uint64_t>(time(nullptr));
+        ++indexVersion;
+    }
 }
 
 void DiskCache::Unpin(uint64_t key)
@@ -311,9 +722,11 @@ void DiskCache::Unpin(uint64_t key)
     if (stop) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end() && inodeToCacheIter[key]->refs > 0) {
-        inodeToCacheIter[key]->refs -= 1;
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr && item->refs > 0) {
+        item->refs -= 1;
     }
 }
 
@@ -323,66 +736,62 @@ bool DiskCache::Find(uint64_t key, bool needPin)
         std::string fileName = GetFilePath(key);
         return access(fileName.c_str(), F_OK) == 0;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        if (needPin) {
-            Pin(key);
-        }
-        return true;
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item == nullptr || (item->unverified && !ReconcileLocked(shard, *item))) {
+        return false;
     }
-    return false;
+    item->referenced = true;
+    if (needPin) {
+        item->refs += 1;
+        item->atime = static_cast<uint64_t>(time(nullptr));
+        ++indexVersion;
+    }
+    return true;
 }
 
 void DiskCache::DeleteOldCacheWithNoPin(uint64_t key)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        if (inodeToCacheIter[key]->refs <= 0) {
-            int ret = 0;
-            auto elem = inodeToCacheIter[key];
-            uint64_t size = elem->size;
-            std::string fileName = GetFilePath(key);
-            ret = remove(fileName.c_str());
-            if (ret != 0) {
-                int err = errno;
-                FALCON_LOG(LOG_ERROR) << "DeleteOldCacheWithNoPin file: " << fileName << " failed: " << strerror(err);
-                return;
-            }
-            cacheItems.erase(elem);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr && item->refs <= 0) {
+        std::string fileName = GetFilePath(key);
+        int ret = RemoveCacheFile(key, item->packed);
+        if (ret != 0) {
+            FALCON_LOG(LOG_ERROR) << "DeleteOldCacheWithNoPin file: " << fileName << " failed: " << strerror(-ret);
+            return;
         }
+        EraseLocked(shard, key);
     }
 }
 
-void DiskCache::InsertAndUpdate(uint64_t key, uint64_t size, bool needPin)
+void DiskCache::InsertAndUpdate(uint64_t key, uint64_t size, bool needPin, bool packed)
 {
     if (stop) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr) {
         // update
-        usedCap += static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        freeCap -= static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size = size;
-        //
+        usedCap += static_cast<int64_t>(size - item->size);
+        freeCap -= static_cast<int64_t>(size - item->size);
+        item->atime = static_cast<uint64_t>(time(nullptr));
+        item->size = size;
+        item->referenced = true;
+        item->packed = packed;
+        item->unverified = false;
+        ++indexVersion;
     } else {
         // insert
-        CacheItem elem;
-        elem.atime = static_cast<uint64_t>(time(nullptr));
-        elem.size = size;
-        elem.inode = key;
-        cacheItems.emplace_back(elem);
-        inodeToCacheIter[key] = prev(cacheItems.end());
-        usedCap += size;
-        freeCap -= size;
+        CacheItem &elem = InsertLocked(shard, key, size);
+        elem.packed = packed;
         if (needPin) {
-            Pin(key);
+            elem.refs += 1;
         }
-        //
     }
 }
 
@@ -391,17 +800,20 @@ bool DiskCache::Update(uint64_t key, uint64_t size)
     if (stop) {
         return true;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr) {
         // update
-        if (size <= inodeToCacheIter[key]->size) {
+        if (size <= item->size) {
             return true;
         }
-        usedCap += static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        freeCap -= static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size = size;
-        // FALCON_LOG(LOG_INFO) << "Add Cache, inode =  " << key << ", size = " << size << ", usedCap = " << usedCap;
+        usedCap += static_cast<int64_t>(size - item->size);
+        freeCap -= static_cast<int64_t>(size - item->size);
+        item->atime = static_cast<uint64_t>(time(nullptr));
+        item->size = size;
+        item->referenced = true;
+        ++indexVersion;
     } else {
         FALCON_LOG(LOG_ERROR) << "In DiskCache::Add(), inode " << key << " not found";
         return false;
@@ -414,14 +826,17 @@ bool DiskCache::Add(uint64_t key, uint64_t size)
     if (stop) {
         return true;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
+    CacheShard &shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    CacheItem *item = Lookup(shard, lock, key);
+    if (item != nullptr) {
         // update
         usedCap += static_cast<int64_t>(size);
         freeCap -= static_cast<int64_t>(size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size += size;
-        // FALCON_LOG(LOG_INFO) << "Add Cache, inode =  " << key << ", size = " << size << ", usedCap = " << usedCap;
+        item->atime = static_cast<uint64_t>(time(nullptr));
+        item->size += size;
+        item->referenced = true;
+        ++indexVersion;
     } else {
         FALCON_LOG(LOG_ERROR) << "In DiskCache::Add(), inode " << key << " not found";
         return false;
@@ -431,7 +846,7 @@ bool DiskCache::Add(uint64_t key, uint64_t size)
 
 void DiskCache::Evict(uint64_t size)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::mutex> lock(evictMutex);
     GetCurFreeRatio();
     CleanupForEvict(size);
 }
@@ -479,7 +894,7 @@ bool DiskCache::HasFreeSpace() { return hasFreeSpace.load(); }
 int DiskCache::CheckSpaceEnough()
 {
     float blockRatio = (freeCap + usedCap) * 1.0 / totalCap;
-    float inodeRatio = (freeInodes + inodeToCacheIter.size()) * 1.0 / totalInodes;
+    float inodeRatio = (freeInodes + cachedInodes) * 1.0 / totalInodes;
     if (blockRatio <= bgFreeRatio || inodeRatio <= bgFreeRatio || blockRatio <= freeRatio || inodeRatio < freeRatio) {
         FALCON_LOG(LOG_ERROR) << "The free space can not support FalconFS running";
         FALCON_LOG(LOG_ERROR) << "Free space is not enough";
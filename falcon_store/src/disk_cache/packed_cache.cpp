@@ -0,0 +1,548 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "disk_cache/packed_cache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "io_engine/io_engine.h"
+#include "log/logging.h"
+
+#define PACKED_RECORD_MAGIC 0x46435052U /* "FCPR" */
+#define PACKED_RECORD_DELETED 0x1U
+#define PACKED_SEGMENT_PREFIX "seg-"
+#define PACKED_EXTRACT_PREFIX "extract-"
+
+struct PackedRecordHeader
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t inode;
+    uint64_t len;
+};
+
+static uint64_t RecordSize(uint64_t len) { return sizeof(PackedRecordHeader) + len; }
+
+static bool ValidRecord(const PackedRecordHeader &header, uint64_t offset, uint64_t fileSize)
+{
+    return header.magic == PACKED_RECORD_MAGIC && (header.flags & ~PACKED_RECORD_DELETED) == 0 &&
+           header.len <= fileSize && offset + RecordSize(header.len) <= fileSize;
+}
+
+/* offset of the first valid record header at or after from, fileSize if there is none */
+static uint64_t FindNextRecord(int fd, uint64_t from, uint64_t fileSize)
+{
+    const uint32_t magic = PACKED_RECORD_MAGIC;
+    std::vector<char> chunk(64 * 1024);
+    for (uint64_t base = from; base + sizeof(PackedRecordHeader) <= fileSize;) {
+        ssize_t ret = pread(fd, chunk.data(), std::min<uint64_t>(chunk.size(), fileSize - base), base);
+        if (ret < static_cast<ssize_t>(sizeof(magic))) {
+            break;
+        }
+        for (size_t i = 0; i + sizeof(magic) <= static_cast<size_t>(ret); ++i) {
+            if (memcmp(chunk.data() + i, &magic, sizeof(magic)) != 0) {
+                continue;
+            }
+            PackedRecordHeader header;
+            if (pread(fd, &header, sizeof(header), base + i) == sizeof(header) &&
+                ValidRecord(header, base + i, fileSize)) {
+                return base + i;
+            }
+        }
+        /* a magic split over two chunks is found by the next one */
+        base += static_cast<uint64_t>(ret) - (sizeof(magic) - 1);
+    }
+    return fileSize;
+}
+
+PackedCache::Segment::~Segment()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+PackedCache::~PackedCache() { Stop(); }
+
+int PackedCache::Start(const std::string &cacheRoot, uint64_t segSize)
+{
+    packedDir = cacheRoot + "/" + PACKED_CACHE_DIR;
+    segmentSize = segSize;
+    if (mkdir(packedDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache::Start(): create " << packedDir << " failed: " << strerror(err);
+        return -err;
+    }
+
+    DIR *dir = opendir(packedDir.c_str());
+    if (dir == nullptr) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache::Start(): open " << packedDir << " failed: " << strerror(err);
+        return -err;
+    }
+    std::vector<uint32_t> ids;
+    for (const struct dirent *f = readdir(dir); f; f = readdir(dir)) {
+        if (strncmp(f->d_name, PACKED_SEGMENT_PREFIX, strlen(PACKED_SEGMENT_PREFIX)) == 0) {
+            ids.push_back(static_cast<uint32_t>(atoll(f->d_name + strlen(PACKED_SEGMENT_PREFIX))));
+        } else if (strncmp(f->d_name, PACKED_EXTRACT_PREFIX, strlen(PACKED_EXTRACT_PREFIX)) == 0) {
+            /* left behind by an Extract interrupted before its rename */
+            unlink((packedDir + "/" + f->d_name).c_str());
+        }
+    }
+    closedir(dir);
+
+    /* later segments hold the newer copy of a record moved by compaction */
+    std::sort(ids.begin(), ids.end());
+    for (uint32_t id : ids) {
+        auto segment = std::make_shared<Segment>();
+        segment->id = id;
+        segment->path = packedDir + "/" + PACKED_SEGMENT_PREFIX + std::to_string(id);
+        segment->fd = open(segment->path.c_str(), O_RDWR);
+        if (segment->fd < 0) {
+            FALCON_LOG(LOG_ERROR) << "PackedCache::Start(): open " << segment->path << " failed: " << strerror(errno);
+            continue;
+        }
+        segments[id] = segment;
+        ScanSegment(segment);
+        nextSegmentId = id + 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(compactMutex);
+        stopCompact = false;
+    }
+    started = true;
+    compactThread = std::thread(&PackedCache::CompactWorker, this);
+    FALCON_LOG(LOG_INFO) << "PackedCache::Start(): loaded " << index.size() << " packed files from " << ids.size()
+                         << " segments";
+    return 0;
+}
+
+void PackedCache::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(compactMutex);
+        stopCompact = true;
+    }
+    compactCv.notify_all();
+    if (compactThread.joinable()) {
+        compactThread.join();
+    }
+    started = false;
+    std::lock_guard<std::mutex> appendLock(appendMutex);
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    activeSegment = nullptr;
+    index.clear();
+    segments.clear();
+}
+
+bool PackedCache::IsStarted() { return started.load(); }
+
+/*
+ * Rebuild the index entries of one segment. Appends are written in parallel, so a crash or a failed write can leave
+ * a hole of zeros or a torn record anywhere in the segment. The scan skips forward to the next valid record header
+ * instead of stopping there, the bytes skipped are dead and reclaimed by compaction.
+ */
+int PackedCache::ScanSegment(const std::shared_ptr<Segment> &segment)
+{
+    struct stat st;
+    if (fstat(segment->fd, &st) != 0) {
+        return -errno;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+    uint64_t offset = 0;
+    while (offset + sizeof(PackedRecordHeader) <= fileSize) {
+        PackedRecordHeader header;
+        if (pread(segment->fd, &header, sizeof(header), offset) != sizeof(header) ||
+            !ValidRecord(header, offset, fileSize)) {
+            uint64_t next = FindNextRecord(segment->fd, offset + 1, fileSize);
+            FALCON_LOG(LOG_WARNING) << "PackedCache::ScanSegment(): " << segment->path << " skips bad bytes from "
+                                    << offset << " to " << next;
+            offset = next;
+            continue;
+        }
+        if ((header.flags & PACKED_RECORD_DELETED) == 0) {
+            auto it = index.find(header.inode);
+            if (it != index.end()) {
+                std::shared_ptr<Segment> oldSegment = FindSegment(it->second.segment);
+                if (oldSegment != nullptr) {
+                    oldSegment->liveBytes -= RecordSize(it->second.len);
+                    MarkDeleted(oldSegment, it->second.offset);
+                }
+            }
+            index[header.inode] = Extent{segment->id, static_cast<uint32_t>(header.len), offset};
+            segment->liveBytes += RecordSize(header.len);
+        }
+        offset += RecordSize(header.len);
+    }
+    segment->tail = fileSize;
+    return 0;
+}
+
+/* called with appendMutex held, seals the current active segment */
+int PackedCache::OpenActiveSegment()
+{
+    auto segment = std::make_shared<Segment>();
+    segment->id = nextSegmentId++;
+    segment->path = packedDir + "/" + PACKED_SEGMENT_PREFIX + std::to_string(segment->id);
+    segment->fd = open(segment->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (segment->fd < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache: create segment " << segment->path << " failed: " << strerror(err);
+        return -err;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+        segments[segment->id] = segment;
+    }
+    activeSegment = segment;
+    return 0;
+}
+
+/*
+ * Reserve space in the active segment under appendMutex, write header and data outside it. A range whose write
+ * failed is never handed out again: it is cut off if it still is the last one of the segment, otherwise the
+ * segment is sealed.
+ */
+int PackedCache::Append(uint64_t inode, const char *buf, size_t size, Extent &extent, std::shared_ptr<Segment> &segment)
+{
+    uint64_t offset = 0;
+    uint64_t recordSize = RecordSize(size);
+    {
+        std::lock_guard<std::mutex> lock(appendMutex);
+        if (activeSegment == nullptr || (activeSegment->tail > 0 && activeSegment->tail + recordSize > segmentSize)) {
+            int ret = OpenActiveSegment();
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        segment = activeSegment;
+        offset = segment->tail;
+        segment->tail += recordSize;
+        segment->pendingAppends++;
+    }
+
+    PackedRecordHeader header{PACKED_RECORD_MAGIC, 0, inode, size};
+    struct iovec iov[2] = {{&header, sizeof(header)}, {const_cast<char *>(buf), size}};
+    ssize_t ret = pwritev(segment->fd, iov, 2, offset);
+    if (ret != static_cast<ssize_t>(recordSize)) {
+        int err = ret < 0 ? errno : EIO;
+        FALCON_LOG(LOG_ERROR) << "PackedCache: append inode " << inode << " to " << segment->path
+                              << " failed: " << strerror(err);
+        /* keep the reserved range parseable so a restart can skip it */
+        header.flags = PACKED_RECORD_DELETED;
+        (void)pwrite(segment->fd, &header, sizeof(header), offset);
+        {
+            std::lock_guard<std::mutex> lock(appendMutex);
+            if (segment == activeSegment) {
+                if (segment->tail == offset + recordSize && ftruncate(segment->fd, offset) == 0) {
+                    segment->tail = offset;
+                } else {
+                    activeSegment = nullptr;
+                }
+            }
+        }
+        segment->pendingAppends--;
+        return -err;
+    }
+    segment->liveBytes += recordSize;
+    extent = Extent{segment->id, static_cast<uint32_t>(size), offset};
+    return 0;
+}
+
+int PackedCache::MarkDeleted(const std::shared_ptr<Segment> &segment, uint64_t offset)
+{
+    uint32_t flags = PACKED_RECORD_DELETED;
+    if (pwrite(segment->fd, &flags, sizeof(flags), offset + offsetof(PackedRecordHeader, flags)) != sizeof(flags)) {
+        int err = errno;
+        FALCON_LOG(LOG_WARNING) << "PackedCache: mark record deleted in " << segment->path << " failed: "
+                                << strerror(err);
+        return -err;
+    }
+    return 0;
+}
+
+std::shared_ptr<PackedCache::Segment> PackedCache::FindSegment(uint32_t id)
+{
+    auto it = segments.find(id);
+    if (it == segments.end()) {
+        FALCON_LOG(LOG_ERROR) << "PackedCache: segment " << id << " referenced by the index is missing";
+        return nullptr;
+    }
+    return it->second;
+}
+
+int PackedCache::Put(uint64_t inode, const char *buf, size_t size)
+{
+    if (!started) {
+        return -ENOTSUP;
+    }
+    Extent extent;
+    std::shared_ptr<Segment> segment;
+    int ret = Append(inode, buf, size, extent, segment);
+    if (ret != 0) {
+        return ret;
+    }
+
+    Extent oldExtent;
+    std::shared_ptr<Segment> oldSegment;
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+        auto it = index.find(inode);
+        if (it != index.end()) {
+            oldExtent = it->second;
+            oldSegment = FindSegment(oldExtent.segment);
+        }
+        index[inode] = extent;
+    }
+    segment->pendingAppends--;
+    if (oldSegment != nullptr) {
+        oldSegment->liveBytes -= RecordSize(oldExtent.len);
+        MarkDeleted(oldSegment, oldExtent.offset);
+    }
+    return 0;
+}
+
+ssize_t PackedCache::Read(uint64_t inode, char *buf, size_t size, off_t offset)
+{
+    Extent extent;
+    std::shared_ptr<Segment> segment;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        auto it = index.find(inode);
+        if (it == index.end()) {
+            return -ENOENT;
+        }
+        extent = it->second;
+        segment = FindSegment(extent.segment);
+    }
+    if (segment == nullptr) {
+        return -EIO;
+    }
+    if (offset >= static_cast<off_t>(extent.len)) {
+        return 0;
+    }
+    size_t readSize = std::min<size_t>(size, extent.len - offset);
+    ssize_t ret = pread(segment->fd, buf, readSize, extent.offset + sizeof(PackedRecordHeader) + offset);
+    if (ret < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache: read inode " << inode << " from " << segment->path
+                              << " failed: " << strerror(err);
+        return -err;
+    }
+    return ret;
+}
+
+bool PackedCache::Contains(uint64_t inode)
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    return index.find(inode) != index.end();
+}
+
+int PackedCache::Remove(uint64_t inode)
+{
+    Extent extent;
+    std::shared_ptr<Segment> segment;
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+        auto it = index.find(inode);
+        if (it == index.end()) {
+            return -ENOENT;
+        }
+        extent = it->second;
+        segment = FindSegment(extent.segment);
+        index.erase(it);
+    }
+    if (segment == nullptr) {
+        return -EIO;
+    }
+    segment->liveBytes -= RecordSize(extent.len);
+    return MarkDeleted(segment, extent.offset);
+}
+
+/*
+ * Copy a packed file out to a regular cache file, e.g. before it is opened for write. The data goes to a private
+ * temporary file under packedDir renamed over filePath, so a reader never sees a partially written file.
+ */
+int PackedCache::Extract(uint64_t inode, const std::string &filePath)
+{
+    uint64_t len = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        auto it = index.find(inode);
+        if (it == index.end()) {
+            return -ENOENT;
+        }
+        len = it->second.len;
+    }
+    std::vector<char> data(len);
+    ssize_t readSize = Read(inode, data.data(), len, 0);
+    if (readSize != static_cast<ssize_t>(len)) {
+        return readSize < 0 ? readSize : -EIO;
+    }
+
+    std::string tmpPath =
+        packedDir + "/" + PACKED_EXTRACT_PREFIX + std::to_string(inode) + "." + std::to_string(gettid());
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (fd < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache::Extract(): create " << tmpPath << " failed: " << strerror(err);
+        return -err;
+    }
+    ssize_t ret = len > 0 ? pwrite(fd, data.data(), len, 0) : 0;
+    int err = errno;
+    close(fd);
+    if (ret != static_cast<ssize_t>(len)) {
+        FALCON_LOG(LOG_ERROR) << "PackedCache::Extract(): write " << tmpPath << " failed: " << strerror(err);
+        unlink(tmpPath.c_str());
+        return ret < 0 ? -err : -EIO;
+    }
+    if (rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+        err = errno;
+        FALCON_LOG(LOG_ERROR) << "PackedCache::Extract(): rename " << tmpPath << " failed: " << strerror(err);
+        unlink(tmpPath.c_str());
+        return -err;
+    }
+    return 0;
+}
+
+void PackedCache::ForEach(const std::function<void(uint64_t inode, uint64_t size)> &func)
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    for (const auto &[inode, extent] : index) {
+        func(inode, extent.len);
+    }
+}
+
+size_t PackedCache::SegmentNum()
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    return segments.size();
+}
+
+/*
+ * Rewrite every sealed segment whose live bytes are below liveRatio of its size. Live records are appended to the
+ * active segment and switched in the index only if nobody replaced or removed them meanwhile, then the old segment
+ * is unlinked. Readers still holding the old segment keep its fd until they finish. A segment sealed while some of
+ * its appends are not indexed yet is left for a later round, its index snapshot would miss them.
+ */
+int PackedCache::Compact(double liveRatio)
+{
+    if (!started) {
+        return 0;
+    }
+    uint32_t activeId = UINT32_MAX;
+    {
+        std::lock_guard<std::mutex> lock(appendMutex);
+        if (activeSegment != nullptr) {
+            activeId = activeSegment->id;
+        }
+    }
+    std::vector<std::shared_ptr<Segment>> sparse;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        for (const auto &[id, segment] : segments) {
+            if (id != activeId && segment->pendingAppends == 0 && segment->liveBytes < liveRatio * segment->tail) {
+                sparse.push_back(segment);
+            }
+        }
+    }
+
+    int compacted = 0;
+    for (const auto &segment : sparse) {
+        std::vector<std::pair<uint64_t, Extent>> live;
+        {
+            std::shared_lock<std::shared_mutex> lock(indexMutex);
+            for (const auto &[inode, extent] : index) {
+                if (extent.segment == segment->id) {
+                    live.emplace_back(inode, extent);
+                }
+            }
+        }
+
+        bool failed = false;
+        std::vector<std::vector<char>> data(PACKED_COMPACT_BATCH);
+        std::vector<IoRequest> reqs(PACKED_COMPACT_BATCH);
+        for (size_t i = 0; i < live.size() && !failed; ++i) {
+            size_t slot = i % PACKED_COMPACT_BATCH;
+            if (slot == 0) {
+                /* read the live records of the next batch together */
+                size_t num = std::min<size_t>(PACKED_COMPACT_BATCH, live.size() - i);
+                for (size_t j = 0; j < num; ++j) {
+                    const Extent &extent = live[i + j].second;
+                    data[j].resize(extent.len);
+                    reqs[j] = {.opcode = IoOpcode::READ, .fd = segment->fd, .buf = data[j].data(), .len = extent.len,
+                               .offset = static_cast<off_t>(extent.offset + sizeof(PackedRecordHeader))};
+                }
+                if (IoEngine::GetInstance().Submit(reqs.data(), num) != 0) {
+                    failed = true;
+                    break;
+                }
+            }
+            const auto &[inode, oldExtent] = live[i];
+            Extent newExtent;
+            std::shared_ptr<Segment> newSegment;
+            if (reqs[slot].result != static_cast<ssize_t>(oldExtent.len) ||
+                Append(inode, data[slot].data(), oldExtent.len, newExtent, newSegment) != 0) {
+                failed = true;
+                break;
+            }
+            bool moved = false;
+            {
+                std::unique_lock<std::shared_mutex> lock(indexMutex);
+                auto it = index.find(inode);
+                if (it != index.end() && it->second.segment == oldExtent.segment &&
+                    it->second.offset == oldExtent.offset) {
+                    it->second = newExtent;
+                    moved = true;
+                }
+            }
+            newSegment->pendingAppends--;
+            if (moved) {
+                /* a crash before unlink must not leave two live copies */
+                MarkDeleted(segment, oldExtent.offset);
+            } else {
+                newSegment->liveBytes -= RecordSize(newExtent.len);
+                MarkDeleted(newSegment, newExtent.offset);
+            }
+        }
+        if (failed) {
+            FALCON_LOG(LOG_WARNING) << "PackedCache::Compact(): compact " << segment->path << " failed, keep it";
+            continue;
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(indexMutex);
+            segments.erase(segment->id);
+        }
+        unlink(segment->path.c_str());
+        compacted++;
+        FALCON_LOG(LOG_INFO) << "PackedCache::Compact(): compacted " << segment->path << ", moved " << live.size()
+                             << " files";
+    }
+    return compacted;
+}
+
+void PackedCache::CompactWorker()
+{
+    std::unique_lock<std::mutex> lock(compactMutex);
+    while (!stopCompact) {
+        compactCv.wait_for(lock, std::chrono::seconds(PACKED_COMPACT_INTERVAL));
+        if (stopCompact) {
+            break;
+        }
+        lock.unlock();
+        Compact();
+        lock.lock();
+    }
+}
@@ -0,0 +1,396 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "falcon_store/cache_migrator.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "connection/node.h"
+#include "disk_cache/disk_cache.h"
+#include "log/logging.h"
+#include "stats/falcon_stats.h"
+#include "util/utils.h"
+
+CacheMigrator::~CacheMigrator() { Stop(); }
+
+int CacheMigrator::Start(const std::string &cacheRoot, uint64_t bandwidth)
+{
+    tmpDir = cacheRoot + "/" + MIGRATE_TMP_DIR;
+    if (mkdir(tmpDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator::Start(): create " << tmpDir << " failed: " << strerror(err);
+        return -err;
+    }
+    /* files staged before a restart are incomplete, their senders start over */
+    DIR *dir = opendir(tmpDir.c_str());
+    if (dir == nullptr) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator::Start(): open " << tmpDir << " failed: " << strerror(err);
+        return -err;
+    }
+    for (const struct dirent *f = readdir(dir); f; f = readdir(dir)) {
+        if (strcmp(f->d_name, ".") != 0 && strcmp(f->d_name, "..") != 0) {
+            unlink((tmpDir + "/" + f->d_name).c_str());
+        }
+    }
+    closedir(dir);
+    /* a copy leaving the cache is no longer the handed over one */
+    DiskCache::GetInstance().SetEraseHook([this](uint64_t inodeId) {
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        migratedIn.erase(inodeId);
+    });
+
+    bytesPerSecond = bandwidth;
+    if (bytesPerSecond == 0) {
+        return 0;
+    }
+    stopWorker = false;
+    workerThread = std::thread(&CacheMigrator::Worker, this);
+    return 0;
+}
+
+void CacheMigrator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopWorker = true;
+    }
+    workerCv.notify_all();
+    if (workerThread.joinable()) {
+        workerThread.join();
+    }
+}
+
+/*
+ * Drop an unfinished incoming file, its staging file and its space reservation
+ */
+void CacheMigrator::EndTransfer(uint64_t inodeId)
+{
+    uint64_t reserved = 0;
+    {
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        auto it = receiving.find(inodeId);
+        if (it == receiving.end()) {
+            return;
+        }
+        reserved = it->second.size;
+        receiving.erase(it);
+    }
+    unlink((tmpDir + "/" + std::to_string(inodeId)).c_str());
+    DiskCache::GetInstance().FreePreAllocSpace(reserved);
+}
+
+/*
+ * Drop the incoming files whose sender went quiet, e.g. it failed or was stopped in the middle of a file
+ */
+void CacheMigrator::ExpireTransfers()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<uint64_t> expired;
+    {
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        for (const auto &[inodeId, transfer] : receiving) {
+            if (now - transfer.lastChunk >= std::chrono::seconds(MIGRATE_RECEIVE_TIMEOUT)) {
+                expired.push_back(inodeId);
+            }
+        }
+    }
+    for (uint64_t inodeId : expired) {
+        FALCON_LOG(LOG_WARNING) << "CacheMigrator: incoming inode " << inodeId << " timed out, drop it";
+        EndTransfer(inodeId);
+    }
+}
+
+/*
+ * Called by the MigrateFile rpc. Chunks of one file arrive in order, the first one reserves the space and truncates
+ * the staging file, a chunk at another offset than the end of the previous one aborts the file, and the last one
+ * moves it into the cache. -EEXIST tells the sender a copy is cached here already.
+ */
+int CacheMigrator::Receive(uint64_t inodeId, uint64_t size, off_t offset, butil::IOBuf &data)
+{
+    if (tmpDir.empty()) {
+        return -EAGAIN;
+    }
+    if (offset < 0 || (uint64_t)offset + data.size() > size) {
+        return -EINVAL;
+    }
+    std::string tmpName = tmpDir + "/" + std::to_string(inodeId);
+    int flags = O_WRONLY;
+    if (offset == 0) {
+        ExpireTransfers();
+        /* a sender starting over drops what it sent before */
+        EndTransfer(inodeId);
+        if (DiskCache::GetInstance().Find(inodeId, false)) {
+            return -EEXIST;
+        }
+        if (!DiskCache::GetInstance().PreAllocSpace(size)) {
+            return -ENOSPC;
+        }
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        receiving[inodeId] = {size, 0, std::chrono::steady_clock::now()};
+        flags |= O_CREAT | O_TRUNC;
+    } else {
+        bool expected = false;
+        {
+            std::lock_guard<std::mutex> lock(migratedMutex);
+            auto it = receiving.find(inodeId);
+            expected = it != receiving.end() && it->second.size == size && it->second.next == offset;
+        }
+        if (!expected) {
+            FALCON_LOG(LOG_ERROR) << "CacheMigrator::Receive(): unexpected chunk of inode " << inodeId
+                                  << " at offset " << offset << ", drop the file";
+            EndTransfer(inodeId);
+            return -EINVAL;
+        }
+    }
+    int fd = open(tmpName.c_str(), flags, 0755);
+    if (fd < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator::Receive(): open " << tmpName << " failed: " << strerror(err);
+        EndTransfer(inodeId);
+        return -err;
+    }
+    while (!data.empty()) {
+        ssize_t n = data.pcut_into_file_descriptor(fd, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            int err = errno;
+            FALCON_LOG(LOG_ERROR) << "CacheMigrator::Receive(): write " << tmpName << " failed: " << strerror(err);
+            close(fd);
+            EndTransfer(inodeId);
+            return -err;
+        }
+        offset += n;
+    }
+    close(fd);
+    if ((uint64_t)offset < size) {
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        auto it = receiving.find(inodeId);
+        if (it != receiving.end()) {
+            it->second.next = offset;
+            it->second.lastChunk = std::chrono::steady_clock::now();
+        }
+        return 0;
+    }
+
+    /* a client may have created the file here meanwhile, its copy wins */
+    if (DiskCache::GetInstance().Find(inodeId, false)) {
+        EndTransfer(inodeId);
+        return -EEXIST;
+    }
+    std::string fileName = GetFilePath(inodeId);
+    if (rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator::Receive(): rename " << tmpName << " to " << fileName
+                              << " failed: " << strerror(err);
+        EndTransfer(inodeId);
+        return -err;
+    }
+    DiskCache::GetInstance().InsertAndUpdate(inodeId, size, false);
+    {
+        std::lock_guard<std::mutex> lock(migratedMutex);
+        receiving.erase(inodeId);
+        migratedIn[inodeId] = size;
+    }
+    DiskCache::GetInstance().FreePreAllocSpace(size);
+    return 0;
+}
+
+/*
+ * Asked once by a nodeFail open, the entry is consumed by it
+ */
+bool CacheMigrator::IsMigratedIn(uint64_t inodeId, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(migratedMutex);
+    auto it = migratedIn.find(inodeId);
+    if (it == migratedIn.end()) {
+        return false;
+    }
+    bool match = it->second == size;
+    migratedIn.erase(it);
+    return match;
+}
+
+/*
+ * Sleep until the bytes sent in the current one second window fit in the bandwidth
+ */
+void CacheMigrator::Throttle(size_t bytes)
+{
+    if (bytesPerSecond == 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - windowStart >= std::chrono::seconds(1)) {
+        windowStart = now;
+        windowBytes = 0;
+    }
+    windowBytes += bytes;
+    auto allowed = std::chrono::microseconds(windowBytes * 1000000 / bytesPerSecond);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - windowStart);
+    if (allowed > elapsed) {
+        std::this_thread::sleep_for(allowed - elapsed);
+    }
+}
+
+int CacheMigrator::MigrateOne(uint64_t inodeId, int owner)
+{
+    std::shared_ptr<FalconIOClient> falconIOClient = StoreNode::GetInstance()->GetRpcConnection(owner);
+    if (falconIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    /* pinned while sent, eviction skips it and readers keep using it */
+    if (!DiskCache::GetInstance().Find(inodeId, true)) {
+        return 0;
+    }
+    std::string fileName = GetFilePath(inodeId);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        int err = errno;
+        DiskCache::GetInstance().Unpin(inodeId);
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator::MigrateOne(): open " << fileName << " failed: " << strerror(err);
+        return -err;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        DiskCache::GetInstance().Unpin(inodeId);
+        return -err;
+    }
+    uint64_t size = st.st_size;
+    off_t offset = 0;
+    int ret = 0;
+    do {
+        size_t len = std::min<uint64_t>(MIGRATE_CHUNK_SIZE, size - offset);
+        butil::IOPortal portal;
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = portal.pappend_from_file_descriptor(fd, offset + done, len - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            done += n;
+        }
+        if (done < len) {
+            ret = -EIO;
+            break;
+        }
+        Throttle(len);
+        butil::IOBuf data;
+        data.append(portal);
+        ret = falconIOClient->MigrateFile(inodeId, size, offset, data);
+        if (ret != 0) {
+            break;
+        }
+        FalconStats::GetInstance().stats[MIGRATE_BYTES] += len;
+        offset += len;
+    } while ((uint64_t)offset < size);
+    close(fd);
+    DiskCache::GetInstance().Unpin(inodeId);
+
+    /* the owner caches it already, nothing to send */
+    if (ret == -EEXIST) {
+        ret = 0;
+    }
+    if (ret != 0) {
+        FALCON_LOG(LOG_WARNING) << "CacheMigrator::MigrateOne(): inode " << inodeId << " to node " << owner
+                                << " failed: " << strerror(-ret);
+        return ret;
+    }
+    FalconStats::GetInstance().stats[MIGRATE_FILES]++;
+    return 0;
+}
+
+size_t CacheMigrator::MigrateRound()
+{
+    StoreNode *storeNode = StoreNode::GetInstance();
+    int localNodeId = storeNode->GetNodeId();
+    std::vector<int> nodeIds = storeNode->GetAllNodeId();
+    if (nodeIds.empty()) {
+        return 0;
+    }
+    bool leaving = std::find(nodeIds.begin(), nodeIds.end(), localNodeId) == nodeIds.end();
+
+    std::vector<std::pair<uint64_t, int>> toMove;
+    DiskCache::GetInstance().ForEach([&](uint64_t inode, uint64_t /*size*/) {
+        int owner = storeNode->AllocNode(inode);
+        if (owner != localNodeId) {
+            toMove.emplace_back(inode, owner);
+        }
+    });
+
+    size_t moved = 0;
+    size_t left = 0;
+    std::unordered_map<uint64_t, int> kept;
+    for (const auto &[inode, owner] : toMove) {
+        if (stopWorker) {
+            left += toMove.size() - moved - left;
+            break;
+        }
+        auto it = migratedOut.find(inode);
+        if (it == migratedOut.end() || it->second != owner) {
+            if (MigrateOne(inode, owner) != 0) {
+                FalconStats::GetInstance().stats[MIGRATE_FAILED]++;
+                left++;
+                continue;
+            }
+        }
+        if (leaving) {
+            /* a copy still pinned by readers is dropped by the next round */
+            DiskCache::GetInstance().DeleteOldCacheWithNoPin(inode);
+            if (DiskCache::GetInstance().Find(inode, false)) {
+                kept[inode] = owner;
+                left++;
+                continue;
+            }
+        } else {
+            kept[inode] = owner;
+        }
+        moved++;
+    }
+    migratedOut.swap(kept);
+    if (!toMove.empty()) {
+        FALCON_LOG(LOG_INFO) << "CacheMigrator::MigrateRound(): handed over " << moved << " of " << toMove.size()
+                             << " files" << (leaving ? ", local node left the view" : "");
+    }
+    return left;
+}
+
+void CacheMigrator::Worker()
+{
+    uint64_t handledVersion = StoreNode::GetInstance()->GetRingVersion();
+    windowStart = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(workerMutex);
+    while (!stopWorker) {
+        workerCv.wait_for(lock, std::chrono::seconds(MIGRATE_CHECK_INTERVAL));
+        if (stopWorker) {
+            break;
+        }
+        uint64_t version = StoreNode::GetInstance()->GetRingVersion();
+        if (version == handledVersion) {
+            continue;
+        }
+        lock.unlock();
+        size_t left = MigrateRound();
+        lock.lock();
+        if (left == 0) {
+            handledVersion = version;
+        } else {
+            workerCv.wait_for(lock, std::chrono::seconds(MIGRATE_RETRY_INTERVAL));
+        }
+    }
+}
@@ -4,11 +4,18 @@
 
 #include "falcon_store/falcon_store.h"
 
+#include <map>
+
+#include <bthread/countdown_event.h>
+
 #include "conf/falcon_property_key.h"
 #include "connection/node.h"
 #include "disk_cache/disk_cache.h"
+#include "disk_cache/packed_cache.h"
+#include "falcon_store/cache_migrator.h"
 #include "falcon_code.h"
 #include "init/falcon_init.h"
+#include "io_engine/io_engine.h"
 #include "stats/falcon_stats.h"
 #include "storage/obs_storage.h"
 #include "util/utils.h"
@@ -53,7 +60,15 @@ int FalconStore::InitStore()
     parentPathLevel = GetParentPathLevel();
     isInference = config->GetBool(FalconPropertyKey::FALCON_IS_INFERENCE);
     toLocal = config->GetBool(FalconPropertyKey::FALCON_TO_LOCAL);
+    packedSmallFile = config->GetBool(FalconPropertyKey::FALCON_PACKED_SMALL_FILE);
     std::string mountPath = config->GetString(FalconPropertyKey::FALCON_MOUNT_PATH);
+    std::string ioEngine = config->GetString(FalconPropertyKey::FALCON_IO_ENGINE);
+    uint32_t readaheadInitBlocks = config->GetUint32(FalconPropertyKey::FALCON_READAHEAD_INIT_BLOCKS);
+    uint32_t readaheadMaxBlocks = config->GetUint32(FalconPropertyKey::FALCON_READAHEAD_MAX_BLOCKS);
+    uint32_t readaheadMemory = config->GetUint32(FalconPropertyKey::FALCON_READAHEAD_MEMORY);
+    uint32_t migrateBandwidth = config->GetUint32(FalconPropertyKey::FALCON_MIGRATE_BANDWIDTH);
+    uint32_t memPoolLimit = config->GetUint32(FalconPropertyKey::FALCON_MEM_POOL_LIMIT);
+    bool memPoolHugePage = config->GetBool(FalconPropertyKey::FALCON_MEM_POOL_HUGEPAGE);
 
     FALCON_LOG(LOG_INFO) << "falcon_cache rootPath: " << rootPath;
 
@@ -83,12 +98,47 @@ int FalconStore::InitStore()
         diskFreeRatio = 1.0 - storageThreshold;
         bgDiskFreeRatio = 1.1 - storageThreshold;
     }
+    /* packed records live only in the cache index, they need eviction enabled to be tracked */
+    if (packedSmallFile && diskFreeRatio == 0) {
+        FALCON_LOG(LOG_WARNING) << "Packed small file cache needs disk cache eviction, disabled";
+        packedSmallFile = false;
+    }
+    if (packedSmallFile) {
+        ret = PackedCache::GetInstance().Start(rootPath);
+        if (ret != 0) {
+            FALCON_LOG(LOG_ERROR) << "PackedCache start failed";
+            return 1;
+        }
+    }
     ret = DiskCache::GetInstance().Start(rootPath, totalDirectory, diskFreeRatio, bgDiskFreeRatio);
     if (ret != 0) {
         FALCON_LOG(LOG_ERROR) << "DiskCache start failed";
         return 1;
     }
-    MemPool().GetInstance().init(FALCON_BLOCK_SIZE, preBlockNum);
+    /* only files placed by inode can be matched to their new owner, and the cache index must be tracked */
+    if (migrateBandwidth != 0 && (isInference || toLocal || diskFreeRatio == 0)) {
+        FALCON_LOG(LOG_WARNING) << "Cache migration needs placement by inode and disk cache eviction, disabled";
+        migrateBandwidth = 0;
+    }
+    /* migration bandwidth is configured in MB/s, 0 still accepts files from other nodes */
+    ret = CacheMigrator::GetInstance().Start(rootPath, (uint64_t)migrateBandwidth << 20);
+    if (ret != 0) {
+        FALCON_LOG(LOG_ERROR) << "CacheMigrator start failed";
+        return 1;
+    }
+    /* the memory limit is configured in MB, 0 lets the pool grow without bound */
+    MemPool::GetInstance().init(FALCON_BLOCK_SIZE, preBlockNum, ((uint64_t)memPoolLimit << 20) / FALCON_BLOCK_SIZE,
+                                memPoolHugePage);
+    ret = IoEngine::Init(ioEngine);
+    if (ret != 0) {
+        FALCON_LOG(LOG_ERROR) << "IoEngine init failed";
+        return 1;
+    }
+    FALCON_LOG(LOG_INFO) << "falcon io engine: " << IoEngine::GetInstance().Name();
+    /* pool blocks are registered with the io engine on first use and stay registered while the pool keeps them */
+    MemPool::GetInstance().SetReleaseHook([](void *block) { IoEngine::GetInstance().UnregisterBuffer(block); });
+    /* readahead memory is configured in MB */
+    ReadStream::SetReadahead(readaheadInitBlocks, readaheadMaxBlocks, (uint64_t)readaheadMemory << 20);
     storeThreadPool = ThreadPool::CreateThreadPool(threadNum, 100000, "store thread pool");
     if (storeThreadPool == nullptr || storeThreadPool->Start() != 0) {
         FALCON_LOG(LOG_ERROR) << "Falcon threadpool init failed";
@@ -211,7 +261,21 @@ int FalconStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
     }
     if (!isDirect) {
         while (writeSize > 0) {
-            ssize_t nwrite = buf.pcut_into_file_descriptor(openInstance->physicalFd, offset, writeSize);
+            /* write the IOBuf blocks in place with one vectored request */
+            struct iovec iov[IO_ENGINE_IOV_MAX];
+            int iovcnt = 0;
+            size_t iovLen = 0;
+            for (size_t i = 0; i < buf.backing_block_num() && iovcnt < IO_ENGINE_IOV_MAX && iovLen < writeSize; ++i) {
+                butil::StringPiece block = buf.backing_block(i);
+                size_t blockLen = std::min(block.size(), writeSize - iovLen);
+                iov[iovcnt++] = {(void *)block.data(), blockLen};
+                iovLen += blockLen;
+            }
+            ssize_t nwrite = iovcnt > 0 ? IoEngine::GetInstance().Writev(openInstance->physicalFd, iov, iovcnt, offset)
+                                        : -EINVAL;
+            if (nwrite > 0 && nwrite <= (ssize_t)writeSize) {
+                buf.pop_front(nwrite);
+            }
             if (nwrite < 0 || nwrite > (ssize_t)writeSize) {
                 offset += nwrite > 0 ? nwrite : 0;
                 if ((uint64_t)offset > currentSize) {
@@ -244,11 +308,11 @@ int FalconStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
             free(alignedBuf);
             return -EIO;
         }
-        ssize_t retSize = pwrite(openInstance->physicalFd, alignedBuf, writeSize, offset);
+        ssize_t retSize = IoEngine::GetInstance().Write(openInstance->physicalFd, alignedBuf, writeSize, offset, true);
         free(alignedBuf);
         if (retSize < 0) {
-            int err = errno;
-            FALCON_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): pwrite failed" << strerror(err);
+            int err = -retSize;
+            FALCON_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): write failed" << strerror(err);
             DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
             return -err;
         }
@@ -339,7 +403,7 @@ int FalconStore::ReadFile(OpenInstance *openInstance, char *buf, size_t size, of
             openInstance->isOpened = true;
         }
 
-        /* init and start the read stream */
+        /* init and start the read stream, local files are read directly from the cache file */
         if (!openInstance->preReadStarted.exchange(true)) {
             if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
                 StopPreReadThreaded(openInstance);
@@ -406,12 +470,18 @@ int FalconStore::ReadToBuffer(FalconReadBuffer buf, OpenInstance *openInstance,
     /* for sequence read, make sure to read in order without concurrency */
     /* peek and store atomically */
     std::unique_lock<std::shared_mutex> offsetAndBuffLock(openInstance->fileMutex);
-    if (openInstance->directReadFile.load() || openInstance->serialReadEnd != offset) {
-        StopPreReadThreaded(openInstance);
+    if (openInstance->directReadFile.load()) {
+        offsetAndBuffLock.unlock();
+        return RandomRead(buf, openInstance, offset);
+    }
+    /* jumps are absorbed by the read stream, which repositions its window */
+    int retSize = SequenceRead(buf, openInstance, offset);
+    if (retSize == -ECANCELED) {
+        /* read stream stopped by a write */
         offsetAndBuffLock.unlock();
         return RandomRead(buf, openInstance, offset);
     }
-    return SequenceRead(buf, openInstance, offset);
+    return retSize;
 }
 
 /*
@@ -420,35 +490,19 @@ int FalconStore::ReadToBuffer(FalconReadBuffer buf, OpenInstance *openInstance,
 int FalconStore::RandomRead(FalconReadBuffer buf, OpenInstance *openInstance, off_t offset)
 {
     // read file directly, rather than from read stream
-    if ((openInstance->oflags & __O_DIRECT) == 0) {
-        return ReadFileLR(buf.ptr, offset, openInstance, buf.size);
-    } else {
-        int alignedNum = buf.size / 512 + static_cast<int>(buf.size % 512 != 0);
-        char *alignedBuf = (char *)aligned_alloc(512, 512 * alignedNum);
-        if (alignedBuf == nullptr) {
-            FALCON_LOG(LOG_ERROR) << "aligned_alloc failed: " << strerror(errno);
-            return -ENOMEM;
-        }
-        int ret = ReadFileLR(alignedBuf, offset, openInstance, buf.size);
-        if (ret < 0) {
-            free(alignedBuf);
-            return ret;
-        }
-        (void)memcpy(buf.ptr, alignedBuf, buf.size);
-        free(alignedBuf);
-        return ret;
-    }
+    // O_DIRECT needs no bounce here, the io engine aligns local reads and remote or obs reads are not direct
+    return ReadFileLR(buf.ptr, offset, openInstance, buf.size);
 }
 
 /*
  * Called to read readStream
  */
-int FalconStore::SequenceRead(FalconReadBuffer buf, OpenInstance *openInstance, off_t /*offset*/)
+int FalconStore::SequenceRead(FalconReadBuffer buf, OpenInstance *openInstance, off_t offset)
 {
     // read file from read stream
-    int retSize = openInstance->readStream.WaitPop(buf.ptr, buf.size);
+    int retSize = openInstance->readStream.Read(buf.ptr, buf.size, offset);
     if (retSize > 0) {
-        openInstance->serialReadEnd += retSize;
+        openInstance->serialReadEnd = offset + retSize;
     }
     return retSize;
 }
@@ -471,20 +525,22 @@ ssize_t FalconStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
         if (openInstance->physicalFd != UINT64_MAX && !fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
             /* not locked, read cache file */
             FalconStats::GetInstance().stats[BLOCKCACHE_READ] += checkReadLength;
-            retSize = pread(openInstance->physicalFd, readBuffer, readBufferSize, offset);
+            bool isDirect = openInstance->oflags & __O_DIRECT;
+            IoEngine &engine = IoEngine::GetInstance();
+            retSize = engine.Read(openInstance->physicalFd, readBuffer, readBufferSize, offset, isDirect);
             if (retSize != checkReadLength) {
-                int err = errno;
+                int err = retSize < 0 ? -retSize : EIO;
                 if (err == EAGAIN) {
-                    retSize = pread(openInstance->physicalFd, readBuffer, checkReadLength, offset);
+                    retSize = engine.Read(openInstance->physicalFd, readBuffer, checkReadLength, offset, isDirect);
                     if (retSize != checkReadLength) {
-                        err = errno;
-                        FALCON_LOG(LOG_ERROR) << "In ReadFileLR(): pread fd = " << openInstance->physicalFd
+                        err = retSize < 0 ? -retSize : EIO;
+                        FALCON_LOG(LOG_ERROR) << "In ReadFileLR(): read fd = " << openInstance->physicalFd
                                               << " failed : " << strerror(err);
                         retSize = -err;
                     }
                 } else {
                     FALCON_LOG(LOG_ERROR)
-                        << "In ReadFileLR(): pread fd = " << openInstance->physicalFd << " failed : " << strerror(err);
+                        << "In ReadFileLR(): read fd = " << openInstance->physicalFd << " failed : " << strerror(err);
                     retSize = -err;
                 }
             }
@@ -531,6 +587,72 @@ ssize_t FalconStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
     return retSize;
 }
 
+/*
+ * Read for the ReadFile rpc into the response attachment. A cached file is read by the kernel straight into IOBuf
+ * blocks, so neither a staging buffer nor a memcpy is needed. O_DIRECT, locked and uncached files go through
+ * ReadFileLR into a buffer handed over to the IOBuf.
+ */
+ssize_t FalconStore::ReadFileForBrpc(OpenInstance *openInstance, butil::IOBuf &out, size_t size, off_t offset)
+{
+    if (offset >= (ssize_t)openInstance->currentSize) {
+        return 0;
+    }
+    size_t readLength = std::min(size, openInstance->currentSize - offset);
+
+    bool isDirect = openInstance->oflags & __O_DIRECT;
+    if (!isDirect && openInstance->physicalFd != UINT64_MAX &&
+        !fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
+        butil::IOPortal portal;
+        size_t done = 0;
+        while (done < readLength) {
+            ssize_t ret =
+                portal.pappend_from_file_descriptor(openInstance->physicalFd, offset + done, readLength - done);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                break;
+            }
+            done += ret;
+        }
+        if (done == readLength) {
+            FalconStats::GetInstance().stats[BLOCKCACHE_READ] += done;
+            /* shares the blocks, no data copy */
+            out.append(portal);
+            return done;
+        }
+        FALCON_LOG(LOG_WARNING) << "In ReadFileForBrpc(): read fd = " << openInstance->physicalFd << " got " << done
+                                << " of " << readLength << " bytes, retry with buffer";
+    }
+
+    size_t allocSize = size;
+    char *buffer = nullptr;
+    if (isDirect) {
+        allocSize = (size + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN * IO_DIRECT_ALIGN;
+        buffer = static_cast<char *>(aligned_alloc(IO_DIRECT_ALIGN, allocSize));
+    } else {
+        buffer = static_cast<char *>(malloc(allocSize));
+    }
+    if (buffer == nullptr) {
+        FALCON_LOG(LOG_ERROR) << "In ReadFileForBrpc(): allocation failed for size " << allocSize;
+        return -ENOMEM;
+    }
+    ssize_t retSize = ReadFileLR(buffer, offset, openInstance, allocSize);
+    if (retSize < 0) {
+        free(buffer);
+        return retSize;
+    }
+    /* the aligned tail beyond the request is not returned */
+    retSize = std::min<ssize_t>(retSize, size);
+#ifdef USE_RDMA
+    out.append(buffer, retSize);
+    free(buffer);
+#else
+    out.append_user_data(buffer, retSize, [](void *buf) { free(buf); });
+#endif
+    return retSize;
+}
+
 /*---------------------- open ----------------------*/
 
 /*
@@ -556,11 +678,18 @@ int FalconStore::OpenFile(OpenInstance *openInstance)
         } else {
             /* file resides on local node */
             std::string fileName = GetFilePath(openInstance->inodeId);
-            if (openInstance->nodeFail) {
+            /* a copy handed over by the previous owner is up to date */
+            if (openInstance->nodeFail &&
+                !CacheMigrator::GetInstance().IsMigratedIn(openInstance->inodeId, openInstance->originalSize)) {
                 DiskCache::GetInstance().DeleteOldCacheWithNoPin(openInstance->inodeId);
             }
             if (DiskCache::GetInstance().Find(openInstance->inodeId, true)) {
                 /* Cache Hits: read file from cache */
+                ret = PromotePackedFile(openInstance->inodeId);
+                if (ret != 0) {
+                    DiskCache::GetInstance().Unpin(openInstance->inodeId);
+                    return ret;
+                }
                 int localFd = open(fileName.c_str(), openInstance->oflags, 0755);
                 if (localFd < 0) {
                     err = errno;
@@ -659,7 +788,8 @@ int FalconStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
     /* if file exists in disk cache, pin directly if it is sync */
     if (DiskCache::GetInstance().Find(openInstance->inodeId, isSync)) {
         FALCON_LOG(LOG_INFO) << "DownLoadFromStorage(): No need to load obs, other created local file, abort";
-        return 0;
+        /* sync loaders open the cache file afterwards */
+        return isSync ? PromotePackedFile(openInstance->inodeId) : 0;
     }
 
     if (!DiskCache::GetInstance().PreAllocSpace(fileSize)) {
@@ -920,40 +1050,16 @@ int FalconStore::ReadSmallFiles(OpenInstance *openInstance)
     /* File resides on local node */
     std::string fileName = GetFilePath(inodeId);
 
-    if (openInstance->nodeFail) {
+    if (openInstance->nodeFail && !CacheMigrator::GetInstance().IsMigratedIn(inodeId, openInstance->originalSize)) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
     /* Check if in disk cache. True then pin the file */
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
-        int localFd = open(fileName.c_str(), O_RDONLY);
-        if (localFd < 0) {
-            int err = errno;
-            FALCON_LOG(LOG_ERROR) << "ReadSmallFiles(): open file failed : " << fileName << " << " << strerror(errno);
-            DiskCache::GetInstance().Unpin(inodeId);
-            return -err;
-        }
-        FalconStats::GetInstance().stats[BLOCKCACHE_READ] += bufSize;
-        ssize_t retSize = pread(localFd, readBuffer, bufSize, 0);
-        if (retSize != (ssize_t)bufSize) {
-            int err = errno;
-            if (err == EAGAIN) {
-                retSize = pread(localFd, readBuffer, bufSize, 0);
-                if (retSize == (ssize_t)bufSize) {
-                    close(localFd);
-                    DiskCache::GetInstance().Unpin(inodeId);
-                    return 0;
-                }
-                err = errno;
-            }
-            FALCON_LOG(LOG_ERROR) << "ReadSmallFiles(): Pread size is not equal to size: " << strerror(err);
-            close(localFd);
-            DiskCache::GetInstance().Unpin(inodeId);
-            return -err;
-        }
-        close(localFd);
-        /* unpin the file after close */
+        ret = ReadCachedSmallFile(inodeId, readBuffer, bufSize);
+        /* unpin the file after read */
         DiskCache::GetInstance().Unpin(inodeId);
+        return ret;
     } else {
         /* Cache Miss: load file from obs */
         if (!persistToStorage) {
@@ -994,6 +1100,168 @@ int FalconStore::ReadSmallFiles(OpenInstance *openInstance)
     return 0;
 }
 
+/*
+ * Called on a batch open, rets get what ReadSmallFiles returns for each file. Files on the same remote node are
+ * read with one rpc per BATCH_READ_SMALL_FILES_MAX files, all rpcs sent asynchronously while the local files are
+ * read. Local files and files of a failed rpc go through ReadSmallFiles, which also switches node on connection
+ * errors.
+ */
+void FalconStore::BatchReadSmallFiles(std::vector<OpenInstance *> &openInstances, std::vector<int> &rets)
+{
+    size_t num = openInstances.size();
+    rets.assign(num, 0);
+    std::vector<size_t> localFiles;
+    std::map<int, std::vector<size_t>> nodeFiles;
+    for (size_t i = 0; i < num; ++i) {
+        AllocNodeId(openInstances[i]);
+        if (StoreNode::GetInstance()->IsLocal(openInstances[i]->nodeId)) {
+            localFiles.push_back(i);
+        } else {
+            nodeFiles[openInstances[i]->nodeId].push_back(i);
+        }
+    }
+    std::vector<std::vector<size_t>> batches;
+    for (auto &[nodeId, files] : nodeFiles) {
+        for (size_t start = 0; start < files.size(); start += BATCH_READ_SMALL_FILES_MAX) {
+            size_t end = std::min(files.size(), start + BATCH_READ_SMALL_FILES_MAX);
+            batches.emplace_back(files.begin() + start, files.begin() + end);
+        }
+    }
+
+    /* the rpcs return right away, none of them holds a thread while it waits */
+    std::vector<std::vector<SmallFileReadItem>> batchItems(batches.size());
+    std::vector<std::shared_ptr<FalconIOClient>> batchClients(batches.size());
+    std::vector<int> batchRets(batches.size(), 0);
+    bthread::CountdownEvent answered(static_cast<int>(batches.size()));
+    for (size_t b = 0; b < batches.size(); ++b) {
+        std::vector<SmallFileReadItem> &items = batchItems[b];
+        items.resize(batches[b].size());
+        std::vector<SmallFileReadItem *> itemPtrs;
+        for (size_t i = 0; i < batches[b].size(); ++i) {
+            OpenInstance *openInstance = openInstances[batches[b][i]];
+            items[i].inodeId = openInstance->inodeId;
+            items[i].size = openInstance->originalSize;
+            items[i].path = openInstance->path;
+            items[i].oflags = openInstance->oflags;
+            items[i].nodeFail = openInstance->nodeFail;
+            items[i].buf = openInstance->readBuffer.get();
+            itemPtrs.push_back(&items[i]);
+        }
+        batchClients[b] = StoreNode::GetInstance()->GetRpcConnection(openInstances[batches[b].front()]->nodeId);
+        if (batchClients[b] == nullptr) {
+            batchRets[b] = EHOSTUNREACH;
+            answered.signal();
+            continue;
+        }
+        batchClients[b]->BatchReadSmallFiles(itemPtrs, [&batchRets, &answered, b](int ret) {
+            batchRets[b] = ret;
+            answered.signal();
+        });
+    }
+    for (size_t i : localFiles) {
+        rets[i] = ReadSmallFiles(openInstances[i]);
+    }
+    answered.wait();
+
+    for (size_t b = 0; b < batches.size(); ++b) {
+        for (size_t i = 0; i < batches[b].size(); ++i) {
+            size_t index = batches[b][i];
+            OpenInstance *openInstance = openInstances[index];
+            if (batchRets[b] != 0) {
+                /* the rpc failed, the file is read alone */
+                rets[index] = ReadSmallFiles(openInstance);
+            } else if (batchItems[b][i].ret == 0) {
+                openInstance->writeStream.SetClient(batchClients[b]);
+            } else if (persistToStorage) {
+                /* same as a failed ReadSmallFile, read obs instead */
+                FALCON_LOG(LOG_WARNING) << "BatchReadSmallFiles(): small read remote failed, read obs instead";
+                int obsRet = storage->ReadObject(openInstance->path.substr(1),
+                                                 0,
+                                                 openInstance->readBufferSize,
+                                                 -1,
+                                                 openInstance->readBuffer.get());
+                rets[index] = obsRet < 0 ? -EIO : 0;
+            } else {
+                rets[index] = batchItems[b][i].ret;
+            }
+        }
+    }
+}
+
+/*
+ * Read a whole cached small file, pinned by the caller, from its packed record or its regular cache file
+ */
+int FalconStore::ReadCachedSmallFile(uint64_t inodeId, char *buf, size_t size)
+{
+    FalconStats::GetInstance().stats[BLOCKCACHE_READ] += size;
+    if (packedSmallFile) {
+        ssize_t retSize = PackedCache::GetInstance().Read(inodeId, buf, size, 0);
+        if (retSize == (ssize_t)size) {
+            return 0;
+        }
+        if (retSize != -ENOENT) {
+            FALCON_LOG(LOG_ERROR) << "ReadCachedSmallFile(): packed read size not equal to size: " << retSize;
+            return retSize < 0 ? retSize : -EIO;
+        }
+    }
+
+    std::string fileName = GetFilePath(inodeId);
+    int localFd = open(fileName.c_str(), O_RDONLY);
+    if (localFd < 0) {
+        int err = errno;
+        FALCON_LOG(LOG_ERROR) << "ReadCachedSmallFile(): open file failed : " << fileName << " << " << strerror(err);
+        return -err;
+    }
+    ssize_t retSize = IoEngine::GetInstance().Read(localFd, buf, size, 0);
+    if (retSize != (ssize_t)size) {
+        int err = retSize < 0 ? -retSize : EIO;
+        if (err == EAGAIN) {
+            retSize = IoEngine::GetInstance().Read(localFd, buf, size, 0);
+            if (retSize == (ssize_t)size) {
+                close(localFd);
+                return 0;
+            }
+            err = retSize < 0 ? -retSize : EIO;
+        }
+        FALCON_LOG(LOG_ERROR) << "ReadCachedSmallFile(): read size is not equal to size: " << strerror(err);
+        close(localFd);
+        return -err;
+    }
+    close(localFd);
+    return 0;
+}
+
+/*
+ * A packed small file is copied out to a regular cache file before it is opened by fd, e.g. for write
+ */
+int FalconStore::PromotePackedFile(uint64_t inodeId)
+{
+    if (!packedSmallFile || !PackedCache::GetInstance().Contains(inodeId)) {
+        return 0;
+    }
+    /* a second promoter must not replace the file the first one has handed out and may already be written */
+    std::lock_guard<std::mutex> lock(promoteMutexes[inodeId % PROMOTE_LOCK_NUM]);
+    if (!PackedCache::GetInstance().Contains(inodeId)) {
+        return 0;
+    }
+    std::string fileName = GetFilePath(inodeId);
+    int ret = PackedCache::GetInstance().Extract(inodeId, fileName);
+    if (ret == -ENOENT) {
+        return 0;
+    }
+    if (ret != 0) {
+        FALCON_LOG(LOG_ERROR) << "PromotePackedFile(): extract " << fileName << " failed: " << strerror(-ret);
+        return ret;
+    }
+    struct stat st;
+    if (stat(fileName.c_str(), &st) == 0) {
+        /* the entry is a regular file from now on */
+        DiskCache::GetInstance().InsertAndUpdate(inodeId, st.st_size, false);
+    }
+    PackedCache::GetInstance().Remove(inodeId);
+    return 0;
+}
+
 /*
  * Called by OpenFile and ReadSmallFile. Large file try open and return, small file read obs if failed
  * Use a shared_ptr from read buffer to store the file content
@@ -1018,6 +1286,23 @@ int FalconStore::WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::
         return -ENOSPC;
     }
 
+    /* Small file goes into the packed container instead of its own cache file */
+    if (packedSmallFile && bufSize < READ_BIGFILE_SIZE) {
+        ThreadTask task;
+        task.task = [buf, bufSize, inodeId, lockerPtr]() {
+            FalconStats::GetInstance().stats[BLOCKCACHE_WRITE] += bufSize;
+            int ret = PackedCache::GetInstance().Put(inodeId, buf.get(), bufSize);
+            if (ret != 0) {
+                FALCON_LOG(LOG_ERROR) << "WriteToFileAsync(): packed put failed : " << strerror(-ret);
+            } else {
+                DiskCache::GetInstance().InsertAndUpdate(inodeId, bufSize, false, true);
+            }
+            DiskCache::GetInstance().FreePreAllocSpace(bufSize);
+        };
+        storeThreadPool->Submit(task);
+        return 0;
+    }
+
     /* Cache file must not exist. Create it */
     auto fd = open(fileName.c_str(), O_WRONLY | O_CREAT, 0755);
     if (fd < 0) {
@@ -1060,42 +1345,15 @@ int FalconStore::ReadSmallFilesForBrpc(uint64_t inodeId,
     int ret = 0;
 
     /* File resides on local node */
-    std::string fileName = GetFilePath(inodeId);
     /* Check if in disk cache. True then pin the file */
-    if (nodeFail) {
+    if (nodeFail && !CacheMigrator::GetInstance().IsMigratedIn(inodeId, size)) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
 
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
-        int localFd = open(fileName.c_str(), O_RDONLY);
-        if (localFd < 0) {
-            int err = errno;
-            FALCON_LOG(LOG_ERROR) << "ReadSmallFilesForBrpc(): open file " << fileName
-                                  << " failed : " << strerror(errno);
-            DiskCache::GetInstance().Unpin(inodeId);
-            return -err;
-        }
-        FalconStats::GetInstance().stats[BLOCKCACHE_READ] += size;
-        ssize_t retSize = pread(localFd, buf, size, 0);
-        if (retSize != (ssize_t)size) {
-            int err = errno;
-            if (err == EAGAIN) {
-                retSize = pread(localFd, buf, size, 0);
-                if (retSize == (ssize_t)size) {
-                    close(localFd);
-                    DiskCache::GetInstance().Unpin(inodeId);
-                    return 0;
-                }
-                err = errno;
-            }
-            FALCON_LOG(LOG_ERROR) << "ReadSmallFilesForBrpc(): Pread size not equal: " << strerror(err);
-            close(localFd);
-            DiskCache::GetInstance().Unpin(inodeId);
-            return -err;
-        }
-        close(localFd);
-        /* unpin the file after close */
+        ret = ReadCachedSmallFile(inodeId, buf, size);
+        /* unpin the file after read */
         DiskCache::GetInstance().Unpin(inodeId);
     } else {
         /* Cache Miss: load file from obs */
@@ -1125,6 +1383,37 @@ int FalconStore::ReadSmallFilesForBrpc(uint64_t inodeId,
     return ret;
 }
 
+/*
+ * Called by brpc server only, the items are read in parallel on the store thread pool and finish runs once the last
+ * of them is read, so the rpc bthread does not wait for them. Items with ret set are skipped.
+ */
+void FalconStore::BatchReadSmallFilesForBrpc(std::shared_ptr<std::vector<SmallFileReadItem>> items,
+                                             std::function<void()> finish)
+{
+    std::vector<SmallFileReadItem *> pending;
+    for (SmallFileReadItem &item : *items) {
+        if (item.ret == 0) {
+            pending.push_back(&item);
+        }
+    }
+    if (pending.empty()) {
+        finish();
+        return;
+    }
+    auto remaining = std::make_shared<std::atomic<size_t>>(pending.size());
+    auto sharedFinish = std::make_shared<std::function<void()>>(std::move(finish));
+    for (SmallFileReadItem *item : pending) {
+        /* the task holds items, they live until finish ran */
+        storeThreadPool->Submit({.taskName = "", .task = [this, items, item, remaining, sharedFinish]() {
+                                     item->ret = ReadSmallFilesForBrpc(item->inodeId, item->path, item->buf,
+                                                                       item->size, item->oflags, item->nodeFail);
+                                     if (remaining->fetch_sub(1) == 1) {
+                                         (*sharedFinish)();
+                                     }
+                                 }});
+    }
+}
+
 /*
  * Used by brpc server only, called by ReadSmallFilesForBrpc
  */
@@ -1150,7 +1439,8 @@ int FalconStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
     /* if file exists in disk cache, pin directly if it is sync */
     if (DiskCache::GetInstance().Find(inodeId, isSync)) {
         FALCON_LOG(LOG_INFO) << "DownLoadFromStorage(): No need to load obs, other created local file, abort";
-        return 0;
+        /* sync loaders open the cache file afterwards */
+        return isSync ? PromotePackedFile(inodeId) : 0;
     }
 
     if (!DiskCache::GetInstance().PreAllocSpace(bufSize)) {
@@ -1158,6 +1448,24 @@ int FalconStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
         return -ENOSPC;
     }
 
+    /* read only background load of a small file, append it into the packed container */
+    if (packedSmallFile && !isSync && !toBuffer && bufSize < READ_BIGFILE_SIZE) {
+        auto loadObsPacked = [=, this]() {
+            std::unique_ptr<char[]> data(new (std::nothrow) char[bufSize]);
+            int size = data ? storage->ReadObject(path.substr(1), 0, bufSize, -1, data.get()) : -ENOMEM;
+            if (size < 0) {
+                FALCON_LOG(LOG_ERROR) << "DownLoadFromStorage(): Loading packed file from obs failed";
+            } else if (PackedCache::GetInstance().Put(inodeId, data.get(), bufSize) == 0) {
+                DiskCache::GetInstance().InsertAndUpdate(inodeId, bufSize, false, true);
+            }
+            DiskCache::GetInstance().FreePreAllocSpace(bufSize);
+            /* keep the lock until the record is visible */
+            (void)lockerPtr;
+        };
+        storeThreadPool->Submit({.taskName = "", .task = loadObsPacked});
+        return 0;
+    }
+
     /* here cache file must not exist */
     auto fd = open(fileName.c_str(), O_WRONLY | O_CREAT, 0755);
     if (fd < 0) {
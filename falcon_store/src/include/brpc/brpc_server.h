@@ -40,6 +40,11 @@ class RemoteIOServiceImpl : public RemoteIOService {
                        ErrorCodeOnlyReply *response,
                        google::protobuf::Closure *done) override;
 
+    void BatchReadSmallFiles(google::protobuf::RpcController *cntl_base,
+                             const BatchReadSmallFilesRequest *request,
+                             BatchReadSmallFilesReply *response,
+                             google::protobuf::Closure *done) override;
+
     void WriteFile(google::protobuf::RpcController *cntl_base,
                    const WriteRequest *request,
                    WriteReply *response,
@@ -74,6 +79,11 @@ class RemoteIOServiceImpl : public RemoteIOService {
                          const StatClusterRequest *request,
                          StatClusterReply *response,
                          google::protobuf::Closure *done) override;
+
+    void MigrateFile(google::protobuf::RpcController *cntl_base,
+                     const MigrateFileRequest *request,
+                     ErrorCodeOnlyReply *response,
+                     google::protobuf::Closure *done) override;
 };
 
 class RemoteIOServer {
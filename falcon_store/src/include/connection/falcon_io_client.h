@@ -4,11 +4,13 @@
 
 #pragma once
 
-
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <brpc/channel.h>
+#include <butil/iobuf.h>
 
 #include "brpc_io.pb.h"
 #include "util/utils.h"
@@ -16,6 +18,20 @@
 
 #define BRPC_RETRY_NUM 3
 #define BRPC_RETRY_DELEY 1
+/* small files read by one BatchReadSmallFiles rpc */
+#define BATCH_READ_SMALL_FILES_MAX 256
+
+struct SmallFileReadItem
+{
+    uint64_t inodeId{0};
+    size_t size{0};
+    std::string path;
+    int oflags{0};
+    bool nodeFail{false};
+    char *buf{nullptr};
+    /* 0 or -errno of the item */
+    int ret{0};
+};
 
 class FalconIOClient {
   public:
@@ -47,12 +63,19 @@ class FalconIOClient {
     int WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset);
     ssize_t
     ReadSmallFile(uint64_t inodeId, ssize_t size, std::string &path, char *readBuffer, int oflags, bool nodeFail);
+    int BatchReadSmallFiles(std::vector<SmallFileReadItem *> &items);
+    /*
+     * Sends the rpc and returns at once, done gets what the blocking BatchReadSmallFiles returns once it is answered,
+     * on a brpc thread. The items must outlive the call of done.
+     */
+    void BatchReadSmallFiles(const std::vector<SmallFileReadItem *> &items, std::function<void(int)> done);
     int DeleteFile(uint64_t inodeId, int nodeId, std::string &path);
     int StatFS(std::string &path, struct StatFSBuf *fsBuf);
     int TruncateOpenInstance(uint64_t physicalFd, off_t size);
     int TruncateFile(uint64_t physicalFd, off_t size);
     int CheckConnection();
     int StatCluster(int nodeId, std::vector<size_t> &stats, bool scatter);
+    int MigrateFile(uint64_t inodeId, uint64_t size, off_t offset, butil::IOBuf &data);
 
   private:
     std::shared_ptr<brpc::Channel> channel;
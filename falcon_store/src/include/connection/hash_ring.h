@@ -0,0 +1,34 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/* points of every store node on the ring */
+#define HASH_RING_VIRTUAL_NODES 160
+
+uint64_t hash64(uint64_t x);
+
+/*
+ * Consistent hash ring of the store nodes. Every node is placed at HASH_RING_VIRTUAL_NODES points and a key belongs
+ * to the first point at or after its hash, so adding or removing one of N nodes moves only about 1/N of the keys.
+ * A ring is immutable once built, membership changes build a new one.
+ */
+class HashRing {
+  public:
+    explicit HashRing(const std::vector<int> &nodeIds, uint32_t virtualNodes = HASH_RING_VIRTUAL_NODES);
+
+    bool Empty() const { return points.empty(); }
+    /* node owning the key, -1 if the ring is empty */
+    int Locate(uint64_t key) const;
+    /* first node other than nodeId walking the ring from the owner of key, nodeId if there is no other */
+    int Successor(uint64_t key, int nodeId) const;
+
+  private:
+    /* (hash, nodeId) sorted by hash */
+    std::vector<std::pair<uint64_t, int>> points;
+};
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
+#include "connection/hash_ring.h"
 #include "falcon_io_client.h"
 
 class StoreNode {
@@ -17,6 +19,12 @@ class StoreNode {
     int initStatus = 0;
     int nodeId;
     std::unordered_map<int, std::pair<std::string, std::shared_ptr<FalconIOClient>>> nodeMap;
+    /* placement of nodeMap, rebuilt under nodeMutex and read without it */
+    std::atomic<std::shared_ptr<const HashRing>> ring;
+    /* bumped by every RebuildRing, lets the cache migrator notice membership changes */
+    std::atomic<uint64_t> ringVersion{0};
+
+    void RebuildRing();
 
   public:
     int SetNodeConfig(int initNodeId, std::string &clusterView);
@@ -38,6 +46,7 @@ class StoreNode {
     int GetNextNode(int nodeId, uint64_t inodeId);
     void DeleteNode(int nodeId);
     std::vector<int> GetAllNodeId();
+    uint64_t GetRingVersion();
     int UpdateNodeConfig();
     void UpdateNodeConfigByValue(std::unordered_map<int, std::string> &zkStoreNodes);
 };
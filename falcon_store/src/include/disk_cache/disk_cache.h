@@ -6,8 +6,10 @@
 
 #include <dirent.h>
 
+#include <array>
 #include <atomic>
-#include <list>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -28,8 +30,27 @@ struct CacheItem
     uint64_t size{0};
     uint64_t atime{0};
     uint32_t refs{0};
+    bool valid{false};
+    /* CLOCK reference bit, set on every hit and cleared by the sweeping hand */
+    bool referenced{false};
+    /* picked as a victim, file is being unlinked outside the shard lock */
+    bool evicting{false};
+    /* stored as a record in PackedCache instead of a regular cache file */
+    bool packed{false};
+    /* loaded from the index snapshot, size not yet checked against the file */
+    bool unverified{false};
 };
 
+#define DISK_CACHE_SHARD_BITS 6
+#define DISK_CACHE_SHARD_NUM (1 << DISK_CACHE_SHARD_BITS)
+#define DISK_CACHE_EVICT_BATCH 32
+
+/* index snapshot under the cache root, rewritten every DISK_CACHE_SNAPSHOT_ROUNDS background rounds and on exit */
+#define DISK_CACHE_INDEX_FILE "disk_cache.index"
+#define DISK_CACHE_SNAPSHOT_ROUNDS 30
+/* a cache directory modified later than snapshot time minus this slack is walked again on restart */
+#define DISK_CACHE_SNAPSHOT_SLACK 60
+
 class DiskCache {
   public:
     static DiskCache &GetInstance()
@@ -43,7 +64,7 @@ class DiskCache {
     int Start(std::string &path, int dirNum, float ratio, float bgEvitRatio);
     bool Find(uint64_t key, bool needPin);
     void DeleteOldCacheWithNoPin(uint64_t key);
-    void InsertAndUpdate(uint64_t key, uint64_t size, bool needPin);
+    void InsertAndUpdate(uint64_t key, uint64_t size, bool needPin, bool packed = false);
     bool Add(uint64_t key, uint64_t size);
     bool Update(uint64_t key, uint64_t size);
     int Delete(uint64_t key);
@@ -53,6 +74,11 @@ class DiskCache {
     bool PreAllocSpace(uint64_t size);
     void FreePreAllocSpace(uint64_t size);
     bool HasFreeSpace();
+    int SaveSnapshot();
+    /* regular cache files in the index, packed records and victims being evicted are skipped */
+    void ForEach(const std::function<void(uint64_t inode, uint64_t size)> &func);
+    /* called under the shard lock with every key leaving the index, it must not call back into DiskCache */
+    void SetEraseHook(std::function<void(uint64_t key)> hook) { eraseHook = std::move(hook); }
 
   private:
     uint64_t totalCap{0};
@@ -66,26 +92,55 @@ class DiskCache {
 
     bool testOBS = false;
 
-    uint64_t usedCap{0};
+    std::atomic<uint64_t> usedCap{0};
+    std::atomic<uint64_t> cachedInodes{0};
+
+    /*
+     * The cache index is partitioned by inode hash, every shard owns a CLOCK ring of slots. A hit only sets the
+     * reference bit, so lookups never reorder anything and contend on 1/DISK_CACHE_SHARD_NUM of the keys.
+     */
+    struct CacheShard
+    {
+        std::mutex mutex;
+        std::condition_variable evictDone;
+        std::vector<CacheItem> slots;
+        std::vector<uint32_t> freeSlots;
+        std::unordered_map<uint64_t, uint32_t> index;
+        size_t hand{0};
+    };
 
     std::string rootDir;
-    std::list<CacheItem> cacheItems;
-    using cacheIterator = std::list<CacheItem>::iterator;
-    std::unordered_map<uint64_t, cacheIterator> inodeToCacheIter;
-    std::mutex mutex;
+    std::array<CacheShard, DISK_CACHE_SHARD_NUM> shards;
+    /* serialize eviction rounds and protect the statfs snapshot below */
+    std::mutex evictMutex;
+    uint32_t evictShardCursor{0};
 
     std::thread cleanupThread;
     std::atomic<bool> stop{false};
     std::atomic<bool> hasFreeSpace{true};
+    /* bumped on every insert, erase, size and atime change, lets the background thread skip unchanged snapshots */
+    std::atomic<uint64_t> indexVersion{0};
+    uint64_t snapshotVersion{0};
 
     int totalDirNum{101};
 
     std::atomic<uint64_t> reservedCap{0};
     std::mutex allocMutex;
 
+    std::function<void(uint64_t key)> eraseHook;
+
     static std::mutex initCacheMutex;
 
     static std::vector<CacheItem> initCacheVector;
+    CacheShard &GetShard(uint64_t key);
+    CacheItem *Lookup(CacheShard &shard, std::unique_lock<std::mutex> &lock, uint64_t key);
+    CacheItem &InsertLocked(CacheShard &shard, uint64_t key, uint64_t size);
+    void EraseLocked(CacheShard &shard, uint64_t key);
+    bool ReconcileLocked(CacheShard &shard, CacheItem &item);
+    void PickVictims(CacheShard &shard, std::vector<CacheItem> &victims);
+    void EvictItems(uint64_t toFreeCap, uint64_t toFreeInode, const char *caller);
+    void InsertFromScan(const CacheItem &cache);
+    void LoadSnapshot(std::vector<bool> &walkDirs);
     int GetCurFreeRatio();
     void CheckFreeSpace();
     void Cleanup();
@@ -0,0 +1,101 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#define PACKED_CACHE_DIR "packed"
+#define PACKED_SEGMENT_SIZE (256UL * 1024 * 1024)
+/* sealed segments whose live bytes drop below this ratio are rewritten by the compactor */
+#define PACKED_COMPACT_RATIO 0.5
+#define PACKED_COMPACT_INTERVAL 10
+/* live records the compactor reads with one io engine submission */
+#define PACKED_COMPACT_BATCH 32
+
+/*
+ * Container for small cache files. Instead of one ext4 file per inode, files below READ_BIGFILE_SIZE are appended
+ * as records into large segment files under <cache root>/packed and located through an in-memory
+ * (inode -> segment, offset, len) index. Every record carries a header with its inode, so the index is rebuilt by
+ * scanning the segments on start. Deleted or evicted records only leave holes, which the background compactor
+ * reclaims by copying the live records of sparse segments into the active one.
+ */
+class PackedCache {
+  public:
+    static PackedCache &GetInstance()
+    {
+        static PackedCache instance;
+        return instance;
+    }
+    PackedCache() = default;
+    ~PackedCache();
+    int Start(const std::string &cacheRoot, uint64_t segmentSize = PACKED_SEGMENT_SIZE);
+    void Stop();
+    bool IsStarted();
+    int Put(uint64_t inode, const char *buf, size_t size);
+    ssize_t Read(uint64_t inode, char *buf, size_t size, off_t offset);
+    bool Contains(uint64_t inode);
+    int Remove(uint64_t inode);
+    int Extract(uint64_t inode, const std::string &filePath);
+    void ForEach(const std::function<void(uint64_t inode, uint64_t size)> &func);
+    int Compact(double liveRatio = PACKED_COMPACT_RATIO);
+    size_t SegmentNum();
+
+  private:
+    struct Segment
+    {
+        uint32_t id{0};
+        int fd{-1};
+        std::string path;
+        uint64_t tail{0};
+        std::atomic<uint64_t> liveBytes{0};
+        /* appends reserved in the segment whose record is not in the index yet, the compactor skips it meanwhile */
+        std::atomic<uint32_t> pendingAppends{0};
+        ~Segment();
+    };
+    struct Extent
+    {
+        uint32_t segment{0};
+        uint32_t len{0};
+        uint64_t offset{0};
+    };
+
+    int OpenActiveSegment();
+    /* the caller lowers segment->pendingAppends once extent is in the index */
+    int Append(uint64_t inode, const char *buf, size_t size, Extent &extent, std::shared_ptr<Segment> &segment);
+    int MarkDeleted(const std::shared_ptr<Segment> &segment, uint64_t offset);
+    /* indexMutex held, nullptr if the index points at a segment that is not loaded */
+    std::shared_ptr<Segment> FindSegment(uint32_t id);
+    int ScanSegment(const std::shared_ptr<Segment> &segment);
+    void CompactWorker();
+
+    std::string packedDir;
+    uint64_t segmentSize{PACKED_SEGMENT_SIZE};
+    std::atomic<bool> started{false};
+
+    /* guards index and segments */
+    std::shared_mutex indexMutex;
+    std::unordered_map<uint64_t, Extent> index;
+    std::unordered_map<uint32_t, std::shared_ptr<Segment>> segments;
+
+    /* guards the active segment and its tail */
+    std::mutex appendMutex;
+    std::shared_ptr<Segment> activeSegment;
+    uint32_t nextSegmentId{0};
+
+    std::thread compactThread;
+    std::mutex compactMutex;
+    std::condition_variable compactCv;
+    bool stopCompact{false};
+};
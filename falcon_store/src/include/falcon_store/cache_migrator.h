@@ -0,0 +1,88 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <butil/iobuf.h>
+
+/* staging directory under the cache root, outside the numbered directories scanned by DiskCache */
+#define MIGRATE_TMP_DIR "migrating"
+/* bytes of one file sent by a MigrateFile rpc */
+#define MIGRATE_CHUNK_SIZE (4 * 1024 * 1024)
+#define MIGRATE_CHECK_INTERVAL 1
+/* wait before a round that left files behind, e.g. on an unreachable owner, is tried again */
+#define MIGRATE_RETRY_INTERVAL 30
+/* an incoming file without a chunk for this many seconds is dropped with its staging file and space reservation */
+#define MIGRATE_RECEIVE_TIMEOUT 300
+
+/*
+ * Hands cached files over to their new owner when store membership changes. Every time the hash ring of StoreNode
+ * is rebuilt, the worker walks the local disk cache and streams each file whose ring owner is another node to it
+ * with MigrateFile rpcs, at most bandwidth bytes per second. The local copy stays pinned and keeps serving reads
+ * while it is sent. It is only removed after the owner committed the file and if this node itself left the view,
+ * a member keeps its copy because the metadata of existing files still points at it.
+ *
+ * The receiver reserves the space of a file with its first chunk, stages the chunks under MIGRATE_TMP_DIR in order
+ * and renames the complete file into the cache. Such a copy is remembered with its size until the first client
+ * failing over to this node with nodeFail takes it instead of throwing it away, or until it leaves the cache.
+ */
+class CacheMigrator {
+  public:
+    static CacheMigrator &GetInstance()
+    {
+        static CacheMigrator instance;
+        return instance;
+    }
+    CacheMigrator() = default;
+    ~CacheMigrator();
+    /* bandwidth in bytes per second, 0 only receives files and never sends */
+    int Start(const std::string &cacheRoot, uint64_t bandwidth);
+    void Stop();
+    int Receive(uint64_t inodeId, uint64_t size, off_t offset, butil::IOBuf &data);
+    bool IsMigratedIn(uint64_t inodeId, uint64_t size);
+    /* one pass over the cache, returns the number of files left behind */
+    size_t MigrateRound();
+
+  private:
+    struct Transfer
+    {
+        uint64_t size{0};
+        /* offset the next chunk has to start at */
+        off_t next{0};
+        std::chrono::steady_clock::time_point lastChunk;
+    };
+
+    void EndTransfer(uint64_t inodeId);
+    void ExpireTransfers();
+    int MigrateOne(uint64_t inodeId, int owner);
+    void Throttle(size_t bytes);
+    void Worker();
+
+    std::string tmpDir;
+    uint64_t bytesPerSecond{0};
+    std::chrono::steady_clock::time_point windowStart;
+    uint64_t windowBytes{0};
+    /* files handed over by the worker and kept here, they are not sent again to the same owner */
+    std::unordered_map<uint64_t, int> migratedOut;
+
+    /* guards migratedIn and receiving, DiskCache is never called with it held */
+    std::mutex migratedMutex;
+    std::unordered_map<uint64_t, uint64_t> migratedIn;
+    std::unordered_map<uint64_t, Transfer> receiving;
+
+    std::thread workerThread;
+    std::mutex workerMutex;
+    std::condition_variable workerCv;
+    std::atomic<bool> stopWorker{false};
+};
@@ -6,8 +6,10 @@
 
 #include <fcntl.h>
 
+#include <array>
 #include <atomic>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -18,10 +20,13 @@
 
 #include "buffer/falcon_buffer.h"
 #include "buffer/open_instance.h"
+#include "connection/falcon_io_client.h"
 #include "storage/storage.h"
 #include "thread_pool/thread_pool.h"
 #include "util/file_lock.h"
 
+#define PROMOTE_LOCK_NUM 64
+
 class FalconStore {
   public:
     void SetFalconStoreParam(std::string &newNodeConfig);
@@ -31,9 +36,13 @@ class FalconStore {
     /*-----------------read-----------------*/
     int ReadFile(OpenInstance *openInstance, char *buffer, size_t size, off_t offset);
     ssize_t ReadFileLR(char *readBuffer, off_t offset, OpenInstance *openInstance, size_t readBufferSize);
+    ssize_t ReadFileForBrpc(OpenInstance *openInstance, butil::IOBuf &out, size_t size, off_t offset);
     int ReadSmallFiles(OpenInstance *openInstance);
+    void BatchReadSmallFiles(std::vector<OpenInstance *> &openInstances, std::vector<int> &rets);
     int
     ReadSmallFilesForBrpc(uint64_t inodeId, const std::string &path, char *buf, size_t size, int oflags, bool nodeFail);
+    void BatchReadSmallFilesForBrpc(std::shared_ptr<std::vector<SmallFileReadItem>> items,
+                                    std::function<void()> finish);
 
     /*-----------------func-----------------*/
     int OpenFile(OpenInstance *openInstance);
@@ -67,6 +76,8 @@ class FalconStore {
     int RandomRead(FalconReadBuffer buf, OpenInstance *openInstance, off_t offset);
     int SequenceRead(FalconReadBuffer buf, OpenInstance *openInstance, off_t offset);
     int WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::shared_ptr<char> buf, size_t bufSize);
+    int ReadCachedSmallFile(uint64_t inodeId, char *buf, size_t size);
+    int PromotePackedFile(uint64_t inodeId);
 
     /*-----------------func-----------------*/
     int OpenFileFromRemote(OpenInstance *openInstance, bool largeFile);
@@ -98,7 +109,10 @@ class FalconStore {
     int parentPathLevel{-1};
     bool isInference = true;
     bool toLocal = false;
+    bool packedSmallFile = false;
     FileLock fileLock;
+    /* serialize PromotePackedFile per inode, striped by inode id */
+    std::array<std::mutex, PROMOTE_LOCK_NUM> promoteMutexes;
     std::unordered_map<std::string, std::atomic<uint64_t>> nodeHash;
     std::mutex mutex;
     std::string dataPath;
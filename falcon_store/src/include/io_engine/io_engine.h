@@ -0,0 +1,149 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef WITH_IO_URING
+#include <liburing.h>
+#endif
+
+#define IO_ENGINE_PREAD "pread"
+#define IO_ENGINE_URING "io_uring"
+#define IO_ENGINE_QUEUE_DEPTH 128
+#define IO_ENGINE_RING_NUM 4
+/* slots of the sparse fixed buffer table registered on every ring */
+#define IO_ENGINE_FIXED_BUFFERS 256
+#define IO_DIRECT_ALIGN 512
+/* iovecs gathered for one vectored write */
+#define IO_ENGINE_IOV_MAX 64
+
+enum class IoOpcode { READ, WRITE, WRITEV };
+
+struct IoRequest
+{
+    IoOpcode opcode{IoOpcode::READ};
+    int fd{-1};
+    char *buf{nullptr};
+    size_t len{0};
+    /* only for WRITEV */
+    const struct iovec *iov{nullptr};
+    int iovcnt{0};
+    off_t offset{0};
+    /* fd is opened with O_DIRECT, buffer and range get aligned by the engine */
+    bool direct{false};
+    /* bytes transferred, or -errno */
+    ssize_t result{0};
+};
+
+/*
+ * Local file I/O engine of the store. Requests of a batch are submitted together and the call returns when all
+ * of them completed, the result of each request is stored in it. A read or write completed short is submitted again
+ * for the rest. The pread engine is the default and the fallback when io_uring is not built in or can not be set up.
+ */
+class IoEngine {
+  public:
+    static IoEngine &GetInstance() { return *engine; }
+    static int Init(const std::string &type, uint32_t queueDepth = IO_ENGINE_QUEUE_DEPTH);
+
+    virtual ~IoEngine() = default;
+    virtual const char *Name() = 0;
+    /*
+     * pin a long living buffer, e.g. a MemPool block, so later requests on it skip the page mapping. Registering a
+     * buffer again is cheap, it stays registered until UnregisterBuffer before its memory is released.
+     */
+    virtual int RegisterBuffer(void * /*buf*/, size_t /*len*/) { return 0; }
+    virtual void UnregisterBuffer(void * /*buf*/) {}
+
+    int Submit(IoRequest *reqs, size_t num);
+    ssize_t Read(int fd, char *buf, size_t len, off_t offset, bool direct = false);
+    ssize_t Write(int fd, const char *buf, size_t len, off_t offset, bool direct = false);
+    ssize_t Writev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+  protected:
+    virtual int DoSubmit(IoRequest *reqs, size_t num) = 0;
+
+  private:
+    int SubmitFully(IoRequest *reqs, size_t num);
+
+    static std::unique_ptr<IoEngine> engine;
+};
+
+class PreadIoEngine : public IoEngine {
+  public:
+    const char *Name() override { return IO_ENGINE_PREAD; }
+
+  protected:
+    int DoSubmit(IoRequest *reqs, size_t num) override;
+};
+
+#ifdef WITH_IO_URING
+/*
+ * io_uring engine. Callers are spread over a few rings by thread, a batch is queued under the ring's submit lock
+ * with a single io_uring_submit, and a reaper thread per ring completes the waiting callers. Buffers registered
+ * through RegisterBuffer are read and written with the fixed opcodes.
+ */
+class UringIoEngine : public IoEngine {
+  public:
+    explicit UringIoEngine(uint32_t queueDepth = IO_ENGINE_QUEUE_DEPTH, uint32_t ringNum = IO_ENGINE_RING_NUM);
+    ~UringIoEngine() override;
+    int Start();
+    const char *Name() override { return IO_ENGINE_URING; }
+    int RegisterBuffer(void *buf, size_t len) override;
+    void UnregisterBuffer(void *buf) override;
+
+  protected:
+    int DoSubmit(IoRequest *reqs, size_t num) override;
+
+  private:
+    struct Completion
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t pending{0};
+    };
+    struct Task
+    {
+        IoRequest *req{nullptr};
+        Completion *completion{nullptr};
+    };
+    struct Ring
+    {
+        struct io_uring ring;
+        bool inited{false};
+        std::mutex submitMutex;
+        std::thread reaper;
+    };
+    struct FixedBuffer
+    {
+        size_t len{0};
+        int index{-1};
+    };
+
+    Ring &PickRing();
+    void PrepTask(struct io_uring_sqe *sqe, Task &task);
+    void ReapWorker(Ring &ring);
+
+    uint32_t queueDepth;
+    uint32_t ringNum;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    /* guards fixedBuffers and freeIndexes */
+    std::shared_mutex bufferMutex;
+    bool fixedEnabled{false};
+    std::map<uintptr_t, FixedBuffer> fixedBuffers;
+    std::vector<int> freeIndexes;
+};
+#endif
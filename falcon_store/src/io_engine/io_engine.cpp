@@ -0,0 +1,264 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "io_engine/io_engine.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+
+#include "log/logging.h"
+
+std::unique_ptr<IoEngine> IoEngine::engine = std::make_unique<PreadIoEngine>();
+
+/*
+ * Select the engine of the store, called once on start before any I/O. io_uring falls back to pread when it is
+ * not built in or the rings can not be set up.
+ */
+int IoEngine::Init(const std::string &type, uint32_t queueDepth)
+{
+    if (type.empty() || type == IO_ENGINE_PREAD) {
+        engine = std::make_unique<PreadIoEngine>();
+        return 0;
+    }
+    if (type != IO_ENGINE_URING) {
+        FALCON_LOG(LOG_ERROR) << "IoEngine::Init(): unknown io engine " << type;
+        return -EINVAL;
+    }
+#ifdef WITH_IO_URING
+    auto uring = std::make_unique<UringIoEngine>(queueDepth);
+    int ret = uring->Start();
+    if (ret == 0) {
+        engine = std::move(uring);
+        return 0;
+    }
+    FALCON_LOG(LOG_WARNING) << "IoEngine::Init(): io_uring start failed: " << strerror(-ret) << ", use pread";
+#else
+    (void)queueDepth;
+    FALCON_LOG(LOG_WARNING) << "IoEngine::Init(): io_uring is not built in, use pread";
+#endif
+    engine = std::make_unique<PreadIoEngine>();
+    return 0;
+}
+
+/*
+ * O_DIRECT needs the buffer, offset and length aligned. Misaligned reads go through an aligned bounce buffer
+ * covering the whole range, misaligned write buffers are copied, the written range is left to the caller.
+ */
+int IoEngine::Submit(IoRequest *reqs, size_t num)
+{
+    struct Bounce
+    {
+        char *buf{nullptr};
+        char *origBuf{nullptr};
+        size_t origLen{0};
+        size_t skip{0};
+    };
+    std::vector<Bounce> bounces;
+    for (size_t i = 0; i < num; ++i) {
+        IoRequest &req = reqs[i];
+        if (!req.direct || req.opcode == IoOpcode::WRITEV) {
+            continue;
+        }
+        size_t skip = req.opcode == IoOpcode::READ ? req.offset % IO_DIRECT_ALIGN : 0;
+        size_t alignedLen = (skip + req.len + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN * IO_DIRECT_ALIGN;
+        bool misaligned = (uintptr_t)req.buf % IO_DIRECT_ALIGN != 0 ||
+                          (req.opcode == IoOpcode::READ && (skip != 0 || req.len % IO_DIRECT_ALIGN != 0));
+        if (!misaligned) {
+            continue;
+        }
+        if (bounces.empty()) {
+            bounces.resize(num);
+        }
+        char *buf = (char *)aligned_alloc(IO_DIRECT_ALIGN, alignedLen);
+        if (buf == nullptr) {
+            FALCON_LOG(LOG_ERROR) << "IoEngine::Submit(): aligned_alloc failed";
+            for (size_t j = 0; j < i; ++j) {
+                if (bounces[j].buf != nullptr) {
+                    reqs[j].buf = bounces[j].origBuf;
+                    reqs[j].len = bounces[j].origLen;
+                    reqs[j].offset += bounces[j].skip;
+                    free(bounces[j].buf);
+                }
+            }
+            return -ENOMEM;
+        }
+        bounces[i] = {buf, req.buf, req.len, skip};
+        if (req.opcode == IoOpcode::WRITE) {
+            (void)memcpy(buf, req.buf, req.len);
+        } else {
+            req.offset -= skip;
+            req.len = alignedLen;
+        }
+        req.buf = buf;
+    }
+
+    int ret = SubmitFully(reqs, num);
+
+    for (size_t i = 0; i < bounces.size(); ++i) {
+        Bounce &bounce = bounces[i];
+        if (bounce.buf == nullptr) {
+            continue;
+        }
+        IoRequest &req = reqs[i];
+        if (req.opcode == IoOpcode::READ && req.result >= 0) {
+            ssize_t dataLen = std::clamp<ssize_t>(req.result - (ssize_t)bounce.skip, 0, bounce.origLen);
+            (void)memcpy(bounce.origBuf, bounce.buf + bounce.skip, dataLen);
+            req.result = dataLen;
+        }
+        req.buf = bounce.origBuf;
+        req.len = bounce.origLen;
+        req.offset += bounce.skip;
+        free(bounce.buf);
+    }
+    return ret;
+}
+
+/* bytes the request moves, a WRITEV adds up its vectors */
+static size_t RequestLength(const IoRequest &req)
+{
+    if (req.opcode != IoOpcode::WRITEV) {
+        return req.len;
+    }
+    size_t len = 0;
+    for (int i = 0; i < req.iovcnt; ++i) {
+        len += req.iov[i].iov_len;
+    }
+    return len;
+}
+
+static bool IsShort(const IoRequest &req)
+{
+    if (req.result <= 0 || (size_t)req.result >= RequestLength(req)) {
+        return false;
+    }
+    /* O_DIRECT only stops off the alignment at the end of the file */
+    return !req.direct || req.result % IO_DIRECT_ALIGN == 0;
+}
+
+/* move the request past done bytes, the vectors of a WRITEV are copied to iov before they are trimmed */
+static void SkipDone(IoRequest &req, std::vector<struct iovec> &iov, size_t done)
+{
+    req.offset += done;
+    if (req.opcode != IoOpcode::WRITEV) {
+        req.buf += done;
+        req.len -= done;
+        return;
+    }
+    if (iov.empty()) {
+        iov.assign(req.iov, req.iov + req.iovcnt);
+    }
+    size_t skip = 0;
+    while (skip < iov.size() && done >= iov[skip].iov_len) {
+        done -= iov[skip++].iov_len;
+    }
+    iov.erase(iov.begin(), iov.begin() + skip);
+    if (!iov.empty()) {
+        iov.front().iov_base = (char *)iov.front().iov_base + done;
+        iov.front().iov_len -= done;
+    }
+    req.iov = iov.data();
+    req.iovcnt = iov.size();
+}
+
+/*
+ * Run the batch until every request completed. The rest of a short read or write, e.g. one interrupted by a
+ * signal, is submitted again until it is done, fails or a read reaches the end of file. A failure after some bytes
+ * were moved reports those bytes, like pread does.
+ */
+int IoEngine::SubmitFully(IoRequest *reqs, size_t num)
+{
+    int ret = DoSubmit(reqs, num);
+    if (ret < 0) {
+        return ret;
+    }
+    std::vector<IoRequest> rests;
+    std::vector<size_t> owners;
+    std::vector<std::vector<struct iovec>> iovs;
+    for (size_t i = 0; i < num; ++i) {
+        if (IsShort(reqs[i])) {
+            rests.push_back(reqs[i]);
+            owners.push_back(i);
+            SkipDone(rests.back(), iovs.emplace_back(), reqs[i].result);
+        }
+    }
+    while (!rests.empty()) {
+        ret = DoSubmit(rests.data(), rests.size());
+        if (ret < 0) {
+            return ret;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < rests.size(); ++i) {
+            if (rests[i].result <= 0) {
+                continue;
+            }
+            reqs[owners[i]].result += rests[i].result;
+            if (!IsShort(rests[i])) {
+                continue;
+            }
+            SkipDone(rests[i], iovs[i], rests[i].result);
+            if (kept != i) {
+                rests[kept] = rests[i];
+                owners[kept] = owners[i];
+                /* the moved vector keeps its storage, so the iov of the request stays valid */
+                iovs[kept] = std::move(iovs[i]);
+            }
+            ++kept;
+        }
+        rests.resize(kept);
+        owners.resize(kept);
+        iovs.resize(kept);
+    }
+    return 0;
+}
+
+ssize_t IoEngine::Read(int fd, char *buf, size_t len, off_t offset, bool direct)
+{
+    IoRequest req{.opcode = IoOpcode::READ, .fd = fd, .buf = buf, .len = len, .offset = offset, .direct = direct};
+    int ret = Submit(&req, 1);
+    return ret < 0 ? ret : req.result;
+}
+
+ssize_t IoEngine::Write(int fd, const char *buf, size_t len, off_t offset, bool direct)
+{
+    IoRequest req{
+        .opcode = IoOpcode::WRITE, .fd = fd, .buf = const_cast<char *>(buf), .len = len, .offset = offset,
+        .direct = direct};
+    int ret = Submit(&req, 1);
+    return ret < 0 ? ret : req.result;
+}
+
+ssize_t IoEngine::Writev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+    IoRequest req{.opcode = IoOpcode::WRITEV, .fd = fd, .iov = iov, .iovcnt = iovcnt, .offset = offset};
+    int ret = Submit(&req, 1);
+    return ret < 0 ? ret : req.result;
+}
+
+/*---------------------- pread ----------------------*/
+
+int PreadIoEngine::DoSubmit(IoRequest *reqs, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        IoRequest &req = reqs[i];
+        ssize_t ret = 0;
+        do {
+            switch (req.opcode) {
+            case IoOpcode::READ:
+                ret = pread(req.fd, req.buf, req.len, req.offset);
+                break;
+            case IoOpcode::WRITE:
+                ret = pwrite(req.fd, req.buf, req.len, req.offset);
+                break;
+            case IoOpcode::WRITEV:
+                ret = pwritev(req.fd, req.iov, req.iovcnt, req.offset);
+                break;
+            }
+        } while (ret < 0 && errno == EINTR);
+        req.result = ret < 0 ? -errno : ret;
+    }
+    return 0;
+}
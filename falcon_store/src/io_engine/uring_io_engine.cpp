@@ -0,0 +1,258 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifdef WITH_IO_URING
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <functional>
+
+#include "io_engine/io_engine.h"
+#include "log/logging.h"
+
+UringIoEngine::UringIoEngine(uint32_t queueDepth, uint32_t ringNum)
+    : queueDepth(queueDepth),
+      ringNum(ringNum)
+{
+}
+
+UringIoEngine::~UringIoEngine()
+{
+    for (auto &ring : rings) {
+        if (!ring->inited) {
+            continue;
+        }
+        /* a nop without task stops the reaper after everything queued before it */
+        {
+            std::lock_guard<std::mutex> lock(ring->submitMutex);
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&ring->ring);
+            while (sqe == nullptr) {
+                io_uring_submit(&ring->ring);
+                sched_yield();
+                sqe = io_uring_get_sqe(&ring->ring);
+            }
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+            while (io_uring_submit(&ring->ring) < 0) {
+                sched_yield();
+            }
+        }
+        if (ring->reaper.joinable()) {
+            ring->reaper.join();
+        }
+        io_uring_queue_exit(&ring->ring);
+    }
+}
+
+int UringIoEngine::Start()
+{
+    for (uint32_t i = 0; i < ringNum; ++i) {
+        auto ring = std::make_unique<Ring>();
+        int ret = io_uring_queue_init(queueDepth, &ring->ring, 0);
+        if (ret < 0) {
+            FALCON_LOG(LOG_ERROR) << "UringIoEngine::Start(): io_uring_queue_init failed: " << strerror(-ret);
+            return ret;
+        }
+        ring->inited = true;
+        rings.emplace_back(std::move(ring));
+    }
+
+    /* fixed buffers need a sparse table on every ring, without it requests use plain read/write */
+    fixedEnabled = true;
+    for (auto &ring : rings) {
+        if (io_uring_register_buffers_sparse(&ring->ring, IO_ENGINE_FIXED_BUFFERS) < 0) {
+            fixedEnabled = false;
+            break;
+        }
+    }
+    if (fixedEnabled) {
+        for (int i = IO_ENGINE_FIXED_BUFFERS - 1; i >= 0; --i) {
+            freeIndexes.push_back(i);
+        }
+    } else {
+        FALCON_LOG(LOG_WARNING) << "UringIoEngine::Start(): fixed buffers are not supported";
+    }
+
+    for (auto &ring : rings) {
+        ring->reaper = std::thread(&UringIoEngine::ReapWorker, this, std::ref(*ring));
+    }
+    FALCON_LOG(LOG_INFO) << "UringIoEngine started, rings: " << ringNum << ", queue depth: " << queueDepth;
+    return 0;
+}
+
+int UringIoEngine::RegisterBuffer(void *buf, size_t len)
+{
+    if (!fixedEnabled) {
+        return 0;
+    }
+    {
+        /* a reused block is registered already, skip the update of every ring */
+        std::shared_lock<std::shared_mutex> slock(bufferMutex);
+        if (fixedBuffers.contains((uintptr_t)buf)) {
+            return 0;
+        }
+    }
+    std::unique_lock<std::shared_mutex> xlock(bufferMutex);
+    if (!fixedEnabled || freeIndexes.empty() || fixedBuffers.contains((uintptr_t)buf)) {
+        return 0;
+    }
+    int index = freeIndexes.back();
+    struct iovec iov{buf, len};
+    for (auto &ring : rings) {
+        int ret = io_uring_register_buffers_update_tag(&ring->ring, index, &iov, nullptr, 1);
+        if (ret < 0) {
+            FALCON_LOG(LOG_ERROR) << "UringIoEngine::RegisterBuffer(): register failed: " << strerror(-ret);
+            struct iovec empty{nullptr, 0};
+            for (auto &done : rings) {
+                if (done == ring) {
+                    break;
+                }
+                io_uring_register_buffers_update_tag(&done->ring, index, &empty, nullptr, 1);
+            }
+            return ret;
+        }
+    }
+    freeIndexes.pop_back();
+    fixedBuffers[(uintptr_t)buf] = {len, index};
+    return 0;
+}
+
+/*
+ * Called before the buffer is freed, no request on it may be in flight
+ */
+void UringIoEngine::UnregisterBuffer(void *buf)
+{
+    std::unique_lock<std::shared_mutex> xlock(bufferMutex);
+    auto it = fixedBuffers.find((uintptr_t)buf);
+    if (it == fixedBuffers.end()) {
+        return;
+    }
+    struct iovec empty{nullptr, 0};
+    for (auto &ring : rings) {
+        io_uring_register_buffers_update_tag(&ring->ring, it->second.index, &empty, nullptr, 1);
+    }
+    freeIndexes.push_back(it->second.index);
+    fixedBuffers.erase(it);
+}
+
+UringIoEngine::Ring &UringIoEngine::PickRing()
+{
+    static thread_local size_t slot = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return *rings[slot % rings.size()];
+}
+
+void UringIoEngine::PrepTask(struct io_uring_sqe *sqe, Task &task)
+{
+    IoRequest &req = *task.req;
+    int fixedIndex = -1;
+    if (req.opcode != IoOpcode::WRITEV && fixedEnabled) {
+        std::shared_lock<std::shared_mutex> slock(bufferMutex);
+        auto it = fixedBuffers.upper_bound((uintptr_t)req.buf);
+        if (it != fixedBuffers.begin()) {
+            --it;
+            if ((uintptr_t)req.buf + req.len <= it->first + it->second.len) {
+                fixedIndex = it->second.index;
+            }
+        }
+    }
+    switch (req.opcode) {
+    case IoOpcode::READ:
+        if (fixedIndex >= 0) {
+            io_uring_prep_read_fixed(sqe, req.fd, req.buf, req.len, req.offset, fixedIndex);
+        } else {
+            io_uring_prep_read(sqe, req.fd, req.buf, req.len, req.offset);
+        }
+        break;
+    case IoOpcode::WRITE:
+        if (fixedIndex >= 0) {
+            io_uring_prep_write_fixed(sqe, req.fd, req.buf, req.len, req.offset, fixedIndex);
+        } else {
+            io_uring_prep_write(sqe, req.fd, req.buf, req.len, req.offset);
+        }
+        break;
+    case IoOpcode::WRITEV:
+        io_uring_prep_writev(sqe, req.fd, req.iov, req.iovcnt, req.offset);
+        break;
+    }
+    io_uring_sqe_set_data(sqe, &task);
+}
+
+/*
+ * Queue the whole batch with as few io_uring_submit calls as the ring size allows, then wait for the reaper
+ */
+int UringIoEngine::DoSubmit(IoRequest *reqs, size_t num)
+{
+    if (num == 0) {
+        return 0;
+    }
+    Completion completion;
+    completion.pending = num;
+    std::vector<Task> tasks(num);
+    Ring &ring = PickRing();
+    {
+        std::lock_guard<std::mutex> lock(ring.submitMutex);
+        for (size_t i = 0; i < num; ++i) {
+            tasks[i] = {&reqs[i], &completion};
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&ring.ring);
+            while (sqe == nullptr) {
+                /* submission queue full, flush it */
+                io_uring_submit(&ring.ring);
+                sqe = io_uring_get_sqe(&ring.ring);
+                if (sqe == nullptr) {
+                    sched_yield();
+                }
+            }
+            PrepTask(sqe, tasks[i]);
+        }
+        /* queued sqes can not be withdrawn, keep trying until the kernel takes them */
+        int ret = io_uring_submit(&ring.ring);
+        while (ret < 0) {
+            if (ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                FALCON_LOG(LOG_ERROR) << "UringIoEngine::DoSubmit(): io_uring_submit failed: " << strerror(-ret);
+            }
+            sched_yield();
+            ret = io_uring_submit(&ring.ring);
+        }
+    }
+
+    std::unique_lock<std::mutex> xlock(completion.mutex);
+    completion.cv.wait(xlock, [&completion]() { return completion.pending == 0; });
+    return 0;
+}
+
+void UringIoEngine::ReapWorker(Ring &ring)
+{
+    bool stop = false;
+    while (!stop) {
+        struct io_uring_cqe *cqe = nullptr;
+        int ret = io_uring_wait_cqe(&ring.ring, &cqe);
+        if (ret < 0) {
+            if (ret != -EINTR) {
+                FALCON_LOG(LOG_ERROR) << "UringIoEngine::ReapWorker(): wait cqe failed: " << strerror(-ret);
+            }
+            continue;
+        }
+        unsigned head = 0;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&ring.ring, head, cqe)
+        {
+            ++count;
+            Task *task = (Task *)io_uring_cqe_get_data(cqe);
+            if (task == nullptr) {
+                stop = true;
+                continue;
+            }
+            task->req->result = cqe->res;
+            Completion *completion = task->completion;
+            std::lock_guard<std::mutex> lock(completion->mutex);
+            if (--completion->pending == 0) {
+                completion->cv.notify_one();
+            }
+        }
+        io_uring_cq_advance(&ring.ring, count);
+    }
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <queue>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 #include "conf/falcon_property_key.h"
 #include "error_code.h"
@@ -395,6 +396,24 @@ static int Stat(const char *path, struct stat *stbuf)
     int ret = FalconGetStat(path, stbuf);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
+static PyObject* StatToDict(const struct stat& stbuf)
+{
+    PyObject* dict = PyDict_New();
+    PyDict_SetItem(dict, PyUnicode_FromString("st_dev"), PyLong_FromLong(stbuf.st_dev));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_ino"), PyLong_FromLong(stbuf.st_ino));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_nlink"), PyLong_FromLong(stbuf.st_nlink));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_mode"), PyLong_FromLong(stbuf.st_mode));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_uid"), PyLong_FromLong(stbuf.st_uid));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_gid"), PyLong_FromLong(stbuf.st_gid));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_rdev"), PyLong_FromLong(stbuf.st_rdev));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_size"), PyLong_FromLong(stbuf.st_size));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_blksize"), PyLong_FromLong(stbuf.st_blksize));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_blocks"), PyLong_FromLong(stbuf.st_blocks));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_atime"), PyLong_FromLong(stbuf.st_atime));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_mtime"), PyLong_FromLong(stbuf.st_mtime));
+    PyDict_SetItem(dict, PyUnicode_FromString("st_ctime"), PyLong_FromLong(stbuf.st_ctime));
+    return dict;
+}
 static PyObject* PyWrapper_Stat(PyObject* self, PyObject* args) 
 {
     char* path = nullptr;
@@ -413,24 +432,7 @@ static PyObject* PyWrapper_Stat(PyObject* self, PyObject* args)
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    if (ret == 0)
-    {
-        PyDict_SetItem(dict, PyUnicode_FromString("st_dev"), PyLong_FromLong(stbuf.st_dev));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_ino"), PyLong_FromLong(stbuf.st_ino));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_nlink"), PyLong_FromLong(stbuf.st_nlink));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_mode"), PyLong_FromLong(stbuf.st_mode));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_uid"), PyLong_FromLong(stbuf.st_uid));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_gid"), PyLong_FromLong(stbuf.st_gid));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_rdev"), PyLong_FromLong(stbuf.st_rdev));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_size"), PyLong_FromLong(stbuf.st_size));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_blksize"), PyLong_FromLong(stbuf.st_blksize));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_blocks"), PyLong_FromLong(stbuf.st_blocks));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_atime"), PyLong_FromLong(stbuf.st_atime));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_mtime"), PyLong_FromLong(stbuf.st_mtime));
-        PyDict_SetItem(dict, PyUnicode_FromString("st_ctime"), PyLong_FromLong(stbuf.st_ctime));
-    }
-    
+    PyObject* dict = ret == 0 ? StatToDict(stbuf) : PyDict_New();
     return Py_BuildValue("(iN)", ret, dict);
 }
 
@@ -536,6 +538,183 @@ static PyObject* PyWrapper_ReadDir(PyObject* self, PyObject* args)
     return Py_BuildValue("(iN)", ret, list);
 }
 
+static void BatchGet(const std::vector<std::string>& paths, std::vector<Py_buffer>& buffers, std::vector<int>& rets)
+{
+    FalconStats::GetInstance().stats[META_OPEN].fetch_add(paths.size());
+    std::vector<uint64_t> fds;
+    std::vector<int> openRets;
+    {
+        StatFuseTimer t;
+        FalconBatchOpen(paths, O_RDONLY, fds, openRets);
+    }
+
+    rets.assign(paths.size(), 0);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (openRets[i] != 0)
+        {
+            rets[i] = openRets[i] > 0 ? -ErrorCodeToErrno(openRets[i]) : openRets[i];
+            continue;
+        }
+        int readSize = Read(paths[i].c_str(), fds[i], (char*)buffers[i].buf, buffers[i].len, 0);
+        int ret = Close(paths[i].c_str(), fds[i]);
+        rets[i] = readSize < 0 ? readSize : (ret != 0 ? ret : readSize);
+    }
+}
+static PyObject* PyWrapper_BatchGet(PyObject* self, PyObject* args)
+{
+    PyObject* pathList = nullptr;
+    PyObject* bufferList = nullptr;
+    if (!PyArg_ParseTuple(args, "O!O!", &PyList_Type, &pathList, &PyList_Type, &bufferList))
+        return NULL;
+    Py_ssize_t num = PyList_Size(pathList);
+    if (PyList_Size(bufferList) != num)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "the number of buffers does not match the number of paths.");
+        return NULL;
+    }
+
+    std::vector<std::string> paths;
+    std::vector<Py_buffer> buffers;
+    auto releaseBuffers = [&buffers]()
+    {
+        for (Py_buffer& buffer : buffers)
+            PyBuffer_Release(&buffer);
+    };
+    for (Py_ssize_t i = 0; i < num; ++i)
+    {
+        const char* path = PyUnicode_AsUTF8(PyList_GetItem(pathList, i));
+        if (path == nullptr)
+        {
+            releaseBuffers();
+            return NULL;
+        }
+        Py_buffer buffer;
+        if (PyObject_GetBuffer(PyList_GetItem(bufferList, i), &buffer, PyBUF_WRITABLE) != 0)
+        {
+            releaseBuffers();
+            return NULL;
+        }
+        paths.emplace_back(path);
+        buffers.push_back(buffer);
+    }
+
+    std::vector<int> rets;
+    try
+    {
+        BatchGet(paths, buffers, rets);
+    }
+    catch (const std::exception& e)
+    {
+        releaseBuffers();
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+    releaseBuffers();
+
+    PyObject* list = PyList_New(num);
+    for (Py_ssize_t i = 0; i < num; ++i)
+        PyList_SET_ITEM(list, i, PyLong_FromLong(rets[i]));
+    return list;
+}
+
+static bool PathListToVector(PyObject* pathList, std::vector<std::string>& paths)
+{
+    Py_ssize_t num = PyList_Size(pathList);
+    for (Py_ssize_t i = 0; i < num; ++i)
+    {
+        const char* path = PyUnicode_AsUTF8(PyList_GetItem(pathList, i));
+        if (path == nullptr)
+            return false;
+        paths.emplace_back(path);
+    }
+    return true;
+}
+static PyObject* RetsToList(const std::vector<int>& rets)
+{
+    PyObject* list = PyList_New(rets.size());
+    for (size_t i = 0; i < rets.size(); ++i)
+        PyList_SET_ITEM(list, i, PyLong_FromLong(rets[i] > 0 ? -ErrorCodeToErrno(rets[i]) : rets[i]));
+    return list;
+}
+
+static PyObject* PyWrapper_BatchStat(PyObject* self, PyObject* args)
+{
+    PyObject* pathList = nullptr;
+    if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &pathList))
+        return NULL;
+    std::vector<std::string> paths;
+    if (!PathListToVector(pathList, paths))
+        return NULL;
+
+    std::vector<struct stat> stbufs;
+    std::vector<int> rets;
+    try
+    {
+        FalconStats::GetInstance().stats[META_STAT].fetch_add(paths.size());
+        StatFuseTimer t;
+        FalconBatchStat(paths, stbufs, rets);
+    }
+    catch (const std::exception& e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+
+    PyObject* statList = PyList_New(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+        PyList_SET_ITEM(statList, i, rets[i] == 0 ? StatToDict(stbufs[i]) : PyDict_New());
+    return Py_BuildValue("(NN)", RetsToList(rets), statList);
+}
+
+static PyObject* PyWrapper_BatchCreate(PyObject* self, PyObject* args)
+{
+    PyObject* pathList = nullptr;
+    if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &pathList))
+        return NULL;
+    std::vector<std::string> paths;
+    if (!PathListToVector(pathList, paths))
+        return NULL;
+
+    std::vector<int> rets;
+    try
+    {
+        FalconStats::GetInstance().stats[META_CREATE].fetch_add(paths.size());
+        StatFuseTimer t;
+        FalconBatchCreate(paths, rets);
+    }
+    catch (const std::exception& e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+    return RetsToList(rets);
+}
+
+static PyObject* PyWrapper_BatchUnlink(PyObject* self, PyObject* args)
+{
+    PyObject* pathList = nullptr;
+    if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &pathList))
+        return NULL;
+    std::vector<std::string> paths;
+    if (!PathListToVector(pathList, paths))
+        return NULL;
+
+    std::vector<int> rets;
+    try
+    {
+        FalconStats::GetInstance().stats[META_UNLINK].fetch_add(paths.size());
+        StatFuseTimer t;
+        FalconBatchUnlink(paths, rets);
+    }
+    catch (const std::exception& e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+    return RetsToList(rets);
+}
+
 /* =================== Non-Blocking Methods =======================*/
 class AsyncTaskThreadPool 
 {
@@ -1065,6 +1244,48 @@ static PyMethodDef PyFalconFSInternalMethods[] =
         "  errno (int): Refer to errno in linux\n"
         "  content (list): Contain items which are (name, st_mode)"
     },
+    {
+        "BatchGet", 
+        PyWrapper_BatchGet, 
+        METH_VARARGS, 
+        "Get the contents of many files in FalconFS, small files on the same store node are read together\n"
+        "Parameters:\n"
+        "  paths (list): Target file paths, must start with '/', which corresponding to mount point\n"
+        "  buffers (list): Space to store data of each file, e.g. bytearray of the file size\n"
+        "Returns:\n"
+        "  read sizes (list): read byte size of each file, or errno (negative) refer to errno in linux"
+    },
+    {
+        "BatchStat", 
+        PyWrapper_BatchStat, 
+        METH_VARARGS, 
+        "Stat many files/directories in FalconFS, with one request per metadata server\n"
+        "Parameters:\n"
+        "  paths (list): Target file/directory paths, must start with '/', which corresponding to mount point\n"
+        "Returns:\n"
+        "  errnos (list): errno of each path, refer to errno in linux\n"
+        "  stbufs (list): Info of each target, empty dict for the failed ones"
+    },
+    {
+        "BatchCreate", 
+        PyWrapper_BatchCreate, 
+        METH_VARARGS, 
+        "Create many empty files in FalconFS, with one request per metadata server, the files are not opened\n"
+        "Parameters:\n"
+        "  paths (list): Target file paths, must start with '/', which corresponding to mount point\n"
+        "Returns:\n"
+        "  errnos (list): errno of each path, refer to errno in linux"
+    },
+    {
+        "BatchUnlink", 
+        PyWrapper_BatchUnlink, 
+        METH_VARARGS, 
+        "Remove many files in FalconFS, with one request per metadata server\n"
+        "Parameters:\n"
+        "  paths (list): Target file paths, must start with '/', which corresponding to mount point\n"
+        "Returns:\n"
+        "  errnos (list): errno of each path, refer to errno in linux"
+    },
     {
         "AsyncExists", 
         PyWrapper_AsyncExists, 
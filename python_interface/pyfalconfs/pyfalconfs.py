@@ -71,6 +71,22 @@ class Client:
     def ReadDir(self, path, fd):
         return _pyfalconfs_internal.ReadDir(path, fd)
 
+    @copy_doc_from(_pyfalconfs_internal.BatchGet)
+    def BatchGet(self, paths, buffers):
+        return _pyfalconfs_internal.BatchGet(paths, buffers)
+
+    @copy_doc_from(_pyfalconfs_internal.BatchStat)
+    def BatchStat(self, paths):
+        return _pyfalconfs_internal.BatchStat(paths)
+
+    @copy_doc_from(_pyfalconfs_internal.BatchCreate)
+    def BatchCreate(self, paths):
+        return _pyfalconfs_internal.BatchCreate(paths)
+
+    @copy_doc_from(_pyfalconfs_internal.BatchUnlink)
+    def BatchUnlink(self, paths):
+        return _pyfalconfs_internal.BatchUnlink(paths)
+
 class AsyncConnector:
     @copy_doc_from(_pyfalconfs_internal.Init)
     def __init__(self, workspace, running_config_file):
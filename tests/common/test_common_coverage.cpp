@@ -116,6 +116,14 @@ std::string FullFalconConfigJson()
         "falcon_is_inference": false,
         "falcon_mount_path": "/tmp/falcon_mnt",
         "falcon_to_local": true,
+        "falcon_packed_small_file": false,
+        "falcon_io_engine": "pread",
+        "falcon_readahead_init_blocks": 2,
+        "falcon_readahead_max_blocks": 16,
+        "falcon_readahead_memory": 1024,
+        "falcon_migrate_bandwidth": 100,
+        "falcon_mem_pool_limit": 4096,
+        "falcon_mem_pool_hugepage": false,
         "falcon_log_reserved_num": 3,
         "falcon_log_reserved_time": 5,
         "falcon_stat_max": true,
@@ -832,12 +840,14 @@ TEST(CommonBufferUT, OpenAndDirOpenInstancePublicHelpers)
     EXPECT_TRUE(dirOpenInstance.lastFileNames["127.0.0.2:56040"].empty());
 
     dirOpenInstance.partialEntryVec.push_back("entry");
-    dirOpenInstance.fileModes.push_back(0644);
+    struct stat entryStat {};
+    entryStat.st_mode = 0644;
+    dirOpenInstance.fileStats.push_back(entryStat);
     dirOpenInstance.offset = 3;
     dirOpenInstance.ResetDirOpenInstance();
     EXPECT_TRUE(dirOpenInstance.workers.empty());
     EXPECT_TRUE(dirOpenInstance.partialEntryVec.empty());
-    EXPECT_TRUE(dirOpenInstance.fileModes.empty());
+    EXPECT_TRUE(dirOpenInstance.fileStats.empty());
     EXPECT_TRUE(dirOpenInstance.workingWorkers.empty());
     EXPECT_EQ(dirOpenInstance.offset, 0U);
 }
@@ -1,6 +1,9 @@
 #include "test_metadb_coverage_common.h"
 
+#include "falcon_meta_response_generated.h"
+
 #include <algorithm>
+#include <cstring>
 
 using namespace metadb_test;
 
@@ -96,6 +99,7 @@ TEST(MetadbCoverageUT, SerializedMetaResponseEncodeFlow)
         CLOSE,
         UNLINK,
         READDIR,
+        READDIRPLUS,
         OPENDIR,
         RMDIR,
         RENAME,
@@ -111,6 +115,77 @@ TEST(MetadbCoverageUT, SerializedMetaResponseEncodeFlow)
     }
 }
 
+TEST(MetadbCoverageUT, SerializedReadDirPlusFlow)
+{
+    /*
+     * DT 对应关系:
+     * - TC-DIR-005 READDIR 返回目录项完整。
+     *
+     * 该用例只覆盖 READDIRPLUS 复用 READDIR 参数，且响应中每个目录项都带完整 stat。
+     */
+    SerializedDataGuard param;
+    std::vector<uint8_t> param_bytes = BuildReadDirParam("/roundtrip", 16, 2, "last");
+    char *segment = SerializedDataApplyForSegment(param.get(), param_bytes.size());
+    ASSERT_NE(segment, nullptr);
+    memcpy(segment, param_bytes.data(), param_bytes.size());
+    MetaProcessInfoData decoded{};
+    // TC-DIR-005: READDIRPLUS 解码 READDIR 参数并打上标记。
+    ASSERT_TRUE(SerializedDataMetaParamDecode(READDIRPLUS, 1, param.get(), &decoded));
+    EXPECT_TRUE(decoded.readDirPlus);
+    EXPECT_EQ(decoded.readDirMaxReadCount, 16);
+    EXPECT_EQ(decoded.readDirLastShardIndex, 2);
+    EXPECT_STREQ(decoded.readDirLastFileName, "last");
+    ASSERT_TRUE(SerializedDataMetaParamDecode(READDIR, 1, param.get(), &decoded));
+    EXPECT_FALSE(decoded.readDirPlus);
+
+    char name[] = "child";
+    char dst_name[] = "dst";
+    MetaProcessInfoData info = BuildSampleMetaInfo(name, dst_name);
+    OneReadDirResult child{};
+    child.fileName = "child";
+    child.mode = 0100644;
+    child.inodeId = 77;
+    child.st_nlink = 1;
+    child.st_uid = 1000;
+    child.st_gid = 1001;
+    child.st_size = 8192;
+    child.st_mtim = 102;
+    OneReadDirResult *children[] = {&child};
+    info.readDirLastShardIndex = -1;
+    info.readDirLastFileName = nullptr;
+    info.readDirResultList = children;
+    info.readDirResultCount = 1;
+
+    SerializedDataGuard response;
+    ASSERT_TRUE(SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(READDIRPLUS, 1, &info, response.get()));
+    auto meta_response =
+        falcon::meta_fbs::GetMetaResponse(reinterpret_cast<uint8_t *>(response.get()->buffer) + SERIALIZED_DATA_ALIGNMENT);
+    ASSERT_EQ(meta_response->response_type(), falcon::meta_fbs::AnyMetaResponse_ReadDirPlusResponse);
+    auto result_list = meta_response->response_as_ReadDirPlusResponse()->result_list();
+    ASSERT_EQ(result_list->size(), 1U);
+    // TC-DIR-005: 目录项自带 stat，客户端无需再逐项 STAT。
+    EXPECT_STREQ(result_list->Get(0)->file_name()->c_str(), "child");
+    EXPECT_EQ(result_list->Get(0)->st_ino(), 77U);
+    EXPECT_EQ(result_list->Get(0)->st_mode(), 0100644U);
+    EXPECT_EQ(result_list->Get(0)->st_uid(), 1000U);
+    EXPECT_EQ(result_list->Get(0)->st_gid(), 1001U);
+    EXPECT_EQ(result_list->Get(0)->st_size(), 8192);
+    EXPECT_EQ(result_list->Get(0)->st_mtim(), 102U);
+    // 客户端按服务端下发的租约缓存这些属性。
+    EXPECT_EQ(meta_response->response_as_ReadDirPlusResponse()->lease_ms(), (uint32_t)FalconAttrLeaseMs);
+
+    int old_lease = FalconAttrLeaseMs;
+    FalconAttrLeaseMs = 0;
+    SerializedDataGuard stat_response;
+    ASSERT_TRUE(SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(STAT, 1, &info, stat_response.get()));
+    auto stat_meta_response = falcon::meta_fbs::GetMetaResponse(
+        reinterpret_cast<uint8_t *>(stat_response.get()->buffer) + SERIALIZED_DATA_ALIGNMENT);
+    ASSERT_EQ(stat_meta_response->response_type(), falcon::meta_fbs::AnyMetaResponse_StatResponse);
+    // 租约为 0 时客户端不缓存。
+    EXPECT_EQ(stat_meta_response->response_as_StatResponse()->lease_ms(), 0U);
+    FalconAttrLeaseMs = old_lease;
+}
+
 TEST(MetadbCoverageUT, SerializedMetaSubResponseRoundTripAndErrorFlow)
 {
     /*
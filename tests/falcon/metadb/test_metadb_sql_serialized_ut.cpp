@@ -1,5 +1,7 @@
 #include "test_metadb_coverage_common.h"
 
+#include <sstream>
+
 using namespace metadb_test;
 
 namespace {
@@ -152,6 +154,111 @@ TEST(MetadbCoverageUT, PlainSqlFileCreateStatAndReadDirFlow)
     dfs_shutdown();
 }
 
+TEST(MetadbCoverageUT, PlainSqlParallelReadDirFlow)
+{
+    /*
+     * 覆盖多分片并行 readdir:
+     * - 并行 worker 扫描各本地分片, 结果与串行扫描一致。
+     */
+    SqlConnections connections;
+    if (!PrepareSqlConnections(&connections)) {
+        GTEST_SKIP() << "local-run SQL endpoints are not ready";
+    }
+
+    std::string root = BuildSqlRoot("plain_sql_parallel_readdir");
+    int ret = -1;
+    ASSERT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_mkdir(" + SqlQuote(root) + ")", &ret))
+        << connections.cn->ErrorMessage();
+    ASSERT_EQ(ret, 0);
+    constexpr int fileCount = 64;
+    for (int i = 0; i < fileCount; ++i) {
+        std::string file = fmt::format("{}/parallel_file_{}", root, i);
+        EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_create(" + SqlQuote(file) + ")", &ret));
+        EXPECT_EQ(ret, 0);
+    }
+
+    auto readDir = [&](const char *workers) {
+        std::string setting;
+        EXPECT_TRUE(connections.worker->ScalarText(
+            fmt::format("SELECT set_config('falcon.readdir_parallel_workers', '{}', false)", workers), &setting))
+            << connections.worker->ErrorMessage();
+        // fan out after the first few rows, a directory this small is read serially by default
+        EXPECT_TRUE(connections.worker->ScalarText(
+            "SELECT set_config('falcon.readdir_parallel_min_rows', '8', false)", &setting))
+            << connections.worker->ErrorMessage();
+        std::string entries;
+        EXPECT_TRUE(connections.worker->ScalarText("SELECT falcon_plain_readdir(" + SqlQuote(root) + ")", &entries))
+            << connections.worker->ErrorMessage();
+        std::vector<std::string> names;
+        std::istringstream stream(entries);
+        for (std::string name; stream >> name;) {
+            names.push_back(name);
+        }
+        return names;
+    };
+    std::vector<std::string> serial = readDir("0");
+    std::vector<std::string> parallel = readDir("4");
+    EXPECT_EQ(serial.size(), static_cast<size_t>(fileCount));
+    EXPECT_EQ(parallel, serial);
+
+    for (int i = 0; i < fileCount; ++i) {
+        EXPECT_EQ(dfs_unlink(fmt::format("{}/parallel_file_{}", root, i).c_str()), 0);
+    }
+    EXPECT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_rmdir(" + SqlQuote(root) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+    dfs_shutdown();
+}
+
+TEST(MetadbCoverageUT, PlainSqlDeepPathPrefixCacheFlow)
+{
+    /*
+     * 覆盖多级路径的前缀缓存:
+     * - 同一父目录下重复 stat 命中缓存的父路径;
+     * - 中间目录删除重建后, 缓存中失效的父路径不会解析到旧 inode。
+     */
+    SqlConnections connections;
+    if (!PrepareSqlConnections(&connections)) {
+        GTEST_SKIP() << "local-run SQL endpoints are not ready";
+    }
+
+    std::string root = BuildSqlRoot("plain_sql_prefix");
+    std::string middle = fmt::format("{}/level_1", root);
+    std::string leaf = fmt::format("{}/level_2", middle);
+    std::string file = fmt::format("{}/prefix_file", leaf);
+    int ret = -1;
+    for (const std::string &dir : {root, middle, leaf}) {
+        ASSERT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_mkdir(" + SqlQuote(dir) + ")", &ret))
+            << connections.cn->ErrorMessage();
+        ASSERT_EQ(ret, 0);
+    }
+    EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_create(" + SqlQuote(file) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_stat(" + SqlQuote(file) + ")", &ret));
+        EXPECT_EQ(ret, 0);
+    }
+
+    // 删除并重建最深一级目录, 旧文件不可见, 新文件可见。
+    EXPECT_EQ(dfs_unlink(file.c_str()), 0);
+    EXPECT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_rmdir(" + SqlQuote(leaf) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+    EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_stat(" + SqlQuote(file) + ")", &ret));
+    EXPECT_NE(ret, 0);
+    EXPECT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_mkdir(" + SqlQuote(leaf) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+    EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_create(" + SqlQuote(file) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+    EXPECT_TRUE(connections.worker->ScalarInt("SELECT falcon_plain_stat(" + SqlQuote(file) + ")", &ret));
+    EXPECT_EQ(ret, 0);
+
+    EXPECT_EQ(dfs_unlink(file.c_str()), 0);
+    for (const std::string &dir : {leaf, middle, root}) {
+        EXPECT_TRUE(connections.cn->ScalarInt("SELECT falcon_plain_rmdir(" + SqlQuote(dir) + ")", &ret));
+        EXPECT_EQ(ret, 0);
+    }
+    dfs_shutdown();
+}
+
 TEST(MetadbCoverageUT, DirPathHashSqlLockAndPrintFlow)
 {
     SqlConnections connections;
@@ -189,6 +296,16 @@ TEST(MetadbCoverageUT, DirPathHashSqlLockAndPrintFlow)
         << connections.cn->ErrorMessage();
     ASSERT_GE(parent_id, 0);
 
+    int cache_capacity = 0;
+    int cache_entries = -1;
+    ASSERT_TRUE(connections.cn->ScalarInt("SELECT capacity FROM falcon_dir_path_cache_stats()", &cache_capacity))
+        << connections.cn->ErrorMessage();
+    EXPECT_GT(cache_capacity, 0);
+    ASSERT_TRUE(connections.cn->ScalarInt("SELECT entries FROM falcon_dir_path_cache_stats()", &cache_entries))
+        << connections.cn->ErrorMessage();
+    EXPECT_GE(cache_entries, count);
+    EXPECT_LE(cache_entries, cache_capacity);
+
     EXPECT_FALSE(connections.cn->ScalarInt("SELECT falcon_acquire_hash_lock(" + SqlQuote(hash_file_name) +
                                               "::cstring, " +
                                               std::to_string(parent_id) + ", 1)",
@@ -402,6 +519,12 @@ TEST(MetadbCoverageUT, SerializedDirectoryFileAttributeFlow)
         << connections.worker->ErrorMessage();
     EXPECT_TRUE(connections.worker->SerializedCall(READDIR, BuildReadDirParam(root, 1, -1, ""), &response_size))
         << connections.worker->ErrorMessage();
+    int plus_response_size = 0;
+    // TC-DIR-005: READDIRPLUS 返回同样的目录项并附带 stat，响应不小于 READDIR。
+    EXPECT_TRUE(
+        connections.worker->SerializedCall(READDIRPLUS, BuildReadDirParam(root, 1, -1, ""), &plus_response_size))
+        << connections.worker->ErrorMessage();
+    EXPECT_GE(plus_response_size, response_size);
 
     // TC-FILE-006 / TC-DIR-006: serialized 入口清理文件和目录。
     EXPECT_TRUE(connections.worker->SerializedCall(UNLINK, BuildPathOnlyParam(file), &response_size))
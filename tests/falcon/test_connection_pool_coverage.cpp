@@ -12,6 +12,7 @@
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base_comm_adapter/base_meta_service_job.h"
@@ -28,6 +29,12 @@ int FalconConnectionPoolBatchSize = 4;
 int FalconConnectionPoolWaitAdjust = 1;
 int FalconConnectionPoolWaitMin = 1;
 int FalconConnectionPoolWaitMax = 512;
+int FalconConnectionPoolDispatcherNum = 2;
+int FalconConnectionPoolBatchLatencySlo = 2000;
+char *FalconConnectionPoolBatchLatencySloOverride = nullptr;
+int FalconConnectionPoolBatchLingerMax = 200;
+int FalconConnectionPoolPipelineDepth = 2;
+int FalconConnectionPoolShedQueueDepth = 4096;
 uint64_t FalconConnectionPoolShmemSize = 256 * 1024 * 1024;
 char *FalconNodeLocalIp = nullptr;
 char *FalconCommunicationServerIp = nullptr;
@@ -64,6 +71,8 @@ std::deque<FakePgResult *> g_pgResults;
 bool g_querySent = false;
 int g_sendQueryReturn = 1;
 std::string g_pgError;
+std::string g_lastStatement;
+std::vector<std::string> g_lastParams;
 
 void ResetFakePg()
 {
@@ -74,6 +83,8 @@ void ResetFakePg()
     g_querySent = false;
     g_sendQueryReturn = 1;
     g_pgError.clear();
+    g_lastStatement.clear();
+    g_lastParams.clear();
 }
 
 void QueueFakePgResult(FakePgResult *result)
@@ -110,6 +121,23 @@ int PQsendQuery(PGconn *, const char *)
     return g_sendQueryReturn;
 }
 
+int PQsendQueryPrepared(PGconn *conn,
+                        const char *stmtName,
+                        int nParams,
+                        const char *const *paramValues,
+                        const int *paramLengths,
+                        const int *paramFormats,
+                        int)
+{
+    g_lastStatement = stmtName;
+    g_lastParams.clear();
+    for (int i = 0; i < nParams; ++i) {
+        EXPECT_EQ(paramFormats[i], 1);
+        g_lastParams.emplace_back(paramValues[i], paramLengths[i]);
+    }
+    return PQsendQuery(conn, stmtName);
+}
+
 char *PQerrorMessage(const PGconn *)
 {
     return g_pgError.empty() ? const_cast<char *>("fake pg error") : g_pgError.data();
@@ -316,10 +344,15 @@ class FakeMetaServiceJob : public BaseMetaServiceJob {
         return serviceType_;
     }
 
-    void ProcessResponse(void *, size_t, FalDataDeleter) override
+    void ProcessResponse(void *data, size_t size, FalDataDeleter deleter) override
     {
         responseProcessed = true;
         responseCount++;
+        if (deleter) {
+            // a reply lent out of shmem, held like a comm plugin still sending it
+            lentResponses.emplace_back(static_cast<char *>(data), size);
+            lentDeleters.push_back(std::move(deleter));
+        }
     }
 
     bool done{false};
@@ -328,12 +361,16 @@ class FakeMetaServiceJob : public BaseMetaServiceJob {
     inline static int doneCount{0};
     inline static int failedCount{0};
     inline static int responseCount{0};
+    inline static std::vector<std::pair<char *, size_t>> lentResponses;
+    inline static std::vector<FalDataDeleter> lentDeleters;
 
     static void ResetCounters()
     {
         doneCount = 0;
         failedCount = 0;
         responseCount = 0;
+        lentResponses.clear();
+        lentDeleters.clear();
     }
 
   private:
@@ -472,6 +509,8 @@ TEST(ConnectionPoolCoverageUT, SingleWorkerTaskProcessesPlainCommandResult)
     EXPECT_EQ(FakeMetaServiceJob::doneCount, 1);
     EXPECT_EQ(FakeMetaServiceJob::failedCount, 0);
     EXPECT_EQ(FakeMetaServiceJob::responseCount, 1);
+    // plain commands keep the simple query protocol
+    EXPECT_TRUE(g_lastStatement.empty());
 
     SerializedDataDestroy(&replyBuilder);
     ResetFakePg();
@@ -506,6 +545,140 @@ TEST(ConnectionPoolCoverageUT, BatchWorkerTaskHandlesZeroReplyShift)
     ResetFakePg();
 }
 
+TEST(ConnectionPoolCoverageUT, BatchWorkerTaskReportsBatchSizeToSizer)
+{
+    ResetFakePg();
+    FakeMetaServiceJob::ResetCounters();
+    TestAllocator allocator(4 * 1024 * 1024);
+    flatbuffers::FlatBufferBuilder flatBufferBuilder;
+    SerializedData replyBuilder;
+    SerializedDataInit(&replyBuilder, nullptr, 0, 0, nullptr);
+
+    auto *result = new FakePgResult();
+    result->status = PGRES_TUPLES_OK;
+    result->rows = 1;
+    result->cols = 1;
+    result->values = {"0"};
+    QueueFakePgResult(result);
+
+    BatchSizer sizer;
+    sizer.Configure(1000000, 0, 64, 1);
+    int reportedJobs = -1;
+    {
+        std::vector<BaseMetaServiceJob *> jobs{
+            new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+            new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+            new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+        };
+        // same wiring as the dispatcher, DoWork empties the job list before the task reports
+        sizer.Dispatched();
+        BatchWorkerTask task(allocator.get(), jobs, [&](int jobNum, int64_t durationNs) {
+            reportedJobs = jobNum;
+            sizer.Complete(jobNum, durationNs);
+        });
+        EXPECT_NO_THROW(task.DoWork(nullptr, flatBufferBuilder, replyBuilder));
+        EXPECT_EQ(reportedJobs, -1);
+    }
+    EXPECT_EQ(reportedJobs, 3);
+    EXPECT_EQ(FakeMetaServiceJob::doneCount, 3);
+
+    double fixedNs = 0;
+    double perJobNs = 0;
+    sizer.Estimate(fixedNs, perJobNs);
+    EXPECT_GT(perJobNs, 0);
+
+    SerializedDataDestroy(&replyBuilder);
+    ResetFakePg();
+}
+
+TEST(ConnectionPoolCoverageUT, BatchWorkerTasksShareOnePipeline)
+{
+    ResetFakePg();
+    FakeMetaServiceJob::ResetCounters();
+    TestAllocator allocator(4 * 1024 * 1024);
+    flatbuffers::FlatBufferBuilder flatBufferBuilder;
+    SerializedData replyBuilder;
+    SerializedDataInit(&replyBuilder, nullptr, 0, 0, nullptr);
+
+    std::vector<BaseMetaServiceJob *> firstJobs{
+        new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+        new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+    };
+    std::vector<BaseMetaServiceJob *> secondJobs{
+        new FakeMetaServiceJob(FalconMetaServiceType::MKDIR),
+    };
+    BatchWorkerTask first(allocator.get(), firstJobs);
+    BatchWorkerTask second(allocator.get(), secondJobs);
+    EXPECT_TRUE(first.SupportPipeline());
+    // both requests are out before the first reply is read
+    EXPECT_NO_THROW(first.SendRequest(nullptr));
+    // the call goes through the prepared statement with binary parameters, the count in network byte order
+    EXPECT_EQ(g_lastStatement, "cs_meta_call_shmem");
+    ASSERT_EQ(g_lastParams.size(), 5U);
+    EXPECT_EQ(g_lastParams[1], std::string("\0\0\0\2", 4));
+    EXPECT_EQ(g_lastParams[2].size(), sizeof(int64_t));
+    EXPECT_NO_THROW(second.SendRequest(nullptr));
+
+    auto *firstResult = new FakePgResult();
+    firstResult->rows = 1;
+    firstResult->cols = 1;
+    firstResult->values = {"0"};
+    EXPECT_NO_THROW(first.ProcessResult(reinterpret_cast<PGresult *>(firstResult), flatBufferBuilder, replyBuilder));
+    EXPECT_EQ(FakeMetaServiceJob::doneCount, 2);
+
+    // the reply of the second request never came
+    EXPECT_THROW(second.ProcessResult(nullptr, flatBufferBuilder, replyBuilder), std::runtime_error);
+
+    SerializedDataDestroy(&replyBuilder);
+    ResetFakePg();
+}
+
+TEST(ConnectionPoolCoverageUT, BatchWorkerTaskRepliesStraightFromShmem)
+{
+    ResetFakePg();
+    FakeMetaServiceJob::ResetCounters();
+    TestAllocator allocator(4 * 1024 * 1024);
+    flatbuffers::FlatBufferBuilder flatBufferBuilder;
+    SerializedData replyBuilder;
+    SerializedDataInit(&replyBuilder, nullptr, 0, 0, nullptr);
+
+    // the backend answers both jobs in one reply block
+    SerializedData reply;
+    SerializedDataInit(&reply, nullptr, 0, 0, nullptr);
+    std::memcpy(SerializedDataApplyForSegment(&reply, 8), "reply-1", 8);
+    std::memcpy(SerializedDataApplyForSegment(&reply, 8), "reply-2", 8);
+    uint64_t replyShift = FalconShmemAllocatorMalloc(allocator.get(), reply.size);
+    ASSERT_NE(replyShift, 0U);
+    char *replyBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator.get(), replyShift);
+    std::memcpy(replyBuffer, reply.buffer, reply.size);
+    SerializedDataDestroy(&reply);
+
+    auto *result = new FakePgResult();
+    result->rows = 1;
+    result->cols = 1;
+    result->values = {std::to_string(replyShift)};
+    QueueFakePgResult(result);
+
+    std::vector<BaseMetaServiceJob *> jobs{
+        new FakeMetaServiceJob(FalconMetaServiceType::STAT),
+        new FakeMetaServiceJob(FalconMetaServiceType::STAT),
+    };
+    BatchWorkerTask task(allocator.get(), jobs);
+    EXPECT_NO_THROW(task.DoWork(nullptr, flatBufferBuilder, replyBuilder));
+    EXPECT_EQ(FakeMetaServiceJob::doneCount, 2);
+
+    // each job got its own segment of the block, not a copy
+    ASSERT_EQ(FakeMetaServiceJob::lentResponses.size(), 2U);
+    EXPECT_EQ(FakeMetaServiceJob::lentResponses[0].first, replyBuffer);
+    EXPECT_EQ(FakeMetaServiceJob::lentResponses[0].second, SERIALIZED_DATA_ALIGNMENT + 8);
+    EXPECT_EQ(FakeMetaServiceJob::lentResponses[1].first, replyBuffer + SERIALIZED_DATA_ALIGNMENT + 8);
+    EXPECT_STREQ(FakeMetaServiceJob::lentResponses[1].first + SERIALIZED_DATA_ALIGNMENT, "reply-2");
+
+    FakeMetaServiceJob::ResetCounters();
+    SerializedDataDestroy(&replyBuilder);
+    ResetFakePg();
+}
+
 TEST(ConnectionPoolCoverageUT, WorkerTasksConvertPgErrorsToResponses)
 {
     ResetFakePg();
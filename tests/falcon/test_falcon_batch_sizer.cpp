@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "connection_pool/falcon_batch_service_def.h"
+#include "connection_pool/falcon_batch_sizer.h"
+
+#define US 1000LL
+#define MAX_BATCH 512
+#define CONN_NUM 8
+// most connections busy, the case lingering is meant for
+#define IDLE_CONN 2
+
+// feed batches of alternating size so the fixed and per job share of the cost can be told apart
+static void Train(BatchSizer &sizer, double fixedNs, double perJobNs, int rounds = 64)
+{
+    for (int i = 0; i < rounds; ++i) {
+        int jobs = (i % 2 == 0) ? 4 : 64;
+        sizer.Dispatched();
+        sizer.Complete(jobs, (int64_t)(fixedNs + perJobNs * jobs));
+    }
+}
+
+TEST(FalconBatchSizerUT, DisabledTakesFixedBatchSize)
+{
+    BatchSizer sizer;
+    sizer.Configure(0, 200 * US, MAX_BATCH, CONN_NUM);
+    BatchDecision decision = sizer.Decide(10000, 10000, IDLE_CONN, 1000 * US);
+    EXPECT_EQ(decision.batchSize, MAX_BATCH);
+    decision = sizer.Decide(3, 10003, IDLE_CONN, 1001 * US);
+    EXPECT_EQ(decision.batchSize, 3);
+    EXPECT_EQ(decision.lingeredNs, 0);
+}
+
+TEST(FalconBatchSizerUT, FitsFixedAndPerJobCost)
+{
+    BatchSizer sizer;
+    sizer.Configure(2000 * US, 200 * US, MAX_BATCH, CONN_NUM);
+    Train(sizer, 50 * US, 10 * US);
+    double fixedNs = 0;
+    double perJobNs = 0;
+    sizer.Estimate(fixedNs, perJobNs);
+    EXPECT_NEAR(fixedNs, 50 * US, 1 * US);
+    EXPECT_NEAR(perJobNs, 10 * US, 0.1 * US);
+}
+
+TEST(FalconBatchSizerUT, SloBoundsBatchSize)
+{
+    BatchSizer sizer;
+    sizer.Configure(2000 * US, 200 * US, MAX_BATCH, CONN_NUM);
+    Train(sizer, 50 * US, 10 * US);
+    // (2000 - 50) / 10 jobs fit in the SLO
+    BatchDecision decision = sizer.Decide(1000, 1000, IDLE_CONN, 1000 * US);
+    EXPECT_NEAR(decision.targetSize, 195, 1);
+    EXPECT_EQ(decision.batchSize, decision.targetSize);
+
+    // a backlog beyond what all connections take at the SLO size is spread over them
+    decision = sizer.Decide(3200, 4200, IDLE_CONN, 1001 * US);
+    EXPECT_EQ(decision.batchSize, 400);
+    decision = sizer.Decide(100000, 104200, IDLE_CONN, 1002 * US);
+    EXPECT_EQ(decision.batchSize, MAX_BATCH);
+}
+
+TEST(FalconBatchSizerUT, UntrainedTakesWholeQueue)
+{
+    BatchSizer sizer;
+    sizer.Configure(2000 * US, 200 * US, MAX_BATCH, CONN_NUM);
+    BatchDecision decision = sizer.Decide(2, 2, IDLE_CONN, 1000 * US);
+    EXPECT_EQ(decision.batchSize, 2);
+    EXPECT_EQ(decision.lingerUntilNs, 0);
+}
+
+TEST(FalconBatchSizerUT, LingersUnderLoadUntilDeadline)
+{
+    BatchSizer sizer;
+    sizer.Configure(2000 * US, 200 * US, MAX_BATCH, CONN_NUM);
+    Train(sizer, 50 * US, 1 * US);
+    // one job per microsecond keeps arriving while an earlier batch runs
+    sizer.Dispatched();
+    int64_t now = 1000 * US;
+    uint64_t enqueued = 0;
+    sizer.Decide(1, enqueued, IDLE_CONN, now);
+    now += 100 * US;
+    enqueued += 100;
+    BatchDecision decision = sizer.Decide(2, enqueued, IDLE_CONN, now);
+    EXPECT_EQ(decision.batchSize, 0);
+    EXPECT_EQ(decision.lingerUntilNs, now + 200 * US);
+
+    int64_t deadline = decision.lingerUntilNs;
+    now = deadline - 1 * US;
+    decision = sizer.Decide(50, enqueued + 50, IDLE_CONN, now);
+    EXPECT_EQ(decision.batchSize, 50);
+    EXPECT_EQ(decision.lingeredNs, 199 * US);
+
+    // the next short batch starts a new linger
+    decision = sizer.Decide(1, enqueued + 51, IDLE_CONN, now + 1 * US);
+    EXPECT_EQ(decision.batchSize, 0);
+}
+
+TEST(FalconBatchSizerUT, NoLingerWithoutReasonToWait)
+{
+    BatchSizer sizer;
+    sizer.Configure(2000 * US, 200 * US, MAX_BATCH, CONN_NUM);
+    Train(sizer, 50 * US, 1 * US);
+    int64_t now = 1000 * US;
+    sizer.Decide(1, 0, IDLE_CONN, now);
+    now += 100 * US;
+    // nothing in flight, a lone client waits for its own reply
+    EXPECT_EQ(sizer.Decide(1, 100, IDLE_CONN, now).batchSize, 1);
+
+    sizer.Dispatched();
+    // every connection busy, the batch grows while waiting for one anyway
+    EXPECT_EQ(sizer.Decide(1, 100, 0, now + 1 * US).batchSize, 1);
+    // most connections idle, a round trip more costs nothing
+    EXPECT_EQ(sizer.Decide(1, 100, CONN_NUM, now + 1 * US).batchSize, 1);
+    // no linger configured
+    sizer.Configure(2000 * US, 0, MAX_BATCH, CONN_NUM);
+    Train(sizer, 50 * US, 1 * US);
+    sizer.Dispatched();
+    EXPECT_EQ(sizer.Decide(1, 100, IDLE_CONN, now + 2 * US).batchSize, 1);
+}
+
+TEST(FalconBatchSizerUT, NoLingerPastSlo)
+{
+    BatchSizer sizer;
+    // the target batch alone takes almost all of the SLO
+    sizer.Configure(300 * US, 200 * US, 250, CONN_NUM);
+    Train(sizer, 50 * US, 1 * US);
+    sizer.Dispatched();
+    int64_t now = 1000 * US;
+    sizer.Decide(1, 0, IDLE_CONN, now);
+    BatchDecision decision = sizer.Decide(1, 1000, IDLE_CONN, now + 100 * US);
+    EXPECT_GE(decision.targetSize, 249);
+    EXPECT_EQ(decision.batchSize, 1);
+}
+
+TEST(FalconBatchSizerUT, ParsesSloOverride)
+{
+    int64_t sloUs[int(FalconBatchServiceType::NOT_SUPPORT)];
+    std::fill(std::begin(sloUs), std::end(sloUs), 2000);
+    ParseBatchLatencySloOverride(" stat=500, kv_get=300,bogus=1,create=,open=x,slice_del=0", sloUs, std::size(sloUs));
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::STAT)], 500);
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::KV_GET)], 300);
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::CREATE)], 2000);
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::OPEN)], 2000);
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::SLICE_DEL)], 0);
+    ParseBatchLatencySloOverride(nullptr, sloUs, std::size(sloUs));
+    EXPECT_EQ(sloUs[int(FalconBatchServiceType::STAT)], 500);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -292,6 +292,159 @@ TEST_F(ConcurrentQueueTest, ThreadExitCleanup) {
     EXPECT_EQ(queue.active_producer_count(), initial_count);
 }
 
+TEST(MpmcRingQueueTest, BoundedFifo) {
+    MpmcRingQueue<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8);
+    EXPECT_TRUE(ring.empty());
+
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(ring.enqueue(i));
+    }
+    EXPECT_FALSE(ring.enqueue(8));
+    EXPECT_EQ(ring.size_approx(), 8);
+
+    int value;
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(ring.dequeue(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(ring.dequeue(value));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(MpmcRingQueueTest, BulkWrapsAround) {
+    MpmcRingQueue<int> ring(8);
+    std::vector<int> input = {0, 1, 2, 3, 4, 5};
+    std::vector<int> output;
+    auto collect = [&output](int val) { output.push_back(val); };
+
+    EXPECT_EQ(ring.enqueue_bulk(input.begin(), 6), 6);
+    EXPECT_EQ(ring.dequeue_bulk(collect, 4), 4);
+    // 2 left, only 6 of the next 10 fit and they wrap over the end of the ring
+    std::vector<int> more = {6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    EXPECT_EQ(ring.enqueue_bulk(more.begin(), more.size()), 6);
+    EXPECT_EQ(ring.enqueue_bulk(more.begin(), 1), 0);
+    EXPECT_EQ(ring.dequeue_bulk(collect, 100), 8);
+    EXPECT_EQ(output, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+    EXPECT_EQ(ring.dequeue_bulk(collect, 100), 0);
+    EXPECT_EQ(ring.dequeue_bulk(collect, 0), 0);
+}
+
+TEST(MpmcRingQueueTest, ConcurrentProducersConsumers) {
+    constexpr int PRODUCER_COUNT = 8;
+    constexpr int CONSUMER_COUNT = 3;
+    constexpr int ITEMS_PER_PRODUCER = 20000;
+    MpmcRingQueue<int> ring(256);
+
+    std::atomic<int> consumed{0};
+    std::atomic<long long> sum{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < PRODUCER_COUNT; ++i) {
+        threads.emplace_back([&ring, i]() {
+            std::vector<int> burst;
+            for (int j = 0; j < ITEMS_PER_PRODUCER;) {
+                // half of the producers push bursts, all claims share the same positions
+                if (i % 2 == 0) {
+                    burst.clear();
+                    for (int k = 0; k < 16 && j + k < ITEMS_PER_PRODUCER; ++k) {
+                        burst.push_back(j + k);
+                    }
+                    size_t pushed = 0;
+                    while (pushed < burst.size()) {
+                        size_t more = ring.enqueue_bulk(burst.begin() + pushed, burst.size() - pushed);
+                        if (more == 0) {
+                            std::this_thread::yield();
+                        }
+                        pushed += more;
+                    }
+                    j += burst.size();
+                } else if (ring.enqueue(j)) {
+                    ++j;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int i = 0; i < CONSUMER_COUNT; ++i) {
+        threads.emplace_back([&]() {
+            while (consumed.load() < PRODUCER_COUNT * ITEMS_PER_PRODUCER) {
+                size_t got = ring.dequeue_bulk([&sum](int val) { sum += val; }, 32);
+                consumed += got;
+                if (got == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    long long expected = (long long)PRODUCER_COUNT * ITEMS_PER_PRODUCER * (ITEMS_PER_PRODUCER - 1) / 2;
+    EXPECT_EQ(consumed.load(), PRODUCER_COUNT * ITEMS_PER_PRODUCER);
+    EXPECT_EQ(sum.load(), expected);
+    EXPECT_TRUE(ring.empty());
+}
+
+// producers each push items one by one while a single consumer drains with dequeue_bulk, as the pool dispatcher does.
+// Producers stay alive until everything is consumed, thread exit is not part of the measurement.
+template <typename Queue>
+static double ProducerThroughput(Queue &queue, int producers, int itemsPerProducer) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> drained{false};
+    std::atomic<int> consumed{0};
+    int total = producers * itemsPerProducer;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&queue, &go, &drained, itemsPerProducer]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (int j = 0; j < itemsPerProducer; ++j) {
+                while (!queue.enqueue(j)) {
+                    std::this_thread::yield();
+                }
+            }
+            while (!drained.load()) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true);
+    while (consumed.load(std::memory_order_relaxed) < total) {
+        size_t got = queue.dequeue_bulk([](int) {}, 512);
+        if (got == 0) {
+            std::this_thread::yield();
+        }
+        consumed.fetch_add(got, std::memory_order_relaxed);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    drained.store(true);
+    for (auto &t : threads) {
+        t.join();
+    }
+    return total / seconds;
+}
+
+TEST(MpmcRingQueueTest, ThroughputByProducerCount) {
+    constexpr int TOTAL_ITEMS = 256000;
+    for (int producers : {1, 4, 16, 64, 256}) {
+        int itemsPerProducer = TOTAL_ITEMS / producers;
+        double perProducerQueue = 0;
+        {
+            ConcurrentQueue<int> queue(itemsPerProducer);
+            perProducerQueue = ProducerThroughput(queue, producers, itemsPerProducer);
+        }
+        MpmcRingQueue<int> ring(MPMC_RING_QUEUE_DEFAULT_CAPACITY);
+        double ringQueue = ProducerThroughput(ring, producers, itemsPerProducer);
+        std::cout << producers << " producers: per producer queues " << (uint64_t)perProducerQueue
+                  << " items/s, mpmc ring " << (uint64_t)ringQueue << " items/s" << std::endl;
+        EXPECT_GT(ringQueue, 0);
+    }
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
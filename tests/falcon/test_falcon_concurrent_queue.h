@@ -9,6 +9,7 @@
 #include <future>
 #include <iostream>
 #include "connection_pool/falcon_concurrent_queue.h"
+#include "connection_pool/falcon_mpmc_ring_queue.h"
 
 using namespace pg_connection_pool;
 
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "connection_pool/falcon_fair_job_queue.h"
+
+class FairTestJob : public BaseMetaServiceJob {
+  public:
+    FairTestJob(FalconRequestPriority jobPriority, uint64_t tenant)
+    {
+        priority = jobPriority;
+        tenantId = tenant;
+    }
+
+    void Done() override {}
+    bool IsAllowBatchProcess() override { return true; }
+    bool IsEmptyRequest() override { return false; }
+    int GetReqServiceCnt() override { return 1; }
+    size_t GetReqDatasize() override { return 0; }
+    size_t CopyOutData(void *, size_t) override { return 0; }
+    FalconMetaServiceType GetFalconMetaServiceType(int) override { return FalconMetaServiceType::STAT; }
+    void ProcessResponse(void *, size_t, FalDataDeleter) override {}
+};
+
+class FairJobQueueTest : public testing::Test {
+  protected:
+    BaseMetaServiceJob *NewJob(FalconRequestPriority priority, uint64_t tenant = 0)
+    {
+        jobs.push_back(std::make_unique<FairTestJob>(priority, tenant));
+        return jobs.back().get();
+    }
+
+    std::vector<std::unique_ptr<FairTestJob>> jobs;
+    FairJobQueue queue;
+};
+
+TEST_F(FairJobQueueTest, EmptyQueue)
+{
+    std::vector<BaseMetaServiceJob *> popped;
+    EXPECT_EQ(queue.Size(), 0U);
+    EXPECT_EQ(queue.TopPriority(), FALCON_PRIORITY_NUM);
+    EXPECT_EQ(queue.Pop(16, popped), 0U);
+    EXPECT_TRUE(popped.empty());
+}
+
+TEST_F(FairJobQueueTest, TopPriorityFollowsWaitingJobs)
+{
+    queue.Push(NewJob(FALCON_PRIORITY_BACKGROUND));
+    EXPECT_EQ(queue.TopPriority(), FALCON_PRIORITY_BACKGROUND);
+    queue.Push(NewJob(FALCON_PRIORITY_INTERACTIVE));
+    EXPECT_EQ(queue.TopPriority(), FALCON_PRIORITY_INTERACTIVE);
+    EXPECT_EQ(queue.Size(), 2U);
+
+    std::vector<BaseMetaServiceJob *> popped;
+    EXPECT_EQ(queue.Pop(1, popped), 1U);
+    EXPECT_EQ(popped[0]->priority, FALCON_PRIORITY_INTERACTIVE);
+    EXPECT_EQ(queue.TopPriority(), FALCON_PRIORITY_BACKGROUND);
+    EXPECT_EQ(queue.Size(), 1U);
+}
+
+TEST_F(FairJobQueueTest, ClassesShareByWeight)
+{
+    for (int i = 0; i < 100; ++i) {
+        queue.Push(NewJob(FALCON_PRIORITY_BACKGROUND));
+        queue.Push(NewJob(FALCON_PRIORITY_NORMAL));
+        queue.Push(NewJob(FALCON_PRIORITY_INTERACTIVE));
+    }
+    // a few rounds of 8 + 4 + 1, every class still has jobs
+    std::vector<BaseMetaServiceJob *> popped;
+    EXPECT_EQ(queue.Pop(13 * 4, popped), 13U * 4);
+    int counts[FALCON_PRIORITY_NUM] = {0};
+    for (auto *job : popped) {
+        counts[job->priority]++;
+    }
+    EXPECT_EQ(counts[FALCON_PRIORITY_INTERACTIVE], 8 * 4);
+    EXPECT_EQ(counts[FALCON_PRIORITY_NORMAL], 4 * 4);
+    EXPECT_EQ(counts[FALCON_PRIORITY_BACKGROUND], 1 * 4);
+}
+
+TEST_F(FairJobQueueTest, LowerClassNotStarved)
+{
+    queue.Push(NewJob(FALCON_PRIORITY_BACKGROUND));
+    std::vector<BaseMetaServiceJob *> popped;
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            queue.Push(NewJob(FALCON_PRIORITY_INTERACTIVE));
+        }
+        queue.Pop(8, popped);
+    }
+    queue.Pop(1, popped);
+    int background = 0;
+    for (auto *job : popped) {
+        background += job->priority == FALCON_PRIORITY_BACKGROUND;
+    }
+    EXPECT_EQ(background, 1);
+}
+
+TEST_F(FairJobQueueTest, TenantsTakeTurns)
+{
+    // tenant 1 floods the queue before tenant 2 shows up
+    for (int i = 0; i < 6; ++i) {
+        queue.Push(NewJob(FALCON_PRIORITY_NORMAL, 1));
+    }
+    queue.Push(NewJob(FALCON_PRIORITY_NORMAL, 2));
+    queue.Push(NewJob(FALCON_PRIORITY_NORMAL, 2));
+
+    std::vector<BaseMetaServiceJob *> popped;
+    EXPECT_EQ(queue.Pop(4, popped), 4U);
+    std::vector<uint64_t> order;
+    for (auto *job : popped) {
+        order.push_back(job->tenantId);
+    }
+    EXPECT_EQ(order, (std::vector<uint64_t>{1, 2, 1, 2}));
+
+    popped.clear();
+    EXPECT_EQ(queue.Pop(16, popped), 4U);
+    for (auto *job : popped) {
+        EXPECT_EQ(job->tenantId, 1U);
+    }
+    EXPECT_EQ(queue.Size(), 0U);
+}
+
+TEST_F(FairJobQueueTest, TenantKeepsFifoOrder)
+{
+    std::vector<BaseMetaServiceJob *> pushed;
+    for (int i = 0; i < 5; ++i) {
+        pushed.push_back(NewJob(FALCON_PRIORITY_INTERACTIVE, 7));
+        queue.Push(pushed.back());
+    }
+    std::vector<BaseMetaServiceJob *> popped;
+    queue.Pop(5, popped);
+    EXPECT_EQ(popped, pushed);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "utils/falcon_shmem_allocator.h"
+
+#define MB (1024 * 1024)
+#define KB 1024
+
+class ShmemAllocatorTest : public testing::Test {
+  protected:
+    void Init(int pages)
+    {
+        size_t size = sizeof(PaddedAtomic64) * (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT +
+                                                FALCON_SHMEM_ALLOCATOR_COUNTER_NUM + pages) +
+                      (size_t)pages * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        shmem_.assign(size, 1);
+        ASSERT_EQ(FalconShmemAllocatorInit(&allocator_, shmem_.data(), shmem_.size()), 0);
+        ASSERT_EQ(allocator_.pageCount, (uint32_t)pages);
+        FalconShmemAllocatorReset(&allocator_);
+    }
+
+    void TearDown() override { FalconShmemAllocatorDetachThreadCache(); }
+
+    FalconShmemAllocatorStats Stats()
+    {
+        FalconShmemAllocatorStats stats;
+        FalconShmemAllocatorGetStats(&allocator_, &stats);
+        return stats;
+    }
+
+    std::vector<char> shmem_;
+    FalconShmemAllocator allocator_{};
+};
+
+TEST_F(ShmemAllocatorTest, SmallBlocksRoundUpAndComeBack)
+{
+    Init(2);
+    uint64_t a = FalconShmemAllocatorMalloc(&allocator_, 100);
+    uint64_t b = FalconShmemAllocatorMalloc(&allocator_, 20 * KB);
+    ASSERT_NE(a, 0U);
+    ASSERT_NE(b, 0U);
+    char *pointer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(&allocator_, b);
+    EXPECT_EQ(FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(pointer), 20U * KB);
+    EXPECT_EQ(Stats().usedBytes, (uint64_t)(16 + 32) * KB);
+    EXPECT_EQ(Stats().partialPages, 1U);
+
+    FalconShmemAllocatorFree(&allocator_, a);
+    FalconShmemAllocatorFree(&allocator_, b);
+    FalconShmemAllocatorStats stats = Stats();
+    EXPECT_EQ(stats.usedBytes, 0U);
+    EXPECT_EQ(stats.freePages, 2U);
+    EXPECT_EQ(stats.largestFreeSpan, 2U);
+}
+
+TEST_F(ShmemAllocatorTest, LargeRequestsTakeSpans)
+{
+    Init(6);
+    uint64_t small = FalconShmemAllocatorMalloc(&allocator_, 100);
+    ASSERT_NE(small, 0U);
+    // 2MB and its header take three pages
+    uint64_t span = FalconShmemAllocatorMalloc(&allocator_, 2 * MB);
+    ASSERT_NE(span, 0U);
+    char *pointer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(&allocator_, span);
+    memset(pointer, 0xab, 2 * MB);
+    EXPECT_EQ(FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(pointer), 2U * MB);
+    FalconShmemAllocatorStats stats = Stats();
+    EXPECT_EQ(stats.spanCount, 1U);
+    EXPECT_EQ(stats.freePages, 2U);
+    EXPECT_EQ(stats.largestFreeSpan, 2U);
+
+    // no three free pages in a row left, small blocks still fit so the shmem does not count as exhausted
+    EXPECT_EQ(FalconShmemAllocatorMalloc(&allocator_, 2 * MB), 0U);
+    EXPECT_FALSE(FalconShmemAllocatorIsExhausted(&allocator_));
+    EXPECT_EQ(FalconShmemAllocatorMalloc(&allocator_, 100 * MB), 0U);
+    EXPECT_EQ(Stats().failCount, 1U);
+
+    FalconShmemAllocatorFree(&allocator_, span);
+    FalconShmemAllocatorFree(&allocator_, small);
+    EXPECT_EQ(Stats().largestFreeSpan, 6U);
+    uint64_t whole = FalconShmemAllocatorMalloc(&allocator_, FalconShmemAllocatorMaxAllocSize(&allocator_));
+    ASSERT_NE(whole, 0U);
+    EXPECT_EQ(Stats().freePages, 0U);
+    FalconShmemAllocatorFree(&allocator_, whole);
+    EXPECT_EQ(Stats().usedBytes, 0U);
+}
+
+TEST_F(ShmemAllocatorTest, ExhaustionIsClearedByFree)
+{
+    Init(1);
+    std::vector<uint64_t> blocks;
+    uint64_t shift;
+    while ((shift = FalconShmemAllocatorMalloc(&allocator_, 100)) != 0) {
+        blocks.push_back(shift);
+    }
+    EXPECT_EQ(blocks.size(), (size_t)FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT);
+    EXPECT_TRUE(FalconShmemAllocatorIsExhausted(&allocator_));
+
+    FalconShmemAllocatorFree(&allocator_, blocks.back());
+    blocks.pop_back();
+    EXPECT_FALSE(FalconShmemAllocatorIsExhausted(&allocator_));
+
+    // a waiting allocation gets the block freed meanwhile
+    EXPECT_EQ(FalconShmemAllocatorMalloc(&allocator_, 100 * KB), 0U);
+    std::thread freer([this, &blocks]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int i = 0; i < 8; i++) {
+            FalconShmemAllocatorFree(&allocator_, blocks.back());
+            blocks.pop_back();
+        }
+    });
+    shift = FalconShmemAllocatorMallocWait(&allocator_, 100 * KB, FALCON_SHMEM_ALLOCATOR_WAIT_MS);
+    freer.join();
+    EXPECT_NE(shift, 0U);
+    EXPECT_EQ(Stats().waitCount, 1U);
+    EXPECT_EQ(FalconShmemAllocatorMallocWait(&allocator_, 512 * KB, 10), 0U);
+}
+
+TEST_F(ShmemAllocatorTest, ThreadCacheReusesBlocks)
+{
+    Init(2);
+    FalconShmemAllocatorAttachThreadCache(&allocator_);
+    uint64_t first = FalconShmemAllocatorMalloc(&allocator_, 100);
+    ASSERT_NE(first, 0U);
+    // the refill claimed half of the cache at once
+    uint32_t refill = FALCON_SHMEM_ALLOCATOR_CACHE_MAX_BLOCKS / 2;
+    EXPECT_EQ(Stats().usedBytes, (uint64_t)refill * FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE);
+
+    FalconShmemAllocatorFree(&allocator_, first);
+    EXPECT_EQ(FalconShmemAllocatorMalloc(&allocator_, 200), first);
+    FalconShmemAllocatorFree(&allocator_, first);
+
+    // sizes not worth caching go straight to the pages
+    uint64_t big = FalconShmemAllocatorMalloc(&allocator_, 600 * KB);
+    ASSERT_NE(big, 0U);
+    FalconShmemAllocatorFree(&allocator_, big);
+    EXPECT_EQ(Stats().usedBytes, (uint64_t)refill * FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE);
+
+    FalconShmemAllocatorDetachThreadCache();
+    EXPECT_EQ(Stats().usedBytes, 0U);
+}
+
+TEST_F(ShmemAllocatorTest, CachedBlocksServeOthersAtTheLimit)
+{
+    Init(1);
+    FalconShmemAllocatorAttachThreadCache(&allocator_);
+    std::vector<uint64_t> blocks;
+    for (int i = 0; i < FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT; i++) {
+        blocks.push_back(FalconShmemAllocatorMalloc(&allocator_, 100));
+        ASSERT_NE(blocks.back(), 0U);
+    }
+    for (uint64_t shift : blocks) {
+        FalconShmemAllocatorFree(&allocator_, shift);
+    }
+    // this thread keeps a few of the blocks, the whole page is needed
+    uint64_t page = FalconShmemAllocatorMalloc(&allocator_, 512 * KB);
+    ASSERT_NE(page, 0U);
+    FalconShmemAllocatorFree(&allocator_, page);
+    EXPECT_EQ(Stats().usedBytes, 0U);
+}
+
+TEST_F(ShmemAllocatorTest, ConcurrentMallocFree)
+{
+    Init(8);
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([this, t, &failed]() {
+            if (t % 2 == 0) {
+                FalconShmemAllocatorAttachThreadCache(&allocator_);
+            }
+            std::vector<uint64_t> held;
+            for (int i = 0; i < 5000; i++) {
+                uint64_t size = (uint64_t)(i * 7919 + t * 104729) % (300 * KB);
+                uint64_t shift = FalconShmemAllocatorMalloc(&allocator_, size);
+                if (shift != 0) {
+                    char *pointer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(&allocator_, shift);
+                    pointer[0] = (char)t;
+                    pointer[size == 0 ? 0 : size - 1] = (char)t;
+                    held.push_back(shift);
+                }
+                if (held.size() > 4 || (shift == 0 && !held.empty())) {
+                    uint64_t oldest = held.front();
+                    char *pointer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(&allocator_, oldest);
+                    if (pointer[0] != (char)t) {
+                        failed = true;
+                    }
+                    FalconShmemAllocatorFree(&allocator_, oldest);
+                    held.erase(held.begin());
+                }
+            }
+            for (uint64_t shift : held) {
+                FalconShmemAllocatorFree(&allocator_, shift);
+            }
+            FalconShmemAllocatorDetachThreadCache();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(Stats().usedBytes, 0U);
+    EXPECT_EQ(Stats().freePages, 8U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -178,6 +178,68 @@ TEST(PerfCounterCoverageUT, CheckpointsCompleteAndAggregate)
     EXPECT_TRUE(g_logMessages.empty());
 }
 
+TEST(PerfCounterCoverageUT, BatchSizesAndLingerAggregate)
+{
+    InitFreshPerfShmem();
+    StatBatch(-1, 4, 8, 0);
+    StatBatch(NOT_SUPPORTED, 4, 8, 0);
+    StatBatch(STAT, 4, 8, 0);
+    StatBatch(STAT, 12, 16, 30000);
+    BatchAccum *ba = &g_FalconPerRequestStatShmem->batchAccum[STAT];
+    EXPECT_EQ(ba->batchCount, 2);
+    EXPECT_EQ(ba->jobCount, 16);
+    EXPECT_EQ(ba->maxJobs, 12);
+    EXPECT_EQ(ba->targetSum, 24);
+    EXPECT_EQ(ba->lingerCount, 1);
+    EXPECT_EQ(ba->lingerSumNs, 30000);
+    EXPECT_EQ(ba->lingerMaxNs, 30000);
+
+    /* batches alone are reported, without any sampled request */
+    PerRequestStatAggregateAndOutput();
+    EXPECT_EQ(ba->batchCount, 0);
+    EXPECT_EQ(ba->lingerMaxNs, 0);
+    bool found = false;
+    for (const std::string &message : g_logMessages) {
+        found = found || message.find("size avg/max=8.0/12") != std::string::npos;
+    }
+    EXPECT_TRUE(found);
+
+    g_FalconPerRequestStatShmem->enabled = false;
+    StatBatch(STAT, 4, 8, 0);
+    EXPECT_EQ(ba->batchCount, 0);
+}
+
+TEST(PerfCounterCoverageUT, PriorityQueueWaitAndAdmissionAggregate)
+{
+    InitFreshPerfShmem();
+    StatQueueWait(-1, 1000);
+    StatQueueWait(FALCON_PRIORITY_NUM, 1000);
+    StatQueueWait(FALCON_PRIORITY_INTERACTIVE, 2000);
+    StatQueueWait(FALCON_PRIORITY_INTERACTIVE, 6000);
+    StatAdmission(FALCON_PRIORITY_BACKGROUND, false);
+    StatAdmission(FALCON_PRIORITY_BACKGROUND, true);
+    PriorityAccum *interactive = &g_FalconPerRequestStatShmem->priorityAccum[FALCON_PRIORITY_INTERACTIVE];
+    PriorityAccum *background = &g_FalconPerRequestStatShmem->priorityAccum[FALCON_PRIORITY_BACKGROUND];
+    EXPECT_EQ(interactive->jobCount, 2);
+    EXPECT_EQ(interactive->queueSumNs, 8000);
+    EXPECT_EQ(interactive->queueMaxNs, 6000);
+    EXPECT_EQ(background->delayCount, 1);
+    EXPECT_EQ(background->shedCount, 1);
+
+    PerRequestStatAggregateAndOutput();
+    EXPECT_EQ(interactive->jobCount, 0);
+    EXPECT_EQ(background->shedCount, 0);
+    bool foundInteractive = false;
+    bool foundBackground = false;
+    for (const std::string &message : g_logMessages) {
+        foundInteractive = foundInteractive || message.find("[priority INTERACTIVE] queue avg/max=4.0/6.0us cnt=2") !=
+                                                   std::string::npos;
+        foundBackground = foundBackground || message.find("delayed=1 shed=1") != std::string::npos;
+    }
+    EXPECT_TRUE(foundInteractive);
+    EXPECT_TRUE(foundBackground);
+}
+
 TEST(PerfCounterCoverageUT, CompleteReleasesInvalidAndShortRequests)
 {
     InitFreshPerfShmem();
@@ -6,9 +6,15 @@
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "connection_pool/falcon_worker_task.h"
 
+extern "C" {
+int FalconConnectionPoolPipelineDepth = 2;
+int FalconConnectionPoolShedQueueDepth = 4096;
+}
+
 namespace {
 
 struct FakePgConn {
@@ -27,6 +33,8 @@ std::deque<FakePgResult *> g_execResults;
 std::deque<FakePgResult *> g_pendingResults;
 int g_clearCount = 0;
 int g_finishCount = 0;
+bool g_inPipeline = false;
+int g_syncCount = 0;
 std::string g_lastConnInfo;
 std::string g_lastExecSql;
 
@@ -44,6 +52,8 @@ void ResetFakePg()
     g_connError.clear();
     g_clearCount = 0;
     g_finishCount = 0;
+    g_inPipeline = false;
+    g_syncCount = 0;
     g_lastConnInfo.clear();
     g_lastExecSql.clear();
 }
@@ -77,6 +87,38 @@ class RecordingTask : public BaseWorkerTask {
     bool shouldThrow_;
 };
 
+// records the order its halves ran in, the reply it got and which mode the connection was in
+class PipelinedTask : public BaseWorkerTask {
+  public:
+    PipelinedTask(int id, std::vector<int> &order) : BaseWorkerTask(nullptr), id_(id), order_(order) {}
+
+    void DoWork(PGconn *, flatbuffers::FlatBufferBuilder &, SerializedData &) override { ranAlone = true; }
+
+    bool SupportPipeline() override { return true; }
+
+    void SendRequest(PGconn *) override
+    {
+        EXPECT_TRUE(g_inPipeline);
+        order_.push_back(id_);
+    }
+
+    void ProcessResult(PGresult *res, flatbuffers::FlatBufferBuilder &, SerializedData &) override
+    {
+        order_.push_back(-id_);
+        replyStatus = res == nullptr ? PGRES_EMPTY_QUERY : PQresultStatus(res);
+        if (res != nullptr) {
+            PQclear(res);
+        }
+    }
+
+    bool ranAlone{false};
+    ExecStatusType replyStatus{PGRES_EMPTY_QUERY};
+
+  private:
+    int id_;
+    std::vector<int> &order_;
+};
+
 class NotifyState {
   public:
     void Mark()
@@ -160,6 +202,24 @@ void PQfinish(PGconn *)
     ++g_finishCount;
 }
 
+int PQenterPipelineMode(PGconn *)
+{
+    g_inPipeline = true;
+    return 1;
+}
+
+int PQexitPipelineMode(PGconn *)
+{
+    g_inPipeline = false;
+    return 1;
+}
+
+int PQpipelineSync(PGconn *)
+{
+    ++g_syncCount;
+    return 1;
+}
+
 }
 
 #include "../../falcon/connection_pool/pg_connection.cpp"
@@ -228,3 +288,88 @@ TEST(PGConnectionCoverageUT, BackgroundWorkerClearsPendingResultsAfterTaskExcept
 
     EXPECT_EQ(g_clearCount, 2);
 }
+
+TEST(PGConnectionCoverageUT, PipelinedTasksReceiveTheirOwnReplies)
+{
+    ResetFakePg();
+    auto *okResult = new FakePgResult();
+    auto *errorResult = new FakePgResult();
+    errorResult->status = PGRES_FATAL_ERROR;
+    auto *firstSync = new FakePgResult();
+    firstSync->status = PGRES_PIPELINE_SYNC;
+    auto *secondSync = new FakePgResult();
+    secondSync->status = PGRES_PIPELINE_SYNC;
+    // each statement ends with a NULL result, then its sync point follows
+    for (FakePgResult *result : {okResult, static_cast<FakePgResult *>(nullptr), firstSync, errorResult,
+                                 static_cast<FakePgResult *>(nullptr), secondSync}) {
+        g_pendingResults.push_back(result);
+    }
+
+    std::vector<int> order;
+    auto first = std::make_shared<PipelinedTask>(1, order);
+    auto second = std::make_shared<PipelinedTask>(2, order);
+    NotifyState notifyState;
+    int notifyCount = 0;
+    {
+        PGConnection connection(
+            [&](PGConnection *conn) {
+                if (++notifyCount == 2) {
+                    conn->Stop();
+                    notifyState.Mark();
+                }
+            },
+            "127.0.0.1",
+            5432,
+            "hx");
+        EXPECT_TRUE(g_inPipeline);
+        connection.Exec(first);
+        connection.Exec(second);
+        EXPECT_TRUE(notifyState.Wait());
+    }
+
+    EXPECT_EQ(notifyCount, 2);
+    EXPECT_EQ(g_syncCount, 2);
+    ASSERT_EQ(order.size(), 4U);
+    EXPECT_EQ(order.front(), 1);
+    EXPECT_EQ(order.back(), -2);
+    EXPECT_EQ(first->replyStatus, PGRES_TUPLES_OK);
+    EXPECT_EQ(second->replyStatus, PGRES_FATAL_ERROR);
+    EXPECT_FALSE(first->ranAlone);
+    EXPECT_TRUE(g_pendingResults.empty());
+}
+
+TEST(PGConnectionCoverageUT, PlainTasksRunOutsideThePipeline)
+{
+    ResetFakePg();
+    NotifyState notifyState;
+    bool inPipelineDuringWork = true;
+
+    class ModeTask : public BaseWorkerTask {
+      public:
+        explicit ModeTask(bool &inPipeline) : BaseWorkerTask(nullptr), inPipeline_(inPipeline) {}
+        void DoWork(PGconn *, flatbuffers::FlatBufferBuilder &, SerializedData &) override
+        {
+            inPipeline_ = g_inPipeline;
+        }
+
+      private:
+        bool &inPipeline_;
+    };
+
+    {
+        PGConnection connection(
+            [&](PGConnection *conn) {
+                conn->Stop();
+                notifyState.Mark();
+            },
+            "127.0.0.1",
+            5432,
+            "hx");
+        connection.Exec(std::make_shared<ModeTask>(inPipelineDuringWork));
+        EXPECT_TRUE(notifyState.Wait());
+    }
+
+    EXPECT_FALSE(inPipelineDuringWork);
+    EXPECT_TRUE(g_inPipeline);
+    EXPECT_EQ(g_syncCount, 0);
+}
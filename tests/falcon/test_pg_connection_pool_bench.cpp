@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "base_comm_adapter/base_meta_service_job.h"
+#include "connection_pool/falcon_worker_task.h"
+#include "perf_counter/falcon_per_request_stat.h"
+
+extern "C" {
+int FalconPGPort = 0;
+int FalconConnectionPoolPort = 56999;
+int FalconConnectionPoolSize = 8;
+int FalconConnectionPoolBatchSize = 512;
+int FalconConnectionPoolWaitAdjust = 1;
+int FalconConnectionPoolWaitMin = 1;
+int FalconConnectionPoolWaitMax = 512;
+int FalconConnectionPoolDispatcherNum = 2;
+int FalconConnectionPoolBatchLatencySlo = 2000;
+char *FalconConnectionPoolBatchLatencySloOverride = nullptr;
+int FalconConnectionPoolBatchLingerMax = 200;
+int FalconConnectionPoolPipelineDepth = 2;
+int FalconConnectionPoolShedQueueDepth = 4096;
+uint64_t FalconConnectionPoolShmemSize = 256 * 1024 * 1024;
+char *FalconNodeLocalIp = nullptr;
+char *FalconCommunicationServerIp = nullptr;
+char *FalconCommunicationPluginPath = nullptr;
+
+int32_t PerRequestStatAllocIndex(void)
+{
+    return -1;
+}
+
+void PerRequestStatComplete(int32_t, int32_t) {}
+
+void PQclear(PGresult *) {}
+}
+
+FalconPerRequestStatShmem *g_FalconPerRequestStatShmem = nullptr;
+
+// the stub connection drops its task, the jobs complete from the task destructor
+void SingleWorkerTask::DoWork(PGconn *, flatbuffers::FlatBufferBuilder &, SerializedData &) {}
+void BatchWorkerTask::DoWork(PGconn *, flatbuffers::FlatBufferBuilder &, SerializedData &) {}
+void BatchWorkerTask::SendRequest(PGconn *) {}
+void BatchWorkerTask::ProcessResult(PGresult *, flatbuffers::FlatBufferBuilder &, SerializedData &) {}
+
+// one round trip to postgres, the same for a single job and a whole batch
+#define BENCH_ROUND_TRIP_US 50
+#define BENCH_REQUESTS 4000
+
+#ifndef FALCON_POOLER_PG_CONNECTION_H
+#define FALCON_POOLER_PG_CONNECTION_H
+class PGConnection {
+  public:
+    using FinishFunc = std::function<void(PGConnection *)>;
+
+    PGConnection(FinishFunc finishFunc, const char *, const int, const char *)
+        : finishFunc_(std::move(finishFunc)),
+          thread_(&PGConnection::BackgroundWorker, this)
+    {
+    }
+
+    ~PGConnection()
+    {
+        Stop();
+    }
+
+    void Exec(std::shared_ptr<BaseWorkerTask> taskToExec)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(taskToExec));
+        }
+        cv_.notify_one();
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+  private:
+    void BackgroundWorker()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                break;
+            }
+            std::shared_ptr<BaseWorkerTask> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(BENCH_ROUND_TRIP_US));
+            task.reset();
+            finishFunc_(this);
+            lock.lock();
+        }
+    }
+
+    FinishFunc finishFunc_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<BaseWorkerTask>> tasks_;
+    bool stop_{false};
+    std::thread thread_;
+};
+#endif
+
+#include "../../falcon/connection_pool/pg_connection_pool.cpp"
+
+class BenchJob : public BaseMetaServiceJob {
+  public:
+    explicit BenchJob(std::atomic<bool> &finished, FalconRequestPriority requestPriority = FALCON_PRIORITY_NUM)
+        : finished_(finished),
+          requestPriority_(requestPriority)
+    {
+    }
+
+    void Done() override
+    {
+        finished_.store(true);
+        finished_.notify_one();
+    }
+
+    bool IsAllowBatchProcess() override { return true; }
+    bool IsEmptyRequest() override { return false; }
+    int GetReqServiceCnt() override { return 1; }
+    size_t GetReqDatasize() override { return 0; }
+    size_t CopyOutData(void *, size_t) override { return 0; }
+    FalconMetaServiceType GetFalconMetaServiceType(int) override { return FalconMetaServiceType::STAT; }
+    void ProcessResponse(void *, size_t, FalDataDeleter) override {}
+    FalconRequestPriority GetRequestPriority() override { return requestPriority_; }
+
+  private:
+    std::atomic<bool> &finished_;
+    FalconRequestPriority requestPriority_;
+};
+
+struct BenchResult
+{
+    double p50Us;
+    double p99Us;
+    double opsPerSecond;
+};
+
+static BenchResult RunClients(int clients)
+{
+    PGConnectionPool &pool = PGConnectionPool::GetInstance();
+    EXPECT_TRUE(pool.Init(0, "bench", FalconConnectionPoolSize, 20, 400));
+
+    int perClient = std::max(BENCH_REQUESTS / clients, 100);
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&pool, &latencies, c, perClient]() {
+            std::atomic<bool> finished{false};
+            latencies[c].reserve(perClient);
+            for (int i = 0; i < perClient; ++i) {
+                finished.store(false);
+                auto begin = std::chrono::steady_clock::now();
+                pool.DispatchMetaServiceJob(new BenchJob(finished));
+                finished.wait(false);
+                auto cost = std::chrono::steady_clock::now() - begin;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(cost).count());
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pool.Destroy();
+
+    std::vector<double> all;
+    for (auto &latency : latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    return {all[all.size() / 2], all[all.size() * 99 / 100], all.size() / seconds};
+}
+
+/*
+ * Latency vs throughput of stat requests at growing client concurrency, for the sleep-polling manager
+ * (dispatcher_num = 0) and the wakeup driven dispatchers, the latter with fixed and with SLO sized batches.
+ * Each connection takes BENCH_ROUND_TRIP_US per task.
+ */
+TEST(PGConnectionPoolBench, LatencyByConcurrency)
+{
+    struct {
+        const char *name;
+        int dispatcherNum;
+        int latencySlo;
+    } modes[] = {{"polling dispatcher", 0, 0},
+                 {"event dispatcher", 2, 0},
+                 {"event dispatcher, adaptive batch", 2, 2000}};
+    for (auto &mode : modes) {
+        FalconConnectionPoolDispatcherNum = mode.dispatcherNum;
+        FalconConnectionPoolBatchLatencySlo = mode.latencySlo;
+        for (int clients : {1, 8, 64, 256}) {
+            BenchResult result = RunClients(clients);
+            std::cout << mode.name << ", " << clients << " clients: p50 " << result.p50Us << " us, p99 "
+                      << result.p99Us << " us, " << (uint64_t)result.opsPerSecond << " ops/s" << std::endl;
+            EXPECT_GT(result.opsPerSecond, 0);
+        }
+    }
+}
+
+/*
+ * Latency of an interactive client while background clients keep the pool saturated. With the priority classes the
+ * interactive jobs overtake the background backlog in the queue and at the connections.
+ */
+TEST(PGConnectionPoolBench, InteractiveUnderBackgroundLoad)
+{
+    FalconConnectionPoolDispatcherNum = 2;
+    FalconConnectionPoolBatchLatencySlo = 2000;
+    PGConnectionPool &pool = PGConnectionPool::GetInstance();
+    EXPECT_TRUE(pool.Init(0, "bench", FalconConnectionPoolSize, 20, 400));
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> background;
+    for (int c = 0; c < 128; ++c) {
+        background.emplace_back([&pool, &stop]() {
+            std::atomic<bool> finished{false};
+            while (!stop.load()) {
+                finished.store(false);
+                pool.DispatchMetaServiceJob(new BenchJob(finished, FALCON_PRIORITY_BACKGROUND));
+                finished.wait(false);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::vector<double> latencies;
+    std::atomic<bool> finished{false};
+    for (int i = 0; i < 500; ++i) {
+        finished.store(false);
+        auto begin = std::chrono::steady_clock::now();
+        pool.DispatchMetaServiceJob(new BenchJob(finished, FALCON_PRIORITY_INTERACTIVE));
+        finished.wait(false);
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+    stop.store(true);
+    for (auto &thread : background) {
+        thread.join();
+    }
+    pool.Destroy();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "interactive under background load: p50 " << latencies[latencies.size() / 2] << " us, p99 "
+              << latencies[latencies.size() * 99 / 100] << " us" << std::endl;
+    EXPECT_FALSE(latencies.empty());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
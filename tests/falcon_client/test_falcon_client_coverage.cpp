@@ -95,6 +95,108 @@ TEST(FalconClientMetaUT, InvalidFdOperationsReturnErrorsWithoutService)
     EXPECT_EQ(FalconCloseDir(missing_fd), NOT_FOUND_FD);
 }
 
+TEST(FalconClientAttrCacheUT, PutGetExpireAndInvalidate)
+{
+    AttrCache &cache = AttrCache::GetInstance();
+    uint32_t oldTtl = cache.GetTtl();
+    struct stat st {};
+    st.st_mode = S_IFREG | 0644;
+    st.st_size = 42;
+    struct stat out {};
+    int errorCode = -1;
+
+    cache.SetTtl(0);
+    cache.Put("/attr_cache/off", st, 60000);
+    EXPECT_FALSE(cache.Get("/attr_cache/off", &out, errorCode));
+
+    cache.SetTtl(60000);
+    cache.Put("/attr_cache/no_lease", st, 0);
+    EXPECT_FALSE(cache.Get("/attr_cache/no_lease", &out, errorCode));
+    size_t hits = FalconStats::GetInstance().stats[ATTR_CACHE_HIT];
+    cache.Put("/attr_cache/a", st, 60000);
+    cache.Put("/attr_cache/b", st, 60000);
+    EXPECT_TRUE(cache.Get("/attr_cache/a", &out, errorCode));
+    EXPECT_EQ(errorCode, 0);
+    EXPECT_EQ(out.st_size, 42);
+    EXPECT_EQ(out.st_mode, st.st_mode);
+    EXPECT_EQ(FalconStats::GetInstance().stats[ATTR_CACHE_HIT] - hits, 1U);
+    cache.Invalidate("/attr_cache/a");
+    EXPECT_FALSE(cache.Get("/attr_cache/a", &out, errorCode));
+    EXPECT_TRUE(cache.Get("/attr_cache/b", &out, errorCode));
+
+    // a renamed directory drops the paths below it, not those sharing its name as a prefix
+    cache.Put("/attr_cache/dir/x", st, 60000);
+    cache.Put("/attr_cache/dir/sub/y", st, 60000);
+    cache.Put("/attr_cache/dirx", st, 60000);
+    cache.InvalidatePrefix("/attr_cache/dir");
+    EXPECT_FALSE(cache.Get("/attr_cache/dir/x", &out, errorCode));
+    EXPECT_FALSE(cache.Get("/attr_cache/dir/sub/y", &out, errorCode));
+    EXPECT_TRUE(cache.Get("/attr_cache/dirx", &out, errorCode));
+    EXPECT_TRUE(cache.Get("/attr_cache/b", &out, errorCode));
+
+    // the client probing its own cache is not counted as a hit or a miss
+    hits = FalconStats::GetInstance().stats[ATTR_CACHE_HIT];
+    size_t misses = FalconStats::GetInstance().stats[ATTR_CACHE_MISS];
+    EXPECT_TRUE(cache.Peek("/attr_cache/b", &out, errorCode));
+    EXPECT_EQ(errorCode, 0);
+    EXPECT_FALSE(cache.Peek("/attr_cache/dir/x", &out, errorCode));
+    EXPECT_EQ(FalconStats::GetInstance().stats[ATTR_CACHE_HIT], hits);
+    EXPECT_EQ(FalconStats::GetInstance().stats[ATTR_CACHE_MISS], misses);
+
+    cache.Clear();
+    EXPECT_FALSE(cache.Get("/attr_cache/b", &out, errorCode));
+    EXPECT_EQ(cache.GetMemoryUsage(), 0U);
+
+    // the lease the server granted is shorter than the local ttl
+    cache.Put("/attr_cache/short", st, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(cache.Get("/attr_cache/short", &out, errorCode));
+
+    cache.SetTtl(oldTtl);
+}
+
+TEST(FalconClientAttrCacheUT, NegativeEntriesAndMemoryLimit)
+{
+    AttrCache &cache = AttrCache::GetInstance();
+    uint32_t oldTtl = cache.GetTtl();
+    uint32_t oldNegativeTtl = cache.GetNegativeTtl();
+    struct stat st {};
+    struct stat out {};
+    int errorCode = 0;
+    cache.SetTtl(60000);
+
+    cache.SetNegativeTtl(0);
+    cache.PutNegative("/attr_cache/missing", FILE_NOT_EXISTS);
+    EXPECT_FALSE(cache.Get("/attr_cache/missing", &out, errorCode));
+    cache.SetNegativeTtl(60000);
+    cache.PutNegative("/attr_cache/missing", FILE_NOT_EXISTS);
+    EXPECT_TRUE(cache.Get("/attr_cache/missing", &out, errorCode));
+    EXPECT_EQ(errorCode, FILE_NOT_EXISTS);
+    // a create through this client drops the negative entry
+    cache.Put("/attr_cache/missing", st, 60000);
+    EXPECT_TRUE(cache.Get("/attr_cache/missing", &out, errorCode));
+    EXPECT_EQ(errorCode, 0);
+    cache.Clear();
+
+    // room for a handful of entries per shard, the usage never exceeds the limit
+    const uint64_t limit = 64 * 1024;
+    cache.SetMemoryLimit(limit);
+    size_t misses = FalconStats::GetInstance().stats[ATTR_CACHE_MISS];
+    for (int i = 0; i < 10000; ++i) {
+        cache.Put("/attr_cache/many/" + std::to_string(i), st, 60000);
+    }
+    EXPECT_LE(cache.GetMemoryUsage(), limit);
+    EXPECT_GT(cache.GetMemoryUsage(), 0U);
+    EXPECT_TRUE(cache.Get("/attr_cache/many/9999", &out, errorCode));
+    EXPECT_FALSE(cache.Get("/attr_cache/many/10000", &out, errorCode));
+    EXPECT_EQ(FalconStats::GetInstance().stats[ATTR_CACHE_MISS] - misses, 1U);
+
+    cache.Clear();
+    cache.SetMemoryLimit(ATTR_CACHE_DEFAULT_MEMORY_LIMIT);
+    cache.SetNegativeTtl(oldNegativeTtl);
+    cache.SetTtl(oldTtl);
+}
+
 TEST(FalconClientFuseWrapperUT, InvalidArgumentsReturnEinval)
 {
     struct fuse_file_info fi {};
@@ -420,6 +522,77 @@ TEST(FalconClientMetaServiceUT, DirectoryAndAttributeOperations)
     FalconDestroy();
 }
 
+TEST(FalconClientMetaServiceUT, BatchCreateStatAndUnlink)
+{
+    if (!InitFalconClientOrSkip()) {
+        GTEST_SKIP() << "Falcon client service coverage is disabled or service is unavailable";
+    }
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < 16; ++i) {
+        paths.push_back(BuildUniquePath(("batch_" + std::to_string(i)).c_str()));
+    }
+    std::vector<int> rets;
+    EXPECT_EQ(FalconBatchCreate(paths, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), SUCCESS));
+
+    std::vector<std::string> statPaths = paths;
+    statPaths.push_back(BuildUniquePath("batch_missing"));
+    std::vector<struct stat> stbufs;
+    EXPECT_EQ(FalconBatchStat(statPaths, stbufs, rets), SUCCESS);
+    ASSERT_EQ(rets.size(), statPaths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(rets[i], SUCCESS);
+        EXPECT_TRUE(S_ISREG(stbufs[i].st_mode));
+    }
+    EXPECT_EQ(rets.back(), FILE_NOT_EXISTS);
+
+    EXPECT_EQ(FalconBatchUnlink(paths, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), SUCCESS));
+    EXPECT_EQ(FalconBatchStat(paths, stbufs, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), FILE_NOT_EXISTS));
+    FalconDestroy();
+}
+
+TEST(FalconClientMetaServiceUT, RenameFilesAndDirectoryAcrossServers)
+{
+    if (!InitFalconClientOrSkip()) {
+        GTEST_SKIP() << "Falcon client service coverage is disabled or service is unavailable";
+    }
+
+    std::string dir = BuildUniquePath("rename_dir");
+    ASSERT_EQ(FalconMkdir(dir), SUCCESS);
+    std::vector<std::string> paths;
+    for (int i = 0; i < 16; ++i) {
+        paths.push_back(dir + "/tmp_" + std::to_string(i));
+    }
+    std::vector<int> rets;
+    ASSERT_EQ(FalconBatchCreate(paths, rets), SUCCESS);
+    ASSERT_EQ(rets, std::vector<int>(paths.size(), SUCCESS));
+
+    // the new names land on the same server as the old ones for some files and on another one for the rest
+    std::vector<std::string> renamedPaths;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        renamedPaths.push_back(dir + "/final_" + std::to_string(i));
+        EXPECT_EQ(FalconRename(paths[i], renamedPaths[i]), SUCCESS);
+    }
+    std::vector<struct stat> stbufs;
+    EXPECT_EQ(FalconBatchStat(renamedPaths, stbufs, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), SUCCESS));
+    EXPECT_EQ(FalconBatchStat(paths, stbufs, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), FILE_NOT_EXISTS));
+
+    std::string renamedDir = BuildUniquePath("renamed_dir");
+    EXPECT_EQ(FalconRename(dir, renamedDir), SUCCESS);
+    for (auto &path : renamedPaths) {
+        path = renamedDir + path.substr(dir.size());
+    }
+    EXPECT_EQ(FalconBatchUnlink(renamedPaths, rets), SUCCESS);
+    EXPECT_EQ(rets, std::vector<int>(paths.size(), SUCCESS));
+    EXPECT_EQ(FalconRmDir(renamedDir), SUCCESS);
+    FalconDestroy();
+}
+
 TEST(FalconClientMetaServiceUT, RouterAndMissingPathBranches)
 {
     if (!InitFalconClientOrSkip()) {
@@ -1,4 +1,6 @@
 #include <fstream>
+#include <map>
+#include <thread>
 
 #include "test_disk_cache.h"
 #include "disk_cache/disk_cache.h"
@@ -114,6 +116,22 @@ TEST_F(DiskCacheUT, DeleteOldCacheSkipsPinnedEntry)
     std::filesystem::remove_all(cacheRoot);
 }
 
+TEST_F(DiskCacheUT, ForEachSkipsPackedRecords)
+{
+    DiskCache cache;
+    cache.InsertAndUpdate(501, 10, false);
+    cache.InsertAndUpdate(502, 20, true);
+    cache.InsertAndUpdate(503, 30, false, true);
+
+    std::map<uint64_t, uint64_t> items;
+    cache.ForEach([&items](uint64_t inode, uint64_t size) { items[inode] = size; });
+    EXPECT_EQ(items.size(), 2U);
+    EXPECT_EQ(items[501], 10U);
+    EXPECT_EQ(items[502], 20U);
+    EXPECT_EQ(items.count(503), 0U);
+    cache.Unpin(502);
+}
+
 TEST_F(DiskCacheUT, StartScansExistingCacheFiles)
 {
     std::string cacheRoot = "/tmp/testdir_scan";
@@ -269,6 +287,150 @@ TEST_F(DiskCacheUT, PublicEvictAndFailureBranches)
     std::filesystem::remove_all(cacheRoot);
 }
 
+TEST_F(DiskCacheUT, ConcurrentAccessWithEvictKeepsPinnedEntries)
+{
+    std::string cacheRoot = "/tmp/testdir_concurrent";
+    std::filesystem::remove_all(cacheRoot);
+    for (int i = 0; i < 4; ++i) {
+        std::filesystem::create_directories(cacheRoot + "/" + std::to_string(i));
+    }
+    SetRootPath(cacheRoot);
+    SetTotalDirectory(4);
+
+    /* ratio above 1 fails the space check after binding the root, so no background cleanup thread is started */
+    DiskCache cache(0.4);
+    EXPECT_EQ(cache.Start(cacheRoot, 4, 2.0, 2.0), RETURN_ERROR);
+
+    constexpr int threadNum = 8;
+    constexpr uint64_t keysPerThread = 64;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadNum; ++t) {
+        workers.emplace_back([&cache, t]() {
+            for (uint64_t i = 0; i < keysPerThread; ++i) {
+                uint64_t key = 1000 + t * keysPerThread + i;
+                {
+                    std::ofstream out(GetFilePath(key));
+                    out << "concurrent";
+                }
+                /* even keys stay pinned, odd keys are free to be evicted */
+                cache.InsertAndUpdate(key, 10, i % 2 == 0);
+                if (cache.Find(key, true)) {
+                    cache.Unpin(key);
+                }
+            }
+        });
+    }
+    std::thread evictor([&cache]() {
+        for (int i = 0; i < 16; ++i) {
+            cache.Evict(UINT64_MAX / 4);
+        }
+    });
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    evictor.join();
+    cache.Evict(UINT64_MAX / 4);
+
+    for (int t = 0; t < threadNum; ++t) {
+        for (uint64_t i = 0; i < keysPerThread; ++i) {
+            uint64_t key = 1000 + t * keysPerThread + i;
+            if (i % 2 == 0) {
+                EXPECT_TRUE(cache.Find(key, false));
+                EXPECT_TRUE(std::filesystem::exists(GetFilePath(key)));
+                cache.Unpin(key);
+                EXPECT_EQ(cache.Delete(key), 0);
+            } else {
+                EXPECT_FALSE(cache.Find(key, false));
+                EXPECT_FALSE(std::filesystem::exists(GetFilePath(key)));
+            }
+        }
+    }
+    std::filesystem::remove_all(cacheRoot);
+}
+
+TEST_F(DiskCacheUT, SnapshotRestoresIndexAndWalksChangedDirectories)
+{
+    std::string cacheRoot = "/tmp/testdir_snapshot";
+    std::filesystem::remove_all(cacheRoot);
+    for (int i = 0; i < 2; ++i) {
+        std::filesystem::create_directories(cacheRoot + "/" + std::to_string(i));
+    }
+    SetRootPath(cacheRoot);
+    SetTotalDirectory(2);
+
+    auto sizeOf = [](DiskCache &cache, uint64_t key) {
+        uint64_t found = 0;
+        cache.ForEach([key, &found](uint64_t inode, uint64_t size) {
+            if (inode == key) {
+                found = size;
+            }
+        });
+        return found;
+    };
+
+    /* grows after the snapshot, which leaves its directory mtime alone */
+    uint64_t grownKey = 600;
+    uint64_t walkedKey = 601;
+    /* only known from the snapshot, there is no file behind it */
+    uint64_t indexOnlyKey = 602;
+    {
+        std::ofstream out(GetFilePath(grownKey));
+        out << "0123456789";
+    }
+    {
+        DiskCache cache(0.4);
+        EXPECT_EQ(cache.Start(cacheRoot, 2, 2.0, 2.0), RETURN_ERROR);
+        cache.InsertAndUpdate(grownKey, 10, false);
+        cache.InsertAndUpdate(indexOnlyKey, 10, false);
+        EXPECT_EQ(cache.SaveSnapshot(), 0);
+    }
+    EXPECT_TRUE(std::filesystem::exists(cacheRoot + "/disk_cache.index"));
+    {
+        std::ofstream out(GetFilePath(grownKey), std::ios::app);
+        out << "abcde";
+    }
+
+    auto past = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (int i = 0; i < 2; ++i) {
+        std::filesystem::last_write_time(cacheRoot + "/" + std::to_string(i), past);
+    }
+    {
+        DiskCache cache(0.4);
+        EXPECT_EQ(cache.Start(cacheRoot, 2, 2.0, 2.0), RETURN_ERROR);
+        /* loaded from the snapshot, corrected on first use */
+        EXPECT_EQ(sizeOf(cache, grownKey), 10U);
+        EXPECT_TRUE(cache.Find(grownKey, false));
+        EXPECT_EQ(sizeOf(cache, grownKey), 15U);
+        EXPECT_FALSE(cache.Find(indexOnlyKey, false));
+    }
+
+    /* a new file makes its directory newer than the snapshot, so that directory is walked again */
+    {
+        std::ofstream out(GetFilePath(walkedKey));
+        out << "walked";
+    }
+    {
+        DiskCache cache(0.4);
+        EXPECT_EQ(cache.Start(cacheRoot, 2, 2.0, 2.0), RETURN_ERROR);
+        EXPECT_TRUE(cache.Find(walkedKey, false));
+        EXPECT_TRUE(cache.Find(grownKey, false));
+        EXPECT_EQ(sizeOf(cache, grownKey), 15U);
+    }
+
+    /* a corrupted snapshot falls back to the full walk */
+    {
+        std::ofstream out(cacheRoot + "/disk_cache.index", std::ios::trunc);
+        out << "broken";
+    }
+    {
+        DiskCache cache(0.4);
+        EXPECT_EQ(cache.Start(cacheRoot, 2, 2.0, 2.0), RETURN_ERROR);
+        EXPECT_TRUE(cache.Find(walkedKey, false));
+        EXPECT_FALSE(cache.Find(indexOnlyKey, false));
+    }
+    std::filesystem::remove_all(cacheRoot);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -2,6 +2,7 @@
 
 #include "connection/node.h"
 #include "disk_cache/disk_cache.h"
+#include "falcon_store/cache_migrator.h"
 
 unsigned long myHash(std::string &str);
 
@@ -309,6 +310,111 @@ TEST_F(FalconStoreUT, SmallFilePublicMissBranches)
     FalconStats::GetInstance().stats[BLOCKCACHE_WRITE] = 0;
 }
 
+TEST_F(FalconStoreUT, BatchReadSmallFilesRpc)
+{
+    std::vector<std::string> payloads = {"batch-first", "batch-second-payload"};
+    std::vector<SmallFileReadItem> items(3);
+    std::vector<std::string> buffers(3, std::string(64, '\0'));
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        uint64_t inodeId = 913200 + i;
+        std::string fileName = GetFilePath(inodeId);
+        int fd = open(fileName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0755);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(pwrite(fd, payloads[i].data(), payloads[i].size(), 0), static_cast<ssize_t>(payloads[i].size()));
+        close(fd);
+        DiskCache::GetInstance().InsertAndUpdate(inodeId, payloads[i].size(), false);
+        items[i].inodeId = inodeId;
+        items[i].size = payloads[i].size();
+        items[i].path = "/batch/file" + std::to_string(i);
+    }
+    /* a missing file in the middle of the batch fails alone */
+    std::swap(items[1], items[2]);
+    items[1].inodeId = 913299;
+    items[1].size = 10;
+    items[1].path = "/batch/missing";
+
+    std::vector<SmallFileReadItem *> itemPtrs;
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i].oflags = O_RDONLY;
+        items[i].buf = buffers[i].data();
+        itemPtrs.push_back(&items[i]);
+    }
+    EXPECT_EQ(client->BatchReadSmallFiles(itemPtrs), 0);
+    EXPECT_EQ(items[0].ret, 0);
+    EXPECT_EQ(buffers[0].substr(0, payloads[0].size()), payloads[0]);
+    EXPECT_NE(items[1].ret, 0);
+    EXPECT_EQ(items[2].ret, 0);
+    EXPECT_EQ(buffers[2].substr(0, payloads[1].size()), payloads[1]);
+
+    /* oversized items are refused without reading, nothing is left to wait for */
+    auto bigItems = std::make_shared<std::vector<SmallFileReadItem>>(1);
+    (*bigItems)[0].size = READ_BIGFILE_SIZE + 1;
+    (*bigItems)[0].ret = -EAGAIN;
+    bool finished = false;
+    FalconStore::GetInstance()->BatchReadSmallFilesForBrpc(bigItems, [&finished]() { finished = true; });
+    EXPECT_TRUE(finished);
+    EXPECT_EQ((*bigItems)[0].ret, -EAGAIN);
+
+    FalconStats::GetInstance().stats[BLOCKCACHE_READ] = 0;
+}
+
+TEST_F(FalconStoreUT, MigrateFileRpc)
+{
+    uint64_t inodeId = 913300;
+    std::string payload = "migrated-cache-file";
+    size_t half = payload.size() / 2;
+    unlink(GetFilePath(inodeId).c_str());
+
+    butil::IOBuf data;
+    data.append(payload.data(), half);
+    EXPECT_EQ(client->MigrateFile(inodeId, payload.size(), 0, data), 0);
+    /* staged until the last chunk arrives */
+    EXPECT_FALSE(DiskCache::GetInstance().Find(inodeId, false));
+    data.clear();
+    data.append(payload.data() + half, payload.size() - half);
+    EXPECT_EQ(client->MigrateFile(inodeId, payload.size(), half, data), 0);
+    EXPECT_TRUE(DiskCache::GetInstance().Find(inodeId, false));
+    /* the first nodeFail open takes the handed over copy */
+    EXPECT_TRUE(CacheMigrator::GetInstance().IsMigratedIn(inodeId, payload.size()));
+    EXPECT_FALSE(CacheMigrator::GetInstance().IsMigratedIn(inodeId, payload.size()));
+
+    std::string content(payload.size(), '\0');
+    int fd = open(GetFilePath(inodeId).c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(pread(fd, content.data(), content.size(), 0), static_cast<ssize_t>(payload.size()));
+    close(fd);
+    EXPECT_EQ(content, payload);
+
+    /* a cached file is not taken twice, chunks beyond the size are refused */
+    data.clear();
+    data.append(payload.data(), half);
+    EXPECT_EQ(client->MigrateFile(inodeId, payload.size(), 0, data), -EEXIST);
+    data.clear();
+    data.append(payload.data(), half);
+    EXPECT_EQ(client->MigrateFile(inodeId + 1, half, 1, data), -EINVAL);
+    DiskCache::GetInstance().Delete(inodeId);
+
+    /* chunks have to follow each other, a gap drops the staged file */
+    uint64_t gapInode = inodeId + 2;
+    data.clear();
+    data.append(payload.data(), half);
+    EXPECT_EQ(client->MigrateFile(gapInode, payload.size(), 0, data), 0);
+    data.clear();
+    data.append(payload.data() + half + 1, payload.size() - half - 1);
+    EXPECT_EQ(client->MigrateFile(gapInode, payload.size(), half + 1, data), -EINVAL);
+    data.clear();
+    data.append(payload.data() + half, payload.size() - half);
+    EXPECT_EQ(client->MigrateFile(gapInode, payload.size(), half, data), -EINVAL);
+    EXPECT_FALSE(DiskCache::GetInstance().Find(gapInode, false));
+
+    /* a copy that left the cache is forgotten */
+    data.clear();
+    data.append(payload.data(), payload.size());
+    EXPECT_EQ(client->MigrateFile(gapInode, payload.size(), 0, data), 0);
+    DiskCache::GetInstance().Delete(gapInode);
+    EXPECT_FALSE(CacheMigrator::GetInstance().IsMigratedIn(gapInode, payload.size()));
+}
+
 TEST_F(FalconStoreUT, OpenStatAndTruncatePublicBranches)
 {
     auto *store = FalconStore::GetInstance();
@@ -414,6 +520,42 @@ TEST_F(FalconStoreUT, ReadPublicBranches)
     ResetFalconStatsForCoverage();
 }
 
+TEST_F(FalconStoreUT, ReadForBrpcIntoIOBuf)
+{
+    auto *store = FalconStore::GetInstance();
+
+    NewOpenInstance(913302, StoreNode::GetInstance()->GetNodeId(), "/read/brpc-file", O_RDONLY);
+    std::string payload(20000, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+    std::string fileName = GetFilePath(openInstance->inodeId);
+    int fd = open(fileName.c_str(), O_CREAT | O_RDWR, 0755);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pwrite(fd, payload.data(), payload.size(), 0), static_cast<ssize_t>(payload.size()));
+    openInstance->physicalFd = fd;
+    openInstance->currentSize = payload.size();
+
+    /* cached file, read by the kernel into IOBuf blocks */
+    butil::IOBuf out;
+    EXPECT_EQ(store->ReadFileForBrpc(openInstance.get(), out, 15000, 100), 15000);
+    EXPECT_EQ(out.to_string(), payload.substr(100, 15000));
+    out.clear();
+    EXPECT_EQ(store->ReadFileForBrpc(openInstance.get(), out, 15000, 10000), 10000);
+    EXPECT_EQ(out.to_string(), payload.substr(10000));
+    out.clear();
+    EXPECT_EQ(store->ReadFileForBrpc(openInstance.get(), out, 100, payload.size()), 0);
+    EXPECT_TRUE(out.empty());
+
+    /* O_DIRECT goes through an aligned buffer handed over to the IOBuf */
+    openInstance->oflags = O_RDONLY | __O_DIRECT;
+    EXPECT_EQ(store->ReadFileForBrpc(openInstance.get(), out, 1000, 777), 1000);
+    EXPECT_EQ(out.to_string(), payload.substr(777, 1000));
+    close(fd);
+
+    ResetFalconStatsForCoverage();
+}
+
 TEST_F(FalconStoreUT, DeleteAndStatPublicBranches)
 {
     auto *store = FalconStore::GetInstance();
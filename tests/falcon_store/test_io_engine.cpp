@@ -0,0 +1,234 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "io_engine/io_engine.h"
+
+class IoEngineUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        std::filesystem::remove_all(rootPath);
+        std::filesystem::create_directories(rootPath);
+        fd = open((rootPath + "/data").c_str(), O_RDWR | O_CREAT, 0644);
+        ASSERT_GE(fd, 0);
+    }
+    void TearDown() override
+    {
+        close(fd);
+        std::filesystem::remove_all(rootPath);
+    }
+
+    static std::string Pattern(size_t size, size_t seed = 0)
+    {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>('a' + (i + seed) % 26);
+        }
+        return data;
+    }
+
+    static std::vector<std::unique_ptr<IoEngine>> Engines()
+    {
+        std::vector<std::unique_ptr<IoEngine>> engines;
+        engines.emplace_back(std::make_unique<PreadIoEngine>());
+#ifdef WITH_IO_URING
+        auto uring = std::make_unique<UringIoEngine>(8, 2);
+        if (uring->Start() == 0) {
+            engines.emplace_back(std::move(uring));
+        }
+#endif
+        return engines;
+    }
+
+    std::string rootPath = "/tmp/testdir_io_engine";
+    int fd = -1;
+};
+
+TEST_F(IoEngineUT, ReadWriteAndBatch)
+{
+    for (auto &engine : Engines()) {
+        std::string data = Pattern(16384);
+        EXPECT_EQ(engine->Write(fd, data.data(), data.size(), 0), (ssize_t)data.size()) << engine->Name();
+
+        /* a batch larger than the queue depth */
+        std::vector<std::string> bufs(20, std::string(512, '\0'));
+        std::vector<IoRequest> reqs(bufs.size());
+        for (size_t i = 0; i < reqs.size(); ++i) {
+            reqs[i] = {.opcode = IoOpcode::READ, .fd = fd, .buf = bufs[i].data(), .len = 512, .offset = (off_t)i * 700};
+        }
+        EXPECT_EQ(engine->Submit(reqs.data(), reqs.size()), 0);
+        for (size_t i = 0; i < reqs.size(); ++i) {
+            EXPECT_EQ(reqs[i].result, 512);
+            EXPECT_EQ(bufs[i], data.substr(i * 700, 512));
+        }
+
+        char tail[100];
+        EXPECT_EQ(engine->Read(fd, tail, sizeof(tail), data.size() - 10), 10);
+        EXPECT_EQ(engine->Read(-1, tail, sizeof(tail), 0), -EBADF);
+    }
+}
+
+TEST_F(IoEngineUT, WritevGathersBuffers)
+{
+    for (auto &engine : Engines()) {
+        std::string first = "first-";
+        std::string second = "second";
+        struct iovec iov[2] = {{first.data(), first.size()}, {second.data(), second.size()}};
+        EXPECT_EQ(engine->Writev(fd, iov, 2, 100), 12);
+
+        char buf[12];
+        EXPECT_EQ(engine->Read(fd, buf, sizeof(buf), 100), 12);
+        EXPECT_EQ(std::string(buf, sizeof(buf)), "first-second");
+    }
+}
+
+TEST_F(IoEngineUT, DirectRequestsAreAligned)
+{
+    std::string data = Pattern(8192, 3);
+    ASSERT_EQ(pwrite(fd, data.data(), data.size(), 0), (ssize_t)data.size());
+
+    /* misaligned buffer, offset and length are read through an aligned bounce buffer */
+    for (auto &engine : Engines()) {
+        std::vector<char> buf(2000);
+        EXPECT_EQ(engine->Read(fd, buf.data() + 1, 1000, 777, true), 1000);
+        EXPECT_EQ(std::string(buf.data() + 1, 1000), data.substr(777, 1000));
+        EXPECT_EQ(engine->Read(fd, buf.data() + 1, 1000, 7700, true), 492);
+        EXPECT_EQ(std::string(buf.data() + 1, 492), data.substr(7700));
+
+        std::string update = Pattern(512, 7);
+        std::vector<char> unaligned(update.size() + 1);
+        memcpy(unaligned.data() + 1, update.data(), update.size());
+        EXPECT_EQ(engine->Write(fd, unaligned.data() + 1, update.size(), 1024, true), 512);
+        EXPECT_EQ(engine->Read(fd, buf.data(), 512, 1024), 512);
+        EXPECT_EQ(std::string(buf.data(), 512), update);
+    }
+}
+
+TEST_F(IoEngineUT, InitFallsBackToPread)
+{
+    EXPECT_EQ(IoEngine::Init("unknown"), -EINVAL);
+    EXPECT_EQ(IoEngine::Init(IO_ENGINE_PREAD), 0);
+    EXPECT_STREQ(IoEngine::GetInstance().Name(), IO_ENGINE_PREAD);
+    EXPECT_EQ(IoEngine::Init(IO_ENGINE_URING), 0);
+#ifndef WITH_IO_URING
+    EXPECT_STREQ(IoEngine::GetInstance().Name(), IO_ENGINE_PREAD);
+#endif
+    EXPECT_EQ(IoEngine::Init(IO_ENGINE_PREAD), 0);
+}
+
+/* moves at most SHORT_LIMIT bytes per request, and only the first vector of a WRITEV */
+class ShortIoEngine : public IoEngine {
+  public:
+    static constexpr size_t SHORT_LIMIT = 100;
+    const char *Name() override { return "short"; }
+    size_t calls = 0;
+
+  protected:
+    int DoSubmit(IoRequest *reqs, size_t num) override
+    {
+        ++calls;
+        for (size_t i = 0; i < num; ++i) {
+            IoRequest &req = reqs[i];
+            ssize_t ret = 0;
+            switch (req.opcode) {
+            case IoOpcode::READ:
+                ret = pread(req.fd, req.buf, std::min(req.len, SHORT_LIMIT), req.offset);
+                break;
+            case IoOpcode::WRITE:
+                ret = pwrite(req.fd, req.buf, std::min(req.len, SHORT_LIMIT), req.offset);
+                break;
+            case IoOpcode::WRITEV:
+                ret = pwrite(req.fd, req.iov[0].iov_base, req.iov[0].iov_len, req.offset);
+                break;
+            }
+            req.result = ret < 0 ? -errno : ret;
+        }
+        return 0;
+    }
+};
+
+TEST_F(IoEngineUT, ShortTransfersAreResubmitted)
+{
+    ShortIoEngine engine;
+    std::string data = Pattern(1000);
+    EXPECT_EQ(engine.Write(fd, data.data(), data.size(), 0), 1000);
+
+    std::string buf(1000, '\0');
+    EXPECT_EQ(engine.Read(fd, buf.data(), buf.size(), 0), 1000);
+    EXPECT_EQ(buf, data);
+    /* the end of file stops the resubmission */
+    EXPECT_EQ(engine.Read(fd, buf.data(), buf.size(), 950), 50);
+
+    std::string first = "first-";
+    std::string second = "second";
+    struct iovec iov[2] = {{first.data(), first.size()}, {second.data(), second.size()}};
+    engine.calls = 0;
+    EXPECT_EQ(engine.Writev(fd, iov, 2, 2000), 12);
+    EXPECT_EQ(engine.calls, 2U);
+    EXPECT_EQ(engine.Read(fd, buf.data(), 12, 2000), 12);
+    EXPECT_EQ(buf.substr(0, 12), "first-second");
+}
+
+/*
+ * Microbenchmark: random 4K reads of a cached file, submitted in batches of different queue depths. Disabled by
+ * default, run it with --gtest_also_run_disabled_tests --gtest_filter=*PerformanceQueueDepth
+ */
+TEST_F(IoEngineUT, DISABLED_PerformanceQueueDepth)
+{
+    constexpr size_t FILE_SIZE = 32UL * 1024 * 1024;
+    constexpr size_t BLOCK = 4096;
+    constexpr size_t ITERATIONS = 16384;
+    std::string data = Pattern(FILE_SIZE);
+    ASSERT_EQ(pwrite(fd, data.data(), data.size(), 0), (ssize_t)data.size());
+
+    for (size_t depth : {1, 8, 32, 128}) {
+#ifdef WITH_IO_URING
+        UringIoEngine engine(depth, 1);
+        if (engine.Start() != 0) {
+            GTEST_SKIP() << "io_uring is not available";
+        }
+#else
+        PreadIoEngine engine;
+#endif
+        std::vector<char> mem(BLOCK * depth);
+        engine.RegisterBuffer(mem.data(), mem.size());
+        std::vector<IoRequest> reqs(depth);
+        std::mt19937_64 rng(depth);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t done = 0; done < ITERATIONS; done += depth) {
+            for (size_t i = 0; i < depth; ++i) {
+                off_t offset = (off_t)(rng() % (FILE_SIZE / BLOCK)) * BLOCK;
+                reqs[i] = {.opcode = IoOpcode::READ, .fd = fd, .buf = mem.data() + i * BLOCK, .len = BLOCK,
+                           .offset = offset};
+            }
+            ASSERT_EQ(engine.Submit(reqs.data(), depth), 0);
+            for (size_t i = 0; i < depth; ++i) {
+                ASSERT_EQ(reqs[i].result, (ssize_t)BLOCK);
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        engine.UnregisterBuffer(mem.data());
+
+        auto cost = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        std::cout << engine.Name() << " queue depth " << depth << ": " << ITERATIONS << " reads cost "
+                  << cost.count() << " us" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
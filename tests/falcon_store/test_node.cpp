@@ -176,6 +176,36 @@ TEST_F(NodeUT, Delete)
     EXPECT_FALSE(StoreNode::GetInstance()->IsLocal(localEndpoint));
 }
 
+TEST_F(NodeUT, HashRingMovesOnlyChangedShare)
+{
+    constexpr int nodeNum = 8;
+    constexpr uint64_t keyNum = 100000;
+    std::vector<int> nodeIds;
+    for (int i = 0; i < nodeNum; ++i) {
+        nodeIds.push_back(i);
+    }
+    HashRing ring(nodeIds);
+    nodeIds.push_back(nodeNum);
+    HashRing grown(nodeIds);
+    EXPECT_EQ(HashRing({}).Locate(1), -1);
+    EXPECT_EQ(HashRing({3}).Successor(1, 3), 3);
+
+    uint64_t moved = 0;
+    for (uint64_t key = 0; key < keyNum; ++key) {
+        int owner = ring.Locate(key);
+        int newOwner = grown.Locate(key);
+        if (owner != newOwner) {
+            // keys only move to the added node
+            EXPECT_EQ(newOwner, nodeNum);
+            moved++;
+        }
+        EXPECT_NE(ring.Successor(key, owner), owner);
+    }
+    // about 1 / (nodeNum + 1) of the keys move
+    EXPECT_GT(moved, keyNum / (nodeNum + 1) / 2);
+    EXPECT_LT(moved, keyNum / (nodeNum + 1) * 2);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
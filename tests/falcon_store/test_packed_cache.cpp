@@ -0,0 +1,244 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "disk_cache/disk_cache.h"
+#include "disk_cache/packed_cache.h"
+#include "util/utils.h"
+
+class PackedCacheUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        std::filesystem::remove_all(rootPath);
+        std::filesystem::create_directories(rootPath + "/0");
+        SetRootPath(rootPath);
+        SetTotalDirectory(1);
+    }
+    void TearDown() override { std::filesystem::remove_all(rootPath); }
+
+    static std::string ReadAll(PackedCache &cache, uint64_t inode, size_t size)
+    {
+        std::string data(size, '\0');
+        EXPECT_EQ(cache.Read(inode, data.data(), size, 0), static_cast<ssize_t>(size));
+        return data;
+    }
+
+    std::string rootPath = "/tmp/testdir_packed";
+};
+
+TEST_F(PackedCacheUT, PutReadRemove)
+{
+    PackedCache cache;
+    ASSERT_EQ(cache.Start(rootPath), 0);
+
+    std::string first = "first small file";
+    std::string second = "second";
+    EXPECT_EQ(cache.Put(1, first.data(), first.size()), 0);
+    EXPECT_EQ(cache.Put(2, second.data(), second.size()), 0);
+    EXPECT_TRUE(cache.Contains(1));
+    EXPECT_EQ(ReadAll(cache, 1, first.size()), first);
+    EXPECT_EQ(ReadAll(cache, 2, second.size()), second);
+
+    char part[4] = {0};
+    EXPECT_EQ(cache.Read(1, part, sizeof(part), 6), 4);
+    EXPECT_EQ(std::string(part, 4), "smal");
+    EXPECT_EQ(cache.Read(1, part, sizeof(part), first.size()), 0);
+
+    EXPECT_EQ(cache.Remove(1), 0);
+    EXPECT_FALSE(cache.Contains(1));
+    EXPECT_EQ(cache.Read(1, part, sizeof(part), 0), -ENOENT);
+    EXPECT_EQ(cache.Remove(1), -ENOENT);
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, RestartRebuildsIndexWithoutDeletedRecords)
+{
+    std::string oldData = "old content";
+    std::string newData = "new content!";
+    std::string removed = "removed";
+    {
+        PackedCache cache;
+        ASSERT_EQ(cache.Start(rootPath), 0);
+        EXPECT_EQ(cache.Put(10, oldData.data(), oldData.size()), 0);
+        EXPECT_EQ(cache.Put(11, removed.data(), removed.size()), 0);
+        EXPECT_EQ(cache.Put(10, newData.data(), newData.size()), 0);
+        EXPECT_EQ(cache.Remove(11), 0);
+    }
+
+    PackedCache cache;
+    ASSERT_EQ(cache.Start(rootPath), 0);
+    EXPECT_TRUE(cache.Contains(10));
+    EXPECT_FALSE(cache.Contains(11));
+    EXPECT_EQ(ReadAll(cache, 10, newData.size()), newData);
+
+    /* new appends go to a fresh segment */
+    EXPECT_EQ(cache.Put(12, oldData.data(), oldData.size()), 0);
+    EXPECT_EQ(cache.SegmentNum(), 2);
+}
+
+TEST_F(PackedCacheUT, CompactMovesLiveRecordsAndDropsSparseSegments)
+{
+    PackedCache cache;
+    /* tiny segments, every two records seal a segment */
+    ASSERT_EQ(cache.Start(rootPath, 64), 0);
+    std::vector<std::string> data;
+    for (uint64_t i = 0; i < 8; ++i) {
+        data.push_back("data-" + std::to_string(i));
+        EXPECT_EQ(cache.Put(i, data[i].data(), data[i].size()), 0);
+    }
+    size_t segmentsBefore = cache.SegmentNum();
+    for (uint64_t i = 0; i < 8; i += 2) {
+        EXPECT_EQ(cache.Remove(i), 0);
+    }
+
+    EXPECT_GT(cache.Compact(0.75), 0);
+    for (uint64_t i = 1; i < 8; i += 2) {
+        EXPECT_EQ(ReadAll(cache, i, data[i].size()), data[i]);
+    }
+    cache.Stop();
+
+    ASSERT_EQ(cache.Start(rootPath, 64), 0);
+    for (uint64_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(cache.Contains(i), i % 2 == 1);
+    }
+    EXPECT_LE(cache.SegmentNum(), segmentsBefore);
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, CompactDuringPutsKeepsEverySegmentStillBeingWritten)
+{
+    PackedCache cache;
+    /* tiny segments, every append seals the segment of the one before while it may still be written */
+    ASSERT_EQ(cache.Start(rootPath, 64), 0);
+    std::atomic<bool> stop{false};
+    std::thread compactor([&cache, &stop]() {
+        while (!stop) {
+            cache.Compact(1.0);
+        }
+    });
+    std::vector<std::thread> writers;
+    for (uint64_t t = 0; t < 4; ++t) {
+        writers.emplace_back([&cache, t]() {
+            for (uint64_t i = 0; i < 300; ++i) {
+                std::string data = "data-" + std::to_string(t * 1000 + i);
+                EXPECT_EQ(cache.Put(t * 1000 + i, data.data(), data.size()), 0);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    stop = true;
+    compactor.join();
+
+    for (uint64_t t = 0; t < 4; ++t) {
+        for (uint64_t i = 0; i < 300; ++i) {
+            std::string data = "data-" + std::to_string(t * 1000 + i);
+            EXPECT_EQ(ReadAll(cache, t * 1000 + i, data.size()), data);
+        }
+    }
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, RestartSkipsHoleInTheMiddleOfSegment)
+{
+    std::string data = "0123456789";
+    {
+        PackedCache cache;
+        ASSERT_EQ(cache.Start(rootPath), 0);
+        for (uint64_t i = 30; i < 33; ++i) {
+            EXPECT_EQ(cache.Put(i, data.data(), data.size()), 0);
+        }
+    }
+    /* zero the second record as if its reserved range was never written */
+    std::string segmentPath = rootPath + "/" + PACKED_CACHE_DIR + "/seg-0";
+    uint64_t recordSize = std::filesystem::file_size(segmentPath) / 3;
+    std::fstream segment(segmentPath, std::ios::in | std::ios::out | std::ios::binary);
+    segment.seekp(static_cast<std::streamoff>(recordSize));
+    segment.write(std::string(recordSize, '\0').data(), static_cast<std::streamsize>(recordSize));
+    segment.close();
+
+    PackedCache cache;
+    ASSERT_EQ(cache.Start(rootPath), 0);
+    EXPECT_TRUE(cache.Contains(30));
+    EXPECT_FALSE(cache.Contains(31));
+    EXPECT_TRUE(cache.Contains(32));
+    EXPECT_EQ(ReadAll(cache, 32, data.size()), data);
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, ExtractWritesRegularFile)
+{
+    PackedCache cache;
+    ASSERT_EQ(cache.Start(rootPath), 0);
+    std::string content = "extract me";
+    EXPECT_EQ(cache.Put(20, content.data(), content.size()), 0);
+    EXPECT_EQ(cache.Extract(20, GetFilePath(20)), 0);
+
+    std::ifstream in(GetFilePath(20));
+    std::string fileContent((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(fileContent, content);
+    EXPECT_EQ(cache.Extract(21, GetFilePath(21)), -ENOENT);
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, ConcurrentExtractsNeverLeaveMixedFile)
+{
+    PackedCache cache;
+    ASSERT_EQ(cache.Start(rootPath), 0);
+    std::string content(64 * 1024, 'x');
+    EXPECT_EQ(cache.Put(22, content.data(), content.size()), 0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&cache]() { EXPECT_EQ(cache.Extract(22, GetFilePath(22)), 0); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(std::filesystem::file_size(GetFilePath(22)), content.size());
+    for (const auto &entry : std::filesystem::directory_iterator(rootPath + "/" + PACKED_CACHE_DIR)) {
+        EXPECT_EQ(entry.path().filename().string().rfind("seg-", 0), 0U) << entry.path();
+    }
+    cache.Stop();
+}
+
+TEST_F(PackedCacheUT, DiskCacheDeletesAndEvictsPackedRecords)
+{
+    PackedCache &packed = PackedCache::GetInstance();
+    ASSERT_EQ(packed.Start(rootPath), 0);
+    std::string content = "packed";
+    for (uint64_t inode = 30; inode < 33; ++inode) {
+        EXPECT_EQ(packed.Put(inode, content.data(), content.size()), 0);
+    }
+
+    /* ratio above 1 fails the space check after scanning, so no background cleanup thread is started */
+    DiskCache cache(0.4);
+    EXPECT_EQ(cache.Start(rootPath, 1, 2.0, 2.0), RETURN_ERROR);
+    EXPECT_TRUE(cache.Find(30, false));
+    EXPECT_TRUE(cache.Find(31, true));
+
+    EXPECT_EQ(cache.Delete(30), 0);
+    EXPECT_FALSE(packed.Contains(30));
+
+    cache.Evict(UINT64_MAX / 4);
+    EXPECT_TRUE(packed.Contains(31));
+    EXPECT_FALSE(packed.Contains(32));
+    EXPECT_FALSE(cache.Find(32, false));
+
+    cache.Unpin(31);
+    EXPECT_EQ(cache.Delete(31), 0);
+    packed.Stop();
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
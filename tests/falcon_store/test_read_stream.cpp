@@ -105,6 +105,171 @@ TEST_F(FalconStoreUT, ReadStreamReadFull)
     openInstance = nullptr;
 }
 
+/*-------------------------------------------- Readahead --------------------------------------------*/
+
+class ReadaheadUT : public testing::Test {
+  public:
+    static constexpr size_t BLOCK = 4096;
+    static constexpr int BLOCKS = 64;
+
+    void SetUp() override
+    {
+        MemPool::GetInstance().init(BLOCK, 64);
+        data.resize(BLOCK * BLOCKS - 100);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<char>(i * 7 + i / BLOCK);
+        }
+        ReadStream::SetReadahead(2, 8, READAHEAD_MEMORY_BUDGET);
+    }
+    void TearDown() override
+    {
+        ReadStream::SetReadahead(READAHEAD_INIT_BLOCKS, READAHEAD_MAX_BLOCKS, READAHEAD_MEMORY_BUDGET);
+    }
+
+    ReadStream::FetchFunc Fetch()
+    {
+        return [this](char *buf, off_t offset, size_t size) -> ssize_t {
+            fetched++;
+            if ((size_t)offset >= data.size()) {
+                return 0;
+            }
+            size_t len = std::min(size, data.size() - offset);
+            (void)memcpy(buf, data.data() + offset, len);
+            return len;
+        };
+    }
+
+    void ExpectRead(ReadStream &stream, off_t offset, size_t size)
+    {
+        std::string buf(size, '\0');
+        size_t expectSize = offset < (off_t)data.size() ? std::min(size, data.size() - offset) : 0;
+        EXPECT_EQ(stream.Read(buf.data(), size, offset), (ssize_t)expectSize);
+        EXPECT_TRUE(buf.substr(0, expectSize) == data.substr(std::min((size_t)offset, data.size()), expectSize))
+            << "data mismatch at " << offset;
+    }
+
+    std::string data;
+    std::atomic<int> fetched{0};
+};
+
+TEST_F(ReadaheadUT, SequentialReadGrowsWindow)
+{
+    size_t hits = FalconStats::GetInstance().stats[READAHEAD_HIT];
+    size_t misses = FalconStats::GetInstance().stats[READAHEAD_MISS];
+    ReadStream stream;
+    ASSERT_TRUE(stream.Init(Fetch(), BLOCKS, BLOCK));
+    stream.StartPushThreaded();
+    EXPECT_EQ(stream.window, 2);
+
+    for (off_t offset = 0; offset < (off_t)data.size(); offset += 1000) {
+        ExpectRead(stream, offset, 1000);
+    }
+    ExpectRead(stream, data.size(), 1000);
+    EXPECT_EQ(stream.window, 8);
+    EXPECT_EQ(stream.pipeNum, 9);
+    EXPECT_EQ(FalconStats::GetInstance().stats[READAHEAD_MISS] - misses, 0U);
+    EXPECT_GT(FalconStats::GetInstance().stats[READAHEAD_HIT] - hits, (size_t)BLOCKS);
+    /* every block is loaded once */
+    EXPECT_EQ(fetched.load(), BLOCKS);
+    stream.StopPushThreaded();
+    stream.WaitPushEnded();
+}
+
+TEST_F(ReadaheadUT, StridedAndBackwardJumpsKeepWindow)
+{
+    ReadStream stream;
+    ASSERT_TRUE(stream.Init(Fetch(), BLOCKS, BLOCK));
+    stream.StartPushThreaded();
+    for (int block = 0; block < 16; ++block) {
+        ExpectRead(stream, block * BLOCK, BLOCK);
+    }
+    int window = stream.window;
+    EXPECT_GT(window, 2);
+
+    /* skip a block, step back into the previous one, then continue */
+    ExpectRead(stream, 17 * BLOCK + 10, 100);
+    ExpectRead(stream, 16 * BLOCK + 20, BLOCK);
+    ExpectRead(stream, 18 * BLOCK, 2 * BLOCK);
+    EXPECT_GE(stream.window, window);
+    stream.StopPushThreaded();
+    stream.WaitPushEnded();
+}
+
+TEST_F(ReadaheadUT, FarJumpRestartsAndShrinksWindow)
+{
+    ReadStream stream;
+    ASSERT_TRUE(stream.Init(Fetch(), BLOCKS, BLOCK));
+    stream.StartPushThreaded();
+    for (int block = 0; block < 16; ++block) {
+        ExpectRead(stream, block * BLOCK, BLOCK);
+    }
+    int window = stream.window;
+
+    size_t misses = FalconStats::GetInstance().stats[READAHEAD_MISS];
+    ExpectRead(stream, 50 * BLOCK + 1, 3 * BLOCK);
+    EXPECT_EQ(FalconStats::GetInstance().stats[READAHEAD_MISS] - misses, 1U);
+    EXPECT_EQ(stream.window, window / 2);
+    ExpectRead(stream, 3 * BLOCK, BLOCK);
+    ExpectRead(stream, data.size() - 50, 100);
+    stream.StopPushThreaded();
+    stream.WaitPushEnded();
+}
+
+TEST_F(ReadaheadUT, MemoryBudgetLimitsPipesAndStopCancels)
+{
+    ReadStream::SetReadahead(2, 8, 4 * BLOCK);
+    ReadStream stream;
+    ASSERT_TRUE(stream.Init(Fetch(), BLOCKS, BLOCK));
+    ReadStream other;
+    ASSERT_FALSE(other.Init(Fetch(), BLOCKS, BLOCK));
+
+    char buf[16];
+    EXPECT_EQ(stream.Read(buf, sizeof(buf), 0), -ECANCELED);
+    stream.StartPushThreaded();
+    for (int block = 0; block < 32; ++block) {
+        ExpectRead(stream, block * BLOCK, BLOCK);
+    }
+    EXPECT_EQ(stream.pipeNum, 4);
+    EXPECT_EQ(stream.window, 3);
+
+    stream.StopPushThreaded();
+    EXPECT_EQ(stream.Read(buf, sizeof(buf), 32 * BLOCK), -ECANCELED);
+    stream.WaitPushEnded();
+}
+
+TEST_F(ReadaheadUT, StopDoesNotWaitForBlockedReader)
+{
+    std::mutex gateMutex;
+    std::condition_variable gateCV;
+    bool open = false;
+    ReadStream::FetchFunc fetch = [&, inner = Fetch()](char *buf, off_t offset, size_t size) {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        gateCV.wait(lock, [&open]() { return open; });
+        return inner(buf, offset, size);
+    };
+    ReadStream stream;
+    ASSERT_TRUE(stream.Init(fetch, BLOCKS, BLOCK));
+    stream.StartPushThreaded();
+
+    /* the reader waits for a load that is held back, stop must still get the stream lock */
+    std::atomic<ssize_t> ret = 0;
+    std::thread reader([&stream, &ret]() {
+        char buf[16];
+        ret = stream.Read(buf, sizeof(buf), 0);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stream.StopPushThreaded();
+    reader.join();
+    EXPECT_EQ(ret.load(), -ECANCELED);
+
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        open = true;
+    }
+    gateCV.notify_all();
+    stream.WaitPushEnded();
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
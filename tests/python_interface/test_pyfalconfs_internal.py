@@ -48,6 +48,16 @@ class PyFalconFSInternalCoverageTest(unittest.TestCase):
             self.mod.CloseDir("/file")
         with self.assertRaises(TypeError):
             self.mod.ReadDir("/file")
+        with self.assertRaises(TypeError):
+            self.mod.BatchGet(["/file"])
+        with self.assertRaises(TypeError):
+            self.mod.BatchGet("/file", [bytearray(1)])
+        with self.assertRaises(TypeError):
+            self.mod.BatchStat("/file")
+        with self.assertRaises(TypeError):
+            self.mod.BatchCreate()
+        with self.assertRaises(TypeError):
+            self.mod.BatchUnlink("/file")
         with self.assertRaises(TypeError):
             self.mod.AsyncExists()
         with self.assertRaises(TypeError):
@@ -60,6 +70,10 @@ class PyFalconFSInternalCoverageTest(unittest.TestCase):
             self.mod.Read("/file", 1, bytearray(2), 3, 0)
         with self.assertRaises(RuntimeError):
             self.mod.Write("/file", 1, bytearray(2), 3, 0)
+        with self.assertRaises(RuntimeError):
+            self.mod.BatchGet(["/a", "/b"], [bytearray(1)])
+        with self.assertRaises(BufferError):
+            self.mod.BatchGet(["/a"], [b"read-only"])
 
     def test_fast_paths_that_do_not_require_service(self):
         ret, fd = self.mod.OpenDir("")
@@ -127,6 +141,14 @@ class PyFalconFSInternalServiceCoverageTest(unittest.TestCase):
                 "falcon_is_inference": False,
                 "falcon_mount_path": "/",
                 "falcon_to_local": False,
+                "falcon_packed_small_file": False,
+                "falcon_io_engine": "pread",
+                "falcon_readahead_init_blocks": 2,
+                "falcon_readahead_max_blocks": 16,
+                "falcon_readahead_memory": 1024,
+                "falcon_migrate_bandwidth": 100,
+                "falcon_mem_pool_limit": 4096,
+                "falcon_mem_pool_hugepage": False,
                 "falcon_log_reserved_num": 3,
                 "falcon_log_reserved_time": 1,
                 "falcon_stat_max": True,
@@ -212,6 +234,43 @@ class PyFalconFSInternalServiceCoverageTest(unittest.TestCase):
 
         self.assertEqual(self.mod.Unlink(path), 0)
 
+    def test_batch_get(self):
+        paths = [self.unique_path(f"batch_{i}") for i in range(3)]
+        payloads = [bytearray(f"pyfalconfs-batch-{i}".encode()) for i in range(len(paths))]
+        for path, payload in zip(paths, payloads):
+            ret, fd = self.mod.Create(path, os.O_RDWR | os.O_CREAT)
+            self.assertEqual(ret, 0)
+            self.assertEqual(self.mod.Write(path, fd, payload, len(payload), 0), 0)
+            self.assertEqual(self.mod.Close(path, fd), 0)
+
+        missing = self.unique_path("batch_missing")
+        buffers = [bytearray(len(payload)) for payload in payloads] + [bytearray(4)]
+        rets = self.mod.BatchGet(paths + [missing], buffers)
+        self.assertEqual(rets[:3], [len(payload) for payload in payloads])
+        self.assertEqual(buffers[:3], payloads)
+        self.assertLess(rets[3], 0)
+
+        for path in paths:
+            self.assertEqual(self.mod.Unlink(path), 0)
+
+    def test_batch_create_stat_unlink(self):
+        paths = [self.unique_path(f"batch_meta_{i}") for i in range(8)]
+        missing = self.unique_path("batch_meta_missing")
+
+        self.assertEqual(self.mod.BatchCreate(paths), [0] * len(paths))
+        self.assertEqual(self.mod.BatchCreate(paths[:1]), [-errno.EEXIST])
+
+        rets, stbufs = self.mod.BatchStat(paths + [missing])
+        self.assertEqual(rets[:-1], [0] * len(paths))
+        self.assertEqual(rets[-1], -errno.ENOENT)
+        for stbuf in stbufs[:-1]:
+            self.assertEqual(stbuf["st_size"], 0)
+        self.assertEqual(stbufs[-1], {})
+
+        self.assertEqual(self.mod.BatchUnlink(paths), [0] * len(paths))
+        rets, _ = self.mod.BatchStat(paths)
+        self.assertEqual(rets, [-errno.ENOENT] * len(paths))
+
     def test_directory_listing(self):
         directory = self.unique_path("listdir")
 